@@ -90,7 +90,8 @@ namespace OFX {
     OFX::PluginFactory* _factory;
     OfxPlugin* _plug;
   };
-  typedef std::map<std::string, OfxPlugInfo> OfxPlugInfoMap;
+  // Transparent compare so mainEntryStr finds the plugin by its const char* id without building a std::string
+  typedef std::map<std::string, OfxPlugInfo, std::less<> > OfxPlugInfoMap;
   OfxPlugInfoMap plugInfoMap;
 
   typedef std::vector<OfxPlugin*> OfxPluginArray;
@@ -244,21 +245,21 @@ namespace OFX {
   }
 
   /** @brief turns a bit depth string into and enum */
-  BitDepthEnum mapStrToBitDepthEnum(const std::string &str)
+  BitDepthEnum mapStrToBitDepthEnum(const char *str)
   {
-    if(str == kOfxBitDepthByte) {
+    if(strcmp(str, kOfxBitDepthByte) == 0) {
       return eBitDepthUByte;
     }
-    else if(str == kOfxBitDepthShort) {
+    else if(strcmp(str, kOfxBitDepthShort) == 0) {
       return eBitDepthUShort;
     }
-    else if(str == kOfxBitDepthHalf) {
+    else if(strcmp(str, kOfxBitDepthHalf) == 0) {
       return eBitDepthHalf;
     }
-    else if(str == kOfxBitDepthFloat) {
+    else if(strcmp(str, kOfxBitDepthFloat) == 0) {
       return eBitDepthFloat;
     }
-    else if(str == kOfxBitDepthNone) {
+    else if(strcmp(str, kOfxBitDepthNone) == 0) {
       return eBitDepthNone;
     }
     else {
@@ -266,6 +267,11 @@ namespace OFX {
     }
   }
 
+  BitDepthEnum mapStrToBitDepthEnum(const std::string &str)
+  {
+    return mapStrToBitDepthEnum(str.c_str());
+  }
+
   /** @brief turns a bit depth string into and enum */
   const char* mapBitDepthEnumToStr(BitDepthEnum bitDepth)
   {
@@ -289,18 +295,18 @@ namespace OFX {
   }
 
   /** @brief turns a pixel component string into and enum */
-  PixelComponentEnum mapStrToPixelComponentEnum(const std::string &str)
+  PixelComponentEnum mapStrToPixelComponentEnum(const char *str)
   {
-    if(str == kOfxImageComponentRGBA) {
+    if(strcmp(str, kOfxImageComponentRGBA) == 0) {
       return ePixelComponentRGBA;
     }
-    else if(str == kOfxImageComponentRGB) {
+    else if(strcmp(str, kOfxImageComponentRGB) == 0) {
       return ePixelComponentRGB;
     }
-    else if(str == kOfxImageComponentAlpha) {
+    else if(strcmp(str, kOfxImageComponentAlpha) == 0) {
       return ePixelComponentAlpha;
     }
-    else if(str == kOfxImageComponentNone) {
+    else if(strcmp(str, kOfxImageComponentNone) == 0) {
       return ePixelComponentNone;
     }
     else {
@@ -308,6 +314,11 @@ namespace OFX {
     }
   }
 
+  PixelComponentEnum mapStrToPixelComponentEnum(const std::string &str)
+  {
+    return mapStrToPixelComponentEnum(str.c_str());
+  }
+
   /** @brief turns a pixel component string into and enum */
   const char* mapPixelComponentEnumToStr(PixelComponentEnum pixelComponent)
   {
@@ -327,15 +338,15 @@ namespace OFX {
   }
 
   /** @brief turns a premultiplication string into and enum */
-  static PreMultiplicationEnum mapStrToPreMultiplicationEnum(const std::string &str)
+  static PreMultiplicationEnum mapStrToPreMultiplicationEnum(const char *str)
   {
-    if(str == kOfxImageOpaque) {
+    if(strcmp(str, kOfxImageOpaque) == 0) {
       return eImageOpaque;
     }
-    else if(str == kOfxImagePreMultiplied) {
+    else if(strcmp(str, kOfxImagePreMultiplied) == 0) {
       return eImagePreMultiplied;
     }
-    else if(str == kOfxImageUnPreMultiplied) {
+    else if(strcmp(str, kOfxImageUnPreMultiplied) == 0) {
       return eImageUnPreMultiplied;
     }
     else {
@@ -343,19 +354,24 @@ namespace OFX {
     }
   }
 
+  static PreMultiplicationEnum mapStrToPreMultiplicationEnum(const std::string &str)
+  {
+    return mapStrToPreMultiplicationEnum(str.c_str());
+  }
+
   /** @brief turns a field string into and enum */
-  FieldEnum mapStrToFieldEnum(const std::string &str)
+  FieldEnum mapStrToFieldEnum(const char *str)
   {
-    if(str == kOfxImageFieldNone) {
+    if(strcmp(str, kOfxImageFieldNone) == 0) {
       return eFieldNone;
     }
-    else if(str == kOfxImageFieldBoth) {
+    else if(strcmp(str, kOfxImageFieldBoth) == 0) {
       return eFieldBoth;
     }
-    else if(str == kOfxImageFieldLower) {
+    else if(strcmp(str, kOfxImageFieldLower) == 0) {
       return eFieldLower;
     }
-    else if(str == kOfxImageFieldUpper) {
+    else if(strcmp(str, kOfxImageFieldUpper) == 0) {
       return eFieldUpper;
     }
     else {
@@ -363,6 +379,11 @@ namespace OFX {
     }
   }
 
+  FieldEnum mapStrToFieldEnum(const std::string &str)
+  {
+    return mapStrToFieldEnum(str.c_str());
+  }
+
 
   ////////////////////////////////////////////////////////////////////////////////
   // clip descriptor
@@ -795,11 +816,33 @@ namespace OFX {
   {
     OFX::Validation::validateImageBaseProperties(props);
 
-    // and fetch all the properties
+    fetchProperties();
+  }
+
+  ImageBase::ImageBase()
+    : _imageProps(0)
+    , _pixelComponents(ePixelComponentNone)
+    , _pixelComponentCount(0)
+    , _rowBytes(0)
+    , _pixelBytes(0)
+    , _pixelDepth(eBitDepthNone)
+    , _preMultiplication(eImageOpaque)
+    , _pixelAspectRatio(1.0)
+    , _field(eFieldNone)
+  {
+    _regionOfDefinition.x1 = _regionOfDefinition.y1 = _regionOfDefinition.x2 = _regionOfDefinition.y2 = 0;
+    _bounds = _regionOfDefinition;
+    _renderScale.x = _renderScale.y = 1.0;
+  }
+
+  // Strings are read in place and the unique ID is assigned into the existing string, so refetching into an
+  // image that held one before doesn't allocate
+  void ImageBase::fetchProperties(void)
+  {
     _rowBytes         = _imageProps.propGetInt(kOfxImagePropRowBytes);
     _pixelAspectRatio = _imageProps.propGetDouble(kOfxImagePropPixelAspectRatio);
 
-    std::string str  = _imageProps.propGetString(kOfxImageEffectPropComponents);
+    const char *str  = _imageProps.propGetCString(kOfxImageEffectPropComponents);
     _pixelComponents = mapStrToPixelComponentEnum(str);
 
     switch (_pixelComponents) {
@@ -821,7 +864,7 @@ namespace OFX {
         break;
     }
 
-    str = _imageProps.propGetString(kOfxImageEffectPropPixelDepth);
+    str = _imageProps.propGetCString(kOfxImageEffectPropPixelDepth);
     _pixelDepth = mapStrToBitDepthEnum(str);
 
     // compute bytes per pixel
@@ -837,7 +880,7 @@ namespace OFX {
     case eBitDepthCustom : _pixelBytes *= 0; break;
     }
 
-    str = _imageProps.propGetString(kOfxImageEffectPropPreMultiplication);
+    str = _imageProps.propGetCString(kOfxImageEffectPropPreMultiplication);
     _preMultiplication =  mapStrToPreMultiplicationEnum(str);
 
     _regionOfDefinition.x1 = _imageProps.propGetInt(kOfxImagePropRegionOfDefinition, 0);
@@ -850,25 +893,25 @@ namespace OFX {
     _bounds.x2 = _imageProps.propGetInt(kOfxImagePropBounds, 2);
     _bounds.y2 = _imageProps.propGetInt(kOfxImagePropBounds, 3);
 
-    str = _imageProps.propGetString(kOfxImagePropField);
-    if(str == kOfxImageFieldNone) {
+    str = _imageProps.propGetCString(kOfxImagePropField);
+    if(strcmp(str, kOfxImageFieldNone) == 0) {
       _field = eFieldNone;
     }
-    else if(str == kOfxImageFieldBoth) {
+    else if(strcmp(str, kOfxImageFieldBoth) == 0) {
       _field = eFieldBoth;
     }
-    else if(str == kOfxImageFieldLower) {
+    else if(strcmp(str, kOfxImageFieldLower) == 0) {
       _field = eFieldLower;
     }
-    else if(str == kOfxImageFieldUpper) {
+    else if(strcmp(str, kOfxImageFieldUpper) == 0) {
       _field = eFieldLower;
     }
     else {
-      OFX::Log::error(true, "Unknown field state '%s' reported on an image", str.c_str());
+      OFX::Log::error(true, "Unknown field state '%s' reported on an image", str);
       _field = eFieldNone;
     }
 
-    _uniqueID = _imageProps.propGetString(kOfxImagePropUniqueIdentifier);
+    _uniqueID = _imageProps.propGetCString(kOfxImagePropUniqueIdentifier);
 
     _renderScale.x = _imageProps.propGetDouble(kOfxImageEffectPropRenderScale, 0);
     _renderScale.y = _imageProps.propGetDouble(kOfxImageEffectPropRenderScale, 1);
@@ -890,9 +933,42 @@ namespace OFX {
     _pixelData = _imageProps.propGetPointer(kOfxImagePropData);
   }
 
+  Image::Image()
+    : _pixelData(0)
+  {
+  }
+
   Image::~Image()
   {
-    OFX::Private::gEffectSuite->clipReleaseImage(_imageProps.propSetHandle());
+    release();
+  }
+
+  void Image::reset(OfxPropertySetHandle props)
+  {
+    release();
+
+    OFX::Validation::validateImageBaseProperties(props);
+    OFX::Validation::validateImageProperties(props);
+
+    _imageProps.propSetHandle(props);
+    try {
+      fetchProperties();
+      _pixelData = _imageProps.propGetPointer(kOfxImagePropData);
+    }
+    catch(...) {
+      release();
+      throw;
+    }
+  }
+
+  void Image::release(void)
+  {
+    OfxPropertySetHandle props = _imageProps.propSetHandle();
+    if(props) {
+      _imageProps.propSetHandle(0);
+      _pixelData = 0;
+      OFX::Private::gEffectSuite->clipReleaseImage(props);
+    }
   }
 
 #ifdef OFX_SUPPORTS_OPENGLRENDER
@@ -1196,6 +1272,23 @@ namespace OFX {
     return new Image(imageHandle);
   }
 
+  /** @brief fetch an image into image, without allocating */
+  bool Clip::fetchImage(double t, Image &image)
+  {
+    image.release();
+
+    OfxPropertySetHandle imageHandle;
+    OfxStatus stat = OFX::Private::gEffectSuite->clipGetImage(_clipHandle, t, NULL, &imageHandle);
+    if(stat == kOfxStatFailed) {
+      return false; // not an error, fetched images out of range/region, assume black and transparent
+    }
+    else
+      throwSuiteStatusException(stat);
+
+    image.reset(imageHandle);
+    return true;
+  }
+
   /** @brief fetch an image, with a specific region in cannonical coordinates */
   Image *Clip::fetchImage(double t, const OfxRectD &bounds)
   {
@@ -2078,24 +2171,24 @@ namespace OFX {
     /** @brief Checks the handles passed into the plugin's main entry point */
     static
     void
-      checkMainHandles(const std::string &action,  const void *handle,
+      checkMainHandles(const char *action,  const void *handle,
       OfxPropertySetHandle inArgsHandle,  OfxPropertySetHandle outArgsHandle,
       bool handleCanBeNull, bool inArgsCanBeNull, bool outArgsCanBeNull)
     {
       if(handleCanBeNull)
-        OFX::Log::warning(handle != 0, "Handle passed to '%s' is not null.", action.c_str());
+        OFX::Log::warning(handle != 0, "Handle passed to '%s' is not null.", action);
       else
-        OFX::Log::error(handle == 0, "'Handle passed to '%s' is null.", action.c_str());
+        OFX::Log::error(handle == 0, "'Handle passed to '%s' is null.", action);
 
       if(inArgsCanBeNull)
-        OFX::Log::warning(inArgsHandle != 0, "'inArgs' Handle passed to '%s' is not null.", action.c_str());
+        OFX::Log::warning(inArgsHandle != 0, "'inArgs' Handle passed to '%s' is not null.", action);
       else
-        OFX::Log::error(inArgsHandle == 0, "'inArgs' handle passed to '%s' is null.", action.c_str());
+        OFX::Log::error(inArgsHandle == 0, "'inArgs' handle passed to '%s' is null.", action);
 
       if(outArgsCanBeNull)
-        OFX::Log::warning(outArgsHandle != 0, "'outArgs' Handle passed to '%s' is not null.", action.c_str());
+        OFX::Log::warning(outArgsHandle != 0, "'outArgs' Handle passed to '%s' is not null.", action);
       else
-        OFX::Log::error(outArgsHandle == 0, "'outArgs' handle passed to '%s' is null.", action.c_str());
+        OFX::Log::error(outArgsHandle == 0, "'outArgs' handle passed to '%s' is null.", action);
 
       // validate the property sets on the arguments
       OFX::Validation::validateActionArgumentsProperties(action, inArgsHandle, outArgsHandle);
@@ -2143,13 +2236,14 @@ namespace OFX {
       args.renderQualityDraft = inArgs.propGetInt(kOfxImageEffectPropRenderQualityDraft, false) != 0;
 
       args.fieldToRender = eFieldNone;
-      std::string str = inArgs.propGetString(kOfxImageEffectPropFieldToRender);
+      // Read in place, a copy of the field name is long enough to allocate on every render
+      const char *str = inArgs.propGetCString(kOfxImageEffectPropFieldToRender);
       try {
         args.fieldToRender = mapStrToFieldEnum(str);
       }
       catch (std::invalid_argument) {
         // dud field?
-        OFX::Log::error(true, "Unknown field to render '%s'", str.c_str());
+        OFX::Log::error(true, "Unknown field to render '%s'", str);
 
         // HACK need to throw something to cause a failure
       }
@@ -2258,13 +2352,13 @@ namespace OFX {
       args.renderWindow.x2 = inArgs.propGetInt(kOfxImageEffectPropRenderWindow, 2);
       args.renderWindow.y2 = inArgs.propGetInt(kOfxImageEffectPropRenderWindow, 3);
 
-      std::string str = inArgs.propGetString(kOfxImageEffectPropFieldToRender);
+      const char *str = inArgs.propGetCString(kOfxImageEffectPropFieldToRender);
       try {
         args.fieldToRender = mapStrToFieldEnum(str);
       }
       catch (std::invalid_argument) {
         // dud field?
-        OFX::Log::error(true, "Unknown field to render '%s'", str.c_str());
+        OFX::Log::error(true, "Unknown field to render '%s'", str);
 
         // HACK need to throw something to cause a failure
       }
@@ -2577,6 +2671,12 @@ namespace OFX {
 
     /** @brief The main entry point for the plugin
     */
+    /** @brief compares the action in place, a std::string copy of it would allocate on every call */
+    static inline bool isAction(const char *action, const char *name)
+    {
+      return action != NULL && strcmp(action, name) == 0;
+    }
+
     OfxStatus mainEntryStr(const char    *actionRaw,
       const void    *handleRaw,
       OfxPropertySetHandle   inArgsRaw,
@@ -2602,11 +2702,8 @@ namespace OFX {
         OFX::PropertySet inArgs(inArgsRaw);
         OFX::PropertySet outArgs(outArgsRaw);
 
-        // turn the action into a std::string
-        std::string action(actionRaw);
-
         // figure the actions
-        if (action == kOfxActionLoad) {
+        if (isAction(actionRaw, kOfxActionLoad)) {
           // call the support load function, param-less
           OFX::Private::loadAction();
 
@@ -2618,7 +2715,7 @@ namespace OFX {
         }
 
         // figure the actions
-        else if (action == kOfxActionUnload) {
+        else if (isAction(actionRaw, kOfxActionUnload)) {
           checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, true, true, true);
 
           // call the plugin side unload action, param-less, should be called, eve if the stat above failed!
@@ -2631,7 +2728,7 @@ namespace OFX {
           stat = kOfxStatOK;
         }
 
-        else if(action == kOfxActionDescribe) {
+        else if(isAction(actionRaw, kOfxActionDescribe)) {
           checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, true, true);
 
           // make the plugin descriptor
@@ -2650,7 +2747,7 @@ namespace OFX {
           // got here, must be good
           stat = kOfxStatOK;
         }
-        else if(action == kOfxImageEffectActionDescribeInContext) {
+        else if(isAction(actionRaw, kOfxImageEffectActionDescribeInContext)) {
           checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, false, true);
 
           // make the plugin descriptor and pass it to the plugin to do something with it
@@ -2672,7 +2769,7 @@ namespace OFX {
           // got here, must be good
           stat = kOfxStatOK;
         }
-        else if(action == kOfxActionCreateInstance) {
+        else if(isAction(actionRaw, kOfxActionCreateInstance)) {
           checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, true, true);
 
           // fetch the effect props to figure the context
@@ -2692,7 +2789,7 @@ namespace OFX {
           // got here, must be good
           stat = kOfxStatOK;
         }
-        else if(action == kOfxActionDestroyInstance) {
+        else if(isAction(actionRaw, kOfxActionDestroyInstance)) {
           checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, true, true);
 
           // fetch our pointer out of the props on the handle
@@ -2704,7 +2801,7 @@ namespace OFX {
           // got here, must be good
           stat = kOfxStatOK;
         }
-        else if(action == kOfxImageEffectActionRender) {
+        else if(isAction(actionRaw, kOfxImageEffectActionRender)) {
           checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, false, true);
 
           // call the render action skin
@@ -2713,54 +2810,54 @@ namespace OFX {
           // got here, must be good
           stat = kOfxStatOK;
         }
-        else if(action == kOfxImageEffectActionBeginSequenceRender) {
+        else if(isAction(actionRaw, kOfxImageEffectActionBeginSequenceRender)) {
           checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, false, true);
 
           // call the begin render action skin
           beginSequenceRenderAction(handle, inArgs);
         }
-        else if(action == kOfxImageEffectActionEndSequenceRender) {
+        else if(isAction(actionRaw, kOfxImageEffectActionEndSequenceRender)) {
           checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, false, true);
 
           // call the begin render action skin
           endSequenceRenderAction(handle, inArgs);
         }
-        else if(action == kOfxImageEffectActionIsIdentity) {
+        else if(isAction(actionRaw, kOfxImageEffectActionIsIdentity)) {
           checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, false, false);
 
           // call the identity action, if it is, return OK
           if(isIdentityAction(handle, inArgs, outArgs))
             stat = kOfxStatOK;
         }
-        else if(action == kOfxImageEffectActionGetRegionOfDefinition) {
+        else if(isAction(actionRaw, kOfxImageEffectActionGetRegionOfDefinition)) {
           checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, false, false);
 
           // call the rod action, return OK if it does something
           if(regionOfDefinitionAction(handle, inArgs, outArgs))
             stat = kOfxStatOK;
         }
-        else if(action == kOfxImageEffectActionGetRegionsOfInterest) {
+        else if(isAction(actionRaw, kOfxImageEffectActionGetRegionsOfInterest)) {
           checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, false, false);
 
           // call the RoI action, return OK if it does something
           if(regionsOfInterestAction(handle, inArgs, outArgs, plugname))
             stat = kOfxStatOK;
         }
-        else if(action == kOfxImageEffectActionGetFramesNeeded) {
+        else if(isAction(actionRaw, kOfxImageEffectActionGetFramesNeeded)) {
           checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, false, false);
 
           // call the frames needed action, return OK if it does something
           if(framesNeededAction(handle, inArgs, outArgs, plugname))
             stat = kOfxStatOK;
         }
-        else if(action == kOfxImageEffectActionGetClipPreferences) {
+        else if(isAction(actionRaw, kOfxImageEffectActionGetClipPreferences)) {
           checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, true, false);
 
           // call the frames needed action, return OK if it does something
           if(clipPreferencesAction(handle, outArgs, plugname))
             stat = kOfxStatOK;
         }
-        else if(action == kOfxActionPurgeCaches) {
+        else if(isAction(actionRaw, kOfxActionPurgeCaches)) {
           checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, true, true);
 
           // fetch our pointer out of the props on the handle
@@ -2769,7 +2866,7 @@ namespace OFX {
           // purge 'em
           instance->purgeCaches();
         }
-        else if(action == kOfxActionSyncPrivateData) {
+        else if(isAction(actionRaw, kOfxActionSyncPrivateData)) {
           checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, true, true);
 
           // fetch our pointer out of the props on the handle
@@ -2778,32 +2875,32 @@ namespace OFX {
           // and sync it
           instance->syncPrivateData();
         }
-        else if(action == kOfxImageEffectActionGetTimeDomain) {
+        else if(isAction(actionRaw, kOfxImageEffectActionGetTimeDomain)) {
           checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, true, false);
 
           // call the instance changed action
           if(getTimeDomainAction(handle, outArgs))
             stat = kOfxStatOK;
         }
-        else if(action == kOfxActionBeginInstanceChanged) {
+        else if(isAction(actionRaw, kOfxActionBeginInstanceChanged)) {
           checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, false, true);
 
           // call the instance changed action
           beginInstanceChangedAction(handle, inArgs);
         }
-        else if(action == kOfxActionInstanceChanged) {
+        else if(isAction(actionRaw, kOfxActionInstanceChanged)) {
           checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, false, true);
 
           // call the instance changed action
           instanceChangedAction(handle, inArgs);
         }
-        else if(action == kOfxActionEndInstanceChanged) {
+        else if(isAction(actionRaw, kOfxActionEndInstanceChanged)) {
           checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, false, true);
 
           // call the instance changed action
           endInstanceChangedAction(handle, inArgs);
         }
-        else if(action == kOfxActionBeginInstanceEdit) {
+        else if(isAction(actionRaw, kOfxActionBeginInstanceEdit)) {
           checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, true, true);
 
           // fetch our pointer out of the props on the handle
@@ -2812,7 +2909,7 @@ namespace OFX {
           // call the begin edit function
           instance->beginEdit();
         }
-        else if(action == kOfxActionEndInstanceEdit) {
+        else if(isAction(actionRaw, kOfxActionEndInstanceEdit)) {
           checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, true, true);
 
           // fetch our pointer out of the props on the handle
@@ -2822,7 +2919,7 @@ namespace OFX {
           instance->endEdit();
         }
 #ifdef OFX_SUPPORTS_OPENGLRENDER
-        else if(action == kOfxActionOpenGLContextAttached) {
+        else if(isAction(actionRaw, kOfxActionOpenGLContextAttached)) {
           checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, true, true);
 
           // fetch our pointer out of the props on the handle
@@ -2831,7 +2928,7 @@ namespace OFX {
           // call the context attached function
           instance->contextAttached();
         }
-        else if(action == kOfxActionOpenGLContextDetached) {
+        else if(isAction(actionRaw, kOfxActionOpenGLContextDetached)) {
           checkMainHandles(actionRaw, handleRaw, inArgsRaw, outArgsRaw, false, true, true);
 
           // fetch our pointer out of the props on the handle
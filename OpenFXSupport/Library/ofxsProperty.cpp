@@ -40,9 +40,10 @@ using namespace OFX::Private;
 
 namespace OFX {
 
+  // Takes the name as a const char* as it's called on every property read, a std::string would allocate each time
   static
   void throwPropertyException(OfxStatus stat,
-    const std::string &propName)
+    const char *propName)
   {
     switch (stat)
     {
@@ -56,7 +57,7 @@ namespace OFX {
     case kOfxStatErrUnknown :
     case kOfxStatErrUnsupported : // unsupported implies unknow here
       if(OFX::PropertySet::getThrowOnUnsupportedProperties()) // are we suppressing this?
-        throw OFX::Exception::PropertyUnknownToHost(propName.c_str());
+        throw OFX::Exception::PropertyUnknownToHost(propName);
       break;
 
     case kOfxStatErrMemory :
@@ -64,7 +65,7 @@ namespace OFX {
       break;
 
     case kOfxStatErrValue :
-      throw  OFX::Exception::PropertyValueIllegalToHost(propName.c_str());
+      throw  OFX::Exception::PropertyValueIllegalToHost(propName);
       break;
 
     case kOfxStatErrBadHandle :
@@ -207,6 +208,21 @@ namespace OFX {
     return value != NULL ?  std::string(value) : std::string();
   }
 
+  /** @brief Get single string property without copying it */
+  const char *PropertySet::propGetCString(const char* property, int idx, bool throwOnFailure) const
+  {
+    assert(_propHandle != 0);
+    char *value = NULL;
+    OfxStatus stat = gPropSuite->propGetString(_propHandle, property, idx, &value);
+    OFX::Log::error(stat != kOfxStatOK, "Failed on getting string property %s[%d], host returned status %s;",
+      property, idx, mapStatusToString(stat));
+    if(throwOnFailure)
+      throwPropertyException(stat, property);
+
+    if(_gPropLogging > 0) Log::print("Retrieved string property %s[%d], was given %s.",  property, idx, value);
+    return value != NULL ? value : "";
+  }
+
   /** @brief Get single double property */
   double PropertySet::propGetDouble(const char* property, int idx, bool throwOnFailure) const
   {
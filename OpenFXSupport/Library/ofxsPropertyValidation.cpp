@@ -1174,13 +1174,14 @@ namespace OFX {
 
     /** @brief Validates action in/out arguments */
     void
-      validateActionArgumentsProperties(const std::string &action, PropertySet inArgs, PropertySet outArgs)
+      validateActionArgumentsProperties(const char *actionRaw, PropertySet inArgs, PropertySet outArgs)
     {
 #ifdef kOfxsDisableValidation
-    (void)action;
+    (void)actionRaw;
     (void)inArgs;
     (void)outArgs;
 #else
+      const std::string action(actionRaw);
       if(action == kOfxActionInstanceChanged) {
         gInstanceChangedInArgPropSet.validate(inArgs);
       }
@@ -324,6 +324,8 @@ namespace OFX {
 
     /// get a string property
     std::string propGetString(const char* property, int idx, bool throwOnFailure = true) const;
+    /// get a string property without copying it, the host owns the string
+    const char *propGetCString(const char* property, int idx, bool throwOnFailure = true) const;
     /// get a double property
     double      propGetDouble(const char* property, int idx, bool throwOnFailure = true) const;
 
@@ -342,6 +344,12 @@ namespace OFX {
       return propGetString(property, 0, throwOnFailure);
     }
 
+    /// get a string property with index 0 without copying it
+    const char *propGetCString(const char* property, bool throwOnFailure = true) const
+    {
+      return propGetCString(property, 0, throwOnFailure);
+    }
+
     /// get a double property with index 0
     double propGetDouble(const char* property, bool throwOnFailure = true) const
     {
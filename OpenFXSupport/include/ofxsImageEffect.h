@@ -150,6 +150,7 @@ namespace OFX {
 
   /** @brief turns a field string into and enum */
   FieldEnum mapStrToFieldEnum(const std::string &str);
+  FieldEnum mapStrToFieldEnum(const char *str);
 
   ////////////////////////////////////////////////////////////////////////////////
   /** @brief map a std::string to a context enum */
@@ -164,10 +165,12 @@ namespace OFX {
   InstanceChangeReason mapToInstanceChangedReason(const std::string &s);
 
   BitDepthEnum mapStrToBitDepthEnum(const std::string &str);
+  BitDepthEnum mapStrToBitDepthEnum(const char *str);
 
   const char* mapBitDepthEnumToStr(BitDepthEnum bitDepth);
 
   PixelComponentEnum mapStrToPixelComponentEnum(const std::string &str);
+  PixelComponentEnum mapStrToPixelComponentEnum(const char *str);
 
   const char* mapPixelComponentEnumToStr(PixelComponentEnum pixelComponent);
 
@@ -533,10 +536,16 @@ namespace OFX {
     std::string _uniqueID;                   /**< @brief the unique ID of this image */
     OfxPointD _renderScale;                  /**< @brief any scaling factor applied to the image */
 
+    /** @brief fetch all the properties off the handle */
+    void fetchProperties(void);
+
   public :
     /** @brief ctor */
     ImageBase(OfxPropertySetHandle props);
 
+    /** @brief ctor for an image filled in later by Clip::fetchImage(double, Image &) */
+    ImageBase();
+
     /** @brief dtor */
     virtual ~ImageBase();
 
@@ -591,9 +600,21 @@ namespace OFX {
     /** @brief ctor */
     Image(OfxPropertySetHandle props);
 
+    /** @brief ctor for an empty image, to be reused with Clip::fetchImage(double, Image &) */
+    Image();
+
     /** @brief dtor */
     virtual ~Image();
 
+    /** @brief wrap a new image handle, releasing the one held before */
+    void reset(OfxPropertySetHandle props);
+
+    /** @brief give the image back to the host, the object can be reused afterwards */
+    void release(void);
+
+    /** @brief is an image held */
+    bool isFetched(void) const { return _imageProps.propSetHandle() != 0; }
+
     /** @brief get the pixel data for this image */
     void *getPixelData(void) { return _pixelData;}
 
@@ -753,6 +774,13 @@ namespace OFX {
     */
     Image *fetchImage(double t, const OfxRectD &bounds);
 
+    /** @brief fetch an image into image, without allocating
+
+    Releases what image held before. Returns false and leaves image empty when the host has no image at t.
+    The image goes back to the host on image.release() or when image is destroyed.
+    */
+    bool fetchImage(double t, Image &image);
+
     /** @brief fetch an image, with a specific region in cannonical coordinates
 
     When finished with, the client code must delete the image.
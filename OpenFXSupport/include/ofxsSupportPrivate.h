@@ -249,7 +249,7 @@ namespace OFX {
 
     /** @brief Validates action in/out arguments */
     void
-      validateActionArgumentsProperties(const std::string &action, PropertySet inArgs, PropertySet outArgs);
+      validateActionArgumentsProperties(const char *action, PropertySet inArgs, PropertySet outArgs);
 
     /** @brief Validates parameter properties */
     void
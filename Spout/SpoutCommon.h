@@ -37,6 +37,9 @@
 03.07.23	- Remove _MSC_VER condition from SPOUT_DLLEXP define
 			  (#PR93  Fix MinGW error (beta branch)
 07.12.23	- using namespace spoututils moved from SpoutGL.h
+17.10.26	- Include SpoutUtils for Windows only. Other platforms get
+			  logging to stderr for the classes that build there
+			  (SpoutSharedMemory, spoutSharedBuffer, spoutHistogram, spoutSettings)
 
 
 */
@@ -62,7 +65,31 @@
 #endif
 
 // Common utility functions namespace
+#ifdef _WIN32
 #include "SpoutUtils.h"
+#else
+#include <stdio.h>
+#include <stdarg.h>
+#ifndef USE_CHRONO
+#define USE_CHRONO
+#endif
+namespace spoututils {
+	inline void SpoutLogV(const char* level, const char* format, va_list args) {
+		fprintf(stderr, "[%s] ", level);
+		vfprintf(stderr, format, args);
+		fprintf(stderr, "\n");
+	}
+	inline void SpoutLogNotice(const char* format, ...) {
+		va_list args; va_start(args, format); SpoutLogV("notice", format, args); va_end(args);
+	}
+	inline void SpoutLogWarning(const char* format, ...) {
+		va_list args; va_start(args, format); SpoutLogV("warning", format, args); va_end(args);
+	}
+	inline void SpoutLogError(const char* format, ...) {
+		va_list args; va_start(args, format); SpoutLogV("error", format, args); va_end(args);
+	}
+}
+#endif
 
 //
 // This definition enables legacy OpenGL rendering code
@@ -75,6 +75,13 @@
 	Version 2.007.014
 	19.06.24 - Add ClearAlpha
 	07.02.25 - Add GetSSE to return SSE capability
+	17.10.26 - Add rgbaf2yuv for NV12, P010, YUY2, UYVY and v210 with AVX2
+			   Add GetYUVTexture and GetAVX2
+			   Add spoutSwizzle template for all RGBA, BGRA, RGB and BGR copies
+			   with SSSE3 and AVX2 shuffles built at compile time
+			   Legacy byte copy functions are instantiations of it
+			   rgbaf2yuv - chroma subsampling and packing of NV12, P010, YUY2 and UYVY with AVX2
+			   bgr2rgba with dest pitch now swaps red and blue
 
 //
 void spoutCopy::GetSSE
@@ -83,6 +90,8 @@ void spoutCopy::GetSSE
 
 #include "SpoutCopy.h"
 
+#include <type_traits> // for std::true_type
+
 //
 // Class: spoutCopy
 //
@@ -95,7 +104,8 @@ spoutCopy::spoutCopy() {
 	m_bSSE2 = false;
 	m_bSSE3 = false;
 	m_bSSSE3 = false;
-	CheckSSE(); // SSE available - sets m_bSSE2, m_bSSE3, m_bSSSE3
+	m_bAVX2 = false;
+	CheckSSE(); // SSE available - sets m_bSSE2, m_bSSE3, m_bSSSE3, m_bAVX2
 }
 
 
@@ -304,6 +314,181 @@ void spoutCopy::memcpy_sse2(void* dst, const void* src, size_t Size) const
 
 }
 
+//
+// Group: Swizzle kernels
+//
+// One template for all the 8 bit copies between RGBA, BGRA, RGB and BGR.
+// The source and destination layouts, channel type and flip are template
+// parameters, so the shuffle masks are built at compile time and every
+// format pair gets the same SSSE3 and AVX2 paths. The legacy functions
+// below are instantiations of it.
+//
+// Each 16 byte vector holds P whole pixels of the wider layout, for example
+// 4 RGBA pixels in and 12 RGB bytes out. Loads and stores are 16 bytes,
+// so they are only used while they stay inside the line and the rest
+// of the line is copied per pixel.
+//
+
+#if defined(__clang__) || defined(__GNUC__)
+#define SPOUT_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define SPOUT_TARGET_AVX2
+#endif
+
+// Positions of red, green, blue and alpha in the pixel. Alpha -1 for none.
+template<int R, int G, int B, int A>
+struct spoutLayout {
+	static constexpr int channels = A < 0 ? 3 : 4;
+	// Position of channel c (0 red, 1 green, 2 blue, 3 alpha), -1 if missing
+	static constexpr int slot(int c) { return c == 0 ? R : c == 1 ? G : c == 2 ? B : A; }
+	// Channel at position s
+	static constexpr int channel(int s) { return s == R ? 0 : s == G ? 1 : s == B ? 2 : 3; }
+};
+
+typedef spoutLayout<0, 1, 2, 3>  spoutRGBA;
+typedef spoutLayout<2, 1, 0, 3>  spoutBGRA;
+typedef spoutLayout<0, 1, 2, -1> spoutRGB;
+typedef spoutLayout<2, 1, 0, -1> spoutBGR;
+
+template<class Src, class Dst, typename T>
+struct spoutSwizzleKernel {
+
+	static constexpr int srcBytes = Src::channels * (int)sizeof(T);
+	static constexpr int dstBytes = Dst::channels * (int)sizeof(T);
+	// Pixels in one 16 byte vector
+	static constexpr int P = 16 / (srcBytes > dstBytes ? srcBytes : dstBytes);
+
+	// Source position of the channel at destination byte i, -1 if there is none
+	static constexpr int source(int i) {
+		return Src::slot(Dst::channel((i % dstBytes) / (int)sizeof(T)));
+	}
+
+	// Shuffle mask byte for destination byte i. 0x80 gives zero.
+	static constexpr char mask(int i) {
+		return (i / dstBytes >= P || source(i) < 0) ? (char)0x80
+			: (char)((i / dstBytes) * srcBytes + source(i) * (int)sizeof(T) + i % (int)sizeof(T));
+	}
+
+	// Opaque alpha where the source has none
+	static constexpr char fill(int i) {
+		return (i / dstBytes < P && source(i) < 0) ? (char)0xFF : (char)0;
+	}
+
+	static __m128i Mask() {
+		return _mm_setr_epi8(mask(0), mask(1), mask(2), mask(3), mask(4), mask(5), mask(6), mask(7),
+			mask(8), mask(9), mask(10), mask(11), mask(12), mask(13), mask(14), mask(15));
+	}
+
+	static __m128i Fill() {
+		return _mm_setr_epi8(fill(0), fill(1), fill(2), fill(3), fill(4), fill(5), fill(6), fill(7),
+			fill(8), fill(9), fill(10), fill(11), fill(12), fill(13), fill(14), fill(15));
+	}
+
+	static void Pixels(const unsigned char* src, unsigned char* dst, unsigned int x, unsigned int width)
+	{
+		auto s = reinterpret_cast<const T*>(src) + (uint64_t)x * Src::channels;
+		auto d = reinterpret_cast<T*>(dst) + (uint64_t)x * Dst::channels;
+		for (; x < width; x++) {
+			for (int c = 0; c < Dst::channels; c++) {
+				const int k = Src::slot(Dst::channel(c));
+				d[c] = k < 0 ? (T)~(T)0 : s[k];
+			}
+			s += Src::channels;
+			d += Dst::channels;
+		}
+	}
+
+	// Returns the first pixel not done
+	static unsigned int LineSSSE3(const unsigned char* src, unsigned char* dst, unsigned int x, unsigned int width)
+	{
+		const __m128i m = Mask();
+		const __m128i f = Fill();
+		for (; x + P <= width && (uint64_t)(width - x) * srcBytes >= 16 && (uint64_t)(width - x) * dstBytes >= 16; x += P) {
+			__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + (uint64_t)x * srcBytes));
+			v = _mm_or_si128(_mm_shuffle_epi8(v, m), f);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + (uint64_t)x * dstBytes), v);
+		}
+		return x;
+	}
+
+#ifndef _M_ARM64
+	// Two vectors at once, one in each 128 bit lane because the AVX2 shuffle does not cross lanes
+	SPOUT_TARGET_AVX2 static unsigned int LineAVX2(const unsigned char* src, unsigned char* dst, unsigned int x, unsigned int width)
+	{
+		const __m256i m = _mm256_broadcastsi128_si256(Mask());
+		const __m256i f = _mm256_broadcastsi128_si256(Fill());
+		for (; x + 2 * P <= width
+			&& (uint64_t)(width - x) * srcBytes >= (uint64_t)P * srcBytes + 16
+			&& (uint64_t)(width - x) * dstBytes >= (uint64_t)P * dstBytes + 16; x += 2 * P) {
+			const unsigned char* s = src + (uint64_t)x * srcBytes;
+			unsigned char* d = dst + (uint64_t)x * dstBytes;
+			__m256i v;
+			if (P * srcBytes == 16) {
+				v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s));
+			}
+			else {
+				v = _mm256_inserti128_si256(_mm256_castsi128_si256(
+					_mm_loadu_si128(reinterpret_cast<const __m128i*>(s))),
+					_mm_loadu_si128(reinterpret_cast<const __m128i*>(s + P * srcBytes)), 1);
+			}
+			v = _mm256_or_si256(_mm256_shuffle_epi8(v, m), f);
+			if (P * dstBytes == 16) {
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(d), v);
+			}
+			else {
+				// The unused bytes of the first store are written again by the second
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(d), _mm256_castsi256_si128(v));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(d + P * dstBytes), _mm256_extracti128_si256(v, 1));
+			}
+		}
+		return x;
+	}
+#endif
+
+	// Copy all lines. Flip is std::true_type to flip the image vertically.
+	// Pitch 0 is a buffer without padding.
+	template<class Flip>
+	static void Copy(const void* source, void* dest, unsigned int width, unsigned int height,
+		unsigned int sourcePitch, unsigned int destPitch, bool bSSSE3, bool bAVX2, Flip)
+	{
+		auto src = static_cast<const unsigned char*>(source);
+		auto dst = static_cast<unsigned char*>(dest);
+		if (!src || !dst)
+			return;
+
+		const uint64_t srcPitch = sourcePitch ? sourcePitch : (uint64_t)width * srcBytes;
+		const uint64_t dstPitch = destPitch ? destPitch : (uint64_t)width * dstBytes;
+
+		for (unsigned int y = 0; y < height; y++) {
+			const unsigned char* s = src + (Flip::value ? (uint64_t)(height - 1 - y) : (uint64_t)y) * srcPitch;
+			unsigned char* d = dst + (uint64_t)y * dstPitch;
+			unsigned int x = 0;
+#ifndef _M_ARM64
+			if (bAVX2)
+				x = LineAVX2(s, d, x, width);
+#endif
+			if (bSSSE3)
+				x = LineSSSE3(s, d, x, width);
+			Pixels(s, d, x, width);
+		}
+	}
+
+};
+
+//---------------------------------------------------------
+// Function: spoutSwizzle
+// Copy between two layouts with the fastest method available.
+// The flip flag selects the instantiation.
+template<class Src, class Dst, typename T = unsigned char>
+static void spoutSwizzle(const void* source, void* dest, unsigned int width, unsigned int height,
+	unsigned int sourcePitch, unsigned int destPitch, bool bInvert, bool bSSSE3, bool bAVX2)
+{
+	if (bInvert)
+		spoutSwizzleKernel<Src, Dst, T>::Copy(source, dest, width, height, sourcePitch, destPitch, bSSSE3, bAVX2, std::true_type());
+	else
+		spoutSwizzleKernel<Src, Dst, T>::Copy(source, dest, width, height, sourcePitch, destPitch, bSSSE3, bAVX2, std::false_type());
+}
+
 //
 // Group: RGBA <> RGBA
 //
@@ -436,15 +621,13 @@ void spoutCopy::rgba2bgra(const void* rgba_source, void* bgra_dest,
 	if (!rgba_source || !bgra_dest)
 		return;
 
-	if ((width % 16) == 0) { // 16 byte aligned width
-		if (m_bSSE2 && m_bSSSE3) // SSE3 available
-			rgba_bgra_sse3(rgba_source, bgra_dest, width, height, bInvert);
-		else if (m_bSSE2) // SSE2 available
-			rgba_bgra_sse2(rgba_source, bgra_dest, width, height, bInvert);
-	}
-	else {
-		rgba_bgra(rgba_source, bgra_dest, width, height, bInvert);
+	// No SSSE3 shuffle, use the SSE2 function
+	if (!m_bSSSE3 && m_bSSE2) {
+		rgba_bgra_sse2(rgba_source, bgra_dest, width, height, bInvert);
+		return;
 	}
+
+	spoutSwizzle<spoutRGBA, spoutBGRA>(rgba_source, bgra_dest, width, height, 0, 0, bInvert, m_bSSSE3, m_bAVX2);
 }
 
 //---------------------------------------------------------
@@ -453,43 +636,7 @@ void spoutCopy::rgba2bgra(const void* rgba_source, void* bgra_dest,
 void spoutCopy::rgba2bgra(const void *rgba_source, void *bgra_dest,
 	unsigned int width, unsigned int height, unsigned int sourcePitch, bool bInvert) const
 {
-	if (!rgba_source || !bgra_dest)
-		return;
-
-	for (unsigned int y = 0; y < height; y++) {
-
-		// Start of buffers
-		auto source = static_cast<const unsigned __int32*>(rgba_source); // unsigned int = 4 bytes
-		auto dest = static_cast<unsigned __int32*>(bgra_dest);
-		if (!source || !dest)
-			return;
-
-		// Casting first avoids warning C26451: Arithmetic overflow with VS2022 code review
-		// https://docs.microsoft.com/en-us/visualstudio/code-quality/c26451
-		unsigned long YxW = (unsigned long)(y * width);
-
-		// Increment to current line.
-		if (bInvert) {
-			// Pitch is line length in bytes.
-			// Divide by 4 to get the line width in rgba pixels.
-			source += ((height - 1 - y) * sourcePitch / 4);
-			dest += YxW; // dest is not inverted
-		}
-		else {
-			source += (unsigned long)(y * sourcePitch / 4);
-			dest += YxW;
-		}
-		// Copy the line
-		if ((width % 16) == 0) { // 16 byte aligned width
-			if (m_bSSE2 && m_bSSSE3) // SSE3 available
-				rgba_bgra_sse3(source, dest, width, 1, bInvert);
-			else if (m_bSSE2) // SSE2 available
-				rgba_bgra_sse2(source, dest, width, 1, bInvert);
-		}
-		else {
-			rgba_bgra(source, dest, width, 1, bInvert);
-		}
-	}
+	spoutSwizzle<spoutRGBA, spoutBGRA>(rgba_source, bgra_dest, width, height, sourcePitch, 0, bInvert, m_bSSSE3, m_bAVX2);
 }
 
 //---------------------------------------------------------
@@ -499,43 +646,7 @@ void spoutCopy::rgba2bgra(const void* rgba_source, void* bgra_dest,
 	unsigned int width, unsigned int height,
 	unsigned int sourcePitch, unsigned int destPitch, bool bInvert) const
 {
-	if (!rgba_source || !bgra_dest)
-		return;
-
-	for (unsigned int y = 0; y < height; y++) {
-
-		// Start of buffers
-		auto source = static_cast<const unsigned __int32*>(rgba_source); // unsigned int = 4 bytes
-		auto dest = static_cast<unsigned __int32*>(bgra_dest);
-		if (!source || !dest)
-			return;
-
-		// Cast first to avoid warning C26451: Arithmetic overflow
-		unsigned long YxDP = (unsigned long)(y * destPitch / 4);
-
-		// Increment to current line.
-		// Pitch is line length in bytes.
-		// Divide by 4 to get the line width in rgba pixels.
-		if (bInvert) {
-			source += (unsigned long)((height - 1 - y) * sourcePitch / 4);
-			dest += YxDP; // dest is not inverted
-		}
-		else {
-			source += (unsigned long)(y * sourcePitch / 4);
-			dest += YxDP;
-		}
-		// Copy the line
-		if ((width % 16) == 0) { // 16 byte aligned width
-			if (m_bSSE2 && m_bSSSE3) // SSE3 available
-				rgba_bgra_sse3(source, dest, width, 1, bInvert);
-			else if (m_bSSE2) // SSE2 available
-				rgba_bgra_sse2(source, dest, width, 1, bInvert);
-		}
-		else {
-			rgba_bgra(source, dest, width, 1, bInvert);
-		}
-
-	}
+	spoutSwizzle<spoutRGBA, spoutBGRA>(rgba_source, bgra_dest, width, height, sourcePitch, destPitch, bInvert, m_bSSSE3, m_bAVX2);
 }
 
 //---------------------------------------------------------
@@ -566,37 +677,28 @@ void spoutCopy::rgba2rgb(const void* rgba_source, void* rgb_dest,
 	if (!rgb || !rgba)
 		return;
 
-	//
-	// SSE3 copy
-	// No mirror option, image size 16 bit byte aligned, SSE3 intrinsics support
-	//
-	// Timing tests show more than twice as fast
-	// (Intel(R) Core(TM) i7-3770K CPU @ 3.50GHz)
-	//
-	// SSE
-	//   1280x720    1.6 msec
-	//   1920x1080   3.7 msec
-	//   3840x2160  14.0 msec
-	// Byte copy
-	//   1280x720    4.0 msec
-	//   1920x1080   9.3 msec
-	//   3840x2160  35.9 msec
-	//
 	unsigned int pitch = rgba_pitch;
 	if(pitch == 0) pitch = width*4;
-	if (!bMirror && width >= 320 && (width % 16) == 0 && m_bSSE3) {
-		rgba_to_rgb_sse3(rgba_source, rgb_dest, width, height, pitch, bInvert, bSwapRB);
+
+	//
+	// No mirror option, swizzle kernel
+	//
+	if (!bMirror) {
+		if (bSwapRB)
+			spoutSwizzle<spoutRGBA, spoutBGR>(rgba_source, rgb_dest, width, height, pitch, 0, bInvert, m_bSSSE3, m_bAVX2);
+		else
+			spoutSwizzle<spoutRGBA, spoutRGB>(rgba_source, rgb_dest, width, height, pitch, 0, bInvert, m_bSSSE3, m_bAVX2);
 		return;
 	}
 
 	//
-	// Byte pointer copy
+	// Byte pointer copy for mirror
 	//
 
 	// RGB dest does not have padding
 	uint64_t rgbsize = (uint64_t)width * (uint64_t)height * 3;
 	uint64_t rgbpitch = (uint64_t)width * 3;
-	const uint64_t rgba_padding = (uint64_t)rgba_pitch-((uint64_t)width * 4);
+	const uint64_t rgba_padding = (uint64_t)pitch-((uint64_t)width * 4);
 
 	// RGBA source may have padding 
 	// Dest and source must be the same dimensions otherwise
@@ -615,18 +717,10 @@ void spoutCopy::rgba2rgb(const void* rgba_source, void* rgb_dest,
 	unsigned int z = 0;
 	for (unsigned int y = 0; y < height; y++) {
 		for (unsigned int x = 0; x < width; x++) {
-			if (bMirror) {
-				z = (width - x - 1)*3;
-				*(rgb + z + ir) = *(rgba + 0); // red
-				*(rgb + z + ig) = *(rgba + 1); // grn
-				*(rgb + z + ib) = *(rgba + 2); // blu
-			}
-			else {
-				z = x * 3;
-				*(rgb + z + ir) = *(rgba + 0); // red
-				*(rgb + z + ig) = *(rgba + 1); // grn
-				*(rgb + z + ib) = *(rgba + 2); // blu
-			}
+			z = (width - x - 1)*3;
+			*(rgb + z + ir) = *(rgba + 0); // red
+			*(rgb + z + ig) = *(rgba + 1); // grn
+			*(rgb + z + ib) = *(rgba + 2); // blu
 			rgba += 4;
 		}
 		rgb += (uint64_t)width * 3;
@@ -644,34 +738,7 @@ void spoutCopy::rgba2rgb(const void* rgba_source, void* rgb_dest,
 //
 void spoutCopy::rgb2rgba(const void *rgb_source, void *rgba_dest, unsigned int width, unsigned int height, bool bInvert) const
 {
-	// Start of buffers
-	auto rgb = static_cast<const unsigned char*>(rgb_source); // RGB
-	auto rgba = static_cast<unsigned char*>(rgba_dest); // RGBA
-	if (!rgb || !rgba)
-		return;
-
-	const uint64_t rgbsize  = (uint64_t)width * (uint64_t)height * 3;
-	const uint64_t rgbpitch = (uint64_t)width * 3;
-
-	if (bInvert) {
-		rgb += rgbsize; // end of rgb buffer
-		rgb -= rgbpitch; // beginning of the last rgb line
-	}
-
-	for (unsigned int y = 0; y < height; y++) {
-		for (unsigned int x = 0; x < width; x++) {
-			// rgb source - rgba dest
-			*(rgba + 0) = *(rgb + 0); // red
-			*(rgba + 1) = *(rgb + 1); // grn
-			*(rgba + 2) = *(rgb + 2); // blu
-			*(rgba + 3) = (unsigned char)255; // alpha
-			rgb += 3;
-			rgba += 4;
-		}
-		if (bInvert)
-			rgb -= rgbpitch * 2L; // move up a line for invert
-	}
-
+	spoutSwizzle<spoutRGB, spoutRGBA>(rgb_source, rgba_dest, width, height, 0, 0, bInvert, m_bSSSE3, m_bAVX2);
 } // end rgb2rgba
 
 //---------------------------------------------------------
@@ -681,40 +748,8 @@ void spoutCopy::rgb2rgba(const void *rgb_source, void *rgba_dest,
 	unsigned int width, unsigned int height,
 	unsigned int dest_pitch, bool bInvert) const
 {
-	// Start of buffers
-	auto rgb = static_cast<const unsigned char*>(rgb_source); // rgb/bgr
-	auto rgba = static_cast<unsigned char*>(rgba_dest); // rgba/bgra
-	if (!rgb || !rgba)
-		return;
-
 	// RGB source does not have padding
-	const uint64_t rgbsize      = (uint64_t )width * (uint64_t)height * 3;
-	const uint64_t rgbpitch     = (uint64_t)width * 3;
-	uint64_t rgba_padding = (uint64_t)dest_pitch - ((uint64_t)width * 4);
-
-	// RGBA dest may have padding 
-	// Dest and source must be the same dimensions otherwise
-
-	if (bInvert) {
-		rgb += rgbsize; // end of rgb buffer
-		rgb -= rgbpitch; // beginning of the last rgb line
-	}
-
-	for (unsigned int y = 0; y < height; y++) {
-		for (unsigned int x = 0; x < width; x++) {
-			*(rgba + 0) = *(rgb + 0); // red
-			*(rgba + 1) = *(rgb + 1); // grn
-			*(rgba + 2) = *(rgb + 2); // blu
-			*(rgba + 3) = (unsigned char)255; // alpha
-			rgb += 3;
-			rgba += 4;
-		}
-		rgba += rgba_padding;
-
-		if (bInvert)
-			rgb -= rgbpitch * 2; // move up a line for invert
-	}
-
+	spoutSwizzle<spoutRGB, spoutRGBA>(rgb_source, rgba_dest, width, height, 0, dest_pitch, bInvert, m_bSSSE3, m_bAVX2);
 } // end rgb2rgba
 
 //---------------------------------------------------------
@@ -722,34 +757,7 @@ void spoutCopy::rgb2rgba(const void *rgb_source, void *rgba_dest,
 //
 void spoutCopy::bgr2rgba(const void *bgr_source, void *rgba_dest, unsigned int width, unsigned int height, bool bInvert) const
 {
-	// Start of buffers
-	auto bgr = static_cast<const unsigned char*>(bgr_source); // BGR
-	auto rgba = static_cast<unsigned char*>(rgba_dest); // RGBA
-	if (!bgr || !rgba)
-		return;
-
-	const uint64_t bgrsize = (uint64_t)width * (uint64_t)height * 3;
-	const uint64_t bgrpitch = (uint64_t)width * 3;
-
-	if (bInvert) {
-		bgr += bgrsize; // end of rgb buffer
-		bgr -= bgrpitch; // beginning of the last rgb line
-	}
-
-	for (unsigned int y = 0; y < height; y++) {
-		for (unsigned int x = 0; x < width; x++) {
-			// bgr source - rgba dest
-			*(rgba + 0) = *(bgr + 2); // red
-			*(rgba + 1) = *(bgr + 1); // grn
-			*(rgba + 2) = *(bgr + 0); // blu
-			*(rgba + 3) = (unsigned char)255; // alpha
-			bgr += 3;
-			rgba += 4;
-		}
-		if (bInvert)
-			bgr -= bgrpitch * 2; // move up a line for invert
-	}
-
+	spoutSwizzle<spoutBGR, spoutRGBA>(bgr_source, rgba_dest, width, height, 0, 0, bInvert, m_bSSSE3, m_bAVX2);
 } // end bgr2rgba
 
 //---------------------------------------------------------
@@ -759,40 +767,8 @@ void spoutCopy::bgr2rgba(const void *bgr_source, void *rgba_dest,
 	unsigned int width, unsigned int height,
 	unsigned int dest_pitch, bool bInvert) const
 {
-	// Start of buffers
-	auto bgr = static_cast<const unsigned char*>(bgr_source); // rgb/bgr
-	auto rgba = static_cast<unsigned char*>(rgba_dest); // rgba/bgra
-	if (!bgr || !rgba)
-		return;
-
-	// BGR buffer dest does not have padding
-	const uint64_t bgrsize = (uint64_t)width * (uint64_t)height * 3;
-	const uint64_t bgrpitch = (uint64_t)width * 3;
-	const uint64_t rgba_padding = (uint64_t)dest_pitch - ((uint64_t)width * 4);
-
-	// RGBA dest may have padding 
-	// Dest and source must be the same dimensions otherwise
-
-	if (bInvert) {
-		bgr += bgrsize; // end of rgb buffer
-		bgr -= bgrpitch; // beginning of the last rgb line
-	}
-
-	for (unsigned int y = 0; y < height; y++) {
-		for (unsigned int x = 0; x < width; x++) {
-			*(rgba + 0) = *(bgr + 0); // blu
-			*(rgba + 1) = *(bgr + 1); // grn
-			*(rgba + 2) = *(bgr + 2); // red
-			*(rgba + 3) = (unsigned char)255; // alpha
-			bgr += 3;
-			rgba += 4;
-		}
-		rgba += rgba_padding;
-
-		if (bInvert)
-			bgr -= bgrpitch * 2; // move up a line for invert
-	}
-
+	// BGR source does not have padding
+	spoutSwizzle<spoutBGR, spoutRGBA>(bgr_source, rgba_dest, width, height, 0, dest_pitch, bInvert, m_bSSSE3, m_bAVX2);
 } // end bgr2rgba with dest pitch
 
 //---------------------------------------------------------
@@ -800,34 +776,7 @@ void spoutCopy::bgr2rgba(const void *bgr_source, void *rgba_dest,
 //
 void spoutCopy::rgb2bgra(const void *rgb_source, void *bgra_dest, unsigned int width, unsigned int height, bool bInvert) const
 {
-	// Start of buffers
-	auto rgb = static_cast<const unsigned char*>(rgb_source); // RGB
-	auto bgra = static_cast<unsigned char*>(bgra_dest); // BGRA
-	if (!rgb || !bgra)
-		return;
-
-	const uint64_t rgbsize = (uint64_t)width * (uint64_t)height * 3;
-	const uint64_t rgbpitch = (uint64_t)width * 3;
-
-	if (bInvert) {
-		rgb += rgbsize; // end of rgb buffer
-		rgb -= rgbpitch; // beginning of the last rgb line
-	}
-
-	for (unsigned int y = 0; y < height; y++) {
-		for (unsigned int x = 0; x < width; x++) {
-			// rgb source - bgra dest
-			*(bgra + 0) = *(rgb + 2); // blu
-			*(bgra + 1) = *(rgb + 1); // grn
-			*(bgra + 2) = *(rgb + 0); // red
-			*(bgra + 3) = (unsigned char)255; // alpha
-			rgb += 3;
-			bgra += 4;
-		}
-		if (bInvert)
-			rgb -= rgbpitch * 2; // move up a line for invert
-	}
-
+	spoutSwizzle<spoutRGB, spoutBGRA>(rgb_source, bgra_dest, width, height, 0, 0, bInvert, m_bSSSE3, m_bAVX2);
 } // end rgb2bgra
 
 //---------------------------------------------------------
@@ -837,128 +786,22 @@ void spoutCopy::rgb2bgra(const void *rgb_source, void *bgra_dest,
 	unsigned int width, unsigned int height,
 	unsigned int dest_pitch, bool bInvert) const
 {
-	// Start of buffers
-	auto rgb = static_cast<const unsigned char*>(rgb_source); // rgb/bgr
-	auto bgra = static_cast<unsigned char*>(bgra_dest); // rgba/bgra
-	if (!rgb || !bgra)
-		return;
-
 	// RGB source does not have padding
-	const uint64_t rgbsize = (uint64_t)width * (uint64_t)height * 3;
-	const uint64_t rgbpitch = (uint64_t)width * 3;
-	// BGRA dest may have padding 
-	uint64_t bgra_padding = (uint64_t)dest_pitch - ((uint64_t)width * 4);
-	// Dest and source must be the same dimensions otherwise
-
-	if (bInvert) {
-		rgb += rgbsize; // end of rgb buffer
-		rgb -= rgbpitch; // beginning of the last rgb line
-	}
-
-	for (unsigned int y = 0; y < height; y++) {
-		for (unsigned int x = 0; x < width; x++) {
-			*(bgra + 0) = *(rgb + 2); // blu
-			*(bgra + 1) = *(rgb + 1); // grn
-			*(bgra + 2) = *(rgb + 0); // red
-			*(bgra + 3) = (unsigned char)255; // alpha
-			rgb += 3;
-			bgra += 4;
-		}
-		bgra += bgra_padding;
-
-		if (bInvert)
-			rgb -= rgbpitch * 2; // move up a line for invert
-	}
-
+	spoutSwizzle<spoutRGB, spoutBGRA>(rgb_source, bgra_dest, width, height, 0, dest_pitch, bInvert, m_bSSSE3, m_bAVX2);
 } // end rgb2bgra
 
 
-// =====================================================================================
-//
-// Experimental
-// https://exchangetuts.com/fast-vectorized-conversion-from-rgb-to-bgra-1640844423877396
-// in and out must be 16-byte aligned
-// See also SIMD library
-// https://github.com/ermig1979/Simd
-//
-
 //---------------------------------------------------------
 // Function: rgb_to_bgrx_sse
-// Experimental pending testing
-// Single line function
+// Single line function. Buffers need not be aligned.
 void spoutCopy::rgb_to_bgrx_sse(unsigned int npixels, const void* rgb_source, void* bgrx_dest) const
 {
-	const __m128i* in_vec = static_cast<const __m128i*>(rgb_source);
-	__m128i* out_vec = static_cast<__m128i*>(bgrx_dest);
-
-	if (!in_vec || !out_vec)
-		return;
-
-	npixels /= 16;
-
-	while (npixels-- > 0) {
-
-		//             0  1  2  3  4  5  6  7  8  9  10 11 12 13 14 15
-		// in_vec[0]   Ra Ga Ba Rb Gb Bb Rc Gc Bc Rd Gd Bd Re Ge Be Rf
-		// in_vec[1]   Gf Bf Rg Gg Bg Rh Gh Bh Ri Gi Bi Rj Gj Bj Rk Gk
-		// in_vec[2]   Bk Rl Gl Bl Rm Gm Bm Rn Gn Bn Ro Go Bo Rp Gp Bp
-		//
-
-		__m128i in1={};
-		__m128i in2={};
-		__m128i in3={};
-		__m128i out={};
-
-		in1 = in_vec[0];
-
-		out = _mm_shuffle_epi8(in1,
-			_mm_set_epi8('\xff', 9, 10, 11, '\xff', 6, 7, 8, '\xff', 3, 4, 5, '\xff', 0, 1, 2));
-		out = _mm_or_si128(out,
-			_mm_set_epi8('\xff', 0, 0, 0, '\xff', 0, 0, 0, '\xff', 0, 0, 0, '\xff', 0, 0, 0));
-		out_vec[0] = out;
-
-		in2 = in_vec[1];
-
-		in1 = _mm_and_si128(in1,
-			_mm_set_epi8('\xff', '\xff', '\xff', '\xff', '\xff', '\xff', '\xff', '\xff', 0, 0, 0, 0, 0, 0, 0, 0));
-		out = _mm_and_si128(in2,
-			_mm_set_epi8(0, 0, 0, 0, 0, 0, 0, 0, '\xff', '\xff', '\xff', '\xff', '\xff', '\xff', '\xff', '\xff'));
-		out = _mm_or_si128(out, in1);
-		out = _mm_shuffle_epi8(out,
-			_mm_set_epi8('\xff', 5, 6, 7, '\xff', 2, 3, 4, '\xff', 15, 0, 1, '\xff', 12, 13, 14));
-		out = _mm_or_si128(out,
-			_mm_set_epi8('\xff', 0, 0, 0, '\xff', 0, 0, 0, '\xff', 0, 0, 0, '\xff', 0, 0, 0));
-		out_vec[1] = out;
-
-		in3 = in_vec[2];
-		in_vec += 3;
-
-		in2 = _mm_and_si128(in2,
-			_mm_set_epi8('\xff', '\xff', '\xff', '\xff', '\xff', '\xff', '\xff', '\xff', 0, 0, 0, 0, 0, 0, 0, 0));
-		out = _mm_and_si128(in3,
-			_mm_set_epi8(0, 0, 0, 0, 0, 0, 0, 0, '\xff', '\xff', '\xff', '\xff', '\xff', '\xff', '\xff', '\xff'));
-		out = _mm_or_si128(out, in2);
-		out = _mm_shuffle_epi8(out,
-			_mm_set_epi8('\xff', 1, 2, 3, '\xff', 14, 15, 0, '\xff', 11, 12, 13, '\xff', 8, 9, 10));
-		out = _mm_or_si128(out,
-			_mm_set_epi8('\xff', 0, 0, 0, '\xff', 0, 0, 0, '\xff', 0, 0, 0, '\xff', 0, 0, 0));
-		out_vec[2] = out;
-
-		out = _mm_shuffle_epi8(in3,
-			_mm_set_epi8('\xff', 13, 14, 15, '\xff', 10, 11, 12, '\xff', 7, 8, 9, '\xff', 4, 5, 6));
-		out = _mm_or_si128(out,
-			_mm_set_epi8('\xff', 0, 0, 0, '\xff', 0, 0, 0, '\xff', 0, 0, 0, '\xff', 0, 0, 0));
-		out_vec[3] = out;
-
-		out_vec += 4;
-	}
-
+	spoutSwizzle<spoutRGB, spoutBGRA>(rgb_source, bgrx_dest, npixels, 1, 0, 0, false, m_bSSSE3, m_bAVX2);
 } // end rgb_to_bgrx_sse
 
 
 //---------------------------------------------------------
-// Function: rgb_to_bgra_sse
-// Experimental pending testing
+// Function: rgb_to_bgra_sse3
 // Full image height
 void spoutCopy::rgb_to_bgra_sse3 (
 	void* rgb_source, 
@@ -966,200 +809,21 @@ void spoutCopy::rgb_to_bgra_sse3 (
 	unsigned int width, 
 	unsigned int height) const
 {
-	if ((width % 16) != 0)
-		return;
-
-	auto rgb = static_cast<const unsigned char*>(rgb_source); // rgb/bgr
-	auto rgba = static_cast<unsigned char*>(rgba_dest); // rgba/bgra
-	if (!rgb || !rgba)
-		return;
-
-	for (unsigned int y = 0; y < height-2; y++) {
-		rgb_to_bgrx_sse(width*3, rgb, rgba);
-		rgb  += width*3;
-		rgba += width*4;
-	}
-
+	spoutSwizzle<spoutRGB, spoutBGRA>(rgb_source, rgba_dest, width, height, 0, 0, false, m_bSSSE3, m_bAVX2);
 } // end rgb_to_bgra_sse3
 
-//
-// =====================================================================================
-
 
 //---------------------------------------------------------
 // Function: rgba_to_rgb_sse3
-//
+// Any width, the name is kept for compatibility
 void spoutCopy::rgba_to_rgb_sse3(const void* rgba_source, void* rgb_dest,
 	unsigned int width, unsigned int height, unsigned int rgba_pitch,
 	bool bInvert, bool bSwapRB) const
 {
-	const __m128i* in_vec = static_cast<const __m128i*>(rgba_source); // rgba
-	__m128i* out_vec = static_cast<__m128i*>(rgb_dest); // rgb
-
-	if (!out_vec || !in_vec)
-		return;
-
-	// RGB dest does not have padding
-	unsigned int rgbsize = width*height*3;
-	unsigned int rgbpitch = width*3;
-
-	// Dest and source must be the same dimensions otherwise
-	unsigned int rgba_padding = rgba_pitch-width*4; // byte line padding
-
-	// Flip image option, move to the beginning of the last rgb line
-	if (bInvert) {
-		out_vec += rgbsize/16; // end of rgb buffer
-		out_vec -= rgbpitch/16; // beginning of the last rgb line
-	}
-
-	unsigned int w = width/16;
-	for (unsigned int y = 0; y < height; y++) {
-
-		while (w-- > 0) {
-
-			__m128i in0={};
-			__m128i in1={};
-			__m128i in2={};
-			__m128i in3={};
-
-			__m128i out0={};
-			__m128i out1={};
-
-			in0 = in_vec[0];   // First 128 bits RGBA
-			in1 = in_vec[1];   // Second 128 bits RGBA
-			in2 = in_vec[2];   // Third 128 bits RGBA
-			in3 = in_vec[3];   // Fourth 128 bits RGBA
-
-			if (!bSwapRB) {
-				
-				// RGBA > RGB
-
-				//
-				// RGBA in 4x16 = 64 bytes (4 pixels at 4 bytes each = 16 bytes)
-				//               0  1  2  3  4  5  6  7  8  9 10 11 12 13 14 15
-				// in_vec[0]    Ra Ga Ba Xa Rb Gb Bb Xb Rc Gc Bc Xc Rd Gd Bd Xd
-				// in_vec[1]    Re Ge Be Xe Rf Gf Bf Xf Rg Gg Bg Xg Rh Gh Bh Xh
-				// in_vec[2]    Ri Gi Bi Xi Rj Gj Bj Xj Rk Gk Bk Xk Rl Gl Bl Xl
-				// in_vec[3]    Rm Gm Bm Xm Rn Gn Bn Xn Ro Go Bo Xo Rp Gp Bp Xp
-
-				//
-				// RGB out  3x16 = 48 bytes (4 pixels at 3 bytes each = 12 bytes)
-				//
-				// out_vec[0]    Rf Be Ge Re Bd Gd Rd Bc Gc Rc Bb Gb Rb Ba Ga Ra
-				//                4  2  1  0 14 13 12 10  9  8  6  5  4  2  1  0
-				//                 in_vec[1] |            in_vec[0]            |
-				// out_vec[1]    Gk Rk Bj Gj Rj Bi Gi Ri Bh Gh Rh Bg Gg Rg Bf Gf
-				//                9  8  6  5  4  2  1  0 14 13 12 10  9  8  6  5
-				//                        in_vec[2]       |     in_vec[1]
-				// out_vec[2]    Bp Gp Rp Bo Go Ro Bn Gn Rn Bm Gm Rm Bl Gl Rl Bk
-				//               14 13 12 10  9  8  6  5  4  2  1  0 14 13 12 10  
-				//                        in_vec[3]                   | in_vec[2]
-
-				// First 16 RGB bytes
-				// out_vec[0]    Rf Be Ge Re Bd Gd Rd Bc Gc Rc Bb Gb Rb Ba Ga Ra
-				//                4  2  1  0 14 13 12 10  9  8  6  5  4  2  1  0
-				//                 in_vec[1] |            in_vec[0]            |
-				out0 = _mm_shuffle_epi8(in0,
-					_mm_set_epi8('\xff', '\xff', '\xff', '\xff', 14, 13, 12, 10, 9, 8, 6, 5, 4, 2, 1, 0));
-				out1 = _mm_shuffle_epi8(in1,
-					_mm_set_epi8(4, 2, 1, 0, '\xff', '\xff', '\xff', '\xff', '\xff', '\xff', '\xff', '\xff', '\xff', '\xff', '\xff', '\xff'));
-				out_vec[0] = _mm_or_si128(out0, out1);
-
-				// Second 16 RGB bytes
-				// out_vec[1]    Gk Rk Bj Gj Rj Bi Gi Ri Bh Gh Rh Bg Gg Rg Bf Gf
-				//                9  8  6  5  4  2  1  0 14 13 12 10  9  8  6  5
-				//                        in_vec[2]       |     in_vec[1]
-				out0 = _mm_shuffle_epi8(in1,
-					_mm_set_epi8('\xff', '\xff', '\xff', '\xff', '\xff', '\xff', '\xff', '\xff', 14, 13, 12, 10, 9, 8, 6, 5));
-				out1 = _mm_shuffle_epi8(in2,
-					_mm_set_epi8(9, 8, 6, 5, 4, 2, 1, 0, '\xff', '\xff', '\xff', '\xff', '\xff', '\xff', '\xff', '\xff'));
-				out_vec[1] = _mm_or_si128(out0, out1);
-
-				// Third 16 RGB bytes
-				// out_vec[2]    Bp Gp Rp Bo Go Ro Bn Gn Rn Bm Gm Rm Bl Gl Rl Bk
-				//               14 13 12 10  9  8  6  5  4  2  1  0 14 13 12 10  
-				//                        in_vec[3]                   | in_vec[2]
-				out0 = _mm_shuffle_epi8(in2,
-					_mm_set_epi8('\xff', '\xff', '\xff', '\xff', '\xff', '\xff', '\xff', '\xff', '\xff', '\xff', '\xff', '\xff', 14, 13, 12, 10));
-				out1 = _mm_shuffle_epi8(in3,
-					_mm_set_epi8(14, 13, 12, 10, 9, 8, 6, 5, 4, 2, 1, 0, '\xff', '\xff', '\xff', '\xff'));
-				out_vec[2] = _mm_or_si128(out0, out1);
-			}  // end RGBA >RGB
-			else {
-
-				// RGBA > BGR
-
-				//
-				// RGBA in 4x16 = 64 bytes (4 pixels at 4 bytes each = 16 bytes)
-				//               0  1  2  3  4  5  6  7  8  9 10 11 12 13 14 15
-				// in_vec[0]    Ra Ga Ba Xa Rb Gb Bb Xb Rc Gc Bc Xc Rd Gd Bd Xd
-				// in_vec[1]    Re Ge Be Xe Rf Gf Bf Xf Rg Gg Bg Xg Rh Gh Bh Xh
-				// in_vec[2]    Ri Gi Bi Xi Rj Gj Bj Xj Rk Gk Bk Xk Rl Gl Bl Xl
-				// in_vec[3]    Rm Gm Bm Xm Rn Gn Bn Xn Ro Go Bo Xo Rp Gp Bp Xp
-
-				//
-				// BGR out  3x16 = 48 bytes (4 pixels at 3 bytes each = 12 bytes)
-				//
-				// out_vec[0]    Bf Re Ge Be Rd Gd Bd Rc Gc Bc Rb Gb Bb Ra Ga Ba
-				//                6  0  1  2 12 13 14  8  9 10  4  5  6  0  1  2
-				//                 in_vec[1] |            in_vec[0]            |
-				// out_vec[1]    Gk Bk Rj Gj Bj Ri Gi Bi Rh Gh Bh Rg Gg Bg Rf Gf
-				//                9 10  4  5  6  0  1  2 12 13 14  8  9 10  4  5
-				//                        in_vec[2]       |     in_vec[1]
-				// out_vec[2]    Rp Gp Bp Ro Go Bo Rn Gn Bn Rm Gm Bm Rl Gl Bl Rk
-				//               12 13 14  8  9 10  4  5  6  0  1  2 12 13 14  8  
-				//                        in_vec[3]                   | in_vec[2]
-
-				// First 16 BGR bytes
-				// out_vec[0]    Rf Be Ge Re Bd Gd Rd Bc Gc Rc Bb Gb Rb Ba Ga Ra
-				//                6  0  1  2 12 13 14  8  9 10  4  5  6  0  1  2
-				//                 in_vec[1] |            in_vec[0]            |
-				out0 = _mm_shuffle_epi8(in0,
-					_mm_set_epi8('\xff', '\xff', '\xff', '\xff', 12, 13, 14, 8, 9, 10, 4, 5, 6, 0, 1, 2));
-				out1 = _mm_shuffle_epi8(in1,
-					_mm_set_epi8(6, 0, 1, 2, '\xff', '\xff', '\xff', '\xff', '\xff', '\xff', '\xff', '\xff', '\xff', '\xff', '\xff', '\xff'));
-				out_vec[0] = _mm_or_si128(out0, out1);
-
-				// Second 16 BGR bytes
-				// out_vec[1]    Gk Rk Bj Gj Rj Bi Gi Ri Bh Gh Rh Bg Gg Rg Bf Gf
-				//                9 10  4  5  6  0  1  2 12 13 14  8  9 10  4  5
-				//                        in_vec[2]      |     in_vec[1]
-				out0 = _mm_shuffle_epi8(in1,
-					_mm_set_epi8('\xff', '\xff', '\xff', '\xff', '\xff', '\xff', '\xff', '\xff', 12, 13, 14, 8, 9, 10, 4, 5));
-				out1 = _mm_shuffle_epi8(in2,
-					_mm_set_epi8(9, 10, 4, 5, 6, 0, 1, 2, '\xff', '\xff', '\xff', '\xff', '\xff', '\xff', '\xff', '\xff'));
-				out_vec[1] = _mm_or_si128(out0, out1);
-
-				// Third 16 BGR bytes
-				// out_vec[2]    Bp Gp Rp Bo Go Ro Bn Gn Rn Bm Gm Rm Bl Gl Rl Bk
-				//               12 13 14  8  9 10  4  5  6  0  1  2 12 13 14  8  
-				//                        in_vec[3]                  | in_vec[2]
-				out0 = _mm_shuffle_epi8(in2,
-					_mm_set_epi8('\xff', '\xff', '\xff', '\xff', '\xff', '\xff', '\xff', '\xff', '\xff', '\xff', '\xff', '\xff', 12, 13, 14, 8));
-				out1 = _mm_shuffle_epi8(in3,
-					_mm_set_epi8(12, 13, 14, 8, 9, 10, 4, 5, 6, 0, 1, 2, '\xff', '\xff', '\xff', '\xff'));
-				out_vec[2] = _mm_or_si128(out0, out1);
-
-			} // end RGBA > BGR
-
-			in_vec  += 4; // RGBA 4x16
-			out_vec += 3; // RGB  3x16
-
-		} // done the line
-
-		// Reset width
-		w = width/16;
-		
-		// Allow for padding at the end of the rgba source line
-		in_vec += rgba_padding/16;
-
-		// move up a line for invert
-		if (bInvert) {
-			out_vec -= w*3*2;
-		}
-
-	}
-
+	if (bSwapRB)
+		spoutSwizzle<spoutRGBA, spoutBGR>(rgba_source, rgb_dest, width, height, rgba_pitch, 0, bInvert, m_bSSSE3, m_bAVX2);
+	else
+		spoutSwizzle<spoutRGBA, spoutRGB>(rgba_source, rgb_dest, width, height, rgba_pitch, 0, bInvert, m_bSSSE3, m_bAVX2);
 } // end rgba_to_rgb_sse
 
 
@@ -1168,34 +832,7 @@ void spoutCopy::rgba_to_rgb_sse3(const void* rgba_source, void* rgb_dest,
 //
 void spoutCopy::bgr2bgra(const void *bgr_source, void *bgra_dest, unsigned int width, unsigned int height, bool bInvert) const
 {
-	// Start of buffers
-	auto bgr = static_cast<const unsigned char*>(bgr_source); // BGR
-	auto bgra = static_cast<unsigned char*>(bgra_dest); // BGRA
-	if (!bgr || !bgra)
-		return;
-
-	const uint64_t bgrsize = (uint64_t)width * (uint64_t)height * 3;
-	const uint64_t bgrpitch = (uint64_t)width * 3;
-
-	if (bInvert) {
-		bgr += bgrsize; // end of rgb buffer
-		bgr -= bgrpitch; // beginning of the last rgb line
-	}
-
-	for (unsigned int y = 0; y < height; y++) {
-		for (unsigned int x = 0; x < width; x++) {
-			// bgr source - bgra dest
-			*(bgra + 0) = *(bgr + 0); // blu
-			*(bgra + 1) = *(bgr + 1); // grn
-			*(bgra + 2) = *(bgr + 2); // red
-			*(bgra + 3) = (unsigned char)255; // alpha
-			bgr += 3;
-			bgra += 4;
-		}
-		if (bInvert)
-			bgr -= bgrpitch * 2; // move up a line for invert
-	}
-
+	spoutSwizzle<spoutBGR, spoutBGRA>(bgr_source, bgra_dest, width, height, 0, 0, bInvert, m_bSSSE3, m_bAVX2);
 } // end bgr2bgra
 
 //---------------------------------------------------------
@@ -1203,34 +840,7 @@ void spoutCopy::bgr2bgra(const void *bgr_source, void *bgra_dest, unsigned int w
 //
 void spoutCopy::rgba2bgr(const void *rgba_source, void *bgr_dest, unsigned int width, unsigned int height, bool bInvert) const
 {
-
-	// Start of buffers
-	auto rgba = static_cast<const unsigned char*>(rgba_source); // RGBA
-	auto bgr = static_cast<unsigned char*>(bgr_dest); // BGR
-	if (!rgba || !bgr)
-		return;
-
-	uint64_t bgrsize = (uint64_t)width * (uint64_t)height * 3;
-	uint64_t bgrpitch = (uint64_t)width * 3;
-
-	if (bInvert) {
-		bgr += bgrsize; // end of rgb buffer
-		bgr -= bgrpitch; // beginning of the last bgr line
-	}
-
-	for (unsigned int y = 0; y < height; y++) {
-		for (unsigned int x = 0; x < width; x++) {
-			// rgba source - bgr dest
-			*(bgr + 0) = *(rgba + 2); // blu
-			*(bgr + 1) = *(rgba + 1); // grn
-			*(bgr + 2) = *(rgba + 0); // red
-			bgr += 3;
-			rgba += 4;
-		}
-		if (bInvert)
-			bgr -= bgrpitch * 2; // move up a line for invert
-	}
-
+	spoutSwizzle<spoutRGBA, spoutBGR>(rgba_source, bgr_dest, width, height, 0, 0, bInvert, m_bSSSE3, m_bAVX2);
 } // end rgba2bgr
 
 //---------------------------------------------------------
@@ -1240,38 +850,8 @@ void spoutCopy::rgba2bgr(const void *rgba_source, void *bgr_dest,
 	unsigned int width, unsigned int height,
 	unsigned int rgba_pitch, bool bInvert) const
 {
-	// Start of buffers
-	auto rgba = static_cast<const unsigned char*>(rgba_source); // rgba/bgra
-	auto bgr = static_cast<unsigned char*>(bgr_dest); // rgb/bgr
-	if (!rgba || !bgr)
-		return;
-
-	// RGB dest does not have padding
-	uint64_t rgbsize = (uint64_t)width * (uint64_t)height * 3;
-	uint64_t rgbpitch = (uint64_t)width * 3;
-	const uint64_t rgba_padding = (uint64_t)rgba_pitch - ((uint64_t)width * 4);
-
-	// RGBA source may have padding 
-	// Dest and source must be the same dimensions otherwise
-	if (bInvert) {
-		bgr += rgbsize; // end of rgb buffer
-		bgr -= rgbpitch; // beginning of the last rgb line
-	}
-
-	for (unsigned int y = 0; y < height; y++) {
-		for (unsigned int x = 0; x < width; x++) {
-			*(bgr + 2) = *(rgba + 0); // red
-			*(bgr + 1) = *(rgba + 1); // grn
-			*(bgr + 0) = *(rgba + 2); // blu
-			bgr += 3;
-			rgba += 4;
-		}
-		rgba += rgba_padding;
-
-		if (bInvert)
-			bgr -= rgbpitch * 2; // move up a line for invert
-	}
-
+	// BGR dest does not have padding
+	spoutSwizzle<spoutRGBA, spoutBGR>(rgba_source, bgr_dest, width, height, rgba_pitch, 0, bInvert, m_bSSSE3, m_bAVX2);
 } // end rgba2bgr
 
 //---------------------------------------------------------
@@ -1369,69 +949,454 @@ void spoutCopy::rgba2bgrResample(const void* source, void* dest,
 //
 void spoutCopy::bgra2rgb(const void *bgra_source, void *rgb_dest, unsigned int width, unsigned int height, bool bInvert) const
 {
+	spoutSwizzle<spoutBGRA, spoutRGB>(bgra_source, rgb_dest, width, height, 0, 0, bInvert, m_bSSSE3, m_bAVX2);
+} // end bgra2rgb
 
-	// Start of buffers
-	auto bgra = static_cast<const unsigned char*>(bgra_source); // BGRA
-	auto rgb = static_cast<unsigned char*>(rgb_dest); // RGB
-	if (!bgra || !rgb)
-		return;
+//---------------------------------------------------------
+// Function: bgra2bgr
+//
+void spoutCopy::bgra2bgr(const void *bgra_source, void *bgr_dest, unsigned int width, unsigned int height, bool bInvert) const
+{
+	spoutSwizzle<spoutBGRA, spoutBGR>(bgra_source, bgr_dest, width, height, 0, 0, bInvert, m_bSSSE3, m_bAVX2);
+} // end bgra2bgr
 
-	uint64_t rgbsize = (uint64_t)width * (uint64_t)height * 3;
-	uint64_t rgbpitch = (uint64_t)width * 3;
 
-	if (bInvert) {
-		rgb += rgbsize; // end of rgb buffer
-		rgb -= rgbpitch; // beginning of the last rgb line
+//
+// Float RGBA to YUV
+//
+// Each line is converted in blocks of SPOUT_YUV_BLOCK pixels.
+// Luma is rounded per pixel and chroma is averaged over 2 pixels (4:2:2)
+// or 2x2 pixels (4:2:0) before rounding. The block size is a multiple
+// of the 6 pixel v210 group and of the 8 pixels converted at once with AVX2.
+//
+// The matrix step writes luma and unrounded chroma of the block, which stay
+// in the L1 cache, and the packing step reads them back into the destination.
+// With AVX2 both steps take 16 pixels at a time, except the packing of v210.
+//
+#define SPOUT_YUV_BLOCK 192
+
+struct spoutYUVCoefficients {
+	float kr, kg, kb; // luma weights
+	float ys, yo;     // luma scale and offset in code values
+	float cbs, crs;   // chroma scales in code values
+	float co;         // chroma offset
+	float max;        // largest code value
+};
+
+static void GetYUVCoefficients(bool bBT2020, bool bFullRange, int bits, spoutYUVCoefficients &k)
+{
+	const float kr = bBT2020 ? 0.2627f : 0.2126f;
+	const float kb = bBT2020 ? 0.0593f : 0.0722f;
+	const float unit = static_cast<float>(1 << (bits - 8)); // 8 bit code value step
+	float cs = 0.0f;
+
+	k.kr = kr;
+	k.kb = kb;
+	k.kg = 1.0f - kr - kb;
+	k.max = static_cast<float>((1 << bits) - 1);
+	if (bFullRange) {
+		k.ys = k.max;
+		k.yo = 0.0f;
+		cs = k.max;
+	}
+	else {
+		k.ys = 219.0f*unit;
+		k.yo = 16.0f*unit;
+		cs = 224.0f*unit;
+	}
+	k.co = 128.0f*unit;
+	k.cbs = cs/(2.0f*(1.0f - kb));
+	k.crs = cs/(2.0f*(1.0f - kr));
+}
+
+// Clamp and round a code value. NaN goes to 0.
+static inline uint16_t yuv_round(float v, float max)
+{
+	if (!(v > 0.0f)) return 0;
+	if (v > max) v = max;
+	return static_cast<uint16_t>(v + 0.5f);
+}
+
+// Luma code values and unrounded chroma code values of n pixels
+static void yuv_line(const float* rgba, unsigned int n, const spoutYUVCoefficients &k,
+	uint16_t* Y, float* Cb, float* Cr)
+{
+	for (unsigned int i = 0; i < n; i++) {
+		const float r = rgba[i*4 + 0];
+		const float g = rgba[i*4 + 1];
+		const float b = rgba[i*4 + 2];
+		const float y = k.kr*r + k.kg*g + k.kb*b;
+		Y[i] = yuv_round(y*k.ys + k.yo, k.max);
+		Cb[i] = (b - y)*k.cbs + k.co;
+		Cr[i] = (r - y)*k.crs + k.co;
 	}
+}
 
-	for (unsigned int y = 0; y < height; y++) {
-		for (unsigned int x = 0; x < width; x++) {
-			// bgra source - rgb dest
-			*(rgb + 0) = *(bgra + 2); // red
-			*(rgb + 1) = *(bgra + 1); // grn
-			*(rgb + 2) = *(bgra + 0); // blu
-			rgb += 3;
-			bgra += 4;
+#ifndef _M_ARM64
+// yuv_line for 8 pixels at a time
+SPOUT_TARGET_AVX2 static void yuv_line_avx2(const float* rgba, unsigned int n, const spoutYUVCoefficients &k,
+	uint16_t* Y, float* Cb, float* Cr)
+{
+	const __m256 kr = _mm256_set1_ps(k.kr);
+	const __m256 kg = _mm256_set1_ps(k.kg);
+	const __m256 kb = _mm256_set1_ps(k.kb);
+	const __m256 ys = _mm256_set1_ps(k.ys);
+	const __m256 yo = _mm256_set1_ps(k.yo);
+	const __m256 cbs = _mm256_set1_ps(k.cbs);
+	const __m256 crs = _mm256_set1_ps(k.crs);
+	const __m256 co = _mm256_set1_ps(k.co);
+	const __m256 max = _mm256_set1_ps(k.max);
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 half = _mm256_set1_ps(0.5f);
+
+	unsigned int i = 0;
+	for (; i + 8 <= n; i += 8) {
+		// Two 4x4 transposes from RGBA pixels to R, G and B of 8 pixels
+		const float* p = rgba + i*4;
+		__m128 a0 = _mm_loadu_ps(p);
+		__m128 a1 = _mm_loadu_ps(p + 4);
+		__m128 a2 = _mm_loadu_ps(p + 8);
+		__m128 a3 = _mm_loadu_ps(p + 12);
+		_MM_TRANSPOSE4_PS(a0, a1, a2, a3);
+		__m128 b0 = _mm_loadu_ps(p + 16);
+		__m128 b1 = _mm_loadu_ps(p + 20);
+		__m128 b2 = _mm_loadu_ps(p + 24);
+		__m128 b3 = _mm_loadu_ps(p + 28);
+		_MM_TRANSPOSE4_PS(b0, b1, b2, b3);
+		const __m256 r = _mm256_insertf128_ps(_mm256_castps128_ps256(a0), b0, 1);
+		const __m256 g = _mm256_insertf128_ps(_mm256_castps128_ps256(a1), b1, 1);
+		const __m256 b = _mm256_insertf128_ps(_mm256_castps128_ps256(a2), b2, 1);
+
+		const __m256 y = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(kr, r), _mm256_mul_ps(kg, g)), _mm256_mul_ps(kb, b));
+
+		// Same rounding as yuv_round. max_ps returns zero for NaN.
+		__m256 yq = _mm256_add_ps(_mm256_mul_ps(y, ys), yo);
+		yq = _mm256_min_ps(_mm256_max_ps(yq, zero), max);
+		const __m256i yi = _mm256_cvttps_epi32(_mm256_add_ps(yq, half));
+		// Pack to 16 bit, the 8 values are in qwords 0 and 2
+		const __m256i y16 = _mm256_permute4x64_epi64(_mm256_packus_epi32(yi, yi), 0x08);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(Y + i), _mm256_castsi256_si128(y16));
+
+		_mm256_storeu_ps(Cb + i, _mm256_add_ps(_mm256_mul_ps(_mm256_sub_ps(b, y), cbs), co));
+		_mm256_storeu_ps(Cr + i, _mm256_add_ps(_mm256_mul_ps(_mm256_sub_ps(r, y), crs), co));
+	}
+
+	// Remaining pixels
+	yuv_line(rgba + i*4, n - i, k, Y + i, Cb + i, Cr + i);
+}
+#endif
+
+// Chroma of the pixel pair starting at x, averaged with the second row for 4:2:0.
+// The last pixel is repeated for an odd width.
+static inline void yuv_chroma(const float* Cb0, const float* Cr0, const float* Cb1, const float* Cr1,
+	unsigned int x, unsigned int n, float max, uint16_t &cb, uint16_t &cr)
+{
+	const unsigned int x0 = x < n ? x : n - 1;
+	const unsigned int x1 = x + 1 < n ? x + 1 : n - 1;
+	if (Cb1) {
+		cb = yuv_round((Cb0[x0] + Cb0[x1] + Cb1[x0] + Cb1[x1])*0.25f, max);
+		cr = yuv_round((Cr0[x0] + Cr0[x1] + Cr1[x0] + Cr1[x1])*0.25f, max);
+	}
+	else {
+		cb = yuv_round((Cb0[x0] + Cb0[x1])*0.5f, max);
+		cr = yuv_round((Cr0[x0] + Cr0[x1])*0.5f, max);
+	}
+}
+
+#ifndef _M_ARM64
+// Rounded chroma of 8 pixel pairs, as yuv_chroma without the odd width.
+// Summed in the same order as yuv_chroma so the code values are the same.
+SPOUT_TARGET_AVX2 static inline __m256i yuv_pairs_avx2(const float* c0, const float* c1, __m256 max)
+{
+	// Even and odd pixels. Pairs 0, 1, 4, 5 are in the low lane and 2, 3, 6, 7 in the high lane.
+	const __m256 a0 = _mm256_loadu_ps(c0);
+	const __m256 a1 = _mm256_loadu_ps(c0 + 8);
+	__m256 sum = _mm256_add_ps(_mm256_shuffle_ps(a0, a1, _MM_SHUFFLE(2, 0, 2, 0)), _mm256_shuffle_ps(a0, a1, _MM_SHUFFLE(3, 1, 3, 1)));
+	__m256 scale = _mm256_set1_ps(0.5f);
+	if (c1) {
+		const __m256 b0 = _mm256_loadu_ps(c1);
+		const __m256 b1 = _mm256_loadu_ps(c1 + 8);
+		sum = _mm256_add_ps(_mm256_add_ps(sum, _mm256_shuffle_ps(b0, b1, _MM_SHUFFLE(2, 0, 2, 0))), _mm256_shuffle_ps(b0, b1, _MM_SHUFFLE(3, 1, 3, 1)));
+		scale = _mm256_set1_ps(0.25f);
+	}
+
+	// Same rounding as yuv_round. max_ps returns zero for NaN.
+	__m256 v = _mm256_mul_ps(sum, scale);
+	v = _mm256_min_ps(_mm256_max_ps(v, _mm256_setzero_ps()), max);
+	const __m256i vi = _mm256_cvttps_epi32(_mm256_add_ps(v, _mm256_set1_ps(0.5f)));
+	// Pairs in order
+	return _mm256_permute4x64_epi64(vi, 0xD8);
+}
+
+// Cb and Cr of 8 pixel pairs interleaved as 16 bit values, pairs 0-3 in the low lane
+SPOUT_TARGET_AVX2 static inline __m256i yuv_cbcr_avx2(const float* Cb0, const float* Cr0,
+	const float* Cb1, const float* Cr1, unsigned int i, __m256 max)
+{
+	const __m256i cb = yuv_pairs_avx2(Cb0 + i, Cb1 ? Cb1 + i : nullptr, max);
+	const __m256i cr = yuv_pairs_avx2(Cr0 + i, Cr1 ? Cr1 + i : nullptr, max);
+	return _mm256_packus_epi32(_mm256_unpacklo_epi32(cb, cr), _mm256_unpackhi_epi32(cb, cr));
+}
+
+// 16 bit values to bytes in order
+SPOUT_TARGET_AVX2 static inline __m128i yuv_bytes_avx2(__m256i v)
+{
+	return _mm256_castsi256_si128(_mm256_permute4x64_epi64(_mm256_packus_epi16(v, v), 0x08));
+}
+
+// NV12 and P010 luma of one or two lines and their chroma, 16 pixels at a time.
+// Luma1 is null for the repeated last line of an odd height.
+// Returns the pixels written, the rest are left to the scalar code.
+SPOUT_TARGET_AVX2 static unsigned int yuv_420_avx2(const uint16_t* Y0, const uint16_t* Y1,
+	const float* Cb0, const float* Cr0, const float* Cb1, const float* Cr1,
+	unsigned int n, float fmax, bool b10bit, unsigned char* luma0, unsigned char* luma1, unsigned char* chroma)
+{
+	const __m256 max = _mm256_set1_ps(fmax);
+	unsigned int i = 0;
+	for (; i + 16 <= n; i += 16) {
+		const __m256i y0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(Y0 + i));
+		const __m256i cbcr = yuv_cbcr_avx2(Cb0, Cr0, Cb1, Cr1, i, max);
+		if (b10bit) {
+			// The 10 bit value in the high bits
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(luma0 + i*2), _mm256_slli_epi16(y0, 6));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(chroma + i*2), _mm256_slli_epi16(cbcr, 6));
+			if (luma1) {
+				const __m256i y1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(Y1 + i));
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(luma1 + i*2), _mm256_slli_epi16(y1, 6));
+			}
+		}
+		else {
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(luma0 + i), yuv_bytes_avx2(y0));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(chroma + i), yuv_bytes_avx2(cbcr));
+			if (luma1) {
+				const __m256i y1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(Y1 + i));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(luma1 + i), yuv_bytes_avx2(y1));
+			}
 		}
-		if (bInvert)
-			rgb -= rgbpitch * 2; // move up a line for invert
 	}
+	return i;
+}
 
-} // end bgra2rgb
+// YUY2 and UYVY, 16 pixels at a time. Returns the pixels written.
+SPOUT_TARGET_AVX2 static unsigned int yuv_422_avx2(const uint16_t* Y, const float* Cb, const float* Cr,
+	unsigned int n, float fmax, bool bYUY2, unsigned char* out)
+{
+	const __m256 max = _mm256_set1_ps(fmax);
+	unsigned int i = 0;
+	for (; i + 16 <= n; i += 16) {
+		const __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(Y + i));
+		const __m256i cbcr = yuv_cbcr_avx2(Cb, Cr, nullptr, nullptr, i, max);
+		// Pixels 0-7 in the low lane and 8-15 in the high lane, as the pairs of cbcr
+		__m256i lo, hi;
+		if (bYUY2) {
+			lo = _mm256_unpacklo_epi16(y, cbcr);
+			hi = _mm256_unpackhi_epi16(y, cbcr);
+		}
+		else {
+			lo = _mm256_unpacklo_epi16(cbcr, y);
+			hi = _mm256_unpackhi_epi16(cbcr, y);
+		}
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i*2), _mm256_packus_epi16(lo, hi));
+	}
+	return i;
+}
+#endif
 
 //---------------------------------------------------------
-// Function: bgra2bgr
+// Function: rgbaf2yuv
+// Convert float RGBA to a SPOUT_YUV format.
 //
-void spoutCopy::bgra2bgr(const void *bgra_source, void *bgr_dest, unsigned int width, unsigned int height, bool bInvert) const
+// The destination is laid out as GetYUVTexture describes.
+// Returns false for an unknown format or an odd rowBegin
+// for NV12 and P010.
+bool spoutCopy::rgbaf2yuv(const float* rgba_source, void* yuv_dest,
+	unsigned int width, unsigned int height,
+	unsigned int sourcePitch, unsigned int destPitch,
+	DWORD dwFormat, bool bBT2020, bool bFullRange,
+	unsigned int rowBegin, unsigned int rowEnd) const
 {
+	if (!rgba_source || !yuv_dest || width == 0 || height == 0)
+		return false;
+
+	int bits = 8;
+	bool b420 = false;
+	switch (dwFormat) {
+		case SPOUT_YUV_NV12: b420 = true; break;
+		case SPOUT_YUV_P010: b420 = true; bits = 10; break;
+		case SPOUT_YUV_YUY2:
+		case SPOUT_YUV_UYVY: break;
+		case SPOUT_YUV_V210: bits = 10; break;
+		default: return false;
+	}
 
-	// Start of buffers
-	auto bgra = static_cast<const unsigned char*>(bgra_source); // BGRA
-	auto bgr = static_cast<unsigned char*>(bgr_dest); // BGR
-	if (!bgra || !bgr) return;
+	if (rowEnd == 0 || rowEnd > height)
+		rowEnd = height;
+	if (b420 && (rowBegin & 1))
+		return false;
 
-	uint64_t bgrsize = (uint64_t)width * (uint64_t)height * 3;
-	uint64_t bgrpitch = (uint64_t)width * 3;
+	spoutYUVCoefficients k;
+	GetYUVCoefficients(bBT2020, bFullRange, bits, k);
 
-	if (bInvert) {
-		bgr += bgrsize; // end of bgr buffer
-		bgr -= bgrpitch; // beginning of the last bgr line
+	auto line = yuv_line;
+	bool bAVX2 = false;
+#ifndef _M_ARM64
+	if (m_bAVX2) {
+		line = yuv_line_avx2;
+		bAVX2 = true;
 	}
+#endif
 
-	for (unsigned int y = 0; y < height; y++) {
-		for (unsigned int x = 0; x < width; x++) {
-			// bgra source - bgr dest
-			*(bgr + 2) = *(bgra + 2); // red
-			*(bgr + 1) = *(bgra + 1); // grn
-			*(bgr + 0) = *(bgra + 0); // blu
-			bgr += 3;
-			bgra += 4;
+	// Luma and chroma of one block of the two lines
+	uint16_t Y[2][SPOUT_YUV_BLOCK];
+	float Cb[2][SPOUT_YUV_BLOCK];
+	float Cr[2][SPOUT_YUV_BLOCK];
+
+	const auto source = reinterpret_cast<const unsigned char*>(rgba_source);
+	const auto dest = static_cast<unsigned char*>(yuv_dest);
+	const unsigned int step = b420 ? 2 : 1;
+
+	for (unsigned int y = rowBegin; y < rowEnd; y += step) {
+
+		// For 4:2:0 the second line of the pair. The last line is repeated for an odd height.
+		const bool bSecond = b420 && y + 1 < height;
+		const auto src0 = reinterpret_cast<const float*>(source + (uint64_t)y*sourcePitch);
+		const auto src1 = reinterpret_cast<const float*>(source + (uint64_t)(bSecond ? y + 1 : y)*sourcePitch);
+		unsigned char* dst0 = dest + (uint64_t)y*destPitch;
+		unsigned char* dst1 = dest + (uint64_t)(y + 1)*destPitch;
+		unsigned char* chroma = dest + (uint64_t)(height + y/2)*destPitch;
+
+		for (unsigned int x = 0; x < width; x += SPOUT_YUV_BLOCK) {
+
+			const unsigned int n = (width - x < SPOUT_YUV_BLOCK) ? width - x : SPOUT_YUV_BLOCK;
+
+			line(src0 + x*4, n, k, Y[0], Cb[0], Cr[0]);
+			if (b420)
+				line(src1 + x*4, n, k, Y[1], Cb[1], Cr[1]);
+
+			const float* Cb1 = b420 ? Cb[1] : nullptr;
+			const float* Cr1 = b420 ? Cr[1] : nullptr;
+			uint16_t cb = 0;
+			uint16_t cr = 0;
+
+			// Pixels of the block packed with AVX2, always even
+			unsigned int packed = 0;
+#ifndef _M_ARM64
+			if (bAVX2 && b420) {
+				const unsigned int bytes = dwFormat == SPOUT_YUV_P010 ? 2 : 1;
+				packed = yuv_420_avx2(Y[0], Y[1], Cb[0], Cr[0], Cb1, Cr1, n, k.max, bytes == 2,
+					dst0 + x*bytes, bSecond ? dst1 + x*bytes : nullptr, chroma + x*bytes);
+			}
+			else if (bAVX2 && dwFormat != SPOUT_YUV_V210) {
+				packed = yuv_422_avx2(Y[0], Cb[0], Cr[0], n, k.max, dwFormat == SPOUT_YUV_YUY2, dst0 + x*2);
+			}
+#else
+			(void)bAVX2;
+#endif
+
+			if (dwFormat == SPOUT_YUV_NV12) {
+				// 8 bit luma plane, interleaved UV plane at half height
+				for (unsigned int i = packed; i < n; i++) {
+					dst0[x + i] = static_cast<unsigned char>(Y[0][i]);
+					if (bSecond) dst1[x + i] = static_cast<unsigned char>(Y[1][i]);
+				}
+				for (unsigned int i = packed; i < n; i += 2) {
+					yuv_chroma(Cb[0], Cr[0], Cb1, Cr1, i, n, k.max, cb, cr);
+					chroma[x + i] = static_cast<unsigned char>(cb);
+					chroma[x + i + 1] = static_cast<unsigned char>(cr);
+				}
+			}
+			else if (dwFormat == SPOUT_YUV_P010) {
+				// As NV12 with 16 bit samples, the 10 bit value in the high bits
+				auto luma0 = reinterpret_cast<uint16_t*>(dst0);
+				auto luma1 = reinterpret_cast<uint16_t*>(dst1);
+				auto uv = reinterpret_cast<uint16_t*>(chroma);
+				for (unsigned int i = packed; i < n; i++) {
+					luma0[x + i] = static_cast<uint16_t>(Y[0][i] << 6);
+					if (bSecond) luma1[x + i] = static_cast<uint16_t>(Y[1][i] << 6);
+				}
+				for (unsigned int i = packed; i < n; i += 2) {
+					yuv_chroma(Cb[0], Cr[0], Cb1, Cr1, i, n, k.max, cb, cr);
+					uv[x + i] = static_cast<uint16_t>(cb << 6);
+					uv[x + i + 1] = static_cast<uint16_t>(cr << 6);
+				}
+			}
+			else if (dwFormat == SPOUT_YUV_YUY2 || dwFormat == SPOUT_YUV_UYVY) {
+				// 4 bytes for each pixel pair
+				unsigned char* out = dst0 + (x + packed)*2;
+				const bool bYUY2 = dwFormat == SPOUT_YUV_YUY2;
+				for (unsigned int i = packed; i < n; i += 2) {
+					yuv_chroma(Cb[0], Cr[0], nullptr, nullptr, i, n, k.max, cb, cr);
+					const auto y0 = static_cast<unsigned char>(Y[0][i]);
+					const auto y1 = static_cast<unsigned char>(Y[0][i + 1 < n ? i + 1 : i]);
+					if (bYUY2) {
+						out[0] = y0; out[1] = static_cast<unsigned char>(cb);
+						out[2] = y1; out[3] = static_cast<unsigned char>(cr);
+					}
+					else {
+						out[0] = static_cast<unsigned char>(cb); out[1] = y0;
+						out[2] = static_cast<unsigned char>(cr); out[3] = y1;
+					}
+					out += 4;
+				}
+			}
+			else {
+				// v210 - 6 pixels in 4 words of three 10 bit samples
+				auto out = reinterpret_cast<uint32_t*>(dst0) + (x/6)*4;
+				for (unsigned int i = 0; i < n; i += 6) {
+					uint32_t l[6];
+					for (unsigned int j = 0; j < 6; j++)
+						l[j] = Y[0][i + j < n ? i + j : n - 1];
+					uint16_t cb0, cr0, cb2, cr2, cb4, cr4;
+					yuv_chroma(Cb[0], Cr[0], nullptr, nullptr, i, n, k.max, cb0, cr0);
+					yuv_chroma(Cb[0], Cr[0], nullptr, nullptr, i + 2, n, k.max, cb2, cr2);
+					yuv_chroma(Cb[0], Cr[0], nullptr, nullptr, i + 4, n, k.max, cb4, cr4);
+					out[0] = cb0 | (l[0] << 10) | ((uint32_t)cr0 << 20);
+					out[1] = l[1] | ((uint32_t)cb2 << 10) | (l[2] << 20);
+					out[2] = cr2 | (l[3] << 10) | ((uint32_t)cb4 << 20);
+					out[3] = l[4] | ((uint32_t)cr4 << 10) | (l[5] << 20);
+					out += 4;
+				}
+			}
 		}
-		if (bInvert)
-			bgr -= bgrpitch * 2; // move up a line for invert
 	}
-} // end bgra2bgr
 
+	return true;
+}
+
+//---------------------------------------------------------
+// Function: GetYUVTexture
+// Texture format and size to carry a SPOUT_YUV format.
+//
+//   NV12 - R8_UNORM, chroma rows below the luma rows
+//   P010 - R16_UNORM, as NV12
+//   YUY2, UYVY - R8G8B8A8_UNORM, one texel for each pixel pair
+//   v210 - R10G10B10A2_UNORM, one texel for each word,
+//          lines padded to 48 pixels (128 bytes)
+//
+bool spoutCopy::GetYUVTexture(DWORD dwFormat, unsigned int width, unsigned int height,
+	DXGI_FORMAT &texFormat, unsigned int &texWidth, unsigned int &texHeight)
+{
+	switch (dwFormat) {
+		case SPOUT_YUV_NV12:
+		case SPOUT_YUV_P010:
+			texFormat = dwFormat == SPOUT_YUV_NV12 ? DXGI_FORMAT_R8_UNORM : DXGI_FORMAT_R16_UNORM;
+			texWidth = (width + 1) & ~1u;
+			texHeight = height + (height + 1)/2;
+			return true;
+		case SPOUT_YUV_YUY2:
+		case SPOUT_YUV_UYVY:
+			texFormat = DXGI_FORMAT_R8G8B8A8_UNORM;
+			texWidth = (width + 1)/2;
+			texHeight = height;
+			return true;
+		case SPOUT_YUV_V210:
+			texFormat = DXGI_FORMAT_R10G10B10A2_UNORM;
+			texWidth = ((width + 47)/48)*32;
+			texHeight = height;
+			return true;
+		default:
+			return false;
+	}
+}
 
 //---------------------------------------------------------
 // Function: GetSSE
@@ -1444,6 +1409,15 @@ void spoutCopy::GetSSE(bool & bSSE2, bool & bSSE3, bool & bSSSE3)
 	bSSSE3 = m_bSSSE3;
 }
 
+//---------------------------------------------------------
+// Function: GetAVX2
+// Return AVX2 capability
+//
+bool spoutCopy::GetAVX2() const
+{
+	return m_bAVX2;
+}
+
 //
 // Protected
 //
@@ -1495,6 +1469,7 @@ void spoutCopy::CheckSSE()
 	m_bSSE2 = true;
 	m_bSSE3 = true;
 	m_bSSSE3 = true;
+	m_bAVX2 = false;
 #else
 	// An array of four integers that contains the information returned
 	// in EAX (0), EBX (1), ECX (2), and EDX (3) about supported features of the CPU.
@@ -1517,6 +1492,21 @@ void spoutCopy::CheckSSE()
 		// SSSE3 = (cpuid02 & (0x1 << 9)
 		m_bSSSE3 = ((CPUInfo[2] & (0x1 << 9)) || false);
 	}
+
+	//-- Get info for id "7"
+	if (nIds >= 7) {
+		// AVX2 | [bit 5] EBX of id 7
+		// The OS must also save the AVX registers.
+		// OSXSAVE | [bit 27] ECX and AVX | [bit 28] ECX of id 1
+		// and XCR0 bits 1 and 2 for the SSE and AVX state.
+		__cpuid(CPUInfo, 1);
+		const bool bOSXSAVE = (CPUInfo[2] & (0x1 << 27)) != 0;
+		const bool bAVX = (CPUInfo[2] & (0x1 << 28)) != 0;
+		if (bOSXSAVE && bAVX && (_xgetbv(0) & 0x6) == 0x6) {
+			__cpuidex(CPUInfo, 7, 0);
+			m_bAVX2 = (CPUInfo[1] & (0x1 << 5)) != 0;
+		}
+	}
 #endif
 
 }
@@ -1526,39 +1516,7 @@ void spoutCopy::CheckSSE()
 void spoutCopy::rgba_bgra(const void* rgba_source, void* bgra_dest,
 	unsigned int width, unsigned int height, bool bInvert) const
 {
-
-	if (!rgba_source)
-		return;
-	if (!bgra_dest)
-		return;
-
-	for (unsigned int y = 0; y < height; y++) {
-
-		// Start of buffer
-		auto source = static_cast<const unsigned __int32*>(rgba_source);; // unsigned int = 4 bytes
-		auto dest = static_cast<unsigned __int32*>(bgra_dest);
-		if (!source || !dest) return;
-
-		// Cast first to avoid warning C26451: Arithmetic overflow
-		const unsigned long H1YxW = (unsigned long)((height - 1 - y) * width);
-		unsigned long YxW = (unsigned long)(y * width);
-
-		// Increment to current line
-		if (bInvert) {
-			source += H1YxW;
-			dest += YxW; // dest is not inverted
-		}
-		else {
-			source += YxW;
-			dest += YxW;
-		}
-
-		for (unsigned int x = 0; x < width; x++) {
-			const auto rgbapix = source[x];
-			dest[x] = (_rotl(rgbapix, 16) & 0x00ff00ff) | (rgbapix & 0xff00ff00);
-		}
-
-	}
+	spoutSwizzle<spoutRGBA, spoutBGRA>(rgba_source, bgra_dest, width, height, 0, 0, bInvert, false, false);
 } // end rgba_bgra
 
 
@@ -1634,60 +1592,8 @@ void spoutCopy::rgba_bgra_sse2(const void* rgba_source, void* bgra_dest, unsigne
 
 } // end rgba_bgra_sse2
 
-//
-//	Adapted from a Gist snippet by Aurlien Valle (NewbiZ) http://newbiz.github.io/
-//
-//	https://gist.github.com/NewbiZ/5541524
-//
-//	Approximately 15% faster than SSE2 function
-//
+// Copy rgba to bgra with the SSSE3 shuffle only
 void spoutCopy::rgba_bgra_sse3(const void* rgba_source, void* bgra_dest, unsigned int width, unsigned int height, bool bInvert) const
 {
-	// Shuffling mask (RGBA -> BGRA) x 4, in reverse byte order
-	static const __m128i m = _mm_set_epi8(15, 12, 13, 14, 11, 8, 9, 10, 7, 4, 5, 6, 3, 0, 1, 2);
-
-	for (unsigned int y = 0; y < height; y++) {
-
-		// Start of buffer
-		auto source = static_cast<const unsigned __int32*>(rgba_source); // unsigned int = 4 bytes
-		auto dest = static_cast<unsigned __int32*>(bgra_dest);
-
-		// Cast first to avoid warning C26451: Arithmetic overflow
-		const unsigned long H1YxW = (unsigned long)((height - 1 - y) * width);
-		unsigned long YxW = (unsigned long)(y * width);
-
-		// Increment to current line
-		if (bInvert)
-			source += H1YxW;
-		else
-			source += YxW;
-		dest += YxW; // dest is not inverted
-
-		// Assert pixels will NOT be aliased here : TODO
-		// __m128i* __restrict__ pix = (__m128i*)pixels;
-		auto src = reinterpret_cast<const __m128i*>(source);
-		auto dst = reinterpret_cast<__m128i*>(dest);
-
-		// Tile the LHS to match 64B cache line size
-		const auto srcEnd = reinterpret_cast<const __m128i*>(source + width);
-		for (; src < srcEnd; src += 4, dst += 4) {
-
-			__m128i p1 = _mm_load_si128(src); // SSE2
-			__m128i p2 = _mm_load_si128(src + 1);
-			__m128i p3 = _mm_load_si128(src + 2);
-			__m128i p4 = _mm_load_si128(src + 3);
-
-			p1 = _mm_shuffle_epi8(p1, m); // SSSE3
-			p2 = _mm_shuffle_epi8(p2, m);
-			p3 = _mm_shuffle_epi8(p3, m);
-			p4 = _mm_shuffle_epi8(p4, m);
-
-			_mm_store_si128(dst, p1); // SSE2
-			_mm_store_si128(dst + 1, p2);
-			_mm_store_si128(dst + 2, p3);
-			_mm_store_si128(dst + 3, p4);
-
-		}
-	}
-
+	spoutSwizzle<spoutRGBA, spoutBGRA>(rgba_source, bgra_dest, width, height, 0, 0, bInvert, true, false);
 } // end rgba_bgra_sse3
@@ -43,9 +43,24 @@
 #else
 #include <emmintrin.h> // for SSE2
 #include <tmmintrin.h> // for SSSE3
+#include <immintrin.h> // for AVX2
 #endif
 #include <cmath> // For compatibility with Clang. PR#81
 #include <stdint.h> // for _uint32 etc
+#include <dxgiformat.h> // for YUV texture formats
+
+//
+// YUV formats for rgbaf2yuv
+//
+// The value is written to SharedTextureInfo.format so that receivers can detect it.
+// NV12, P010 and YUY2 are the DXGI_FORMAT values. UYVY and v210 have no
+// DXGI format and use their FourCC.
+//
+#define SPOUT_YUV_NV12 103        // DXGI_FORMAT_NV12
+#define SPOUT_YUV_P010 104        // DXGI_FORMAT_P010
+#define SPOUT_YUV_YUY2 107        // DXGI_FORMAT_YUY2
+#define SPOUT_YUV_UYVY 0x59565955 // FourCC 'UYVY'
+#define SPOUT_YUV_V210 0x30313276 // FourCC 'v210'
 
 class SPOUT_DLLEXP spoutCopy {
 
@@ -184,7 +199,7 @@ class SPOUT_DLLEXP spoutCopy {
 			unsigned int dest_pitch, bool bInvert) const;
 
 
-		// Experimental SSE RGB to BGRA
+		// SSE RGB to BGRA
 		// Single line
 		void rgb_to_bgrx_sse(unsigned int npixels, const void* rgb_source, void* bgrx_out) const;
 		// Full height
@@ -203,16 +218,39 @@ class SPOUT_DLLEXP spoutCopy {
 		// Copy BGRA to BGR
 		void bgra2bgr (const void* bgra_source, void *bgr_dest,  unsigned int width, unsigned int height, bool bInvert = false) const;
 
+		//
+		// Float RGBA to YUV
+		//
+
+		// Convert float RGBA to a SPOUT_YUV format with the BT.709 or BT.2020 matrix
+		// and limited or full range. Rows from rowBegin up to rowEnd are converted
+		// so that the image can be split between threads. rowEnd 0 is the image height.
+		// NV12 and P010 need an even rowBegin.
+		bool rgbaf2yuv(const float* rgba_source, void* yuv_dest,
+			unsigned int width, unsigned int height,
+			unsigned int sourcePitch, unsigned int destPitch,
+			DWORD dwFormat, bool bBT2020 = false, bool bFullRange = false,
+			unsigned int rowBegin = 0, unsigned int rowEnd = 0) const;
+
+		// Texture format and size to carry a SPOUT_YUV format.
+		// NV12 and P010 planes are stacked, chroma below luma.
+		static bool GetYUVTexture(DWORD dwFormat, unsigned int width, unsigned int height,
+			DXGI_FORMAT &texFormat, unsigned int &texWidth, unsigned int &texHeight);
+
 		// SSE capability
 
 		void GetSSE(bool &bSSE2, bool &bSSE3, bool &bSSSE3);
 
+		// AVX2 capability
+		bool GetAVX2() const;
+
 	protected :
 
 		void CheckSSE();
 		bool m_bSSE2;
 		bool m_bSSE3;
 		bool m_bSSSE3;
+		bool m_bAVX2;
 
 		void rgba_bgra(const void *rgba_source, void *bgra_dest, unsigned int width, unsigned int height, bool bInvert = false) const;
 		void rgba_bgra_sse2(const void *rgba_source, void *bgra_dest, unsigned int width, unsigned int height, bool bInvert = false) const;
@@ -159,6 +159,22 @@
 //		15.07.24	- SelectSender - after cast of window handle to long 
 //					  convert to a string of 8 characters without new line
 //		28.07.24	- Change to #if __has_include("SpoutCommon.h") in Spout.h
+//		17.10.26	- Create and close frame metadata with the sender and receiver
+//					  Send functions publish frame metadata. Add GetFrameMetadata.
+//					- Add versioned shared buffer functions
+//					  CreateSharedBuffer, BeginSharedBufferWrite, CommitSharedBuffer,
+//					  BeginSharedBufferRead, EndSharedBufferRead, CloseSharedBuffer
+//					- Record send, receive and pixel read times in histograms
+//					- GetDX9 and GetMemoryShareMode read spoutSettings instead of the registry
+//					- Create receiver slots with the sender and open them with the receiver.
+//					  Receive functions record the frame copied for the sender to see lag.
+//					- Add SetSenderFormatCode for formats carried by another texture format
+//					- Add RenameSender to change the sender name without releasing
+//					  the device and shared texture
+//					- Add SetSharedBufferRows, BeginSharedBufferStream and
+//					  WaitSharedBufferRows for streaming readers of a shared buffer
+//					- Add AcquireFrameLease and ReleaseFrameLease to read
+//					  frames in a shared buffer in place without a copy
 //
 // ====================================================================================
 /*
@@ -212,6 +228,7 @@ spoutDX::spoutDX()
 	m_SenderNameSetup[0] = 0;
 	m_SenderName[0] = 0;
 	m_dwFormat = DXGI_FORMAT_B8G8R8A8_UNORM; // default;
+	m_dwFormatCode = 0;
 	m_Width = 0;
 	m_Height = 0;
 	m_bUpdated = false;
@@ -421,6 +438,67 @@ void spoutDX::SetSenderFormat(DXGI_FORMAT format)
 	m_dwFormat = format;
 }
 
+//---------------------------------------------------------
+// Function: SetSenderFormatCode
+// Set a format code for receivers other than the texture format.
+//
+// The code is written to the sender information instead of the
+// texture format, for example a SPOUT_YUV format carried by an
+// RGBA texture. Receivers that do not know the code see an
+// unsupported format. 0 restores the texture format.
+void spoutDX::SetSenderFormatCode(DWORD dwCode)
+{
+	if (dwCode == m_dwFormatCode)
+		return;
+
+	m_dwFormatCode = dwCode;
+
+	// Update an existing sender. CheckSender uses the code from now on.
+	if (m_bSpoutInitialized)
+		sendernames.UpdateSender(m_SenderName, m_Width, m_Height, m_dxShareHandle, m_dwFormatCode ? m_dwFormatCode : m_dwFormat);
+}
+
+//---------------------------------------------------------
+// Function: RenameSender
+// Change the name of a sender without releasing it.
+//
+// The device, shared texture and share handle are kept.
+// The sender information, frame count semaphore, texture access mutex,
+// frame metadata and receiver slots move to the new name.
+// Receivers of the old name see the sender close and can
+// connect to the new name.
+//
+// If the sender has not been created yet, the name is set for creation.
+// If a sender with the new name exists, the name is incremented.
+bool spoutDX::RenameSender(const char* sendername)
+{
+	if (!sendername || !sendername[0])
+		return false;
+
+	if (!m_bSpoutInitialized)
+		return SetSenderName(sendername);
+
+	if (strcmp(sendername, m_SenderName) == 0)
+		return true;
+
+	char name[256]={};
+	strcpy_s(name, 256, sendername);
+	if (!sendernames.RenameSender(m_SenderName, name)) {
+		SpoutLogWarning("spoutDX::RenameSender - could not rename [%s] to [%s]", m_SenderName, sendername);
+		return false;
+	}
+
+	strcpy_s(m_SenderName, 256, name);
+
+	if (!frame.RenameSender(m_SenderName))
+		SpoutLogWarning("spoutDX::RenameSender - frame objects of [%s] not all created", m_SenderName);
+
+	// Created again with the new name by the next WriteMemoryBuffer
+	memorybuffer.Close();
+
+	return true;
+}
+
 //---------------------------------------------------------
 // Function: ReleaseSender
 // Close sender and release resources.
@@ -441,8 +519,13 @@ void spoutDX::ReleaseSender()
 	m_SenderName[0] = 0;
 	m_bSpoutInitialized = false;
 
-	// Close shared memory buffer if used
+	// Close frame metadata and release the receiver slot
+	frame.CloseFrameMetadata();
+	frame.CloseReceiverSlots();
+
+	// Close shared memory buffers if used
 	memorybuffer.Close();
+	sharedbuffer.Close();
 
 }
 
@@ -522,11 +605,14 @@ bool spoutDX::SendTexture(ID3D11Texture2D* pTexture)
 
 	// Check the sender mutex for access the shared texture
 	if (frame.CheckTextureAccess(m_pSharedTexture)) {
+		// Time to update the shared texture and signal the frame
+		spoutHistogramTimer timer(sendtimes);
 		// Copy the application texture to the sender's shared texture
 		m_pImmediateContext->CopyResource(m_pSharedTexture, pTexture);
 		// Flush the command queue now because the shared texture has been updated on this device
 		m_pImmediateContext->Flush();
-		// Signal a new frame while the mutex is locked
+		// Publish frame metadata and signal a new frame while the mutex is locked
+		WriteFrameMetadata();
 		frame.SetNewFrame();
 		// Allow access to the shared texture
 		frame.AllowTextureAccess(m_pSharedTexture);
@@ -584,11 +670,14 @@ bool spoutDX::SendTexture(ID3D11Texture2D* pTexture,
 
 	// Check the sender mutex for access the shared texture
 	if (frame.CheckTextureAccess(m_pSharedTexture)) {
+		// Time to update the shared texture and signal the frame
+		spoutHistogramTimer timer(sendtimes);
 		// Copy the texture region to the sender's shared texture
 		m_pImmediateContext->CopySubresourceRegion(m_pSharedTexture, 0, 0, 0, 0, pTexture, 0, &sourceRegion);
 		// Flush the command queue now because the shared texture has been updated on this device
 		m_pImmediateContext->Flush();
-		// Signal a new frame while the mutex is locked
+		// Publish frame metadata and signal a new frame while the mutex is locked
+		WriteFrameMetadata();
 		frame.SetNewFrame();
 		// Allow access to the shared texture
 		frame.AllowTextureAccess(m_pSharedTexture);
@@ -613,11 +702,14 @@ bool spoutDX::SendImage(const unsigned char * pData, unsigned int width, unsigne
 
 	// Check the sender mutex for access the shared texture
 	if (frame.CheckTextureAccess(m_pSharedTexture)) {
+		// Time to update the shared texture and signal the frame
+		spoutHistogramTimer timer(sendtimes);
 		// Update the shared texture resource with the pixel buffer
 		m_pImmediateContext->UpdateSubresource(m_pSharedTexture, 0, NULL, pData, m_Width*4, 0);
 		// Flush the command queue because the shared texture has been updated on this device
 		m_pImmediateContext->Flush();
-		// Signal a new frame while the mutex is locked
+		// Publish frame metadata and signal a new frame while the mutex is locked
+		WriteFrameMetadata();
 		frame.SetNewFrame();
 		// Allow access to the shared texture
 		frame.AllowTextureAccess(m_pSharedTexture);
@@ -751,12 +843,15 @@ void spoutDX::ReleaseReceiver()
 	// Flush now to avoid deferred object destruction
 	if (m_pImmediateContext) m_pImmediateContext->Flush();
 
-	// Close the named access mutex and frame counting semaphore.
+	// Close the named access mutex, frame counting semaphore, frame metadata and receiver slots.
 	frame.CloseAccessMutex();
 	frame.CleanupFrameCount();
+	frame.CloseFrameMetadata();
+	frame.CloseReceiverSlots();
 
-	// Close shared memory buffer if used
+	// Close shared memory buffers if used
 	memorybuffer.Close();
+	sharedbuffer.Close();
 
 	// Zero width and height so that they are reset when a sender is found
 	m_Width = 0;
@@ -804,6 +899,7 @@ bool spoutDX::ReceiveTexture()
 		if (frame.CheckTextureAccess(m_pSharedTexture)) {
 			// Check if the sender has produced a new frame.
 			if (frame.GetNewFrame()) {
+				spoutHistogramTimer timer(receivetimes);
 				// Copy from the sender's shared texture to the receiving class texture.
 				m_pImmediateContext->CopyResource(m_pTexture, m_pSharedTexture);
 				// Testing has shown that Flush is needed here for the texture
@@ -811,6 +907,8 @@ bool spoutDX::ReceiveTexture()
 				// May be removed if the texture is not immediately copied.
 				// Test for the individual application.
 				m_pImmediateContext->Flush();
+				// Let the sender know how far behind this receiver is
+				frame.SetReceivedFrame();
 			}
 			// Allow access to the shared texture
 			frame.AllowTextureAccess(m_pSharedTexture);
@@ -878,6 +976,7 @@ bool spoutDX::ReceiveTexture(ID3D11Texture2D** ppTexture)
 		if (frame.CheckTextureAccess(m_pSharedTexture)) {
 			// Check if the sender has produced a new frame.
 			if (frame.GetNewFrame()) {
+				spoutHistogramTimer timer(receivetimes);
 				// Copy from the sender's shared texture to the receiving texture.
 				m_pImmediateContext->CopyResource(pTexture, m_pSharedTexture);
 				// Testing has shown that Flush is needed here for the texture
@@ -885,6 +984,8 @@ bool spoutDX::ReceiveTexture(ID3D11Texture2D** ppTexture)
 				// May be removed if the texture is not immediately copied.
 				// Test for the individual application.
 				m_pImmediateContext->Flush();
+				// Let the sender know how far behind this receiver is
+				frame.SetReceivedFrame();
 			 }
 			// Allow access to the shared texture
 			frame.AllowTextureAccess(m_pSharedTexture);
@@ -949,6 +1050,7 @@ bool spoutDX::ReceiveImage(unsigned char * pixels,
 		if (frame.CheckTextureAccess(m_pSharedTexture)) {
 			// Check if the sender has produced a new frame.
 			if (frame.GetNewFrame()) {
+				spoutHistogramTimer timer(receivetimes);
 				// Read from the sender GPU texture to CPU pixels via two staging textures
 				// One texture - approx 7 - 12 msec at 1920x1080
 				// Two textures - approx 2.5 - 3.5 msec at 1920x1080
@@ -958,6 +1060,8 @@ bool spoutDX::ReceiveImage(unsigned char * pixels,
 				m_pImmediateContext->CopyResource(m_pStaging[m_Index], m_pSharedTexture);
 				// Map and read from the second while the first is occupied
 				ReadPixelData(m_pStaging[m_NextIndex], pixels, width, height, bRGB, bInvert, m_bSwapRB);
+				// Let the sender know how far behind this receiver is
+				frame.SetReceivedFrame();
 			}
 			// Allow access to the shared texture
 			frame.AllowTextureAccess(m_pSharedTexture);
@@ -1203,6 +1307,16 @@ long spoutDX::GetSenderFrame()
 	return frame.GetSenderFrame();
 }
 
+//---------------------------------------------------------
+// Function: GetFrameMetadata
+// Get metadata of the latest sender frame.
+//
+// Returns false if the sender does not publish metadata.
+bool spoutDX::GetFrameMetadata(SpoutFrameMetadata* metadata)
+{
+	return frame.ReadFrameMetadata(metadata);
+}
+
 
 //---------------------------------------------------------
 // COMMON
@@ -1960,6 +2074,238 @@ int spoutDX::GetMemoryBufferSize(const char *name)
 
 }
 
+//
+// Group: Versioned shared buffer
+//
+//   An alternative to WriteMemoryBuffer/ReadMemoryBuffer for data
+//   exchanged every frame. The writer fills one of several buffers
+//   in place and commits it. Readers use the latest committed buffer
+//   in place and check afterwards whether it was overwritten.
+//   There is no mutex and no copy on either side.
+//
+//   Writer
+//
+//      CreateSharedBuffer("name", maxlength);
+//      ...
+//      int maxlength = 0;
+//      char* data = BeginSharedBufferWrite(&maxlength);
+//      (fill up to maxlength bytes)
+//      CommitSharedBuffer(length);
+//
+//   Reader
+//
+//      int length = 0;
+//      uint64_t version = 0;
+//      const char* data = BeginSharedBufferRead("name", &length, &version);
+//      if (data) {
+//          (use length bytes)
+//          if (!EndSharedBufferRead(version))
+//              (overwritten while reading, read again)
+//      }
+//
+//   A writer that fills the buffer from the top can call SetSharedBufferRows
+//   as rows are done. A streaming reader then starts before the commit.
+//
+//      uint64_t version = 0;
+//      const char* data = BeginSharedBufferStream("name", lastversion, &version);
+//      if (data) {
+//          int rows = WaitSharedBufferRows(version, (rows needed), timeout);
+//          (use the rows, -1 if overwritten)
+//      }
+//
+//   Frames written with SpoutFrameMetadata in the first SPOUT_FRAME_HEADER_BYTES
+//   can be leased. The writer skips the leased buffer until it is released,
+//   so an encoder reads the frame in place rather than copying it out first.
+//
+//      SpoutFrameLease lease = {};
+//      if (AcquireFrameLease("name", &lease, lastsequence)) {
+//          (use lease.height rows of lease.pitch bytes from lease.data)
+//          lastsequence = lease.sequence;
+//          ReleaseFrameLease(&lease);
+//      }
+//
+//   The shared memory is closed when the sender or receiver is released.
+//
+
+//---------------------------------------------------------
+// Function: CreateSharedBuffer
+// Create a versioned shared buffer.
+//
+//   length  - maximum bytes for each commit
+//   buffers - number of buffers, 2 to SPOUT_SHARED_BUFFER_MAX
+//
+bool spoutDX::CreateSharedBuffer(const char* name, int length, int buffers)
+{
+	// Quit if 2.006 memoryshare mode
+	if (m_bMemoryShare)
+		return false;
+
+	return sharedbuffer.Create(name, length, buffers);
+}
+
+//---------------------------------------------------------
+// Function: BeginSharedBufferWrite
+// Get the next buffer to fill in place.
+//
+// Returns null if the shared buffer has not been created.
+char* spoutDX::BeginSharedBufferWrite(int* maxlength)
+{
+	return sharedbuffer.BeginWrite(maxlength);
+}
+
+//---------------------------------------------------------
+// Function: CommitSharedBuffer
+// Publish the buffer filled since BeginSharedBufferWrite.
+bool spoutDX::CommitSharedBuffer(int length)
+{
+	return sharedbuffer.Commit(length);
+}
+
+//---------------------------------------------------------
+// Function: BeginSharedBufferRead
+// Get the latest committed buffer to read in place.
+//
+// The shared buffer is opened if not already.
+// Returns null if it does not exist or nothing has been committed.
+const char* spoutDX::BeginSharedBufferRead(const char* name, int* length, uint64_t* version)
+{
+	// Quit if 2.006 memoryshare mode
+	if (m_bMemoryShare)
+		return nullptr;
+
+	if (!sharedbuffer.IsOpen()) {
+		if (!sharedbuffer.Open(name))
+			return nullptr;
+	}
+
+	return sharedbuffer.BeginRead(length, version);
+}
+
+//---------------------------------------------------------
+// Function: EndSharedBufferRead
+// Check that the buffer was not overwritten while it was read.
+bool spoutDX::EndSharedBufferRead(uint64_t version)
+{
+	return sharedbuffer.EndRead(version);
+}
+
+//---------------------------------------------------------
+// Function: SetSharedBufferRows
+// Publish the rows completed so far of the buffer being filled.
+//
+// Call from any thread filling the buffer, the count only increases.
+void spoutDX::SetSharedBufferRows(int rows)
+{
+	sharedbuffer.SetRowsCompleted(rows);
+}
+
+//---------------------------------------------------------
+// Function: BeginSharedBufferStream
+// Get the newest buffer after lastversion to read in place while it is filled.
+//
+// The shared buffer is opened if not already.
+// Returns null if it does not exist or there is no newer buffer.
+const char* spoutDX::BeginSharedBufferStream(const char* name, uint64_t lastversion, uint64_t* version)
+{
+	// Quit if 2.006 memoryshare mode
+	if (m_bMemoryShare)
+		return nullptr;
+
+	if (!sharedbuffer.IsOpen()) {
+		if (!sharedbuffer.Open(name))
+			return nullptr;
+	}
+
+	return sharedbuffer.BeginStreamRead(lastversion, version);
+}
+
+//---------------------------------------------------------
+// Function: WaitSharedBufferRows
+// Wait for rows of a buffer being filled.
+//
+//   timeout - milliseconds
+//
+// Returns the rows completed, or -1 if the buffer was overwritten.
+int spoutDX::WaitSharedBufferRows(uint64_t version, int rows, int timeout)
+{
+	return sharedbuffer.WaitRowsCompleted(version, rows, timeout);
+}
+
+//---------------------------------------------------------
+// Function: AcquireFrameLease
+// Lease the latest frame newer than lastsequence to read in place.
+//
+// The shared buffer is opened if not already.
+// Returns false if there is no new frame or the buffer does not hold one.
+// Release the lease within SPOUT_SHARED_BUFFER_LEASE_MSEC.
+bool spoutDX::AcquireFrameLease(const char* name, SpoutFrameLease* lease, uint64_t lastsequence)
+{
+	if (!lease)
+		return false;
+
+	// Quit if 2.006 memoryshare mode
+	if (m_bMemoryShare)
+		return false;
+
+	if (!sharedbuffer.IsOpen()) {
+		if (!sharedbuffer.Open(name))
+			return false;
+	}
+
+	if (sharedbuffer.GetVersion() <= lastsequence)
+		return false;
+
+	int length = 0;
+	uint64_t version = 0;
+	const char* data = sharedbuffer.AcquireLease(&length, &version);
+	if (!data)
+		return false;
+
+	SpoutFrameMetadata metadata = {};
+	if (length > SPOUT_FRAME_HEADER_BYTES)
+		memcpy(&metadata, data, sizeof(SpoutFrameMetadata));
+
+	// The rows fill the rest of the commit
+	if (metadata.height == 0 || (length - SPOUT_FRAME_HEADER_BYTES) < static_cast<int>(metadata.height)) {
+		sharedbuffer.ReleaseLease(version);
+		return false;
+	}
+
+	lease->data = data + SPOUT_FRAME_HEADER_BYTES;
+	lease->pitch = static_cast<unsigned int>(length - SPOUT_FRAME_HEADER_BYTES)/metadata.height;
+	lease->width = metadata.width;
+	lease->height = metadata.height;
+	lease->format = metadata.format;
+	lease->sequence = version;
+	lease->metadata = metadata;
+
+	return true;
+}
+
+//---------------------------------------------------------
+// Function: ReleaseFrameLease
+// Release a frame leased by AcquireFrameLease.
+//
+// Returns false if the frame was overwritten because
+// the lease was held too long.
+bool spoutDX::ReleaseFrameLease(SpoutFrameLease* lease)
+{
+	if (!lease || !lease->data)
+		return false;
+
+	const bool valid = sharedbuffer.ReleaseLease(lease->sequence);
+	lease->data = nullptr;
+	return valid;
+}
+
+//---------------------------------------------------------
+// Function: CloseSharedBuffer
+// Close the versioned shared buffer.
+void spoutDX::CloseSharedBuffer()
+{
+	sharedbuffer.Close();
+}
+
 //
 // Options used for SpoutCam
 //
@@ -2010,9 +2356,7 @@ bool spoutDX::GetSwap()
 // Get user DX9 mode
 bool spoutDX::GetDX9()
 {
-	DWORD dwDX9 = 0;
-	ReadDwordFromRegistry(HKEY_CURRENT_USER, "Software\\Leading Edge\\Spout", "DX9", &dwDX9);
-	return (dwDX9 == 1);
+	return spoutSettings::Instance().Get().bDX9;
 }
 
 //---------------------------------------------------------
@@ -2020,12 +2364,7 @@ bool spoutDX::GetDX9()
 // Get user memory share mode
 bool spoutDX::GetMemoryShareMode()
 {
-	bool bRet = false;
-	DWORD dwMem = 0;
-	if (ReadDwordFromRegistry(HKEY_CURRENT_USER, "Software\\Leading Edge\\Spout", "MemoryShare", &dwMem)) {
-		bRet = (dwMem == 1);
-	}
-	return bRet;
+	return spoutSettings::Instance().Get().bMemoryShare;
 }
 
 //
@@ -2219,7 +2558,7 @@ bool spoutDX::CheckSender(unsigned int width, unsigned int height, DWORD dwForma
 		// and specifying the same texture format.
 		// If the sender already exists, the name is incremented
 		// name, name_1, name_2 etc
-		if (sendernames.CreateSender(m_SenderName, m_Width, m_Height, m_dxShareHandle, m_dwFormat)) {
+		if (sendernames.CreateSender(m_SenderName, m_Width, m_Height, m_dxShareHandle, m_dwFormatCode ? m_dwFormatCode : m_dwFormat)) {
 
 			// sendernames::SetSenderInfo writes the sender information to shared memory
 			// including the sender executable path
@@ -2227,6 +2566,12 @@ bool spoutDX::CheckSender(unsigned int width, unsigned int height, DWORD dwForma
 			// Create a sender mutex for access to the shared texture
 			frame.CreateAccessMutex(m_SenderName);
 
+			// Create shared memory for frame metadata
+			frame.CreateFrameMetadata(m_SenderName);
+
+			// Create shared memory for receivers to report the frame they copied
+			frame.CreateReceiverSlots(m_SenderName);
+
 			// Enable frame counting so the receiver gets frame number and fps
 			frame.EnableFrameCount(m_SenderName);
 
@@ -2255,7 +2600,7 @@ bool spoutDX::CheckSender(unsigned int width, unsigned int height, DWORD dwForma
 		}
 
 		// Update the sender information
-		sendernames.UpdateSender(m_SenderName, width, height, m_dxShareHandle, dwFormat);
+		sendernames.UpdateSender(m_SenderName, width, height, m_dxShareHandle, m_dwFormatCode ? m_dwFormatCode : dwFormat);
 
 		// Update class variables
 		m_Width = width;
@@ -2268,6 +2613,18 @@ bool spoutDX::CheckSender(unsigned int width, unsigned int height, DWORD dwForma
 
 }
 
+//---------------------------------------------------------
+// Publish frame size and format with the next frame.
+// Called by the send functions while the texture access mutex is locked.
+void spoutDX::WriteFrameMetadata()
+{
+	SpoutFrameMetadata metadata={};
+	metadata.width = m_Width;
+	metadata.height = m_Height;
+	metadata.format = m_dwFormatCode ? m_dwFormatCode : m_dwFormat;
+	frame.WriteFrameMetadata(&metadata);
+}
+
 //---------------------------------------------------------
 // Used when the sender was there but the texture pointer could not be retrieved from the share handle.
 // Try using the sender adapter if different.
@@ -2485,6 +2842,12 @@ void spoutDX::CreateReceiver(const char * SenderName, unsigned int width, unsign
 	// Create a named sender mutex for access to the sender's shared texture
 	frame.CreateAccessMutex(SenderName);
 
+	// Open the sender frame metadata if available
+	frame.OpenFrameMetadata(SenderName);
+
+	// Open the sender receiver slots if available
+	frame.OpenReceiverSlots(SenderName);
+
 	// Enable frame counting to get the sender frame number and fps
 	frame.EnableFrameCount(SenderName);
 
@@ -2513,6 +2876,9 @@ bool spoutDX::ReadPixelData(ID3D11Texture2D* pStagingSource, unsigned char* dest
 	if (!m_pImmediateContext || !pStagingSource || !destpixels)
 		return false;
 
+	// Time to wait for the staging texture and copy the pixels
+	spoutHistogramTimer timer(readtimes);
+
 	// Map the staging texture resource so we can access the pixels
 	D3D11_MAPPED_SUBRESOURCE mappedSubResource={};
 	// Make sure all commands are done before mapping the staging texture
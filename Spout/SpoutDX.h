@@ -50,6 +50,8 @@
 #include "SpoutDirectX.h"
 #include "SpoutSenderNames.h"
 #include "SpoutFrameCount.h"
+#include "SpoutSharedBuffer.h"
+#include "SpoutSettings.h"
 #include "SpoutCopy.h"
 #include "SpoutUtils.h"
 #else
@@ -57,6 +59,8 @@
 #include "..\..\SpoutGL\SpoutDirectX.h"
 #include "..\..\SpoutGL\SpoutSenderNames.h"
 #include "..\..\SpoutGL\SpoutFrameCount.h"
+#include "..\..\SpoutGL\SpoutSharedBuffer.h"
+#include "..\..\SpoutGL\SpoutSettings.h"
 #include "..\..\SpoutGL\SpoutCopy.h"
 #include "..\..\SpoutGL\SpoutUtils.h"
 #endif
@@ -67,6 +71,26 @@
 #include <psapi.h> // for GetModuleFileNameExA
 #pragma comment(lib, "Psapi.lib")
 
+// Frame in a versioned shared buffer - SpoutFrameMetadata
+// in the first SPOUT_FRAME_HEADER_BYTES, then the rows
+#define SPOUT_FRAME_HEADER_BYTES 128
+
+//
+// Frame leased from a versioned shared buffer
+//
+// data points into the shared memory and stays valid
+// until the lease is released with ReleaseFrameLease.
+//
+struct SpoutFrameLease {
+	const char* data;           // First row
+	unsigned int pitch;         // Bytes per row
+	unsigned int width;
+	unsigned int height;
+	DWORD format;               // DXGI format or SPOUT_YUV code
+	uint64_t sequence;          // Shared buffer version
+	SpoutFrameMetadata metadata;
+};
+
 class SPOUT_DLLEXP spoutDX {
 
 	public:
@@ -92,6 +116,10 @@ class SPOUT_DLLEXP spoutDX {
 	bool SetSenderName(const char* sendername = nullptr);
 	// Set the sender texture format
 	void SetSenderFormat(DXGI_FORMAT format);
+	// Set a format code for receivers other than the texture format, 0 for none
+	void SetSenderFormatCode(DWORD dwCode = 0);
+	// Change the name of a sender without releasing it
+	bool RenameSender(const char* sendername);
 	// Close sender and free resources
 	void ReleaseSender();
 	// Send the back buffer
@@ -158,6 +186,8 @@ class SPOUT_DLLEXP spoutDX {
 	double GetSenderFps();
 	// Received sender frame number
 	long GetSenderFrame();
+	// Received sender frame metadata
+	bool GetFrameMetadata(SpoutFrameMetadata* metadata);
 	
 	//
 	// COMMON
@@ -302,6 +332,34 @@ class SPOUT_DLLEXP spoutDX {
 	// Get the number of bytes available for data transfer
 	int  GetMemoryBufferSize(const char *name);
 
+	//
+	// Versioned shared buffer
+	// Data sharing in place without a mutex or copy
+	//
+
+	// Create a versioned shared buffer
+	bool CreateSharedBuffer(const char* name, int length, int buffers = 2);
+	// Get the next buffer to fill in place
+	char* BeginSharedBufferWrite(int* maxlength = nullptr);
+	// Publish the filled buffer as the latest version
+	bool CommitSharedBuffer(int length);
+	// Get the latest buffer to read in place
+	const char* BeginSharedBufferRead(const char* name, int* length, uint64_t* version);
+	// Check that the buffer was not overwritten while it was read
+	bool EndSharedBufferRead(uint64_t version);
+	// Publish the rows completed so far of the buffer being filled
+	void SetSharedBufferRows(int rows);
+	// Get the newest buffer to read in place while it is filled
+	const char* BeginSharedBufferStream(const char* name, uint64_t lastversion, uint64_t* version);
+	// Wait for rows of a buffer being filled, -1 if it was overwritten
+	int WaitSharedBufferRows(uint64_t version, int rows, int timeout);
+	// Lease the latest frame newer than lastsequence to read in place
+	bool AcquireFrameLease(const char* name, SpoutFrameLease* lease, uint64_t lastsequence = 0);
+	// Release a leased frame, false if it was overwritten while held
+	bool ReleaseFrameLease(SpoutFrameLease* lease);
+	// Close the versioned shared buffer
+	void CloseSharedBuffer();
+
 	//
 	// Options used for SpoutCam
 	//
@@ -335,6 +393,7 @@ class SPOUT_DLLEXP spoutDX {
 
 	HANDLE m_dxShareHandle;
 	DWORD m_dwFormat;
+	DWORD m_dwFormatCode;
 	SharedTextureInfo m_SenderInfo;
 	char m_SenderNameSetup[256];
 	char m_SenderName[256];
@@ -355,7 +414,17 @@ class SPOUT_DLLEXP spoutDX {
 	// For WriteMemoryBuffer/ReadMemoryBuffer
 	SpoutSharedMemory memorybuffer;
 
+	// For versioned shared buffer functions
+	spoutSharedBuffer sharedbuffer;
+
+	// Timing distributions in nanoseconds
+	spoutHistogram sendtimes; // update the shared texture and signal the frame
+	spoutHistogram receivetimes; // copy a new frame from the shared texture
+	spoutHistogram readtimes; // wait for and read staging texture pixels
+
 	bool CheckSender(unsigned int width, unsigned int height, DWORD dwFormat);
+	// Publish frame size and format with the next frame
+	void WriteFrameMetadata();
 	ID3D11Texture2D* CheckSenderTexture(char *sendername, HANDLE dxShareHandle);
 
 	bool ReceiveSenderData();
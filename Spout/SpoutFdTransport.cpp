@@ -0,0 +1,755 @@
+//
+//		SpoutFdTransport
+//
+//		Linux frame buffers shared as sealed memfd file descriptors
+//
+//		On Windows a sender shares a texture through the share handle in
+//		SharedTextureInfo. The Linux equivalent of a handle that another
+//		process can map is a file descriptor. It can't be looked up by name,
+//		so a broker process holds the descriptors of registered senders and
+//		passes them to receivers over a Unix domain socket with SCM_RIGHTS.
+//
+//		The memory has the spoutSharedBuffer layout, so writing and reading
+//		are the same and neither side copies the data. Compared with the
+//		shm_open backend of SpoutSharedMemory
+//
+//			the memory has no name that another process could open,
+//			receivers only get a read-only descriptor,
+//			the size is sealed so that a receiver can't be faulted,
+//			nothing is left in /dev/shm if a sender crashes.
+//
+//		One process runs spoutFdBroker for the session.
+//		tools/spout_fd_bench.cpp compares the latency with spoutSharedBuffer.
+//
+// ====================================================================================
+//		Revisions :
+//
+//		17.10.26	- project start
+//		17.10.26	- Readers are read only, AcquireLease is refused
+//
+// ====================================================================================
+//
+/*
+	Redistribution and use in source and binary forms, with or without modification,
+	are permitted provided that the following conditions are met:
+
+		1. Redistributions of source code must retain the above copyright notice,
+		   this list of conditions and the following disclaimer.
+
+		2. Redistributions in binary form must reproduce the above copyright notice,
+		   this list of conditions and the following disclaimer in the documentation
+		   and/or other materials provided with the distribution.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"	AND ANY
+	EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+	OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE	ARE DISCLAIMED.
+	IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+	INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+	PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+	LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+	OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "SpoutFdTransport.h"
+
+#ifndef _WIN32
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// "SPFD"
+#define SPOUT_FD_MAGIC 0x44465053
+
+// Seals a receiver relies on
+#define SPOUT_FD_SEALS (F_SEAL_SHRINK | F_SEAL_GROW)
+
+//
+// Socket helpers
+//
+
+// -----------------------------------------------
+// Socket address of the broker, length zero if invalid
+static socklen_t BrokerAddress(const char* address, sockaddr_un& addr)
+{
+	if (!address || !address[0])
+		address = getenv(SPOUT_FD_BROKER_ENV);
+	if (!address || !address[0])
+		address = SPOUT_FD_BROKER_DEFAULT;
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+
+	const size_t len = strlen(address);
+	if (len >= sizeof(addr.sun_path))
+		return 0;
+
+	// Abstract names start with a zero byte and are not terminated
+	if (address[0] == '@') {
+		memcpy(addr.sun_path + 1, address + 1, len - 1);
+		return static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + len);
+	}
+
+	memcpy(addr.sun_path, address, len);
+	return static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + len + 1);
+}
+
+// -----------------------------------------------
+// Send a message with an optional descriptor
+static bool SendMessage(int sock, const SpoutFdMessage& message, int fd)
+{
+	iovec iov;
+	iov.iov_base = const_cast<SpoutFdMessage*>(&message);
+	iov.iov_len = sizeof(message);
+
+	union {
+		cmsghdr header;
+		char data[CMSG_SPACE(sizeof(int))];
+	} control;
+	memset(&control, 0, sizeof(control));
+
+	msghdr msg;
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+
+	if (fd >= 0) {
+		msg.msg_control = control.data;
+		msg.msg_controllen = sizeof(control.data);
+		cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+		cmsg->cmsg_level = SOL_SOCKET;
+		cmsg->cmsg_type = SCM_RIGHTS;
+		cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+		memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+	}
+
+	// Don't wait for a peer that is not reading
+	const ssize_t sent = sendmsg(sock, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+	return (sent == static_cast<ssize_t>(sizeof(message)));
+}
+
+// -----------------------------------------------
+// Receive a message and the descriptor sent with it, -1 if none.
+// Returns false if the connection has closed or the message is invalid.
+static bool ReceiveMessage(int sock, SpoutFdMessage& message, int* fd, int flags)
+{
+	*fd = -1;
+
+	iovec iov;
+	iov.iov_base = &message;
+	iov.iov_len = sizeof(message);
+
+	union {
+		cmsghdr header;
+		char data[CMSG_SPACE(sizeof(int))];
+	} control;
+
+	msghdr msg;
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control.data;
+	msg.msg_controllen = sizeof(control.data);
+
+	ssize_t received = 0;
+	do {
+		received = recvmsg(sock, &msg, MSG_CMSG_CLOEXEC | flags);
+	} while (received < 0 && errno == EINTR);
+
+	for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); received >= 0 && cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+		if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS && cmsg->cmsg_len >= CMSG_LEN(sizeof(int))) {
+			memcpy(fd, CMSG_DATA(cmsg), sizeof(int));
+			break;
+		}
+	}
+
+	// Truncated control data would have lost descriptors
+	if (received != static_cast<ssize_t>(sizeof(message))
+		|| (msg.msg_flags & (MSG_TRUNC | MSG_CTRUNC))
+		|| message.magic != SPOUT_FD_MAGIC) {
+		if (*fd >= 0)
+			close(*fd);
+		*fd = -1;
+		return false;
+	}
+
+	message.name[sizeof(message.name) - 1] = 0;
+	return true;
+}
+
+// -----------------------------------------------
+// Connect to the broker, -1 if it is not running
+static int ConnectBroker()
+{
+	sockaddr_un addr;
+	const socklen_t addrlen = BrokerAddress(nullptr, addr);
+	if (addrlen == 0) {
+		SpoutLogError("spoutFdBuffer - invalid broker address in %s", SPOUT_FD_BROKER_ENV);
+		return -1;
+	}
+
+	const int sock = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+	if (sock < 0)
+		return -1;
+
+	if (connect(sock, reinterpret_cast<sockaddr*>(&addr), addrlen) != 0) {
+		close(sock);
+		return -1;
+	}
+
+	timeval timeout;
+	timeout.tv_sec = SPOUT_FD_BROKER_TIMEOUT_MSEC/1000;
+	timeout.tv_usec = (SPOUT_FD_BROKER_TIMEOUT_MSEC%1000)*1000;
+	setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+	return sock;
+}
+
+// -----------------------------------------------
+// Send a request and wait for the reply
+static bool BrokerRequest(int sock, SpoutFdMessage& message, int sendfd, int* replyfd)
+{
+	message.magic = SPOUT_FD_MAGIC;
+	if (!SendMessage(sock, message, sendfd))
+		return false;
+
+	SpoutFdMessage reply;
+	if (!ReceiveMessage(sock, reply, replyfd, 0) || reply.type != SPOUT_FD_REPLY) {
+		if (*replyfd >= 0)
+			close(*replyfd);
+		*replyfd = -1;
+		return false;
+	}
+
+	message = reply;
+	return true;
+}
+
+// -----------------------------------------------
+// Descriptor has the seals that fix its size and at least the size given
+static bool CheckSealed(int fd, uint64_t size)
+{
+	const int seals = fcntl(fd, F_GET_SEALS);
+	if (seals < 0 || (seals & SPOUT_FD_SEALS) != SPOUT_FD_SEALS)
+		return false;
+
+	struct stat st;
+	return (fstat(fd, &st) == 0 && st.st_size > 0 && static_cast<uint64_t>(st.st_size) >= size);
+}
+
+//
+// Class: spoutFdBroker
+//
+// Broker mapping sender names to memfd descriptors.
+//
+// Refer to source code for documentation.
+//
+
+struct spoutFdBroker::State {
+
+	struct Entry {
+		int fd; // Read-only memfd descriptor
+		int owner; // Connection of the sender
+		uint64_t size;
+	};
+
+	std::thread thread;
+	std::mutex mutex; // Guards entries for GetSenderCount
+	std::map<std::string, Entry> entries;
+	std::vector<int> clients;
+	std::string path; // Socket file to remove, empty if abstract
+	int listener = -1;
+	int wake[2] = { -1, -1 };
+	bool running = false;
+
+	void Run();
+	void Serve(int client);
+	void Drop(int client);
+	void Reply(int client, uint64_t size, int fd);
+
+};
+
+// -----------------------------------------------
+spoutFdBroker::spoutFdBroker()
+{
+	m_pState = new State;
+}
+
+// -----------------------------------------------
+spoutFdBroker::~spoutFdBroker()
+{
+	Stop();
+	delete m_pState;
+}
+
+// -----------------------------------------------
+// Function: Start
+// Listen on the broker socket and serve requests on a thread.
+//
+//   address - socket address, '@' for the abstract namespace,
+//             null for SPOUT_FD_BROKER_ENV or the default
+//
+// Fails if another broker is listening at the address.
+bool spoutFdBroker::Start(const char* address)
+{
+	State& state = *m_pState;
+	if (state.running)
+		return true;
+
+	sockaddr_un addr;
+	const socklen_t addrlen = BrokerAddress(address, addr);
+	if (addrlen == 0) {
+		SpoutLogError("spoutFdBroker::Start - invalid address");
+		return false;
+	}
+
+	state.listener = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+	if (state.listener < 0) {
+		SpoutLogError("spoutFdBroker::Start - socket failed error = %d", errno);
+		return false;
+	}
+
+	int result = bind(state.listener, reinterpret_cast<sockaddr*>(&addr), addrlen);
+	if (result != 0 && errno == EADDRINUSE && addr.sun_path[0]) {
+		// A socket file left by a broker that has exited can be replaced
+		const int probe = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+		if (probe >= 0 && connect(probe, reinterpret_cast<sockaddr*>(&addr), addrlen) != 0 && errno == ECONNREFUSED) {
+			unlink(addr.sun_path);
+			result = bind(state.listener, reinterpret_cast<sockaddr*>(&addr), addrlen);
+		}
+		if (probe >= 0)
+			close(probe);
+	}
+	if (result != 0 || listen(state.listener, 64) != 0) {
+		if (errno == EADDRINUSE)
+			SpoutLogWarning("spoutFdBroker::Start - a broker is already running");
+		else
+			SpoutLogError("spoutFdBroker::Start - bind failed error = %d", errno);
+		close(state.listener);
+		state.listener = -1;
+		return false;
+	}
+
+	if (pipe2(state.wake, O_CLOEXEC) != 0) {
+		SpoutLogError("spoutFdBroker::Start - pipe failed error = %d", errno);
+		close(state.listener);
+		state.listener = -1;
+		return false;
+	}
+
+	state.path = addr.sun_path[0] ? addr.sun_path : "";
+	state.running = true;
+	state.thread = std::thread(&State::Run, &state);
+
+	SpoutLogNotice("spoutFdBroker::Start - listening");
+
+	return true;
+}
+
+// -----------------------------------------------
+// Function: Stop
+// Stop serving and close all connections.
+//
+// Receivers keep the memory they have mapped.
+void spoutFdBroker::Stop()
+{
+	State& state = *m_pState;
+	if (!state.running)
+		return;
+
+	const char stop = 0;
+	if (write(state.wake[1], &stop, 1) != 1)
+		SpoutLogWarning("spoutFdBroker::Stop - could not wake the broker thread");
+	if (state.thread.joinable())
+		state.thread.join();
+
+	for (size_t i = 0; i < state.clients.size(); i++)
+		close(state.clients[i]);
+	state.clients.clear();
+
+	{
+		std::lock_guard<std::mutex> lock(state.mutex);
+		for (auto& entry : state.entries)
+			close(entry.second.fd);
+		state.entries.clear();
+	}
+
+	close(state.listener);
+	close(state.wake[0]);
+	close(state.wake[1]);
+	state.listener = -1;
+	state.wake[0] = state.wake[1] = -1;
+
+	if (!state.path.empty())
+		unlink(state.path.c_str());
+	state.path.clear();
+
+	state.running = false;
+}
+
+// -----------------------------------------------
+// Function: IsRunning
+// Broker is running.
+bool spoutFdBroker::IsRunning()
+{
+	return m_pState->running;
+}
+
+// -----------------------------------------------
+// Function: GetSenderCount
+// Number of registered senders.
+int spoutFdBroker::GetSenderCount()
+{
+	std::lock_guard<std::mutex> lock(m_pState->mutex);
+	return static_cast<int>(m_pState->entries.size());
+}
+
+// -----------------------------------------------
+// Poll the listener and connections until Stop
+void spoutFdBroker::State::Run()
+{
+	std::vector<pollfd> fds;
+
+	for (;;) {
+
+		fds.clear();
+		fds.push_back({ wake[0], POLLIN, 0 });
+		fds.push_back({ listener, POLLIN, 0 });
+		for (size_t i = 0; i < clients.size(); i++)
+			fds.push_back({ clients[i], POLLIN, 0 });
+
+		if (poll(fds.data(), static_cast<nfds_t>(fds.size()), -1) < 0) {
+			if (errno == EINTR)
+				continue;
+			SpoutLogError("spoutFdBroker - poll failed error = %d", errno);
+			return;
+		}
+
+		if (fds[0].revents)
+			return;
+
+		// Connections first, so that a sender that closed and
+		// registers again is removed before the new registration
+		for (size_t i = 2; i < fds.size(); i++) {
+			if (fds[i].revents & (POLLIN | POLLHUP | POLLERR))
+				Serve(fds[i].fd);
+		}
+
+		if (fds[1].revents & POLLIN) {
+			const int client = accept4(listener, nullptr, nullptr, SOCK_CLOEXEC | SOCK_NONBLOCK);
+			if (client >= 0) {
+				if (clients.size() < SPOUT_FD_BROKER_MAX_CLIENTS) {
+					clients.push_back(client);
+				}
+				else {
+					SpoutLogWarning("spoutFdBroker - too many connections");
+					close(client);
+				}
+			}
+		}
+	}
+}
+
+// -----------------------------------------------
+// Handle a request, or remove a connection that has closed
+void spoutFdBroker::State::Serve(int client)
+{
+	SpoutFdMessage message;
+	int fd = -1;
+	errno = 0;
+	if (!ReceiveMessage(client, message, &fd, MSG_DONTWAIT)) {
+		if (errno != EAGAIN && errno != EWOULDBLOCK)
+			Drop(client);
+		return;
+	}
+
+	if (message.type == SPOUT_FD_REGISTER) {
+		std::lock_guard<std::mutex> lock(mutex);
+		if (fd < 0 || !message.name[0] || entries.count(message.name) || !CheckSealed(fd, message.size)) {
+			SpoutLogWarning("spoutFdBroker - refused to register [%s]", message.name);
+			if (fd >= 0)
+				close(fd);
+			Reply(client, 0, -1);
+			return;
+		}
+		State::Entry entry;
+		entry.fd = fd;
+		entry.owner = client;
+		entry.size = message.size;
+		entries[message.name] = entry;
+		Reply(client, message.size, -1);
+	}
+	else if (message.type == SPOUT_FD_LOOKUP) {
+		if (fd >= 0)
+			close(fd);
+		std::lock_guard<std::mutex> lock(mutex);
+		auto it = entries.find(message.name);
+		if (it != entries.end())
+			Reply(client, it->second.size, it->second.fd);
+		else
+			Reply(client, 0, -1);
+	}
+	else {
+		if (fd >= 0)
+			close(fd);
+		Drop(client);
+	}
+}
+
+// -----------------------------------------------
+// Close a connection and remove the senders it registered
+void spoutFdBroker::State::Drop(int client)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		for (auto it = entries.begin(); it != entries.end();) {
+			if (it->second.owner == client) {
+				close(it->second.fd);
+				it = entries.erase(it);
+			}
+			else {
+				++it;
+			}
+		}
+	}
+
+	for (size_t i = 0; i < clients.size(); i++) {
+		if (clients[i] == client) {
+			clients.erase(clients.begin() + i);
+			break;
+		}
+	}
+	close(client);
+}
+
+// -----------------------------------------------
+void spoutFdBroker::State::Reply(int client, uint64_t size, int fd)
+{
+	SpoutFdMessage reply;
+	memset(&reply, 0, sizeof(reply));
+	reply.magic = SPOUT_FD_MAGIC;
+	reply.type = SPOUT_FD_REPLY;
+	reply.size = size;
+	SendMessage(client, reply, fd);
+}
+
+//
+// Class: spoutFdBuffer
+//
+// spoutSharedBuffer layout in a sealed memfd.
+//
+// Refer to source code for documentation.
+//
+
+// -----------------------------------------------
+spoutFdBuffer::spoutFdBuffer()
+{
+	m_pMemory = nullptr;
+	m_Size = 0;
+	m_Socket = -1;
+}
+
+// -----------------------------------------------
+spoutFdBuffer::~spoutFdBuffer()
+{
+	Close();
+}
+
+// -----------------------------------------------
+// Function: Create
+// Writer create the memory and register it with the broker.
+//
+//   length  - bytes available in each buffer
+//   buffers - number of buffers, 2 to SPOUT_SHARED_BUFFER_MAX
+//
+// Fails if the broker is not running or the name is registered.
+// Receivers that have the previous memory open keep it until they
+// open the name again. Versions start again from one.
+bool spoutFdBuffer::Create(const char* name, int length, int buffers)
+{
+	if (!name || !name[0] || strlen(name) >= sizeof(SpoutFdMessage::name)) {
+		SpoutLogError("spoutFdBuffer::Create - invalid name");
+		return false;
+	}
+
+	const uint64_t size = LayoutSize(length, buffers);
+	if (size == 0) {
+		SpoutLogError("spoutFdBuffer::Create - invalid length %d or buffers %d", length, buffers);
+		return false;
+	}
+
+	Close();
+
+	// The memfd name is only shown in /proc/<pid>/fd
+	std::string memname = "spout_";
+	memname += name;
+	if (memname.size() > 240)
+		memname.resize(240);
+
+	const int fd = memfd_create(memname.c_str(), MFD_CLOEXEC | MFD_ALLOW_SEALING);
+	if (fd < 0) {
+		SpoutLogError("spoutFdBuffer::Create - memfd_create failed error = %d", errno);
+		return false;
+	}
+
+	if (ftruncate(fd, static_cast<off_t>(size)) != 0
+		|| fcntl(fd, F_ADD_SEALS, SPOUT_FD_SEALS | F_SEAL_SEAL) != 0) {
+		SpoutLogError("spoutFdBuffer::Create - could not size and seal the memory error = %d", errno);
+		close(fd);
+		return false;
+	}
+
+	void* pMap = mmap(nullptr, static_cast<size_t>(size), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (pMap == MAP_FAILED) {
+		SpoutLogError("spoutFdBuffer::Create - mmap failed error = %d", errno);
+		close(fd);
+		return false;
+	}
+	m_pMemory = static_cast<char*>(pMap);
+	m_Size = size;
+
+	// New memory, initially zero
+	InitLayout(m_pMemory, length, buffers);
+	Attach(m_pMemory, m_Size);
+
+	// Receivers get a read-only descriptor of the same memory
+	char path[64];
+	snprintf(path, sizeof(path), "/proc/self/fd/%d", fd);
+	int readfd = open(path, O_RDONLY | O_CLOEXEC);
+	if (readfd < 0) {
+		SpoutLogWarning("spoutFdBuffer::Create - no read-only descriptor, receivers can write to [%s]", name);
+		readfd = fd;
+	}
+
+	m_Socket = ConnectBroker();
+	if (m_Socket < 0) {
+		SpoutLogError("spoutFdBuffer::Create - broker is not running");
+		if (readfd != fd)
+			close(readfd);
+		close(fd);
+		Close();
+		return false;
+	}
+
+	SpoutFdMessage message;
+	memset(&message, 0, sizeof(message));
+	message.type = SPOUT_FD_REGISTER;
+	message.size = size;
+	strcpy(message.name, name);
+
+	int replyfd = -1;
+	const bool registered = BrokerRequest(m_Socket, message, readfd, &replyfd) && message.size == size;
+	if (replyfd >= 0)
+		close(replyfd);
+
+	// The mapping and the broker's copy keep the memory
+	if (readfd != fd)
+		close(readfd);
+	close(fd);
+
+	if (!registered) {
+		SpoutLogError("spoutFdBuffer::Create - broker refused [%s], is the name in use?", name);
+		Close();
+		return false;
+	}
+
+	SpoutLogNotice("spoutFdBuffer::Create - [%s] %d buffers of %d bytes", name, buffers, length);
+
+	return true;
+}
+
+// -----------------------------------------------
+// Function: Open
+// Reader get the memory of a registered writer from the broker.
+//
+// Returns false if the broker is not running or the name is not registered.
+// The memory is mapped read only, BeginWrite and Commit must not be used.
+bool spoutFdBuffer::Open(const char* name)
+{
+	if (!name || !name[0] || strlen(name) >= sizeof(SpoutFdMessage::name))
+		return false;
+
+	if (m_pHeader)
+		return true;
+
+	const int sock = ConnectBroker();
+	if (sock < 0)
+		return false;
+
+	SpoutFdMessage message;
+	memset(&message, 0, sizeof(message));
+	message.type = SPOUT_FD_LOOKUP;
+	strcpy(message.name, name);
+
+	int fd = -1;
+	const bool found = BrokerRequest(sock, message, -1, &fd) && fd >= 0 && message.size > 0;
+	close(sock);
+	if (!found) {
+		if (fd >= 0)
+			close(fd);
+		return false;
+	}
+
+	// Without the seals, the writer could shrink the memory under the mapping
+	if (!CheckSealed(fd, message.size)) {
+		SpoutLogWarning("spoutFdBuffer::Open - [%s] memory is not sealed", name);
+		close(fd);
+		return false;
+	}
+
+	void* pMap = mmap(nullptr, static_cast<size_t>(message.size), PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (pMap == MAP_FAILED)
+		return false;
+
+	m_pMemory = static_cast<char*>(pMap);
+	m_Size = message.size;
+
+	if (!Attach(m_pMemory, m_Size)) {
+		Close();
+		return false;
+	}
+	// Leases write to the memory
+	m_bReadOnly = true;
+
+	SpoutLogNotice("spoutFdBuffer::Open - [%s] %d buffers of %d bytes", name, m_pHeader->buffers, m_pHeader->length);
+
+	return true;
+}
+
+// -----------------------------------------------
+// Function: Close
+// Unmap the memory and leave the broker.
+//
+// A writer's name is removed from the broker.
+void spoutFdBuffer::Close()
+{
+	if (m_Socket >= 0)
+		close(m_Socket);
+	m_Socket = -1;
+
+	if (m_pMemory)
+		munmap(m_pMemory, static_cast<size_t>(m_Size));
+	m_pMemory = nullptr;
+	m_Size = 0;
+
+	spoutSharedBuffer::Close();
+}
+
+#endif
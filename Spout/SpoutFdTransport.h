@@ -0,0 +1,147 @@
+/*
+
+					SpoutFdTransport.h
+
+			Linux frame buffers shared as sealed memfd file descriptors
+			passed through a Unix domain socket broker.
+
+	Redistribution and use in source and binary forms, with or without modification,
+	are permitted provided that the following conditions are met:
+
+		1. Redistributions of source code must retain the above copyright notice,
+		   this list of conditions and the following disclaimer.
+
+		2. Redistributions in binary form must reproduce the above copyright notice,
+		   this list of conditions and the following disclaimer in the documentation
+		   and/or other materials provided with the distribution.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"	AND ANY
+	EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+	OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE	ARE DISCLAIMED.
+	IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+	INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+	PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+	LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+	OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#ifndef __spoutFdTransport__
+#define __spoutFdTransport__
+
+#ifndef _WIN32
+
+#include "SpoutCommon.h"
+#include "SpoutSharedBuffer.h"
+
+#include <stdint.h>
+
+using namespace spoututils;
+
+// Environment variable with the broker socket address.
+// A name starting with '@' is in the abstract namespace, otherwise it is a path.
+#define SPOUT_FD_BROKER_ENV "SPOUT_FD_BROKER"
+
+// Default broker socket address
+#define SPOUT_FD_BROKER_DEFAULT "@spout_fd_broker"
+
+// Maximum number of connections to the broker
+#define SPOUT_FD_BROKER_MAX_CLIENTS 256
+
+// Broker reply timeout
+#define SPOUT_FD_BROKER_TIMEOUT_MSEC 1000
+
+//
+// Message exchanged with the broker, one per SOCK_SEQPACKET packet
+//
+// REGISTER carries the sender's read-only descriptor. LOOKUP replies
+// carry the descriptor of the sender if it is registered. size is the
+// size of the memory, zero in a reply if the request failed.
+//
+enum SpoutFdMessageType {
+	SPOUT_FD_REGISTER = 1,
+	SPOUT_FD_LOOKUP,
+	SPOUT_FD_REPLY
+};
+
+struct SpoutFdMessage {
+	uint32_t magic;
+	uint32_t type; // SpoutFdMessageType
+	uint64_t size;
+	char name[256]; // as SpoutMaxSenderNameLen
+};
+
+//
+// Broker mapping sender names to memfd descriptors
+//
+// A sender stays connected while it is registered. Its names are removed
+// when the connection closes, including when the sender process exits.
+// Receivers connect for each lookup. The broker holds a descriptor of each
+// registered memfd, so the memory remains until the sender has gone and
+// the last receiver has unmapped it.
+//
+class SPOUT_DLLEXP spoutFdBroker {
+
+	public:
+
+	spoutFdBroker();
+	~spoutFdBroker();
+	spoutFdBroker(const spoutFdBroker&) = delete;
+	spoutFdBroker& operator=(const spoutFdBroker&) = delete;
+
+	// Listen and serve requests on a thread, address null for the default
+	bool Start(const char* address = nullptr);
+	// Stop serving and close all connections
+	void Stop();
+	// Broker is running
+	bool IsRunning();
+	// Number of registered senders
+	int GetSenderCount();
+
+protected:
+
+	struct State;
+
+	// Avoid C4251 warnings in SpoutLibrary by using a pointer
+	State* m_pState;
+
+};
+
+//
+// spoutSharedBuffer layout in a sealed memfd
+//
+// The writer creates the memfd and registers a read-only descriptor
+// of it with the broker. A reader gets the descriptor from the broker
+// and maps the same pages read only. Reading and writing are as for
+// spoutSharedBuffer, neither side copies the data. A reader can't take
+// a lease as that writes to the memory.
+//
+// The memfd is sealed against changes of size, so a reader
+// can't be faulted by the writer truncating the memory.
+//
+class SPOUT_DLLEXP spoutFdBuffer : public spoutSharedBuffer {
+
+	public:
+
+	spoutFdBuffer();
+	~spoutFdBuffer();
+
+	// Writer create the memory and register it with the broker
+	bool Create(const char* name, int length, int buffers = 2);
+	// Reader get the memory of a registered writer from the broker
+	bool Open(const char* name);
+	// Unmap the memory and leave the broker
+	void Close();
+
+protected:
+
+	char* m_pMemory;
+	uint64_t m_Size; // Bytes mapped
+	int m_Socket; // Writer connection to the broker
+
+};
+
+#endif
+
+#endif
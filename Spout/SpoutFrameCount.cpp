@@ -89,6 +89,23 @@
 //		31.12.23	- Add comments to clarify the purpose of "EnableFrameSync"
 //	Version 2.007.014
 //		04.07.24	- SetNewFrame - add m_hCountSemaphore to initial check
+//		17.10.26	- Add frame metadata shared memory with a sequence lock
+//					  CreateFrameMetadata/OpenFrameMetadata/CloseFrameMetadata
+//					  WriteFrameMetadata/ReadFrameMetadata
+//					- Record texture access wait, sender frame interval and HoldFps
+//					  sleep in histograms. HoldFps without std::chrono uses a class
+//					  start time instead of the global StartTiming/EndTiming.
+//					- Read "Framecount" from spoutSettings instead of the registry
+//					- Add receiver slots shared memory for the sender to see receiver lag
+//					  CreateReceiverSlots/OpenReceiverSlots/CloseReceiverSlots
+//					  SetReceivedFrame/GetReceiverLag
+//					- Add RenameSender to move a sender's named objects to a new name
+//					- Frame metadata version 2 adds the atlas tile layout
+//					- Frame metadata genlockGeneration in place of the reserved word
+//					- Frame metadata layout moved to SpoutFrameMetadata.h so that it can
+//					  be read without D3D11
+//					- UpdateSenderFps without std::chrono times frames with
+//					  spoutHistogram::Now instead of the per thread PC counter
 //
 // ====================================================================================
 //
@@ -134,6 +151,12 @@ spoutFrameCount::spoutFrameCount()
 	m_hSyncEvent = NULL;
 	m_SenderName[0] = 0;
 	m_CountSemaphoreName[0] = 0;
+	m_pFrameMetadata = nullptr;
+	m_FrameMetadataName[0] = 0;
+	m_pReceiverSlots = nullptr;
+	m_ReceiverSlotsName[0] = 0;
+	m_ReceiverSlot = -1;
+	m_ReceiverSlotsRetry = 0;
 	
 	m_FrameCount = 0L;
 	m_LastFrameCount = 0L;
@@ -147,11 +170,8 @@ spoutFrameCount::spoutFrameCount()
 	m_bIsNewFrame = true; // Default true for apps without frame count
 
 	// Check the registry setting for frame counting between sender and receiver
-	m_bFrameCount = false; // default not set
-	DWORD dwFrame = 0;
-	if (ReadDwordFromRegistry(HKEY_CURRENT_USER, "Software\\Leading Edge\\Spout", "Framecount", &dwFrame)) {
-		m_bFrameCount = (dwFrame == 1);
-	}
+	// Read once per process by spoutSettings
+	m_bFrameCount = spoutSettings::Instance().Get().bFrameCount;
 
 	// If frame counting is disabled, set the new frame flag true
 	if (!m_bFrameCount)
@@ -183,6 +203,8 @@ spoutFrameCount::spoutFrameCount()
 #else
 	// Initialize PC msec frequency counter
 	StartCounter();
+	m_HoldStart = spoutHistogram::Now();
+	m_lastFrame = static_cast<double>(m_HoldStart)/1000000.0;
 #endif
 
 }
@@ -202,6 +224,9 @@ spoutFrameCount::~spoutFrameCount()
 	if (m_hAccessMutex) CloseHandle(m_hAccessMutex);
 	if (m_hSyncEvent) CloseHandle(m_hSyncEvent);
 
+	CloseFrameMetadata();
+	CloseReceiverSlots();
+
 }
 
 
@@ -285,6 +310,7 @@ void spoutFrameCount::EnableFrameCount(const char* SenderName)
 #else
 	// Initialize PC msec frequency counter
 	StartCounter();
+	m_lastFrame = static_cast<double>(spoutHistogram::Now())/1000000.0;
 #endif
 
 	// Return if already enabled for this sender
@@ -447,7 +473,9 @@ void spoutFrameCount::HoldFps(int fps)
 
 	// Sleep to reach the target frame time
 	if (elapsedTime < target) {
+		const int64_t sleepStart = spoutHistogram::Now();
 		std::this_thread::sleep_for(std::chrono::milliseconds(static_cast<long long>(target - elapsedTime)));
+		holdtimes.RecordSince(sleepStart);
 	}
 
 	// Set start time for the next frame
@@ -456,14 +484,17 @@ void spoutFrameCount::HoldFps(int fps)
 #else
 
 	// Milliseconds elapsed
-	double elapsedTime = EndTiming();
+	const double elapsedTime = static_cast<double>(spoutHistogram::Now() - m_HoldStart)/1000000.0;
 
 	// Sleep to reach the target frame time
-	if (elapsedTime < target)
+	if (elapsedTime < target) {
+		const int64_t sleepStart = spoutHistogram::Now();
 		Sleep((DWORD)(target - elapsedTime));
+		holdtimes.RecordSince(sleepStart);
+	}
 
 	// Set start time for the next frame
-	StartTiming();
+	m_HoldStart = spoutHistogram::Now();
 
 #endif
 
@@ -645,6 +676,76 @@ void spoutFrameCount::CleanupFrameCount()
 
 }
 
+// -----------------------------------------------
+// Function: RenameSender
+// Sender move the frame count semaphore, texture access mutex,
+// frame metadata and receiver slots to a new sender name.
+//
+// Objects that were not created are not created for the new name.
+// The frame count and the frame metadata sequence continue.
+bool spoutFrameCount::RenameSender(const char* SenderName)
+{
+	if (!SenderName || !*SenderName)
+		return false;
+
+	SpoutLogNotice("spoutFrameCount::RenameSender - [%s]", SenderName);
+
+	bool bResult = true;
+
+	if (m_hAccessMutex) {
+		CloseAccessMutex();
+		if (!CreateAccessMutex(SenderName))
+			bResult = false;
+	}
+
+	strcpy_s(m_SenderName, 256, SenderName);
+
+	if (m_hCountSemaphore) {
+		CloseHandle(m_hCountSemaphore);
+		// The semaphore count is one more than the frames sent
+		sprintf_s(m_CountSemaphoreName, 256, "%s_Count_Semaphore", SenderName);
+		const LONG count = (m_FrameCount >= 0 && m_FrameCount < LONG_MAX) ? m_FrameCount + 1 : 1;
+		m_hCountSemaphore = CreateSemaphoreA(NULL, count, LONG_MAX, m_CountSemaphoreName);
+		if (!m_hCountSemaphore) {
+			SpoutLogError("    could not create frame count semaphore [%s]", m_CountSemaphoreName);
+			bResult = false;
+		}
+	}
+
+	// Opened again with the new name by the next SetFrameSync
+	CloseFrameSync();
+
+	if (m_pFrameMetadata) {
+		// Copy the last frame so receivers of the new name see it
+		// before the next one is sent
+		const uint64_t lock = m_pFrameMetadata->lock.load(std::memory_order_acquire) & ~1ULL;
+		uint64_t words[SPOUT_FRAME_METADATA_WORDS];
+		for (size_t i = 0; i < SPOUT_FRAME_METADATA_WORDS; i++)
+			words[i] = m_pFrameMetadata->words[i].load(std::memory_order_relaxed);
+
+		if (CreateFrameMetadata(SenderName)) {
+			// A map kept open by receivers already has a sequence
+			if (m_pFrameMetadata->lock.load(std::memory_order_relaxed) == 0) {
+				m_pFrameMetadata->lock.store(lock + 1, std::memory_order_relaxed);
+				std::atomic_thread_fence(std::memory_order_release);
+				for (size_t i = 0; i < SPOUT_FRAME_METADATA_WORDS; i++)
+					m_pFrameMetadata->words[i].store(words[i], std::memory_order_relaxed);
+				m_pFrameMetadata->lock.store(lock, std::memory_order_release);
+			}
+		}
+		else {
+			bResult = false;
+		}
+	}
+
+	if (m_pReceiverSlots) {
+		if (!CreateReceiverSlots(SenderName))
+			bResult = false;
+	}
+
+	return bResult;
+}
+
 // =================================================================
 //                     Texture access mutex
 // =================================================================
@@ -664,6 +765,8 @@ void spoutFrameCount::CleanupFrameCount()
 //
 bool spoutFrameCount::CheckTextureAccess(ID3D11Texture2D* D3D11texture)
 {
+	spoutHistogramTimer timer(accesstimes);
+
 	// Test for a keyed mutex.
 	// If no texture was passed in, the function returns false
 	if (IsKeyedMutex(D3D11texture)) {
@@ -949,6 +1052,360 @@ void spoutFrameCount::CloseFrameSync()
 }
 
 
+
+//
+// Group: Frame metadata
+//
+// A fixed layout record "<sendername>_FrameMetadata" published with each frame.
+//
+// The sender writes while it holds the texture access lock, so a receiver
+// that copies the texture under the same lock reads the matching record.
+// The record is guarded by a sequence lock rather than the map mutex,
+// so that a receiver or monitor can read it at any time without waiting.
+//
+
+static_assert(sizeof(SpoutFrameMetadata) % sizeof(uint64_t) == 0, "SpoutFrameMetadata must be 8 byte aligned");
+static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t), "Shared memory atomics must be lock free");
+
+// -----------------------------------------------
+// Steady clock nanoseconds for the metadata timestamp.
+// The same clock for all processes on the system.
+static int64_t GetMetadataTimestamp()
+{
+#ifdef USE_CHRONO
+	return static_cast<int64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count());
+#else
+	LARGE_INTEGER count={};
+	LARGE_INTEGER frequency={};
+	QueryPerformanceCounter(&count);
+	QueryPerformanceFrequency(&frequency);
+	return static_cast<int64_t>(static_cast<double>(count.QuadPart)*1000000000.0/static_cast<double>(frequency.QuadPart));
+#endif
+}
+
+// -----------------------------------------------
+// Function: CreateFrameMetadata
+// Sender create frame metadata shared memory.
+//
+// If receivers still hold a map with the same name open,
+// the existing map is used and the frame sequence continues.
+bool spoutFrameCount::CreateFrameMetadata(const char* SenderName)
+{
+	if (!SenderName || !*SenderName)
+		return false;
+
+	CloseFrameMetadata();
+
+	char szMapName[512]={};
+	sprintf_s(szMapName, 512, "%s_FrameMetadata", SenderName);
+
+	const SpoutCreateResult result = m_FrameMetadataMemory.Create(szMapName, static_cast<int>(sizeof(SpoutFrameMetadataMap)));
+	if (result == SPOUT_CREATE_FAILED) {
+		SpoutLogError("spoutFrameCount::CreateFrameMetadata - could not create [%s]", szMapName);
+		return false;
+	}
+
+	m_pFrameMetadata = reinterpret_cast<SpoutFrameMetadataMap*>(m_FrameMetadataMemory.Buffer());
+	m_pFrameMetadata->version = SPOUT_FRAME_METADATA_VERSION;
+	m_pFrameMetadata->size = static_cast<uint32_t>(sizeof(SpoutFrameMetadata));
+
+	SpoutLogNotice("spoutFrameCount::CreateFrameMetadata - [%s]", szMapName);
+
+	return true;
+}
+
+// -----------------------------------------------
+// Function: OpenFrameMetadata
+// Receiver open frame metadata shared memory.
+//
+// Senders that do not publish metadata have no map.
+// The name is retained and ReadFrameMetadata tries again.
+bool spoutFrameCount::OpenFrameMetadata(const char* SenderName)
+{
+	if (!SenderName || !*SenderName)
+		return false;
+
+	if (m_pFrameMetadata) {
+		if (strcmp(SenderName, m_FrameMetadataName) == 0)
+			return true;
+		CloseFrameMetadata();
+	}
+
+	// Retain the name to try again if the map does not exist yet
+	if (SenderName != m_FrameMetadataName)
+		strcpy_s(m_FrameMetadataName, 256, SenderName);
+
+	char szMapName[512]={};
+	sprintf_s(szMapName, 512, "%s_FrameMetadata", SenderName);
+	if (!m_FrameMetadataMemory.Open(szMapName))
+		return false;
+
+	m_pFrameMetadata = reinterpret_cast<SpoutFrameMetadataMap*>(m_FrameMetadataMemory.Buffer());
+
+	return true;
+}
+
+// -----------------------------------------------
+// Function: CloseFrameMetadata
+// Close frame metadata shared memory.
+void spoutFrameCount::CloseFrameMetadata()
+{
+	if (m_pFrameMetadata)
+		m_FrameMetadataMemory.Close();
+	m_pFrameMetadata = nullptr;
+	m_FrameMetadataName[0] = 0;
+}
+
+// -----------------------------------------------
+// Function: WriteFrameMetadata
+// Sender write metadata for the next frame.
+//
+// Call while the texture access lock is held, before SetNewFrame.
+// The frame sequence and timestamp are set by this function
+// and returned in the metadata argument.
+bool spoutFrameCount::WriteFrameMetadata(SpoutFrameMetadata* metadata)
+{
+	if (!m_pFrameMetadata || !metadata)
+		return false;
+
+	// There is only one writer. An odd value is left
+	// by a sender that closed while writing.
+	const uint64_t lock = m_pFrameMetadata->lock.load(std::memory_order_relaxed) & ~1ULL;
+
+	metadata->sequence = lock/2 + 1;
+	metadata->timestamp = GetMetadataTimestamp();
+
+	uint64_t words[SPOUT_FRAME_METADATA_WORDS];
+	memcpy(words, metadata, sizeof(SpoutFrameMetadata));
+
+	// Odd while writing
+	m_pFrameMetadata->lock.store(lock + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	for (size_t i = 0; i < SPOUT_FRAME_METADATA_WORDS; i++)
+		m_pFrameMetadata->words[i].store(words[i], std::memory_order_relaxed);
+	// Twice the frame sequence when complete
+	m_pFrameMetadata->lock.store(lock + 2, std::memory_order_release);
+
+	return true;
+}
+
+// -----------------------------------------------
+// Function: ReadFrameMetadata
+// Receiver read metadata of the latest frame.
+//
+// Does not block. Returns false if the sender has no metadata,
+// has not written any yet, or a consistent copy could not be
+// read within a few retries.
+bool spoutFrameCount::ReadFrameMetadata(SpoutFrameMetadata* metadata)
+{
+	if (!metadata)
+		return false;
+
+	if (!m_pFrameMetadata) {
+		// Try again for a sender that has not created the map yet
+		if (!m_FrameMetadataName[0] || !OpenFrameMetadata(m_FrameMetadataName))
+			return false;
+	}
+
+	// Layout written by a different version
+	if (m_pFrameMetadata->version != SPOUT_FRAME_METADATA_VERSION
+		|| m_pFrameMetadata->size != sizeof(SpoutFrameMetadata))
+		return false;
+
+	uint64_t words[SPOUT_FRAME_METADATA_WORDS];
+	for (int retry = 0; retry < 64; retry++) {
+		const uint64_t lock1 = m_pFrameMetadata->lock.load(std::memory_order_acquire);
+		if (lock1 == 0)
+			return false; // No frame yet
+		if (lock1 & 1ULL) {
+			// The sender is writing
+			YieldProcessor();
+			continue;
+		}
+		for (size_t i = 0; i < SPOUT_FRAME_METADATA_WORDS; i++)
+			words[i] = m_pFrameMetadata->words[i].load(std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_acquire);
+		const uint64_t lock2 = m_pFrameMetadata->lock.load(std::memory_order_relaxed);
+		if (lock1 == lock2) {
+			memcpy(metadata, words, sizeof(SpoutFrameMetadata));
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+//
+// Receiver slots
+//
+// A receiver writes only its own slot and the sender only reads them,
+// so neither side takes a lock. The sender compares the sequence of its
+// latest frame with the sequence each receiver last copied.
+//
+
+static_assert(sizeof(SpoutReceiverSlot) == 24, "SpoutReceiverSlot must have the same layout for 32 and 64 bit");
+
+// -----------------------------------------------
+// Function: CreateReceiverSlots
+// Sender create receiver slots shared memory.
+//
+// Slots claimed by receivers that still hold the map open are kept.
+bool spoutFrameCount::CreateReceiverSlots(const char* SenderName)
+{
+	if (!SenderName || !*SenderName)
+		return false;
+
+	CloseReceiverSlots();
+
+	char szMapName[512]={};
+	sprintf_s(szMapName, 512, "%s_Receivers", SenderName);
+
+	const SpoutCreateResult result = m_ReceiverSlotsMemory.Create(szMapName, static_cast<int>(sizeof(SpoutReceiverSlotsMap)));
+	if (result == SPOUT_CREATE_FAILED) {
+		SpoutLogError("spoutFrameCount::CreateReceiverSlots - could not create [%s]", szMapName);
+		return false;
+	}
+
+	m_pReceiverSlots = reinterpret_cast<SpoutReceiverSlotsMap*>(m_ReceiverSlotsMemory.Buffer());
+	m_pReceiverSlots->version = SPOUT_RECEIVER_SLOTS_VERSION;
+	m_pReceiverSlots->count = SPOUT_RECEIVER_SLOTS;
+
+	SpoutLogNotice("spoutFrameCount::CreateReceiverSlots - [%s]", szMapName);
+
+	return true;
+}
+
+// -----------------------------------------------
+// Function: OpenReceiverSlots
+// Receiver open receiver slots shared memory.
+//
+// Senders that do not watch receiver lag have no map.
+// The name is retained and SetReceivedFrame tries again
+// once a second.
+bool spoutFrameCount::OpenReceiverSlots(const char* SenderName)
+{
+	if (!SenderName || !*SenderName)
+		return false;
+
+	if (m_pReceiverSlots) {
+		if (strcmp(SenderName, m_ReceiverSlotsName) == 0)
+			return true;
+		CloseReceiverSlots();
+	}
+
+	if (SenderName != m_ReceiverSlotsName)
+		strcpy_s(m_ReceiverSlotsName, 256, SenderName);
+	m_ReceiverSlotsRetry = GetMetadataTimestamp();
+
+	char szMapName[512]={};
+	sprintf_s(szMapName, 512, "%s_Receivers", SenderName);
+	if (!m_ReceiverSlotsMemory.Open(szMapName))
+		return false;
+
+	m_pReceiverSlots = reinterpret_cast<SpoutReceiverSlotsMap*>(m_ReceiverSlotsMemory.Buffer());
+
+	// Layout written by a different version
+	if (m_pReceiverSlots->version != SPOUT_RECEIVER_SLOTS_VERSION
+		|| m_pReceiverSlots->count != SPOUT_RECEIVER_SLOTS) {
+		m_ReceiverSlotsMemory.Close();
+		m_pReceiverSlots = nullptr;
+		return false;
+	}
+
+	return true;
+}
+
+// -----------------------------------------------
+// Function: CloseReceiverSlots
+// Release the receiver slot and close the shared memory.
+void spoutFrameCount::CloseReceiverSlots()
+{
+	if (m_pReceiverSlots) {
+		if (m_ReceiverSlot >= 0)
+			m_pReceiverSlots->slots[m_ReceiverSlot].pid.store(0, std::memory_order_release);
+		m_ReceiverSlotsMemory.Close();
+	}
+	m_pReceiverSlots = nullptr;
+	m_ReceiverSlotsName[0] = 0;
+	m_ReceiverSlot = -1;
+}
+
+// -----------------------------------------------
+// Function: SetReceivedFrame
+// Receiver record the frame just copied.
+//
+// Call while the texture access lock is held so that the
+// frame metadata sequence matches the texture copied.
+void spoutFrameCount::SetReceivedFrame()
+{
+	// The sequence comes from the frame metadata
+	if (!m_pFrameMetadata)
+		return;
+
+	const int64_t now = GetMetadataTimestamp();
+
+	if (!m_pReceiverSlots) {
+		if (!m_ReceiverSlotsName[0] || now - m_ReceiverSlotsRetry < 1000000000LL)
+			return;
+		if (!OpenReceiverSlots(m_ReceiverSlotsName))
+			return;
+	}
+
+	// The lock word is twice the sequence while the sender is not writing
+	const uint64_t sequence = m_pFrameMetadata->lock.load(std::memory_order_acquire)/2;
+
+	if (m_ReceiverSlot < 0) {
+		ClaimReceiverSlot(now, sequence);
+		return;
+	}
+
+	SpoutReceiverSlot& slot = m_pReceiverSlots->slots[m_ReceiverSlot];
+	slot.sequence.store(sequence, std::memory_order_relaxed);
+	slot.heartbeat.store(now, std::memory_order_release);
+}
+
+// -----------------------------------------------
+// Function: GetReceiverLag
+// Sender frames behind for the slowest receiver.
+//
+// Receivers that have not copied a frame within
+// SPOUT_RECEIVER_SLOT_TIMEOUT are not counted.
+// Returns false if there are no receiver slots.
+bool spoutFrameCount::GetReceiverLag(uint64_t* lag, int* receivers)
+{
+	if (!lag)
+		return false;
+
+	*lag = 0;
+	if (receivers) *receivers = 0;
+
+	if (!m_pReceiverSlots || !m_pFrameMetadata)
+		return false;
+
+	const uint64_t latest = m_pFrameMetadata->lock.load(std::memory_order_relaxed)/2;
+	const int64_t now = GetMetadataTimestamp();
+
+	int count = 0;
+	for (int i = 0; i < SPOUT_RECEIVER_SLOTS; i++) {
+		SpoutReceiverSlot& slot = m_pReceiverSlots->slots[i];
+		if (slot.pid.load(std::memory_order_relaxed) == 0)
+			continue;
+		if (now - slot.heartbeat.load(std::memory_order_acquire) > SPOUT_RECEIVER_SLOT_TIMEOUT)
+			continue;
+		const uint64_t sequence = slot.sequence.load(std::memory_order_relaxed);
+		if (latest > sequence && latest - sequence > *lag)
+			*lag = latest - sequence;
+		count++;
+	}
+
+	if (receivers) *receivers = count;
+
+	return true;
+}
+
+
 // ===============================================================================
 //                                Protected
 // ===============================================================================
@@ -1045,12 +1502,16 @@ void spoutFrameCount::UpdateSenderFps(long framecount)
 		// Msecs between this frame and the last
 		m_FrameTime = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(*m_FpsEndPtr - *m_FpsStartPtr).count()/1000000.0);
 #else
-		// End time since last call
-		double thisFrame = GetCounter();
+		// End time since last call. The PC counter is per thread and sends
+		// can come from a thread that never started it.
+		const double thisFrame = static_cast<double>(spoutHistogram::Now())/1000000.0;
 		// Msecs between this frame and the last
 		m_FrameTime = thisFrame - m_lastFrame;
 #endif
 		
+		// Interval of each frame in nanoseconds
+		frametimes.Record(static_cast<uint64_t>(m_FrameTime*1000000.0/static_cast<double>(framecount)));
+
 		if (m_FrameTime > 1.0) { // > 1 msec
 
 			// Frame time in seconds 
@@ -1215,4 +1676,32 @@ bool spoutFrameCount::IsFrameSyncEnabled()
 
 // ===============================================================================
 
+// -----------------------------------------------
+// Claim a free receiver slot, or the slot of a receiver
+// that has not copied a frame within SPOUT_RECEIVER_SLOT_TIMEOUT.
+bool spoutFrameCount::ClaimReceiverSlot(int64_t now, uint64_t sequence)
+{
+	const uint32_t pid = static_cast<uint32_t>(GetCurrentProcessId());
+
+	for (int pass = 0; pass < 2; pass++) {
+		for (int i = 0; i < SPOUT_RECEIVER_SLOTS; i++) {
+			SpoutReceiverSlot& slot = m_pReceiverSlots->slots[i];
+			uint32_t expected = slot.pid.load(std::memory_order_relaxed);
+			if (expected != 0) {
+				// Free slots first
+				if (pass == 0 || now - slot.heartbeat.load(std::memory_order_relaxed) <= SPOUT_RECEIVER_SLOT_TIMEOUT)
+					continue;
+			}
+			// Fill the slot before the sender can see it
+			slot.sequence.store(sequence, std::memory_order_relaxed);
+			slot.heartbeat.store(now, std::memory_order_relaxed);
+			if (slot.pid.compare_exchange_strong(expected, pid, std::memory_order_acq_rel)) {
+				m_ReceiverSlot = i;
+				return true;
+			}
+		}
+	}
 
+	SpoutLogWarning("spoutFrameCount::ClaimReceiverSlot - all %d receiver slots in use", SPOUT_RECEIVER_SLOTS);
+	return false;
+}
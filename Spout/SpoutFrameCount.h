@@ -33,9 +33,14 @@
 
 #include "SpoutCommon.h"
 #include "SpoutSharedMemory.h"
+#include "SpoutHistogram.h"
+#include "SpoutSettings.h"
+#include "SpoutFrameMetadata.h"
 
 #include <string>
 #include <vector>
+#include <atomic>
+#include <stdint.h>
 #include <d3d11.h>
 #pragma comment (lib, "d3d11.lib") // for keyed mutex texture access
 #pragma comment (lib, "Winmm.lib") // for timer resolution functions 
@@ -49,6 +54,32 @@ using namespace spoututils;
 #include <thread>
 #endif
 
+//
+// Receiver slots shared memory "<sendername>_Receivers"
+//
+// Created by the sender. Each receiver claims a free slot and records
+// the sequence of the last frame it copied, so the sender can see how
+// far the slowest receiver is behind. A slot with no update for
+// SPOUT_RECEIVER_SLOT_TIMEOUT is treated as free, which clears the
+// slot of a receiver that closed without releasing it.
+//
+#define SPOUT_RECEIVER_SLOTS_VERSION 1
+#define SPOUT_RECEIVER_SLOTS 16
+#define SPOUT_RECEIVER_SLOT_TIMEOUT 1000000000LL // nanoseconds
+
+struct SpoutReceiverSlot {
+	std::atomic<uint32_t> pid;		// Receiver process id, 0 if free
+	uint32_t reserved;
+	std::atomic<uint64_t> sequence;	// Frame sequence last copied
+	std::atomic<int64_t> heartbeat;	// Time of the copy - steady clock nanoseconds
+};
+
+struct SpoutReceiverSlotsMap {
+	uint32_t version;
+	uint32_t count;
+	SpoutReceiverSlot slots[SPOUT_RECEIVER_SLOTS];
+};
+
 class SPOUT_DLLEXP spoutFrameCount {
 
 	public:
@@ -89,6 +120,8 @@ class SPOUT_DLLEXP spoutFrameCount {
 	bool GetNewFrame();
 	// For class cleanup functions
 	void CleanupFrameCount();
+	// Sender move the named objects to a new sender name
+	bool RenameSender(const char* SenderName);
 
 	//
 	// Mutex locks including DirectX 11 keyed mutex
@@ -131,6 +164,44 @@ class SPOUT_DLLEXP spoutFrameCount {
 	// Check for frame sync option
 	bool IsFrameSyncEnabled();
 
+	//
+	// Frame metadata
+	//
+
+	// Sender create frame metadata shared memory
+	bool CreateFrameMetadata(const char* SenderName);
+	// Receiver open frame metadata shared memory
+	bool OpenFrameMetadata(const char* SenderName);
+	// Close frame metadata shared memory
+	void CloseFrameMetadata();
+	// Sender write metadata for the next frame
+	bool WriteFrameMetadata(SpoutFrameMetadata* metadata);
+	// Receiver read metadata of the latest frame
+	bool ReadFrameMetadata(SpoutFrameMetadata* metadata);
+
+	//
+	// Receiver slots
+	//
+
+	// Sender create receiver slots shared memory
+	bool CreateReceiverSlots(const char* SenderName);
+	// Receiver open receiver slots shared memory
+	bool OpenReceiverSlots(const char* SenderName);
+	// Release the receiver slot and close the shared memory
+	void CloseReceiverSlots();
+	// Receiver record the frame just copied. Call while the texture access lock is held.
+	void SetReceivedFrame();
+	// Sender frames behind for the slowest receiver and the number of active receivers
+	bool GetReceiverLag(uint64_t* lag, int* receivers = nullptr);
+
+	//
+	// Timing distributions in nanoseconds
+	//
+
+	spoutHistogram accesstimes; // wait for texture access
+	spoutHistogram frametimes; // received sender frame interval
+	spoutHistogram holdtimes; // HoldFps sleep
+
 protected:
 
 	// Texture access named mutex
@@ -165,11 +236,29 @@ protected:
 	void StartTimePeriod();
 	void EndTimePeriod();
 
+#ifndef USE_CHRONO
+	// HoldFps start time
+	int64_t m_HoldStart;
+#endif
+
 	// Sync event
 	bool m_bFrameSync;
 	HANDLE m_hSyncEvent;
 	void OpenFrameSync(const char* SenderName);
 
+	// Frame metadata
+	SpoutSharedMemory m_FrameMetadataMemory;
+	SpoutFrameMetadataMap* m_pFrameMetadata;
+	char m_FrameMetadataName[256]; // map opened by a receiver
+
+	// Receiver slots
+	SpoutSharedMemory m_ReceiverSlotsMemory;
+	SpoutReceiverSlotsMap* m_pReceiverSlots;
+	char m_ReceiverSlotsName[256]; // map opened by a receiver
+	int m_ReceiverSlot; // slot claimed by this receiver, -1 if none
+	int64_t m_ReceiverSlotsRetry; // time of the last attempt to open the map
+	bool ClaimReceiverSlot(int64_t now, uint64_t sequence);
+
 #ifdef USE_CHRONO
 
 	// Avoid C4251 warnings in SpoutLibrary by using pointers
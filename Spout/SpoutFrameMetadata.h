@@ -0,0 +1,91 @@
+/*
+
+					SpoutFrameMetadata.h
+
+			Frame metadata layout, without the D3D11 parts of spoutFrameCount
+
+	Redistribution and use in source and binary forms, with or without modification,
+	are permitted provided that the following conditions are met:
+
+		1. Redistributions of source code must retain the above copyright notice,
+		   this list of conditions and the following disclaimer.
+
+		2. Redistributions in binary form must reproduce the above copyright notice,
+		   this list of conditions and the following disclaimer in the documentation
+		   and/or other materials provided with the distribution.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"	AND ANY
+	EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+	OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE	ARE DISCLAIMED.
+	IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+	INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+	PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+	LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+	OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#ifndef __spoutFrameMetadata__
+#define __spoutFrameMetadata__
+
+#include <atomic>
+#include <stdint.h>
+
+//
+// Colour space of the frame pixels
+// Set by the sender and recorded in the frame metadata
+//
+enum SpoutColorSpace {
+	SPOUT_COLORSPACE_UNSPECIFIED = 0,
+	SPOUT_COLORSPACE_SRGB,
+	SPOUT_COLORSPACE_REC709,
+	SPOUT_COLORSPACE_REC2020,
+	SPOUT_COLORSPACE_LINEAR,
+	SPOUT_COLORSPACE_ACESCG,
+};
+
+//
+// Frame metadata
+//
+// Published by the sender with each frame.
+// Fixed layout, 8 byte aligned, the same for 32 and 64 bit.
+// sequence and timestamp are set by WriteFrameMetadata.
+//
+struct SpoutFrameMetadata {
+	uint64_t sequence;		// Frame sequence number
+	int64_t timestamp;		// Publish time - steady clock nanoseconds
+	double time;			// Host timeline time
+	double renderScaleX;	// Host render scale
+	double renderScaleY;
+	uint32_t colorspace;	// SpoutColorSpace
+	uint32_t format;		// Texture format
+	uint32_t width;			// Frame size
+	uint32_t height;
+	uint32_t tileColumns;	// Atlas grid, zero if the frame is not an atlas
+	uint32_t tileRows;
+	uint32_t tileWidth;		// Size of each tile, row major from the top left
+	uint32_t tileHeight;
+	uint32_t tileMask;		// Tiles holding a frame of this time, bit 0 the first tile
+	uint32_t genlockGeneration;	// Low word of the genlock group generation, 0 outside a group
+};
+
+//
+// Frame metadata shared memory "<sendername>_FrameMetadata"
+//
+// The lock word is a sequence lock paired with the frame sequence.
+// It is odd while the sender writes and twice the frame sequence
+// after the write completes. A receiver reads the words of the record
+// and retries if the lock changed, so neither side waits on a mutex.
+//
+#define SPOUT_FRAME_METADATA_VERSION 2
+#define SPOUT_FRAME_METADATA_WORDS (sizeof(SpoutFrameMetadata)/sizeof(uint64_t))
+
+struct SpoutFrameMetadataMap {
+	std::atomic<uint64_t> lock;
+	uint32_t version;
+	uint32_t size;
+	std::atomic<uint64_t> words[SPOUT_FRAME_METADATA_WORDS];
+};
+
+#endif
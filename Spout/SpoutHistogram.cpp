@@ -0,0 +1,310 @@
+//
+//		SpoutHistogram
+//
+//		Thread-safe latency histogram
+//
+//		Counts are kept in log-linear buckets (as HdrHistogram) so that
+//		percentiles are accurate to a few percent over the full range.
+//		Each thread records into one of several shards with relaxed atomic
+//		increments, so threads timing at once do not wait for each other
+//		or corrupt each other's counts. Shards are summed for a snapshot.
+//
+//		Replaces the single StartTiming/EndTiming result with a distribution
+//		for the timing sites in spoutDX and spoutFrameCount.
+//
+// ====================================================================================
+//		Revisions :
+//
+//		17.10.26	- project start
+//
+// ====================================================================================
+//
+/*
+	Redistribution and use in source and binary forms, with or without modification,
+	are permitted provided that the following conditions are met:
+
+		1. Redistributions of source code must retain the above copyright notice,
+		   this list of conditions and the following disclaimer.
+
+		2. Redistributions in binary form must reproduce the above copyright notice,
+		   this list of conditions and the following disclaimer in the documentation
+		   and/or other materials provided with the distribution.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"	AND ANY
+	EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+	OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE	ARE DISCLAIMED.
+	IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+	INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+	PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+	LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+	OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "SpoutHistogram.h"
+
+#include <string.h>
+
+#ifdef USE_CHRONO
+#include <chrono>
+#endif
+
+//
+// Class: spoutHistogram
+//
+// Thread-safe latency histogram with per-thread shards.
+//
+// Refer to source code for documentation.
+//
+
+struct spoutHistogram::Shard {
+	std::atomic<uint64_t> count;
+	std::atomic<uint64_t> sum;
+	std::atomic<uint64_t> min;
+	std::atomic<uint64_t> max;
+	std::atomic<uint64_t> buckets[SPOUT_HISTOGRAM_BUCKETS];
+};
+
+// Shard assigned to each thread on first use
+static std::atomic<unsigned int> g_NextShard(0);
+static thread_local int t_Shard = -1;
+
+static int ThreadShard()
+{
+	if (t_Shard < 0)
+		t_Shard = static_cast<int>(g_NextShard.fetch_add(1, std::memory_order_relaxed) % SPOUT_HISTOGRAM_SHARDS);
+	return t_Shard;
+}
+
+// Index of the most significant bit of a non-zero value
+static int HighBit(uint64_t value)
+{
+	int bit = 0;
+	while (value >>= 1)
+		bit++;
+	return bit;
+}
+
+// -----------------------------------------------
+spoutHistogram::spoutHistogram()
+{
+	m_pShards = new Shard[SPOUT_HISTOGRAM_SHARDS];
+	Reset();
+}
+
+// -----------------------------------------------
+spoutHistogram::~spoutHistogram()
+{
+	delete[] m_pShards;
+}
+
+// -----------------------------------------------
+// Function: Record
+// Record a value, usually nanoseconds.
+//
+// Lock free. Safe to call from any number of threads.
+void spoutHistogram::Record(uint64_t value)
+{
+	Shard& shard = m_pShards[ThreadShard()];
+
+	shard.buckets[BucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+	shard.count.fetch_add(1, std::memory_order_relaxed);
+	shard.sum.fetch_add(value, std::memory_order_relaxed);
+
+	uint64_t current = shard.min.load(std::memory_order_relaxed);
+	while (value < current && !shard.min.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+
+	current = shard.max.load(std::memory_order_relaxed);
+	while (value > current && !shard.max.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+}
+
+// -----------------------------------------------
+// Function: RecordSince
+// Record nanoseconds elapsed since a start time from Now().
+void spoutHistogram::RecordSince(int64_t start)
+{
+	const int64_t elapsed = Now() - start;
+	Record(elapsed > 0 ? static_cast<uint64_t>(elapsed) : 0);
+}
+
+// -----------------------------------------------
+// Function: Snapshot
+// Merge the shards into a snapshot.
+//
+// Values recorded while the snapshot is taken may or may not
+// be included, but counts are never lost or torn.
+void spoutHistogram::Snapshot(spoutHistogramSnapshot& snapshot) const
+{
+	snapshot = spoutHistogramSnapshot();
+	for (int s = 0; s < SPOUT_HISTOGRAM_SHARDS; s++) {
+		const Shard& shard = m_pShards[s];
+		const uint64_t count = shard.count.load(std::memory_order_relaxed);
+		if (count == 0)
+			continue;
+		snapshot.count += count;
+		snapshot.sum += shard.sum.load(std::memory_order_relaxed);
+		const uint64_t min = shard.min.load(std::memory_order_relaxed);
+		const uint64_t max = shard.max.load(std::memory_order_relaxed);
+		if (min < snapshot.min) snapshot.min = min;
+		if (max > snapshot.max) snapshot.max = max;
+		for (int i = 0; i < SPOUT_HISTOGRAM_BUCKETS; i++)
+			snapshot.buckets[i] += shard.buckets[i].load(std::memory_order_relaxed);
+	}
+}
+
+// -----------------------------------------------
+// Function: Reset
+// Clear all counts.
+//
+// Values recorded by other threads during a reset may be partly kept.
+void spoutHistogram::Reset()
+{
+	for (int s = 0; s < SPOUT_HISTOGRAM_SHARDS; s++) {
+		Shard& shard = m_pShards[s];
+		shard.count.store(0, std::memory_order_relaxed);
+		shard.sum.store(0, std::memory_order_relaxed);
+		shard.min.store(UINT64_MAX, std::memory_order_relaxed);
+		shard.max.store(0, std::memory_order_relaxed);
+		for (int i = 0; i < SPOUT_HISTOGRAM_BUCKETS; i++)
+			shard.buckets[i].store(0, std::memory_order_relaxed);
+	}
+}
+
+// -----------------------------------------------
+// Function: Log
+// Log count, mean and percentiles in microseconds.
+void spoutHistogram::Log(const char* name) const
+{
+	spoutHistogramSnapshot snapshot;
+	Snapshot(snapshot);
+	if (snapshot.count == 0)
+		return;
+
+	SpoutLogNotice("%s : %llu samples, usec mean %.1f, min %.1f, p50 %.1f, p90 %.1f, p99 %.1f, max %.1f",
+		name ? name : "spoutHistogram",
+		static_cast<unsigned long long>(snapshot.count),
+		snapshot.Mean()/1000.0,
+		static_cast<double>(snapshot.min)/1000.0,
+		static_cast<double>(snapshot.Percentile(50.0))/1000.0,
+		static_cast<double>(snapshot.Percentile(90.0))/1000.0,
+		static_cast<double>(snapshot.Percentile(99.0))/1000.0,
+		static_cast<double>(snapshot.max)/1000.0);
+}
+
+// -----------------------------------------------
+// Function: Now
+// Steady clock nanoseconds.
+int64_t spoutHistogram::Now()
+{
+#ifdef USE_CHRONO
+	return static_cast<int64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count());
+#else
+	LARGE_INTEGER count={};
+	LARGE_INTEGER frequency={};
+	QueryPerformanceCounter(&count);
+	QueryPerformanceFrequency(&frequency);
+	return static_cast<int64_t>(static_cast<double>(count.QuadPart)*1000000000.0/static_cast<double>(frequency.QuadPart));
+#endif
+}
+
+// -----------------------------------------------
+// Function: BucketIndex
+// Bucket index for a value.
+int spoutHistogram::BucketIndex(uint64_t value)
+{
+	const uint64_t sub = 1ULL << SPOUT_HISTOGRAM_SUB_BITS;
+	if (value < sub)
+		return static_cast<int>(value);
+
+	int bit = HighBit(value);
+	if (bit >= SPOUT_HISTOGRAM_MAX_BITS)
+		return SPOUT_HISTOGRAM_BUCKETS - 1;
+
+	const int shift = bit - SPOUT_HISTOGRAM_SUB_BITS;
+	return ((shift + 1) << SPOUT_HISTOGRAM_SUB_BITS) + static_cast<int>((value >> shift) - sub);
+}
+
+// -----------------------------------------------
+// Function: BucketValue
+// Representative value of a bucket, the middle of its range.
+uint64_t spoutHistogram::BucketValue(int index)
+{
+	const uint64_t sub = 1ULL << SPOUT_HISTOGRAM_SUB_BITS;
+	if (index < static_cast<int>(sub))
+		return static_cast<uint64_t>(index);
+
+	const int shift = (index >> SPOUT_HISTOGRAM_SUB_BITS) - 1;
+	const uint64_t low = (sub + static_cast<uint64_t>(index & (sub - 1))) << shift;
+	return low + ((1ULL << shift) >> 1);
+}
+
+//
+// Struct: spoutHistogramSnapshot
+//
+
+// -----------------------------------------------
+spoutHistogramSnapshot::spoutHistogramSnapshot()
+{
+	count = 0;
+	sum = 0;
+	min = UINT64_MAX;
+	max = 0;
+	memset(buckets, 0, sizeof(buckets));
+}
+
+// -----------------------------------------------
+// Function: Merge
+// Add the counts of another snapshot,
+// for example to combine several instances.
+void spoutHistogramSnapshot::Merge(const spoutHistogramSnapshot& other)
+{
+	count += other.count;
+	sum += other.sum;
+	if (other.min < min) min = other.min;
+	if (other.max > max) max = other.max;
+	for (int i = 0; i < SPOUT_HISTOGRAM_BUCKETS; i++)
+		buckets[i] += other.buckets[i];
+}
+
+// -----------------------------------------------
+// Function: Percentile
+// Value at a percentile 0-100.
+//
+// Within a bucket width of the recorded value
+// and limited to the recorded minimum and maximum.
+uint64_t spoutHistogramSnapshot::Percentile(double percentile) const
+{
+	if (count == 0)
+		return 0;
+
+	if (percentile <= 0.0) return min;
+	if (percentile >= 100.0) return max;
+
+	// Rank of the value, at least one
+	uint64_t rank = static_cast<uint64_t>(percentile*static_cast<double>(count)/100.0 + 0.5);
+	if (rank == 0) rank = 1;
+
+	uint64_t total = 0;
+	for (int i = 0; i < SPOUT_HISTOGRAM_BUCKETS; i++) {
+		total += buckets[i];
+		if (total >= rank) {
+			uint64_t value = spoutHistogram::BucketValue(i);
+			if (value < min) value = min;
+			if (value > max) value = max;
+			return value;
+		}
+	}
+
+	return max;
+}
+
+// -----------------------------------------------
+// Function: Mean
+// Mean value.
+double spoutHistogramSnapshot::Mean() const
+{
+	if (count == 0)
+		return 0.0;
+	return static_cast<double>(sum)/static_cast<double>(count);
+}
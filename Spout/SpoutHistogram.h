@@ -0,0 +1,131 @@
+/*
+
+					SpoutHistogram.h
+
+			Thread-safe latency histogram with per-thread shards
+
+	Redistribution and use in source and binary forms, with or without modification,
+	are permitted provided that the following conditions are met:
+
+		1. Redistributions of source code must retain the above copyright notice,
+		   this list of conditions and the following disclaimer.
+
+		2. Redistributions in binary form must reproduce the above copyright notice,
+		   this list of conditions and the following disclaimer in the documentation
+		   and/or other materials provided with the distribution.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"	AND ANY
+	EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+	OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE	ARE DISCLAIMED.
+	IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+	INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+	PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+	LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+	OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#ifndef __spoutHistogram__
+#define __spoutHistogram__
+
+#include "SpoutCommon.h"
+
+#include <atomic>
+#include <stdint.h>
+
+using namespace spoututils;
+
+//
+// Bucket layout
+//
+// Values below 2^SUB_BITS have a bucket each. Above that, each power
+// of two is divided into 2^SUB_BITS buckets, so the bucket width is
+// within about 3% of the value. Nanosecond values up to about 68 seconds
+// are counted, larger values are counted in the last bucket.
+//
+#define SPOUT_HISTOGRAM_SUB_BITS 5
+#define SPOUT_HISTOGRAM_MAX_BITS 36
+#define SPOUT_HISTOGRAM_BUCKETS ((SPOUT_HISTOGRAM_MAX_BITS - SPOUT_HISTOGRAM_SUB_BITS + 1) << SPOUT_HISTOGRAM_SUB_BITS)
+
+// Number of shards. Threads are assigned a shard in turn.
+#define SPOUT_HISTOGRAM_SHARDS 4
+
+//
+// Merged counts of a histogram at one time
+//
+struct SPOUT_DLLEXP spoutHistogramSnapshot {
+
+	spoutHistogramSnapshot();
+
+	// Add the counts of another snapshot
+	void Merge(const spoutHistogramSnapshot& other);
+	// Value at a percentile 0-100
+	uint64_t Percentile(double percentile) const;
+	// Mean value
+	double Mean() const;
+
+	uint64_t count;
+	uint64_t sum;
+	uint64_t min;
+	uint64_t max;
+	uint64_t buckets[SPOUT_HISTOGRAM_BUCKETS];
+
+};
+
+class SPOUT_DLLEXP spoutHistogram {
+
+	public:
+
+	spoutHistogram();
+	~spoutHistogram();
+	spoutHistogram(const spoutHistogram&) = delete;
+	spoutHistogram& operator=(const spoutHistogram&) = delete;
+
+	// Record a value, usually nanoseconds
+	void Record(uint64_t value);
+	// Record nanoseconds elapsed since a start time from Now()
+	void RecordSince(int64_t start);
+	// Merge the shards into a snapshot
+	void Snapshot(spoutHistogramSnapshot& snapshot) const;
+	// Clear all counts
+	void Reset();
+	// Log count, mean and percentiles in microseconds
+	void Log(const char* name) const;
+
+	// Steady clock nanoseconds
+	static int64_t Now();
+
+	// Bucket index for a value
+	static int BucketIndex(uint64_t value);
+	// Representative value of a bucket
+	static uint64_t BucketValue(int index);
+
+protected:
+
+	struct Shard;
+
+	// Avoid C4251 warnings in SpoutLibrary by using a pointer
+	Shard* m_pShards;
+
+};
+
+//
+// Record the time from construction to destruction
+//
+class SPOUT_DLLEXP spoutHistogramTimer {
+
+	public:
+
+	explicit spoutHistogramTimer(spoutHistogram& histogram)
+		: m_histogram(histogram), m_start(spoutHistogram::Now()) {}
+	~spoutHistogramTimer() { m_histogram.RecordSince(m_start); }
+
+protected:
+
+	spoutHistogram& m_histogram;
+	int64_t m_start;
+
+};
+
+#endif
@@ -110,6 +110,11 @@
 	Version 2.007.014
 	20.06.24 - Add GetSenderIndex
 	23.08.24 - GetSenderInfo, SetSenderID - initialize SharedTextureInfo
+	17.10.26 - Read MaxSenders from spoutSettings instead of the registry
+			   SetMaxSenders - reload spoutSettings after the registry write
+			   Add RenameSender
+			   RegisterSenderName - increment the name within the list already read
+			   Add RegisterSenderNames
 
 
 	- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -155,11 +160,9 @@ spoutSenderNames::spoutSenderNames() {
 	// 15.09.18 - moved from interop class
 	// 06.06.19 - increase default maximum number of senders from 10 to 256
 	// 28.08.20 - decreased from 256 to 64
-	// Read the registry key if it exists
-	DWORD dwSenders = 64; // default maximum number of senders.
-	ReadDwordFromRegistry(HKEY_CURRENT_USER, "Software\\Leading Edge\\Spout", "MaxSenders", &dwSenders);
-	// If the registry read fails, the default will be used
-	m_MaxSenders = (int)dwSenders;
+	// Registry setting read once per process by spoutSettings.
+	// If the registry read fails, the default of 64 is used.
+	m_MaxSenders = spoutSettings::Instance().Get().maxSenders;
 
 }
 
@@ -212,13 +215,15 @@ bool spoutSenderNames::RegisterSenderName(char* Sendername, bool bNewname) {
 	if (bNewname) {
 		// If a sender with this name is already registered
 		// create an incremented name by appending '-1' '_2' etc.
-		if (FindSenderName(Sendername)) {
+		// The list is locked and already read, so look in it
+		// rather than read it again for every name tried.
+		if (SenderNames.find(Sendername) != SenderNames.end()) {
 			char name[256]{};
 			int i = 1;
 			do {
 				sprintf_s(name, 256, "%s_%d", Sendername, i);
 				i++;
-			} while (FindSenderName(name));
+			} while (SenderNames.find(name) != SenderNames.end());
 			// Re-set the sender name
 			strcpy_s(Sendername, 256, name);
 		}
@@ -243,13 +248,122 @@ bool spoutSenderNames::RegisterSenderName(char* Sendername, bool bNewname) {
 		// The active sender is the one selected by the user or the last one 
 		// opened by the user, so don't limit to the first sender in the list.
 		// Thereafter the user can select an active Sender using SpoutPanel.
-		SetActiveSender(Sendername);
+		// The name is in the list we hold, so set it directly
+		// rather than with SetActiveSender, which reads the list again.
+		setActiveSenderName(Sendername);
 	}
 	m_senderNames.Unlock();
 
 	return ret.second;
 }
 
+//---------------------------------------------------------
+// Function: RegisterSenderNames
+// Register a number of senders with one lock of the list of Sender names
+//   The list is read and written once for all the names
+//   instead of once for each, as when many senders start together.
+// bool bNewname
+//   Names already registered are incremented as for RegisterSenderName
+//   and the new names returned in sendernames. The suffixes in use
+//   are found in one pass over the list.
+// std::vector<bool>* registered
+//   Optional, set to whether each name was registered
+// Returns the number of names registered.
+// The last name registered becomes the active sender.
+int spoutSenderNames::RegisterSenderNames(std::vector<std::string>& sendernames, bool bNewname, std::vector<bool>* registered)
+{
+	if (registered)
+		registered->assign(sendernames.size(), false);
+
+	if (sendernames.empty())
+		return 0;
+
+	// Create the shared memory for the sender name set if it does not exist
+	if (!CreateSenderSet())
+		return 0;
+
+	char* pBuf = m_senderNames.Lock();
+	if (!pBuf) return 0;
+
+	std::set<std::string> SenderNames;
+	readSenderSetFromBuffer(pBuf, SenderNames, m_MaxSenders);
+
+	// Without the increment a name already in the list is only registered
+	// if it was left by a sender that has gone. Look for those once for all names.
+	if (!bNewname) {
+		for (const auto& name : sendernames) {
+			if (SenderNames.find(name) != SenderNames.end()) {
+				cleanSenderSet();
+				readSenderSetFromBuffer(pBuf, SenderNames, m_MaxSenders);
+				break;
+			}
+		}
+	}
+
+	// Suffixes in use for each name, "name_2" uses 2 of "name",
+	// and the lowest suffix that may still be free
+	std::unordered_map<std::string, std::unordered_set<int>> suffixes;
+	std::unordered_map<std::string, int> nextsuffix;
+	std::string base;
+	int suffix = 0;
+	if (bNewname) {
+		for (const auto& name : SenderNames) {
+			if (splitSenderName(name, base, suffix))
+				suffixes[base].insert(suffix);
+		}
+	}
+
+	int count = 0;
+	size_t active = sendernames.size();
+	for (size_t i = 0; i < sendernames.size(); i++) {
+
+		if ((int)SenderNames.size() >= m_MaxSenders) {
+			SpoutLogWarning("spoutSenderNames::RegisterSenderNames - Senders exceed max senders (%d)\n", m_MaxSenders);
+			break;
+		}
+
+		std::string name = sendernames[i];
+		if (name.empty() || name.size() >= SpoutMaxSenderNameLen)
+			continue;
+
+		if (bNewname && SenderNames.find(name) != SenderNames.end()) {
+			// Suffixes are only taken, never freed, during the batch
+			// so each search starts where the last one for this name stopped
+			const auto& used = suffixes[name];
+			int& next = nextsuffix[name];
+			if (next < 1) next = 1;
+			while (used.find(next) != used.end())
+				next++;
+			name += "_" + std::to_string(next);
+			if (name.size() >= SpoutMaxSenderNameLen)
+				continue;
+		}
+
+		if (!SenderNames.insert(name).second)
+			continue;
+
+		if (splitSenderName(name, base, suffix))
+			suffixes[base].insert(suffix);
+
+		sendernames[i] = name;
+		if (registered)
+			(*registered)[i] = true;
+		active = i;
+		count++;
+	}
+
+	if (count > 0) {
+		// write the new map to shared memory
+		writeBufferFromSenderSet(SenderNames, pBuf, m_MaxSenders);
+		// The names are in the list we hold, so set the active sender
+		// directly rather than with SetActiveSender, which reads it again.
+		setActiveSenderName(sendernames[active].c_str());
+	}
+	m_senderNames.Unlock();
+
+	return count;
+}
+
 //---------------------------------------------------------
 // Function: ReleaseSenderName
 // Remove a Sender from the set of Sender names
@@ -557,6 +671,8 @@ void spoutSenderNames::SetMaxSenders(int maxSenders)
 	m_MaxSenders = maxSenders;
 	// Set to the registry so that other applications will read the new maximum size
 	WriteDwordToRegistry(HKEY_CURRENT_USER, "Software\\Leading Edge\\Spout", "MaxSenders", (DWORD)maxSenders);
+	// and for new objects in this process
+	spoutSettings::Instance().Reload();
 }
 
 int spoutSenderNames::GetMaxSenders()
@@ -886,6 +1002,53 @@ bool spoutSenderNames::UpdateSender(const char *sendername, unsigned int width,
 		
 } // end UpdateSender
 
+//---------------------------------------------------------
+// Function: RenameSender
+//	Move an existing sender to a new name.
+//	The new name is registered and the sender information copied
+//	to it before the old name is released, so the sender stays listed.
+//	If a sender with the new name exists, the name is incremented
+//	and returned as for CreateSender.
+bool spoutSenderNames::RenameSender(const char* oldname, char* newname)
+{
+	if (!oldname || !newname || !newname[0])
+		return false;
+
+	// The copy keeps the share handle, format, sender ID and executable path
+	SharedTextureInfo info={};
+	if (!getSharedInfo(oldname, &info)) {
+		SpoutLogWarning("spoutSenderNames::RenameSender - no information for [%s]", oldname);
+		return false;
+	}
+
+	if (!RegisterSenderName(newname, true))
+		return false;
+
+	if (m_senders->find(newname) == m_senders->end()) {
+		SpoutSharedMemory *senderInfoMem = new SpoutSharedMemory();
+		const SpoutCreateResult result = senderInfoMem->Create(newname, sizeof(SharedTextureInfo));
+		if (result == SPOUT_CREATE_FAILED) {
+			delete senderInfoMem;
+			ReleaseSenderName(newname);
+			return false;
+		}
+		(*m_senders)[newname] = senderInfoMem;
+	}
+
+	if (!setSharedInfo(newname, &info)) {
+		ReleaseSenderName(newname);
+		return false;
+	}
+
+	// Also deletes the information of the old name
+	ReleaseSenderName(oldname);
+
+	SpoutLogNotice("spoutSenderNames::RenameSender - [%s] to [%s]", oldname, newname);
+
+	return true;
+
+} // end RenameSender
+
 // ===============================================================================
 //	Functions to retrieve information about the shared texture of a sender
 //
@@ -1056,6 +1219,27 @@ void spoutSenderNames::CleanSenders()
 // Private functions for multiple Sender support //
 ///////////////////////////////////////////////////
 
+bool spoutSenderNames::splitSenderName(const std::string& name, std::string& base, int& suffix)
+{
+	const size_t pos = name.rfind('_');
+	if (pos == std::string::npos || pos == 0 || pos + 1 >= name.size())
+		return false;
+
+	// Digits only, no leading zero, so that each suffix has one spelling
+	if (name[pos + 1] == '0' || name.size() - pos - 1 > 9)
+		return false;
+	int value = 0;
+	for (size_t i = pos + 1; i < name.size(); i++) {
+		if (name[i] < '0' || name[i] > '9')
+			return false;
+		value = value*10 + (name[i] - '0');
+	}
+
+	base = name.substr(0, pos);
+	suffix = value;
+	return true;
+}
+
 void spoutSenderNames::readSenderSetFromBuffer(const char* buffer, std::set<std::string>& SenderNames, int maxSenders)
 {
 	const char* buf = buffer;
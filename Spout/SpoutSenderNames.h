@@ -38,6 +38,7 @@
 
 #include "SpoutCommon.h"
 #include "SpoutSharedMemory.h"
+#include "SpoutSettings.h"
 
 #include <windowsx.h>
 #include <wingdi.h>
@@ -46,6 +47,7 @@
 #include <string>
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
 #include <intrin.h> // for __movsd
 #include <stdint.h> // for _uint32
 #include <assert.h>
@@ -106,6 +108,8 @@ class SPOUT_DLLEXP spoutSenderNames {
 
 		// Register a sender name in the list of senders
 		bool RegisterSenderName(char* sendername, bool bNewname = false);
+		// Register a number of sender names with one update of the list
+		int RegisterSenderNames(std::vector<std::string>& sendernames, bool bNewname = false, std::vector<bool>* registered = nullptr);
 		// Remove a name from the list
 		bool ReleaseSenderName(const char* sendername);
 		// Find a name in the list
@@ -175,6 +179,8 @@ class SPOUT_DLLEXP spoutSenderNames {
 		bool CreateSender(char* sendername, unsigned int width, unsigned int height, HANDLE hSharehandle, DWORD dwFormat = 0);
 		// Update an existing sender
 		bool UpdateSender (const char* sendername, unsigned int width, unsigned int height, HANDLE hSharehandle, DWORD dwFormat = 0);
+		// Move an existing sender to a new name, incremented if it exists
+		bool RenameSender (const char* oldname, char* newname);
 		// Check details of a sender
 		bool CheckSender  (const char* sendername, unsigned int &width, unsigned int &height, HANDLE &hSharehandle, DWORD &dwFormat);
 		// Find a sender and return details
@@ -199,6 +205,9 @@ protected:
 		// any that shouldn't still be around
 		void cleanSenderSet();
 
+		// Split "name_2" into "name" and 2, false if there is no numeric suffix
+		static bool splitSenderName(const std::string& name, std::string& base, int& suffix);
+
 		// Functions to manage shared memory map access
 		static void readSenderSetFromBuffer(const char* buffer, std::set<std::string>& SenderNames, int maxSenders);
 		static void	writeBufferFromSenderSet(const std::set<std::string>& SenderNames, char *buffer, int maxSenders);
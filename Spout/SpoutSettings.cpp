@@ -0,0 +1,489 @@
+//
+//		SpoutSettings
+//
+//		Process-wide Spout settings
+//
+//		The registry settings used to be read by each spoutDX, spoutSenderNames
+//		and spoutFrameCount object as it was created, so every sender or receiver
+//		in a process read the same values again. They are now loaded once per
+//		process and published under a sequence lock. Readers copy them and
+//		never take a lock. A background thread checks for changes and
+//		publishes the new values when the source has changed.
+//
+//		Values can be read from a settings file instead of the registry,
+//		for tests and for machines without the Spout registry keys.
+//		The file has one "name=value" per line, with the same names as
+//		the registry values. Lines starting with '#' or ';' are comments.
+//
+//			# Spout settings
+//			MaxSenders=64
+//			Framecount=1
+//
+//		The file is used if the environment variable SPOUT_SETTINGS_FILE
+//		is set to its path, or after SetFilePath.
+//
+// ====================================================================================
+//		Revisions :
+//
+//		17.10.26	- project start
+//		17.10.26	- Publish under a sequence lock instead of keeping every load in memory.
+//					  Get returns a copy. A load that found the same values publishes nothing.
+//		17.10.26	- Add Existing, for modules that stop the watch on unload
+//
+// ====================================================================================
+//
+/*
+	Redistribution and use in source and binary forms, with or without modification,
+	are permitted provided that the following conditions are met:
+
+		1. Redistributions of source code must retain the above copyright notice,
+		   this list of conditions and the following disclaimer.
+
+		2. Redistributions in binary form must reproduce the above copyright notice,
+		   this list of conditions and the following disclaimer in the documentation
+		   and/or other materials provided with the distribution.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"	AND ANY
+	EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+	OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE	ARE DISCLAIMED.
+	IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+	INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+	PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+	LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+	OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "SpoutSettings.h"
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+//
+// Class: spoutSettings
+//
+// Process-wide Spout settings with lock-free reads.
+//
+// Refer to source code for documentation.
+//
+
+struct spoutSettings::State {
+
+	// Current values as whole words under a sequence lock.
+	// The sequence is odd while a load is storing them.
+	static const size_t nWords = (sizeof(spoutSettingsValues) + sizeof(uint64_t) - 1)/sizeof(uint64_t);
+	std::atomic<unsigned int> sequence;
+	std::atomic<uint64_t> published[nWords];
+
+	// The values published last, read and written with the mutex locked
+	spoutSettingsValues last;
+
+	// Guards loading and the watch state
+	std::mutex mutex;
+
+	std::string filepath;
+	long long filetime;
+	long long filesize;
+
+	std::thread watch;
+	std::condition_variable wake;
+	bool bStop;
+
+#ifdef _WIN32
+	HKEY hKey;
+	HANDLE hEvent;
+#endif
+
+	void Load();
+	bool Changed();
+	void Watch();
+	bool ReadFile(spoutSettingsValues& values);
+#ifdef _WIN32
+	void ReadRegistry(spoutSettingsValues& values);
+	bool RegistryChanged();
+	void CloseRegistry();
+#endif
+
+};
+
+// Modified time and size of a file
+static bool FileStat(const std::string& path, long long& mtime, long long& size)
+{
+#ifdef _WIN32
+	struct _stat64 st;
+	if (_stat64(path.c_str(), &st) != 0)
+		return false;
+#else
+	struct stat st;
+	if (stat(path.c_str(), &st) != 0)
+		return false;
+#endif
+	mtime = static_cast<long long>(st.st_mtime);
+	size = static_cast<long long>(st.st_size);
+	return true;
+}
+
+// The settings once Instance has constructed them
+static std::atomic<spoutSettings*> g_pInstance(nullptr);
+
+// Case insensitive compare
+static bool SameName(const char* a, const char* b)
+{
+	while (*a && *b) {
+		if (tolower(static_cast<unsigned char>(*a)) != tolower(static_cast<unsigned char>(*b)))
+			return false;
+		a++;
+		b++;
+	}
+	return *a == *b;
+}
+
+// -----------------------------------------------
+spoutSettings::spoutSettings()
+{
+	m_pState = new State;
+	m_pState->sequence.store(0);
+	for (size_t i = 0; i < State::nWords; i++)
+		m_pState->published[i].store(0);
+	m_pState->last = {};
+	m_pState->filetime = 0;
+	m_pState->filesize = 0;
+	m_pState->bStop = false;
+#ifdef _WIN32
+	m_pState->hKey = NULL;
+	m_pState->hEvent = NULL;
+#endif
+
+	const char* path = getenv(SPOUT_SETTINGS_FILE_ENV);
+	if (path && *path)
+		m_pState->filepath = path;
+
+	Reload();
+	StartWatch();
+
+	g_pInstance.store(this);
+}
+
+// -----------------------------------------------
+spoutSettings::~spoutSettings()
+{
+	g_pInstance.store(nullptr);
+	StopWatch();
+#ifdef _WIN32
+	m_pState->CloseRegistry();
+#endif
+	delete m_pState;
+}
+
+// -----------------------------------------------
+// Function: Instance
+// The process-wide settings, loaded on first use.
+spoutSettings& spoutSettings::Instance()
+{
+	static spoutSettings settings;
+	return settings;
+}
+
+// -----------------------------------------------
+// Function: Existing
+// The process-wide settings if they have been used, or null.
+//
+// Does not load them, so a module can stop the watch
+// on unload without reading the settings first.
+spoutSettings* spoutSettings::Existing()
+{
+	return g_pInstance.load();
+}
+
+// -----------------------------------------------
+// Function: Get
+// Current values.
+//
+// Lock free. A copy of the values of the last load, retried
+// while a load is storing new ones.
+spoutSettingsValues spoutSettings::Get() const
+{
+	uint64_t words[State::nWords];
+	for (;;) {
+		const unsigned int sequence = m_pState->sequence.load(std::memory_order_acquire);
+		if (sequence & 1) {
+			std::this_thread::yield();
+			continue;
+		}
+		for (size_t i = 0; i < State::nWords; i++)
+			words[i] = m_pState->published[i].load(std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (m_pState->sequence.load(std::memory_order_relaxed) == sequence)
+			break;
+	}
+
+	spoutSettingsValues values;
+	memcpy(&values, words, sizeof(values));
+	return values;
+}
+
+// -----------------------------------------------
+// Function: Reload
+// Load the values again now.
+void spoutSettings::Reload()
+{
+	std::lock_guard<std::mutex> lock(m_pState->mutex);
+	m_pState->Load();
+}
+
+// -----------------------------------------------
+// Function: SetFilePath
+// Read from a settings file instead of the registry.
+// A null or empty path reverts to the registry.
+void spoutSettings::SetFilePath(const char* path)
+{
+	std::lock_guard<std::mutex> lock(m_pState->mutex);
+	m_pState->filepath = path ? path : "";
+	m_pState->filetime = 0;
+	m_pState->filesize = 0;
+	m_pState->Load();
+}
+
+// -----------------------------------------------
+// Function: GetFilePath
+// Settings file in use, empty for the registry.
+std::string spoutSettings::GetFilePath() const
+{
+	std::lock_guard<std::mutex> lock(m_pState->mutex);
+	return m_pState->filepath;
+}
+
+// -----------------------------------------------
+// Function: StartWatch
+// Start the background check for changes.
+//
+// Started when the settings are first used. A module that
+// stopped it on unload starts it again when loaded again.
+void spoutSettings::StartWatch()
+{
+	std::lock_guard<std::mutex> lock(m_pState->mutex);
+	if (m_pState->watch.joinable())
+		return;
+	m_pState->bStop = false;
+	m_pState->watch = std::thread(&State::Watch, m_pState);
+}
+
+// -----------------------------------------------
+// Function: StopWatch
+// Stop the background check.
+//
+// A module that is unloaded with FreeLibrary should call this
+// before unload. The thread cannot be joined from DllMain.
+void spoutSettings::StopWatch()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_pState->mutex);
+		m_pState->bStop = true;
+	}
+	m_pState->wake.notify_all();
+	if (m_pState->watch.joinable())
+		m_pState->watch.join();
+}
+
+//
+// State
+//
+
+// Load and publish the values if they changed. Called with the mutex locked.
+void spoutSettings::State::Load()
+{
+	spoutSettingsValues values = {};
+	values.bMemoryShare = false;
+	values.bDX9 = false;
+	values.bFrameCount = false;
+	values.maxSenders = 64; // default maximum number of senders
+
+	if (!filepath.empty()) {
+		if (!ReadFile(values))
+			SpoutLogWarning("spoutSettings - could not read settings file [%s], using defaults", filepath.c_str());
+	}
+#ifdef _WIN32
+	else {
+		ReadRegistry(values);
+	}
+#endif
+
+	const spoutSettingsValues& previous = last;
+	if (previous.generation != 0) {
+		// A load that found the same values publishes nothing
+		if (previous.bMemoryShare == values.bMemoryShare
+			&& previous.bDX9 == values.bDX9
+			&& previous.bFrameCount == values.bFrameCount
+			&& previous.maxSenders == values.maxSenders)
+			return;
+		SpoutLogNotice("spoutSettings - settings changed (MemoryShare %d, DX9 %d, Framecount %d, MaxSenders %d)",
+			values.bMemoryShare, values.bDX9, values.bFrameCount, values.maxSenders);
+	}
+	values.generation = previous.generation + 1;
+	last = values;
+
+	uint64_t words[State::nWords] = {};
+	memcpy(words, &values, sizeof(values));
+
+	// Loads are serialized by the mutex, so there is one writer
+	const unsigned int next = sequence.load(std::memory_order_relaxed);
+	sequence.store(next + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	for (size_t i = 0; i < State::nWords; i++)
+		published[i].store(words[i], std::memory_order_relaxed);
+	sequence.store(next + 2, std::memory_order_release);
+}
+
+// Read "name=value" lines
+bool spoutSettings::State::ReadFile(spoutSettingsValues& values)
+{
+	// Record the file state before reading so that a change
+	// during the read is seen by the next check
+	filetime = 0;
+	filesize = 0;
+	if (!FileStat(filepath, filetime, filesize))
+		return false;
+
+	FILE* file = fopen(filepath.c_str(), "r");
+	if (!file)
+		return false;
+
+	char line[512];
+	while (fgets(line, sizeof(line), file)) {
+
+		char* name = line;
+		while (isspace(static_cast<unsigned char>(*name)))
+			name++;
+		if (*name == 0 || *name == '#' || *name == ';')
+			continue;
+
+		char* equals = strchr(name, '=');
+		if (!equals)
+			continue;
+
+		// Trim the name
+		char* end = equals;
+		while (end > name && isspace(static_cast<unsigned char>(end[-1])))
+			end--;
+		*end = 0;
+
+		const long value = strtol(equals + 1, nullptr, 10);
+
+		if (SameName(name, "MemoryShare"))
+			values.bMemoryShare = (value == 1);
+		else if (SameName(name, "DX9"))
+			values.bDX9 = (value == 1);
+		else if (SameName(name, "Framecount"))
+			values.bFrameCount = (value == 1);
+		else if (SameName(name, "MaxSenders")) {
+			if (value > 0)
+				values.maxSenders = static_cast<int>(value);
+		}
+	}
+
+	fclose(file);
+	return true;
+}
+
+#ifdef _WIN32
+// Read the registry values and arm the change notification
+void spoutSettings::State::ReadRegistry(spoutSettingsValues& values)
+{
+	// Arm before reading so that a change during the read is seen by the next check
+	RegistryChanged();
+
+	DWORD dwValue = 0;
+	if (ReadDwordFromRegistry(HKEY_CURRENT_USER, "Software\\Leading Edge\\Spout", "MemoryShare", &dwValue))
+		values.bMemoryShare = (dwValue == 1);
+	dwValue = 0;
+	if (ReadDwordFromRegistry(HKEY_CURRENT_USER, "Software\\Leading Edge\\Spout", "DX9", &dwValue))
+		values.bDX9 = (dwValue == 1);
+	dwValue = 0;
+	if (ReadDwordFromRegistry(HKEY_CURRENT_USER, "Software\\Leading Edge\\Spout", "Framecount", &dwValue))
+		values.bFrameCount = (dwValue == 1);
+	dwValue = 64;
+	if (ReadDwordFromRegistry(HKEY_CURRENT_USER, "Software\\Leading Edge\\Spout", "MaxSenders", &dwValue))
+		values.maxSenders = static_cast<int>(dwValue);
+}
+
+// True if the Spout registry key changed since the last call.
+// Opens the key and arms the notification if not done yet.
+bool spoutSettings::State::RegistryChanged()
+{
+	bool bChanged = false;
+
+	if (!hKey) {
+		// The key may not exist yet. Report a change once it does.
+		if (RegOpenKeyExA(HKEY_CURRENT_USER, "Software\\Leading Edge\\Spout", 0, KEY_NOTIFY, &hKey) != ERROR_SUCCESS) {
+			hKey = NULL;
+			return false;
+		}
+		if (!hEvent)
+			hEvent = CreateEventA(NULL, FALSE, FALSE, NULL);
+		bChanged = true;
+	}
+	else if (WaitForSingleObject(hEvent, 0) == WAIT_OBJECT_0) {
+		bChanged = true;
+	}
+	else {
+		return false;
+	}
+
+	// Notification is one shot, so arm again
+	if (RegNotifyChangeKeyValue(hKey, FALSE, REG_NOTIFY_CHANGE_LAST_SET, hEvent, TRUE) != ERROR_SUCCESS) {
+		SpoutLogWarning("spoutSettings - could not watch the registry for changes");
+		CloseRegistry();
+	}
+
+	return bChanged;
+}
+
+void spoutSettings::State::CloseRegistry()
+{
+	if (hKey) RegCloseKey(hKey);
+	if (hEvent) CloseHandle(hEvent);
+	hKey = NULL;
+	hEvent = NULL;
+}
+#endif
+
+// True if the settings source changed since it was loaded. Called with the mutex locked.
+bool spoutSettings::State::Changed()
+{
+	if (!filepath.empty()) {
+		long long mtime = 0;
+		long long size = 0;
+		if (!FileStat(filepath, mtime, size))
+			return filetime != 0 || filesize != 0; // removed
+		return mtime != filetime || size != filesize;
+	}
+#ifdef _WIN32
+	return RegistryChanged();
+#else
+	return false;
+#endif
+}
+
+// Background check for changes
+void spoutSettings::State::Watch()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	while (!bStop) {
+		wake.wait_for(lock, std::chrono::milliseconds(SPOUT_SETTINGS_WATCH_MSEC));
+		if (bStop)
+			break;
+		if (Changed())
+			Load();
+	}
+}
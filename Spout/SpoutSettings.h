@@ -0,0 +1,94 @@
+/*
+
+					SpoutSettings.h
+
+			Process-wide Spout settings read once and watched for changes
+
+	Redistribution and use in source and binary forms, with or without modification,
+	are permitted provided that the following conditions are met:
+
+		1. Redistributions of source code must retain the above copyright notice,
+		   this list of conditions and the following disclaimer.
+
+		2. Redistributions in binary form must reproduce the above copyright notice,
+		   this list of conditions and the following disclaimer in the documentation
+		   and/or other materials provided with the distribution.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"	AND ANY
+	EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+	OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE	ARE DISCLAIMED.
+	IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+	INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+	PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+	LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+	OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#ifndef __spoutSettings__
+#define __spoutSettings__
+
+#include "SpoutCommon.h"
+
+#include <string>
+
+using namespace spoututils;
+
+// Environment variable with the path of a settings file to use instead of the registry
+#define SPOUT_SETTINGS_FILE_ENV "SPOUT_SETTINGS_FILE"
+
+// Interval of the background check for changes
+#define SPOUT_SETTINGS_WATCH_MSEC 1000
+
+//
+// Values of one load.
+//
+// Registry values and settings file keys have the same names.
+//
+struct spoutSettingsValues {
+	unsigned int generation; // Incremented by each load that changed a value
+	bool bMemoryShare;       // "MemoryShare" - 2.006 memoryshare mode
+	bool bDX9;               // "DX9" - 2.006 DX9 mode
+	bool bFrameCount;        // "Framecount" - frame counting between sender and receiver
+	int  maxSenders;         // "MaxSenders" - maximum number of senders, default 64
+};
+
+class SPOUT_DLLEXP spoutSettings {
+
+	public:
+
+	// The process-wide settings, loaded on first use
+	static spoutSettings& Instance();
+	// The process-wide settings if they have been used, or null. Does not load them.
+	static spoutSettings* Existing();
+
+	~spoutSettings();
+	spoutSettings(const spoutSettings&) = delete;
+	spoutSettings& operator=(const spoutSettings&) = delete;
+
+	// Current values. Lock free, a copy of the last load.
+	spoutSettingsValues Get() const;
+	// Load the values again now
+	void Reload();
+	// Read from a settings file instead of the registry, or the registry if null or empty
+	void SetFilePath(const char* path);
+	// Settings file in use, empty for the registry
+	std::string GetFilePath() const;
+	// Start the background check for changes
+	void StartWatch();
+	// Stop the background check. Call before the module is unloaded.
+	void StopWatch();
+
+protected:
+
+	spoutSettings();
+
+	struct State;
+
+	// Avoid C4251 warnings in SpoutLibrary by using a pointer
+	State* m_pState;
+
+};
+
+#endif
@@ -0,0 +1,621 @@
+//
+//		SpoutSharedBuffer
+//
+//		Versioned N-buffered shared memory
+//
+//		The writer fills a buffer in place and commits it as the latest version.
+//		A reader reads the latest buffer in place and checks afterwards that
+//		the writer has not started to fill the same buffer again. Neither side
+//		takes a mutex or copies the data through an intermediate buffer.
+//
+//		With two buffers, a reader is undisturbed as long as it finishes before
+//		the writer commits once more. More buffers give slow readers more time.
+//
+//		A reader that must not be overwritten, such as an encoder reading the
+//		frame in place, takes a lease on the latest buffer instead. The writer
+//		skips leased buffers, and has none to fill if readers lease all but
+//		the latest. Leases are not refreshed, one held longer than
+//		SPOUT_SHARED_BUFFER_LEASE_MSEC no longer pins the buffer.
+//
+//		A writer that fills the buffer from the start can publish the rows
+//		completed as it goes. A streaming reader then starts on the buffer
+//		being written and waits for rows as it needs them, so that it works
+//		on the top of a frame while the writer is still on the bottom.
+//
+//		WriteMemoryBuffer/ReadMemoryBuffer in spoutDX remain for compatibility
+//		with existing applications that use the "<name>_map" layout.
+//
+// ====================================================================================
+//		Revisions :
+//
+//		17.10.26	- project start
+//		17.10.26	- LayoutSize, InitLayout and Attach for other transports of the same layout
+//		17.10.26	- Layout version 2 - rows completed for streaming readers
+//					  SetRowsCompleted, BeginStreamRead, GetRowsCompleted, WaitRowsCompleted
+//		17.10.26	- Layout version 3 - reader leases
+//					  AcquireLease, ReleaseLease. BeginWrite skips leased buffers.
+//
+// ====================================================================================
+//
+/*
+	Redistribution and use in source and binary forms, with or without modification,
+	are permitted provided that the following conditions are met:
+
+		1. Redistributions of source code must retain the above copyright notice,
+		   this list of conditions and the following disclaimer.
+
+		2. Redistributions in binary form must reproduce the above copyright notice,
+		   this list of conditions and the following disclaimer in the documentation
+		   and/or other materials provided with the distribution.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"	AND ANY
+	EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+	OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE	ARE DISCLAIMED.
+	IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+	INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+	PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+	LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+	OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "SpoutSharedBuffer.h"
+#include "SpoutHistogram.h"
+
+#include <string>
+#include <thread>
+
+// "SPBF"
+#define SPOUT_SHARED_BUFFER_MAGIC 0x46425053
+
+// Buffer data alignment
+#define SPOUT_SHARED_BUFFER_ALIGN 64
+
+//
+// Class: spoutSharedBuffer
+//
+// Versioned N-buffered shared memory.
+//
+// Refer to source code for documentation.
+//
+
+// -----------------------------------------------
+spoutSharedBuffer::spoutSharedBuffer()
+{
+	m_pHeader = nullptr;
+	m_pData = nullptr;
+	m_Stride = 0;
+	m_WriteVersion = 0;
+	m_bReadOnly = false;
+}
+
+// -----------------------------------------------
+spoutSharedBuffer::~spoutSharedBuffer()
+{
+	Close();
+}
+
+// -----------------------------------------------
+// Size of the header rounded up to the buffer alignment
+static uint32_t HeaderSize()
+{
+	return static_cast<uint32_t>((sizeof(SpoutSharedBufferHeader) + SPOUT_SHARED_BUFFER_ALIGN - 1) & ~(SPOUT_SHARED_BUFFER_ALIGN - 1));
+}
+
+// -----------------------------------------------
+// Function: Create
+// Writer create the shared memory.
+//
+//   length  - bytes available in each buffer
+//   buffers - number of buffers, 2 to SPOUT_SHARED_BUFFER_MAX
+//
+// If readers hold a map of the same name open, it is used
+// if it is large enough and versions continue from the last.
+bool spoutSharedBuffer::Create(const char* name, int length, int buffers)
+{
+	if (!name || !name[0]) {
+		SpoutLogError("spoutSharedBuffer::Create - no name");
+		return false;
+	}
+
+	if (length <= 0 || buffers < 2 || buffers > SPOUT_SHARED_BUFFER_MAX) {
+		SpoutLogError("spoutSharedBuffer::Create - invalid length %d or buffers %d", length, buffers);
+		return false;
+	}
+
+	Close();
+
+	const uint64_t size = LayoutSize(length, buffers);
+	if (size == 0) {
+		SpoutLogError("spoutSharedBuffer::Create - %d buffers of %d bytes is too large", buffers, length);
+		return false;
+	}
+
+	std::string namestring = name;
+	namestring += "_buffer";
+
+	const SpoutCreateResult result = m_Memory.Create(namestring.c_str(), static_cast<int>(size));
+	if (result == SPOUT_CREATE_FAILED) {
+		SpoutLogError("spoutSharedBuffer::Create - could not create shared memory [%s]", namestring.c_str());
+		return false;
+	}
+
+	SpoutSharedBufferHeader* pHeader = reinterpret_cast<SpoutSharedBufferHeader*>(m_Memory.Buffer());
+
+	if (result == SPOUT_ALREADY_EXISTS && pHeader->magic.load(std::memory_order_acquire) == SPOUT_SHARED_BUFFER_MAGIC) {
+		// The existing map keeps the size it was created with
+		if (pHeader->version != SPOUT_SHARED_BUFFER_VERSION
+			|| pHeader->buffers != static_cast<uint32_t>(buffers)
+			|| pHeader->length < static_cast<uint32_t>(length)) {
+			SpoutLogError("spoutSharedBuffer::Create - [%s] exists with a different layout", namestring.c_str());
+			m_Memory.Close();
+			return false;
+		}
+	}
+	else {
+		// New map, initially zero
+		InitLayout(m_Memory.Buffer(), length, buffers);
+	}
+
+	// Only the size requested is mapped, so a larger existing layout is refused
+	if (!Attach(m_Memory.Buffer(), static_cast<uint64_t>(m_Memory.Size()))) {
+		SpoutLogError("spoutSharedBuffer::Create - [%s] exists with a larger layout", namestring.c_str());
+		m_Memory.Close();
+		return false;
+	}
+
+	SpoutLogNotice("spoutSharedBuffer::Create - [%s] %d buffers of %d bytes", namestring.c_str(), m_pHeader->buffers, m_pHeader->length);
+
+	return true;
+}
+
+// -----------------------------------------------
+// Function: Open
+// Reader open existing shared memory.
+//
+// Returns false if the writer has not created it yet.
+bool spoutSharedBuffer::Open(const char* name)
+{
+	if (!name || !name[0])
+		return false;
+
+	if (m_pHeader)
+		return true;
+
+	std::string namestring = name;
+	namestring += "_buffer";
+
+	if (!m_Memory.Open(namestring.c_str()))
+		return false;
+
+	if (!Attach(m_Memory.Buffer(), static_cast<uint64_t>(m_Memory.Size()))) {
+		m_Memory.Close();
+		return false;
+	}
+
+	SpoutLogNotice("spoutSharedBuffer::Open - [%s] %d buffers of %d bytes", namestring.c_str(), m_pHeader->buffers, m_pHeader->length);
+
+	return true;
+}
+
+// -----------------------------------------------
+// Function: Close
+// Close the shared memory.
+//
+// The map remains until all writers and readers have closed it.
+void spoutSharedBuffer::Close()
+{
+	if (m_pHeader)
+		m_Memory.Close();
+	m_pHeader = nullptr;
+	m_pData = nullptr;
+	m_Stride = 0;
+	m_WriteVersion = 0;
+	m_bReadOnly = false;
+}
+
+// -----------------------------------------------
+// Function: IsOpen
+// Shared memory is open.
+bool spoutSharedBuffer::IsOpen()
+{
+	return (m_pHeader != nullptr);
+}
+
+// -----------------------------------------------
+// Function: BeginWrite
+// Writer get the next buffer to fill in place.
+//
+// The buffer is marked as being written so that readers still
+// using it from an earlier version detect the change.
+// Fill up to maxlength bytes and then call Commit.
+//
+// Buffers leased by readers are skipped. Returns null if every
+// buffer other than the latest is leased, the frame is dropped.
+char* spoutSharedBuffer::BeginWrite(int* maxlength)
+{
+	if (!m_pHeader)
+		return nullptr;
+
+	// Only the writer changes "latest"
+	const uint64_t latest = m_pHeader->latest.load(std::memory_order_relaxed);
+	const int64_t now = spoutHistogram::Now();
+
+	// Version n stays in buffer n % buffers, so a skipped buffer
+	// leaves a gap in the versions. The latest buffer is never next.
+	uint64_t version = 0;
+	uint32_t index = 0;
+	for (uint32_t skip = 1; skip < m_pHeader->buffers; skip++) {
+		const uint64_t next = latest + skip;
+		SpoutSharedBufferSlot& slot = m_pHeader->slots[next % m_pHeader->buffers];
+
+		// Invalidate the buffer before any data is written to it and before
+		// checking the leases. A reader leasing it at the same time either
+		// sees the version cleared or its lease is seen here.
+		const uint64_t held = slot.version.exchange(0, std::memory_order_seq_cst);
+		if (!IsLeased(slot, now)) {
+			version = next;
+			index = static_cast<uint32_t>(next % m_pHeader->buffers);
+			break;
+		}
+		// Nothing was written, readers of the held version are undisturbed
+		slot.version.store(held, std::memory_order_release);
+	}
+	if (version == 0)
+		return nullptr;
+
+	// A streaming reader of the earlier version that sees the rows
+	// reset also sees the version cleared.
+	std::atomic_thread_fence(std::memory_order_release);
+	m_pHeader->slots[index].rows.store(0, std::memory_order_relaxed);
+
+	// A streaming reader of this version sees the rows reset
+	m_pHeader->writing.store(version, std::memory_order_release);
+
+	m_WriteVersion = version;
+
+	if (maxlength)
+		*maxlength = static_cast<int>(m_pHeader->length);
+
+	return m_pData + static_cast<size_t>(index)*m_Stride;
+}
+
+// -----------------------------------------------
+// Function: Commit
+// Writer publish the buffer filled since BeginWrite as the latest version.
+bool spoutSharedBuffer::Commit(int length)
+{
+	if (!m_pHeader || m_WriteVersion == 0)
+		return false;
+
+	if (length < 0 || static_cast<uint32_t>(length) > m_pHeader->length) {
+		SpoutLogError("spoutSharedBuffer::Commit - length %d exceeds %d bytes", length, m_pHeader->length);
+		return false;
+	}
+
+	const uint64_t version = m_WriteVersion;
+	const uint32_t index = static_cast<uint32_t>(version % m_pHeader->buffers);
+
+	m_pHeader->slots[index].length.store(static_cast<uint64_t>(length), std::memory_order_relaxed);
+	m_pHeader->slots[index].version.store(version, std::memory_order_release);
+	m_pHeader->latest.store(version, std::memory_order_release);
+	m_pHeader->writing.store(0, std::memory_order_release);
+
+	m_WriteVersion = 0;
+
+	return true;
+}
+
+// -----------------------------------------------
+// Function: SetRowsCompleted
+// Writer publish the rows completed so far of the buffer being written.
+//
+// Rows are counted from the start of the buffer and written before the call.
+// Threads filling the buffer together can each publish the rows they know
+// to be complete, the count only increases.
+void spoutSharedBuffer::SetRowsCompleted(int rows)
+{
+	if (!m_pHeader || m_WriteVersion == 0 || rows < 0)
+		return;
+
+	const uint32_t index = static_cast<uint32_t>(m_WriteVersion % m_pHeader->buffers);
+	std::atomic<uint64_t>& completed = m_pHeader->slots[index].rows;
+
+	uint64_t current = completed.load(std::memory_order_relaxed);
+	while (current < static_cast<uint64_t>(rows)
+		&& !completed.compare_exchange_weak(current, static_cast<uint64_t>(rows), std::memory_order_release, std::memory_order_relaxed)) {}
+}
+
+// -----------------------------------------------
+// Function: BeginRead
+// Reader get the latest committed buffer to read in place.
+//
+// Returns null if nothing has been committed yet.
+// After reading, EndRead with the version returned
+// confirms that the data was not overwritten meanwhile.
+// If it was, read again to get the newer version.
+const char* spoutSharedBuffer::BeginRead(int* length, uint64_t* version)
+{
+	if (!m_pHeader)
+		return nullptr;
+
+	// The latest buffer could be refilled between loading "latest"
+	// and checking the buffer version if the reader is delayed
+	for (int retry = 0; retry < 16; retry++) {
+		const uint64_t latest = m_pHeader->latest.load(std::memory_order_acquire);
+		if (latest == 0)
+			return nullptr;
+		const uint32_t index = static_cast<uint32_t>(latest % m_pHeader->buffers);
+		if (m_pHeader->slots[index].version.load(std::memory_order_acquire) == latest) {
+			if (length)
+				*length = static_cast<int>(m_pHeader->slots[index].length.load(std::memory_order_relaxed));
+			if (version)
+				*version = latest;
+			return m_pData + static_cast<size_t>(index)*m_Stride;
+		}
+	}
+
+	return nullptr;
+}
+
+// -----------------------------------------------
+// Function: EndRead
+// Reader check that the buffer was not overwritten while it was read.
+bool spoutSharedBuffer::EndRead(uint64_t version)
+{
+	if (!m_pHeader || version == 0)
+		return false;
+
+	// Data reads complete before the version is checked
+	std::atomic_thread_fence(std::memory_order_acquire);
+	const uint32_t index = static_cast<uint32_t>(version % m_pHeader->buffers);
+	return (m_pHeader->slots[index].version.load(std::memory_order_relaxed) == version);
+}
+
+// -----------------------------------------------
+// Function: AcquireLease
+// Reader get the latest committed buffer and pin it until ReleaseLease.
+//
+// The writer skips the buffer while it is leased, so the data can be used
+// in place for as long as needed up to SPOUT_SHARED_BUFFER_LEASE_MSEC.
+// Returns null if nothing has been committed or the memory is read only.
+const char* spoutSharedBuffer::AcquireLease(int* length, uint64_t* version)
+{
+	if (!m_pHeader)
+		return nullptr;
+
+	if (m_bReadOnly) {
+		SpoutLogWarning("spoutSharedBuffer::AcquireLease - memory is read only");
+		return nullptr;
+	}
+
+	for (int retry = 0; retry < 16; retry++) {
+		const uint64_t latest = m_pHeader->latest.load(std::memory_order_acquire);
+		if (latest == 0)
+			return nullptr;
+		const uint32_t index = static_cast<uint32_t>(latest % m_pHeader->buffers);
+		SpoutSharedBufferSlot& slot = m_pHeader->slots[index];
+
+		// Take the lease, then check that the writer has not started on the buffer
+		slot.leasetime.store(spoutHistogram::Now(), std::memory_order_relaxed);
+		slot.leases.fetch_add(1, std::memory_order_seq_cst);
+		if (slot.version.load(std::memory_order_seq_cst) == latest) {
+			if (length)
+				*length = static_cast<int>(slot.length.load(std::memory_order_relaxed));
+			if (version)
+				*version = latest;
+			return m_pData + static_cast<size_t>(index)*m_Stride;
+		}
+		ReleaseLease(latest);
+	}
+
+	return nullptr;
+}
+
+// -----------------------------------------------
+// Function: ReleaseLease
+// Reader unpin a buffer leased by AcquireLease.
+//
+// Returns false if the buffer was overwritten after all,
+// because the lease was held too long.
+bool spoutSharedBuffer::ReleaseLease(uint64_t version)
+{
+	if (!m_pHeader || m_bReadOnly || version == 0)
+		return false;
+
+	const uint32_t index = static_cast<uint32_t>(version % m_pHeader->buffers);
+	SpoutSharedBufferSlot& slot = m_pHeader->slots[index];
+
+	// Data reads complete before the version is checked and the lease released
+	std::atomic_thread_fence(std::memory_order_acquire);
+	const bool valid = (slot.version.load(std::memory_order_relaxed) == version);
+
+	// The writer may have cleared an expired lease
+	uint32_t leases = slot.leases.load(std::memory_order_relaxed);
+	while (leases > 0 && !slot.leases.compare_exchange_weak(leases, leases - 1, std::memory_order_release, std::memory_order_relaxed)) {}
+
+	return valid;
+}
+
+// -----------------------------------------------
+// Function: IsLeased
+// Buffer has a lease taken within SPOUT_SHARED_BUFFER_LEASE_MSEC.
+//
+// Expired leases are cleared.
+bool spoutSharedBuffer::IsLeased(SpoutSharedBufferSlot& slot, int64_t now)
+{
+	uint32_t leases = slot.leases.load(std::memory_order_seq_cst);
+	if (leases == 0)
+		return false;
+
+	const int64_t age = now - slot.leasetime.load(std::memory_order_relaxed);
+	if (age < static_cast<int64_t>(SPOUT_SHARED_BUFFER_LEASE_MSEC)*1000000LL)
+		return true;
+
+	// A lease taken meanwhile keeps the buffer
+	return !slot.leases.compare_exchange_strong(leases, 0, std::memory_order_seq_cst);
+}
+
+// -----------------------------------------------
+// Function: BeginStreamRead
+// Streaming reader get the newest buffer after a version.
+//
+// Returns the buffer being written if the writer has started one,
+// otherwise the latest committed buffer, or null if neither is
+// newer than lastversion. Only use rows reported complete by
+// GetRowsCompleted or WaitRowsCompleted for the version returned.
+const char* spoutSharedBuffer::BeginStreamRead(uint64_t lastversion, uint64_t* version)
+{
+	if (!m_pHeader || !version)
+		return nullptr;
+
+	const uint64_t latest = m_pHeader->latest.load(std::memory_order_acquire);
+	const uint64_t writing = m_pHeader->writing.load(std::memory_order_acquire);
+	const uint64_t next = (writing > latest) ? writing : latest;
+	if (next == 0 || next <= lastversion)
+		return nullptr;
+
+	*version = next;
+	return m_pData + static_cast<size_t>(next % m_pHeader->buffers)*m_Stride;
+}
+
+// -----------------------------------------------
+// Function: GetRowsCompleted
+// Streaming reader get the rows completed of a version.
+//
+// Returns -1 if the buffer no longer holds the version. Rows read
+// before are then not valid, start again with BeginStreamRead.
+// Call again after reading to check that the rows were not overwritten.
+int spoutSharedBuffer::GetRowsCompleted(uint64_t version)
+{
+	if (!m_pHeader || version == 0)
+		return -1;
+
+	const uint32_t index = static_cast<uint32_t>(version % m_pHeader->buffers);
+	const uint64_t rows = m_pHeader->slots[index].rows.load(std::memory_order_acquire);
+
+	// The rows belong to the version if the buffer still holds it
+	if (m_pHeader->slots[index].version.load(std::memory_order_relaxed) != version
+		&& m_pHeader->writing.load(std::memory_order_relaxed) != version)
+		return -1;
+
+	return static_cast<int>(rows);
+}
+
+// -----------------------------------------------
+// Function: WaitRowsCompleted
+// Streaming reader wait until a number of rows are completed.
+//
+//   timeout - milliseconds
+//
+// Returns the rows completed, less than requested after a timeout,
+// or -1 if the buffer no longer holds the version.
+int spoutSharedBuffer::WaitRowsCompleted(uint64_t version, int rows, int timeout)
+{
+	const int64_t deadline = spoutHistogram::Now() + static_cast<int64_t>(timeout)*1000000LL;
+	for (;;) {
+		const int completed = GetRowsCompleted(version);
+		if (completed < 0 || completed >= rows || spoutHistogram::Now() > deadline)
+			return completed;
+		std::this_thread::yield();
+	}
+}
+
+// -----------------------------------------------
+// Function: GetVersion
+// Version of the latest committed buffer.
+//
+// Zero if nothing has been committed. A reader can compare
+// with the last version read to detect new data.
+uint64_t spoutSharedBuffer::GetVersion()
+{
+	if (!m_pHeader)
+		return 0;
+	return m_pHeader->latest.load(std::memory_order_acquire);
+}
+
+// -----------------------------------------------
+// Function: GetLength
+// Bytes available in each buffer.
+int spoutSharedBuffer::GetLength()
+{
+	if (!m_pHeader)
+		return 0;
+	return static_cast<int>(m_pHeader->length);
+}
+
+// -----------------------------------------------
+// Function: GetBuffers
+// Number of buffers.
+int spoutSharedBuffer::GetBuffers()
+{
+	if (!m_pHeader)
+		return 0;
+	return static_cast<int>(m_pHeader->buffers);
+}
+
+// -----------------------------------------------
+// Function: LayoutSize
+// Bytes of memory for a header and the buffers.
+//
+// Zero if the layout is invalid or too large.
+uint64_t spoutSharedBuffer::LayoutSize(int length, int buffers)
+{
+	if (length <= 0 || buffers < 2 || buffers > SPOUT_SHARED_BUFFER_MAX)
+		return 0;
+
+	const uint32_t stride = (static_cast<uint32_t>(length) + SPOUT_SHARED_BUFFER_ALIGN - 1) & ~(SPOUT_SHARED_BUFFER_ALIGN - 1);
+	const uint64_t size = static_cast<uint64_t>(HeaderSize()) + static_cast<uint64_t>(stride)*static_cast<uint64_t>(buffers);
+	if (size > 0x7FFFFFFF)
+		return 0;
+
+	return size;
+}
+
+// -----------------------------------------------
+// Function: InitLayout
+// Write the header to new zero filled memory of LayoutSize bytes.
+//
+// The magic number is stored last so that a reader
+// attaching meanwhile does not see a partial header.
+void spoutSharedBuffer::InitLayout(char* pMemory, int length, int buffers)
+{
+	SpoutSharedBufferHeader* pHeader = reinterpret_cast<SpoutSharedBufferHeader*>(pMemory);
+	pHeader->version = SPOUT_SHARED_BUFFER_VERSION;
+	pHeader->buffers = static_cast<uint32_t>(buffers);
+	pHeader->length = static_cast<uint32_t>(length);
+	pHeader->magic.store(SPOUT_SHARED_BUFFER_MAGIC, std::memory_order_release);
+}
+
+// -----------------------------------------------
+// Function: Attach
+// Use memory holding a complete header.
+//
+//   size - bytes of memory mapped, zero if not known
+//
+// Used by Create and Open, and by transports that
+// map the same layout from other kinds of memory.
+bool spoutSharedBuffer::Attach(char* pMemory, uint64_t size)
+{
+	if (!pMemory)
+		return false;
+
+	SpoutSharedBufferHeader* pHeader = reinterpret_cast<SpoutSharedBufferHeader*>(pMemory);
+	if (pHeader->magic.load(std::memory_order_acquire) != SPOUT_SHARED_BUFFER_MAGIC
+		|| pHeader->version != SPOUT_SHARED_BUFFER_VERSION
+		|| pHeader->buffers < 2 || pHeader->buffers > SPOUT_SHARED_BUFFER_MAX
+		|| pHeader->length == 0 || pHeader->length > 0x7FFFFFFF)
+		return false;
+
+	// Buffers must be inside the memory mapped
+	if (size > 0 && LayoutSize(static_cast<int>(pHeader->length), static_cast<int>(pHeader->buffers)) > size)
+		return false;
+
+	m_pHeader = pHeader;
+	m_pData = pMemory + HeaderSize();
+	m_Stride = (pHeader->length + SPOUT_SHARED_BUFFER_ALIGN - 1) & ~(SPOUT_SHARED_BUFFER_ALIGN - 1);
+	m_WriteVersion = 0;
+	m_bReadOnly = false;
+
+	return true;
+}
@@ -0,0 +1,159 @@
+/*
+
+					SpoutSharedBuffer.h
+
+			Versioned N-buffered shared memory for data exchange
+			without a mutex or a copy on either side.
+
+	Redistribution and use in source and binary forms, with or without modification,
+	are permitted provided that the following conditions are met:
+
+		1. Redistributions of source code must retain the above copyright notice,
+		   this list of conditions and the following disclaimer.
+
+		2. Redistributions in binary form must reproduce the above copyright notice,
+		   this list of conditions and the following disclaimer in the documentation
+		   and/or other materials provided with the distribution.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"	AND ANY
+	EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+	OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE	ARE DISCLAIMED.
+	IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+	INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+	PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+	LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+	OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#ifndef __spoutSharedBuffer__
+#define __spoutSharedBuffer__
+
+#include "SpoutCommon.h"
+#include "SpoutSharedMemory.h"
+
+#include <atomic>
+#include <stdint.h>
+
+using namespace spoututils;
+
+// Maximum number of buffers
+#define SPOUT_SHARED_BUFFER_MAX 8
+
+// Shared memory layout version
+#define SPOUT_SHARED_BUFFER_VERSION 3
+
+// A lease older than this no longer pins its buffer,
+// so that a reader which crashed does not hold it
+#define SPOUT_SHARED_BUFFER_LEASE_MSEC 1000
+
+//
+// Buffer state in shared memory
+//
+// version is the committed version held in the buffer,
+// or zero while the writer fills it.
+// rows is the number of rows the writer has completed from the
+// start of the buffer, or any other unit writer and readers agree on.
+// It only increases while the buffer holds one version.
+// leases is the number of readers holding the buffer with a lease
+// and leasetime when the last lease was taken. The writer skips
+// a buffer with leases.
+//
+struct SpoutSharedBufferSlot {
+	std::atomic<uint64_t> version;
+	std::atomic<uint64_t> length;
+	std::atomic<uint64_t> rows;
+	std::atomic<uint32_t> leases;
+	uint32_t reserved;
+	std::atomic<int64_t> leasetime;
+};
+
+//
+// Header at the start of the shared memory "<name>_buffer"
+//
+// Buffer data follows the header, each buffer aligned to 64 bytes.
+// "latest" is the version of the last committed buffer. Version n is
+// held in buffer n % buffers so that a reader uses the latest buffer
+// while the writer fills the next one, skipping buffers leased by
+// readers so that versions can have gaps. "writing" is the version being
+// filled, so that a streaming reader can start on it before the commit.
+//
+struct SpoutSharedBufferHeader {
+	std::atomic<uint32_t> magic; // Set last when the header is complete
+	uint32_t version; // SPOUT_SHARED_BUFFER_VERSION
+	uint32_t buffers; // Number of buffers
+	uint32_t length; // Bytes available in each buffer
+	std::atomic<uint64_t> latest; // Version of the latest committed buffer
+	std::atomic<uint64_t> writing; // Version being written, zero if none
+	SpoutSharedBufferSlot slots[SPOUT_SHARED_BUFFER_MAX];
+};
+
+class SPOUT_DLLEXP spoutSharedBuffer {
+
+	public:
+
+	spoutSharedBuffer();
+	~spoutSharedBuffer();
+
+	// Writer create the shared memory
+	bool Create(const char* name, int length, int buffers = 2);
+	// Reader open existing shared memory
+	bool Open(const char* name);
+	// Close the shared memory
+	void Close();
+	// Shared memory is open
+	bool IsOpen();
+
+	// Writer get the next buffer to fill in place
+	char* BeginWrite(int* maxlength = nullptr);
+	// Writer publish the buffer as the latest version
+	bool Commit(int length);
+	// Writer publish the rows completed so far of the buffer being written
+	void SetRowsCompleted(int rows);
+
+	// Reader get the latest committed buffer to read in place
+	const char* BeginRead(int* length, uint64_t* version);
+	// Reader check that the buffer was not overwritten while it was read
+	bool EndRead(uint64_t version);
+
+	// Reader get the latest committed buffer and pin it until ReleaseLease
+	const char* AcquireLease(int* length, uint64_t* version);
+	// Reader unpin a leased buffer, false if it was overwritten after all
+	bool ReleaseLease(uint64_t version);
+
+	// Streaming reader get the newest buffer after a version, committed or being written
+	const char* BeginStreamRead(uint64_t lastversion, uint64_t* version);
+	// Streaming reader get the rows completed of a version, -1 if the buffer was reused
+	int GetRowsCompleted(uint64_t version);
+	// Streaming reader wait until a number of rows are completed
+	int WaitRowsCompleted(uint64_t version, int rows, int timeout);
+
+	// Version of the latest committed buffer
+	uint64_t GetVersion();
+	// Bytes available in each buffer
+	int GetLength();
+	// Number of buffers
+	int GetBuffers();
+
+protected:
+
+	// Bytes of memory for a header and the buffers, zero if invalid
+	static uint64_t LayoutSize(int length, int buffers);
+	// Write the header to new zero filled memory
+	static void InitLayout(char* pMemory, int length, int buffers);
+	// Use memory holding a complete header
+	bool Attach(char* pMemory, uint64_t size);
+	// Buffer has a current lease
+	static bool IsLeased(SpoutSharedBufferSlot& slot, int64_t now);
+
+	SpoutSharedMemory m_Memory;
+	SpoutSharedBufferHeader* m_pHeader;
+	char* m_pData;
+	uint32_t m_Stride; // Aligned buffer length
+	uint64_t m_WriteVersion; // Version being written, zero if none
+	bool m_bReadOnly; // Memory mapped read only, no leases
+
+};
+
+#endif
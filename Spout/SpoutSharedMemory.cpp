@@ -40,6 +40,16 @@
 #include <assert.h>
 #include <string>
 
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
 // ====================================================================================
 //		Revisions :
 //
@@ -53,6 +63,9 @@
 //	07.12.23 - Remove unused <d3d9.h> from header
 //	Version 2.007.013
 //	Version 2.007.014
+//	17.10.26 - Add Buffer for lock-free access to fixed layout records
+//	17.10.26 - Add POSIX backend (shm_open/mmap and a named semaphore)
+//			   for the portable classes and tools on Linux
 //
 // ====================================================================================
 
@@ -64,6 +77,8 @@
 //
 // Refer to source code for documentation.
 //
+#ifdef _WIN32
+
 SpoutSharedMemory::SpoutSharedMemory()
 {
 	m_pBuffer = NULL;
@@ -300,6 +315,261 @@ void SpoutSharedMemory::Unlock()
 	}
 }
 
+#else
+
+//
+// POSIX backend
+//
+// The map is a shm_open object and the mutex a named semaphore "<name>_mutex".
+// Windows removes a map when the last handle is closed. POSIX objects
+// remain until they are unlinked, so the object that created the map
+// removes the names when it closes. Processes that still have the map
+// open keep using it, but it can no longer be opened by name.
+//
+
+// POSIX names start with one '/' and have no other '/'
+static std::string PosixName(const char* name, const char* suffix = "")
+{
+	std::string posixname = "/";
+	posixname += name;
+	posixname += suffix;
+	for (size_t i = 1; i < posixname.size(); i++) {
+		if (posixname[i] == '/' || posixname[i] == '\\')
+			posixname[i] = '_';
+	}
+	return posixname;
+}
+
+SpoutSharedMemory::SpoutSharedMemory()
+{
+	m_pBuffer = NULL;
+	m_fdMap = -1;
+	m_pMutex = NULL;
+	m_bCreated = false;
+	m_pName = NULL;
+	m_size = 0;
+	m_lockCount = 0;
+}
+
+SpoutSharedMemory::~SpoutSharedMemory()
+{
+	Close();
+}
+
+//---------------------------------------------------------
+// Function: Create
+// Create a new memory segment, or attach to an existing one
+SpoutCreateResult SpoutSharedMemory::Create(const char* name, int size)
+{
+	assert(name);
+	assert(size);
+
+	if (m_fdMap >= 0) {
+		assert(strcmp(name, m_pName) == 0);
+		assert(m_pBuffer && m_pMutex);
+		return SPOUT_ALREADY_CREATED;
+	}
+
+	const std::string mapname = PosixName(name);
+
+	bool alreadyExists = false;
+	m_fdMap = shm_open(mapname.c_str(), O_RDWR | O_CREAT | O_EXCL, 0666);
+	if (m_fdMap < 0 && errno == EEXIST) {
+		alreadyExists = true;
+		m_fdMap = shm_open(mapname.c_str(), O_RDWR, 0666);
+	}
+	if (m_fdMap < 0) {
+		SpoutLogError("SpoutSharedMemory::Create - shm_open [%s] failed error = %d", mapname.c_str(), errno);
+		return SPOUT_CREATE_FAILED;
+	}
+
+	if (alreadyExists) {
+		// The size of the map will be the same as when it was created,
+		// as for CreateFileMapping. It is zero until the creator has set it.
+		struct stat st;
+		if (fstat(m_fdMap, &st) != 0 || st.st_size < size) {
+			Close();
+			return SPOUT_CREATE_FAILED;
+		}
+	}
+	else {
+		// The new object is zero filled
+		m_bCreated = true;
+		if (ftruncate(m_fdMap, static_cast<off_t>(size)) != 0) {
+			SpoutLogError("SpoutSharedMemory::Create - ftruncate [%s] failed error = %d", mapname.c_str(), errno);
+			Close();
+			return SPOUT_CREATE_FAILED;
+		}
+	}
+
+	m_pName = strdup(name);
+
+	void* pMap = mmap(NULL, static_cast<size_t>(size), PROT_READ | PROT_WRITE, MAP_SHARED, m_fdMap, 0);
+	if (pMap == MAP_FAILED) {
+		Close();
+		return SPOUT_CREATE_FAILED;
+	}
+	m_pBuffer = static_cast<char*>(pMap);
+	m_size = size;
+
+	// Only the creator creates the semaphore. Otherwise a process that opens
+	// the map just as the creator removes the names would leave a new one behind.
+	if (alreadyExists)
+		m_pMutex = sem_open(PosixName(name, "_mutex").c_str(), 0);
+	else
+		m_pMutex = sem_open(PosixName(name, "_mutex").c_str(), O_CREAT, 0666, 1);
+	if (m_pMutex == SEM_FAILED) {
+		m_pMutex = NULL;
+		Close();
+		return SPOUT_CREATE_FAILED;
+	}
+
+	return alreadyExists ? SPOUT_ALREADY_EXISTS : SPOUT_CREATE_SUCCESS;
+}
+
+//---------------------------------------------------------
+// Function: Open
+// Open an existing memory map
+bool SpoutSharedMemory::Open(const char* name)
+{
+	assert(name);
+
+	if (m_fdMap >= 0) {
+		assert(strcmp(name, m_pName) == 0);
+		assert(m_pBuffer && m_pMutex);
+		return true;
+	}
+
+	m_fdMap = shm_open(PosixName(name).c_str(), O_RDWR, 0666);
+	if (m_fdMap < 0)
+		return false;
+
+	// Zero while the creator is still setting the size
+	struct stat st;
+	if (fstat(m_fdMap, &st) != 0 || st.st_size <= 0) {
+		Close();
+		return false;
+	}
+
+	m_pName = strdup(name);
+
+	void* pMap = mmap(NULL, static_cast<size_t>(st.st_size), PROT_READ | PROT_WRITE, MAP_SHARED, m_fdMap, 0);
+	if (pMap == MAP_FAILED) {
+		Close();
+		return false;
+	}
+	m_pBuffer = static_cast<char*>(pMap);
+
+	// Unlike Windows, the size of an opened map is known
+	m_size = static_cast<int>(st.st_size);
+
+	// Fails until the creator has made the semaphore
+	m_pMutex = sem_open(PosixName(name, "_mutex").c_str(), 0);
+	if (m_pMutex == SEM_FAILED) {
+		m_pMutex = NULL;
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+//---------------------------------------------------------
+// Function: Close
+// Close a map
+void SpoutSharedMemory::Close()
+{
+	if (m_pBuffer) {
+		munmap(m_pBuffer, static_cast<size_t>(m_size));
+		m_pBuffer = NULL;
+	}
+
+	if (m_fdMap >= 0) {
+		close(m_fdMap);
+		m_fdMap = -1;
+	}
+
+	if (m_pMutex) {
+		sem_close(m_pMutex);
+		m_pMutex = NULL;
+	}
+
+	if (m_pName) {
+		if (m_bCreated) {
+			shm_unlink(PosixName(m_pName).c_str());
+			sem_unlink(PosixName(m_pName, "_mutex").c_str());
+		}
+		free((void*)m_pName);
+		m_pName = NULL;
+	}
+
+	m_bCreated = false;
+	m_size = 0;
+	m_lockCount = 0;
+}
+
+//---------------------------------------------------------
+// Function: Lock
+// Lock an open map and return the buffer
+char* SpoutSharedMemory::Lock()
+{
+	assert(m_lockCount >= 0);
+	assert(m_pMutex);
+
+	if (m_lockCount < 0 || !m_pMutex || !m_pBuffer)
+		return NULL;
+
+	if (m_lockCount > 0) {
+		m_lockCount++;
+		return m_pBuffer;
+	}
+
+	// Same 67 msec timeout as the Windows mutex wait
+	struct timespec deadline;
+	clock_gettime(CLOCK_REALTIME, &deadline);
+	deadline.tv_nsec += 67L * 1000000L;
+	if (deadline.tv_nsec >= 1000000000L) {
+		deadline.tv_sec += 1;
+		deadline.tv_nsec -= 1000000000L;
+	}
+
+	int result = 0;
+	while ((result = sem_timedwait(m_pMutex, &deadline)) != 0 && errno == EINTR) {}
+	if (result != 0)
+		return nullptr;
+
+	m_lockCount++;
+	return m_pBuffer;
+}
+
+//---------------------------------------------------------
+// Function: Unlock
+// Unlock a map
+void SpoutSharedMemory::Unlock()
+{
+	assert(m_pMutex);
+
+	m_lockCount--;
+	assert(m_lockCount >= 0);
+
+	if (m_lockCount == 0)
+		sem_post(m_pMutex);
+}
+
+#endif
+
+//---------------------------------------------------------
+// Function: Buffer
+// Return the buffer of an open map without locking.
+//
+// For fixed layout records that synchronize access themselves,
+// for example using a sequence lock. The pointer remains valid
+// until the map is closed.
+char* SpoutSharedMemory::Buffer()
+{
+	return m_pBuffer;
+}
+
 //---------------------------------------------------------
 // Function: Name
 // Return the name of an existing map
@@ -322,7 +592,11 @@ int SpoutSharedMemory::Size()
 void SpoutSharedMemory::Debug()
 {
 	if (m_pName) {
+#ifdef _WIN32
 		SpoutLogNotice("SpoutSharedMemory::Debug : (%s) m_hMap = [0x%.7X], m_pBuffer = [0x%.7X]", m_pName, LOWORD(m_hMap), PtrToUint(m_pBuffer));
+#else
+		SpoutLogNotice("SpoutSharedMemory::Debug : (%s) m_fdMap = [%d], m_pBuffer = [%p], size %d", m_pName, m_fdMap, (void*)m_pBuffer, m_size);
+#endif
 	}
 	else {
 		SpoutLogNotice("SpoutSharedMemory::Debug : Shared Memory Map is not open\n");
@@ -37,8 +37,12 @@
 #define __SpoutSharedMemory_
 
 #include "SpoutCommon.h"
+#ifdef _WIN32
 #include <windowsx.h>
 #include <wingdi.h>
+#else
+#include <semaphore.h> // POSIX shared memory backend
+#endif
 
 using namespace spoututils;
 
@@ -74,6 +78,9 @@ public:
 	// Unlock a map
 	void Unlock();
 
+	// Return the buffer of an open map without locking
+	char* Buffer();
+
 	// Name of an existing map
 	const char* Name();
 	
@@ -86,8 +93,14 @@ public:
 private:
 
 	char*  m_pBuffer; // Buffer pointer
+#ifdef _WIN32
 	HANDLE m_hMap; // Map handle
 	HANDLE m_hMutex; // Mutex for map access
+#else
+	int    m_fdMap; // Shared memory object
+	sem_t* m_pMutex; // Named semaphore for map access
+	bool   m_bCreated; // This object created the map and removes the names on close
+#endif
 	int m_lockCount; // Map access lock count
 	char* m_pName; // Map name
 	int m_size; // Map size
@@ -225,6 +225,11 @@
 		09.02.25 - Remove debug comments for MB_USERBUTTON (no longer used)
 		17.02.25 - Adjust combo box width to the longest item string
 				   Use CBS_DROPDOWNLIST style for list only
+		17.10.26 - StartTiming/EndTiming and StartCounter/GetCounter state per thread
+				   so that threads timing at once do not corrupt each other.
+				   SpoutHistogram records latency distributions for the SDK.
+				 - PC timer frequency per thread as well. GetCounter and EndTiming
+				   return zero on a thread that has not started them.
 
 */
 
@@ -259,15 +264,21 @@ namespace spoututils {
 	std::string logPath; // folder path for the logfile
 	char logChars[1024]={}; // The current log string
 	bool bConsole = false;
+	// Timing state is kept per thread
 #ifdef USE_CHRONO
-	std::chrono::steady_clock::time_point start;
-	std::chrono::steady_clock::time_point end;
+#define SPOUT_THREAD_LOCAL thread_local
+#else
+#define SPOUT_THREAD_LOCAL __declspec(thread)
+#endif
+#ifdef USE_CHRONO
+	SPOUT_THREAD_LOCAL std::chrono::steady_clock::time_point start;
+	SPOUT_THREAD_LOCAL std::chrono::steady_clock::time_point end;
 #endif
-	// PC timer
-	double PCFreq = 0.0;
-	__int64 CounterStart = 0;
-	double startcount = 0.0;
-	double endcount = 0.0;
+	// PC timer. Zero until the thread calls StartCounter.
+	SPOUT_THREAD_LOCAL double PCFreq = 0.0;
+	SPOUT_THREAD_LOCAL __int64 CounterStart = 0;
+	SPOUT_THREAD_LOCAL double startcount = 0.0;
+	SPOUT_THREAD_LOCAL double endcount = 0.0;
 	double m_FrameStart = 0.0;
 
 	// Spout SDK version number string
@@ -1524,6 +1535,9 @@ namespace spoututils {
 	//
 	// Compiler dependent
 	//
+	// Timing state is kept per thread. For latency distributions
+	// over many samples and threads, use spoutHistogram.
+	//
 
 	// ---------------------------------------------------------
 	// Function: 
@@ -1575,6 +1589,9 @@ namespace spoututils {
 	// (microseconds default).
 	// Code console output can be enabled for quick timing tests.
 	double EndTiming(bool microseconds) {
+		// Zero if this thread has not started timing
+		if (start == std::chrono::steady_clock::time_point())
+			return 0.0;
 		end = std::chrono::steady_clock::now();
 		double elapsed = 0;
 		if(microseconds)
@@ -1628,9 +1645,13 @@ namespace spoututils {
 	}
 
 	// -----------------------------------------------
-	// Return msec elapsed since counter start
+	// Return msec elapsed since counter start,
+	// zero if this thread has not started the counter
 	double GetCounter()
 	{
+		if (CounterStart == 0 || PCFreq < 0.0001)
+			return 0.0;
+
 		LARGE_INTEGER li;
 		if (QueryPerformanceCounter(&li)) {
 			return static_cast<double>(li.QuadPart - CounterStart) / PCFreq;
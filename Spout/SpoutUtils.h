@@ -348,6 +348,7 @@ namespace spoututils {
 	double SPOUT_DLLEXP EndTiming();
 #endif
 
+	// Per thread. GetCounter returns msec since StartCounter on the same thread, zero before it.
 	void SPOUT_DLLEXP StartCounter();
 	double SPOUT_DLLEXP GetCounter();
 
@@ -0,0 +1,903 @@
+/*
+Davinci Resolve Spout Sender
+Copyright (C) 2025 ValueFactory
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of
+the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+#include "file_sink.h"
+#include "half.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <aio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Frames the pool may hold regardless of the budget
+#define FILE_SINK_MIN_FRAMES 2
+#define FILE_SINK_MAX_FRAMES 16
+// Encoded files a worker keeps in flight while it encodes the next one
+#define FILE_SINK_WRITES_PER_WORKER 2
+
+//
+// zlib
+//
+
+static uint32_t adler32(const uint8_t* src, size_t size) {
+  uint32_t a = 1;
+  uint32_t b = 0;
+  while (size > 0) {
+    // Largest run that can't overflow b before the modulo
+    size_t run = size < 5552 ? size : 5552;
+    size -= run;
+    for (size_t i = 0; i < run; ++i) {
+      a += src[i];
+      b += a;
+    }
+    src += run;
+    a %= 65521;
+    b %= 65521;
+  }
+  return (b << 16) | a;
+}
+
+struct Bit_Writer {
+  std::vector<uint8_t>& out;
+  uint64_t bits = 0;
+  int count = 0;
+
+  explicit Bit_Writer(std::vector<uint8_t>& out) : out(out) {}
+
+  void put(uint32_t value, int bit_count) {
+    bits |= (uint64_t)value << count;
+    count += bit_count;
+    while (count >= 8) {
+      out.push_back((uint8_t)bits);
+      bits >>= 8;
+      count -= 8;
+    }
+  }
+
+  void align() {
+    if (count > 0) {
+      out.push_back((uint8_t)bits);
+    }
+    bits = 0;
+    count = 0;
+  }
+};
+
+// One block with the fixed Huffman codes of the deflate spec. Dynamic codes would get another 10-20%
+// on images, the fixed ones keep the encoder small and fast enough to keep up with playback on a few threads.
+// Codes are stored bit reversed since deflate writes Huffman codes from the top bit.
+struct Deflate_Tables {
+  uint16_t literal_code[288];
+  uint8_t literal_bits[288];
+  uint16_t length_symbol[259];
+  uint8_t distance_symbol[32769];
+
+  static const uint16_t length_base[29];
+  static const uint8_t length_extra[29];
+  static const uint16_t distance_base[30];
+  static const uint8_t distance_extra[30];
+
+  static uint16_t reverse(uint32_t code, int bit_count) {
+    uint32_t out = 0;
+    for (int i = 0; i < bit_count; ++i) {
+      out = (out << 1) | ((code >> i) & 1);
+    }
+    return (uint16_t)out;
+  }
+
+  Deflate_Tables() {
+    for (int s = 0; s < 288; ++s) {
+      if (s < 144) { literal_code[s] = reverse(0x30 + s, 8); literal_bits[s] = 8; }
+      else if (s < 256) { literal_code[s] = reverse(0x190 + s - 144, 9); literal_bits[s] = 9; }
+      else if (s < 280) { literal_code[s] = reverse(s - 256, 7); literal_bits[s] = 7; }
+      else { literal_code[s] = reverse(0xc0 + s - 280, 8); literal_bits[s] = 8; }
+    }
+
+    for (int code = 0; code < 29; ++code) {
+      auto end = code == 28 ? 259 : length_base[code + 1];
+      for (int length = length_base[code]; length < end; ++length) {
+        length_symbol[length] = (uint16_t)code;
+      }
+    }
+    // 258 has its own code rather than being the last of code 27
+    length_symbol[258] = 28;
+
+    for (int code = 0; code < 30; ++code) {
+      auto end = code == 29 ? 32769 : distance_base[code + 1];
+      for (int distance = distance_base[code]; distance < end; ++distance) {
+        distance_symbol[distance] = (uint8_t)code;
+      }
+    }
+  }
+};
+
+const uint16_t Deflate_Tables::length_base[29] = {
+  3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+const uint8_t Deflate_Tables::length_extra[29] = {
+  0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+const uint16_t Deflate_Tables::distance_base[30] = {
+  1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769,
+  1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+const uint8_t Deflate_Tables::distance_extra[30] = {
+  0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+static const Deflate_Tables& deflate_tables() {
+  static Deflate_Tables tables;
+  return tables;
+}
+
+#define DEFLATE_WINDOW 32768
+#define DEFLATE_HASH_BITS 15
+#define DEFLATE_MIN_MATCH 3
+#define DEFLATE_MAX_MATCH 258
+
+static void deflate_stored(const uint8_t* src, size_t size, std::vector<uint8_t>& out) {
+  Bit_Writer writer(out);
+  do {
+    auto run = size < 65535 ? size : 65535;
+    size -= run;
+    writer.put(size == 0 ? 1 : 0, 1);
+    writer.put(0, 2);
+    writer.align();
+    out.push_back((uint8_t)run);
+    out.push_back((uint8_t)(run >> 8));
+    out.push_back((uint8_t)~run);
+    out.push_back((uint8_t)(~run >> 8));
+    out.insert(out.end(), src, src + run);
+    src += run;
+  } while (size > 0);
+}
+
+static void deflate_fixed(const uint8_t* src, size_t size, int level, std::vector<uint8_t>& out) {
+  auto& tables = deflate_tables();
+  // Candidates looked at per position, doubling with each level
+  auto max_chain = 4 << (level - 1);
+
+  std::vector<int32_t> head((size_t)1 << DEFLATE_HASH_BITS, -1);
+  std::vector<int32_t> prev(DEFLATE_WINDOW, -1);
+
+  auto hash = [src](size_t i) {
+    uint32_t value = src[i] | (src[i + 1] << 8) | (src[i + 2] << 16);
+    return (value * 2654435761u) >> (32 - DEFLATE_HASH_BITS);
+  };
+  auto insert = [&](size_t i) {
+    auto h = hash(i);
+    prev[i & (DEFLATE_WINDOW - 1)] = head[h];
+    head[h] = (int32_t)i;
+  };
+
+  Bit_Writer writer(out);
+  writer.put(1, 1);
+  writer.put(1, 2);
+
+  size_t i = 0;
+  while (i < size) {
+    size_t best_length = 0;
+    size_t best_distance = 0;
+
+    if (i + DEFLATE_MIN_MATCH <= size) {
+      auto max_length = size - i < DEFLATE_MAX_MATCH ? size - i : DEFLATE_MAX_MATCH;
+      auto candidate = head[hash(i)];
+      auto chain = max_chain;
+
+      // Newer positions take over the slots of older ones in prev, so the chain stops once it stops going back
+      while (candidate >= 0 && i - candidate <= DEFLATE_WINDOW && chain-- > 0) {
+        auto* a = src + candidate;
+        auto* b = src + i;
+        if (a[best_length] == b[best_length]) {
+          size_t length = 0;
+          while (length < max_length && a[length] == b[length]) ++length;
+          if (length > best_length) {
+            best_length = length;
+            best_distance = i - candidate;
+            if (length == max_length) break;
+          }
+        }
+
+        auto next = prev[candidate & (DEFLATE_WINDOW - 1)];
+        if (next >= candidate) break;
+        candidate = next;
+      }
+
+      insert(i);
+    }
+
+    if (best_length >= DEFLATE_MIN_MATCH) {
+      auto length_code = tables.length_symbol[best_length];
+      auto symbol = 257 + length_code;
+      writer.put(tables.literal_code[symbol], tables.literal_bits[symbol]);
+      writer.put((uint32_t)(best_length - Deflate_Tables::length_base[length_code]), Deflate_Tables::length_extra[length_code]);
+
+      auto distance_code = tables.distance_symbol[best_distance];
+      writer.put(Deflate_Tables::reverse(distance_code, 5), 5);
+      writer.put((uint32_t)(best_distance - Deflate_Tables::distance_base[distance_code]), Deflate_Tables::distance_extra[distance_code]);
+
+      // The matched positions go into the chains too, except at the fast levels where it costs more than it finds
+      auto end = i + best_length;
+      if (level >= 4) {
+        for (++i; i < end && i + DEFLATE_MIN_MATCH <= size; ++i) {
+          insert(i);
+        }
+      }
+      i = end;
+    }
+    else {
+      writer.put(tables.literal_code[src[i]], tables.literal_bits[src[i]]);
+      ++i;
+    }
+  }
+
+  writer.put(tables.literal_code[256], tables.literal_bits[256]);
+  writer.align();
+}
+
+void file_sink_deflate(const uint8_t* src, size_t size, int level, std::vector<uint8_t>& out) {
+  out.push_back(0x78);
+  out.push_back(0x01);
+
+  auto body = out.size();
+  if (level > 0 && size > 0) {
+    deflate_fixed(src, size, level > 9 ? 9 : level, out);
+  }
+
+  // Noisy data comes out larger with the fixed codes than stored
+  auto stored_size = size + 5 * (size / 65535 + 1);
+  if (level <= 0 || size == 0 || out.size() - body > stored_size) {
+    out.resize(body);
+    deflate_stored(src, size, out);
+  }
+
+  auto adler = adler32(src, size);
+  out.push_back((uint8_t)(adler >> 24));
+  out.push_back((uint8_t)(adler >> 16));
+  out.push_back((uint8_t)(adler >> 8));
+  out.push_back((uint8_t)adler);
+}
+
+//
+// Encoders
+//
+
+static void put_u32_be(std::vector<uint8_t>& out, uint32_t value) {
+  out.push_back((uint8_t)(value >> 24));
+  out.push_back((uint8_t)(value >> 16));
+  out.push_back((uint8_t)(value >> 8));
+  out.push_back((uint8_t)value);
+}
+
+static void put_u32_le(std::vector<uint8_t>& out, uint32_t value) {
+  out.push_back((uint8_t)value);
+  out.push_back((uint8_t)(value >> 8));
+  out.push_back((uint8_t)(value >> 16));
+  out.push_back((uint8_t)(value >> 24));
+}
+
+static void put_u64_le(uint8_t* out, uint64_t value) {
+  for (int i = 0; i < 8; ++i) {
+    out[i] = (uint8_t)(value >> (8 * i));
+  }
+}
+
+static uint32_t crc32(const uint8_t* src, size_t size, uint32_t crc = 0) {
+  struct Table {
+    uint32_t entries[256];
+    Table() {
+      for (uint32_t n = 0; n < 256; ++n) {
+        auto c = n;
+        for (int k = 0; k < 8; ++k) {
+          c = c & 1 ? 0xedb88320u ^ (c >> 1) : c >> 1;
+        }
+        entries[n] = c;
+      }
+    }
+  };
+  static Table table;
+
+  crc = ~crc;
+  for (size_t i = 0; i < size; ++i) {
+    crc = table.entries[(crc ^ src[i]) & 0xff] ^ (crc >> 8);
+  }
+  return ~crc;
+}
+
+static void png_chunk(std::vector<uint8_t>& out, const char* type, const uint8_t* data, size_t size) {
+  put_u32_be(out, (uint32_t)size);
+  auto start = out.size();
+  out.insert(out.end(), type, type + 4);
+  if (size > 0) {
+    out.insert(out.end(), data, data + size);
+  }
+  put_u32_be(out, crc32(out.data() + start, out.size() - start));
+}
+
+static inline uint16_t float_to_unorm16(float value) {
+  // NaN compares false and ends up 0
+  if (!(value > 0.0f)) return 0;
+  if (value >= 1.0f) return 65535;
+  return (uint16_t)(value * 65535.0f + 0.5f);
+}
+
+void file_sink_encode_png(const char* src, size_t pitch, int width, int height, int compression, std::vector<uint8_t>& out) {
+  out.clear();
+
+  static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+  out.insert(out.end(), signature, signature + 8);
+
+  std::vector<uint8_t> header;
+  put_u32_be(header, (uint32_t)width);
+  put_u32_be(header, (uint32_t)height);
+  header.push_back(16);  // bit depth
+  header.push_back(6);   // RGBA
+  header.push_back(0);   // deflate
+  header.push_back(0);   // adaptive filtering
+  header.push_back(0);   // not interlaced
+  png_chunk(out, "IHDR", header.data(), header.size());
+
+  // Filter byte, then big endian 16 bit RGBA. Sub filtering when compressing, it's the cheapest one that helps.
+  auto row_bytes = (size_t)width * 8;
+  std::vector<uint8_t> rows((row_bytes + 1) * height);
+  auto filter = compression > 0 ? 1 : 0;
+
+  for (int y = 0; y < height; ++y) {
+    auto* in = (const float*)(src + (size_t)(height - 1 - y) * pitch);
+    auto* row = rows.data() + (row_bytes + 1) * y;
+    row[0] = (uint8_t)filter;
+    auto* px = row + 1;
+
+    for (int i = 0; i < width * 4; ++i) {
+      auto value = float_to_unorm16(in[i]);
+      px[i * 2] = (uint8_t)(value >> 8);
+      px[i * 2 + 1] = (uint8_t)value;
+    }
+
+    if (filter) {
+      for (auto i = row_bytes - 1; i >= 8; --i) {
+        px[i] = (uint8_t)(px[i] - px[i - 8]);
+      }
+    }
+  }
+
+  std::vector<uint8_t> data;
+  file_sink_deflate(rows.data(), rows.size(), compression, data);
+  png_chunk(out, "IDAT", data.data(), data.size());
+  png_chunk(out, "IEND", nullptr, 0);
+}
+
+static void exr_attribute(std::vector<uint8_t>& out, const char* name, const char* type, const void* data, size_t size) {
+  out.insert(out.end(), name, name + strlen(name) + 1);
+  out.insert(out.end(), type, type + strlen(type) + 1);
+  put_u32_le(out, (uint32_t)size);
+  out.insert(out.end(), (const uint8_t*)data, (const uint8_t*)data + size);
+}
+
+// Scanline EXR with half RGBA. Above level 0 blocks of 16 lines are zip compressed as OpenEXR does
+// it, the bytes split into even and odd halves and delta coded before deflating. A block that doesn't get smaller
+// is stored, readers tell by the size.
+void file_sink_encode_exr(const char* src, size_t pitch, int width, int height, int compression, std::vector<uint8_t>& out) {
+  out.clear();
+
+  auto zip = compression > 0;
+  auto lines_per_block = zip ? 16 : 1;
+  auto blocks = (height + lines_per_block - 1) / lines_per_block;
+
+  static const uint8_t magic[4] = { 0x76, 0x2f, 0x31, 0x01 };
+  out.insert(out.end(), magic, magic + 4);
+  put_u32_le(out, 2);
+
+  {
+    // Channels are stored in alphabetical order
+    std::vector<uint8_t> channels;
+    for (auto* name : { "A", "B", "G", "R" }) {
+      channels.push_back((uint8_t)name[0]);
+      channels.push_back(0);
+      put_u32_le(channels, 1);  // half
+      put_u32_le(channels, 0);  // pLinear and reserved
+      put_u32_le(channels, 1);  // x sampling
+      put_u32_le(channels, 1);  // y sampling
+    }
+    channels.push_back(0);
+    exr_attribute(out, "channels", "chlist", channels.data(), channels.size());
+  }
+
+  uint8_t compression_type = zip ? 3 : 0;
+  exr_attribute(out, "compression", "compression", &compression_type, 1);
+
+  std::vector<uint8_t> box;
+  put_u32_le(box, 0);
+  put_u32_le(box, 0);
+  put_u32_le(box, (uint32_t)(width - 1));
+  put_u32_le(box, (uint32_t)(height - 1));
+  exr_attribute(out, "dataWindow", "box2i", box.data(), box.size());
+  exr_attribute(out, "displayWindow", "box2i", box.data(), box.size());
+
+  uint8_t line_order = 0;
+  exr_attribute(out, "lineOrder", "lineOrder", &line_order, 1);
+
+  float aspect = 1.0f;
+  exr_attribute(out, "pixelAspectRatio", "float", &aspect, 4);
+  float center[2] = { 0.0f, 0.0f };
+  exr_attribute(out, "screenWindowCenter", "v2f", center, 8);
+  float window_width = 1.0f;
+  exr_attribute(out, "screenWindowWidth", "float", &window_width, 4);
+  out.push_back(0);
+
+  auto offsets = out.size();
+  out.resize(out.size() + (size_t)blocks * 8);
+
+  auto line_bytes = (size_t)width * 4 * 2;
+  std::vector<uint8_t> raw(line_bytes * lines_per_block);
+  std::vector<uint8_t> split(raw.size());
+  std::vector<uint8_t> packed;
+
+  for (int block = 0; block < blocks; ++block) {
+    auto y0 = block * lines_per_block;
+    auto lines = height - y0 < lines_per_block ? height - y0 : lines_per_block;
+
+    // Each line holds all of A, then B, G and R. EXR lines go top down.
+    for (int line = 0; line < lines; ++line) {
+      auto* in = (const float*)(src + (size_t)(height - 1 - y0 - line) * pitch);
+      auto* channel = (uint16_t*)(raw.data() + line_bytes * line);
+      for (int x = 0; x < width; ++x) {
+        channel[x] = float_to_half(in[x * 4 + 3]);
+        channel[width + x] = float_to_half(in[x * 4 + 2]);
+        channel[width * 2 + x] = float_to_half(in[x * 4 + 1]);
+        channel[width * 3 + x] = float_to_half(in[x * 4 + 0]);
+      }
+    }
+
+    auto size = line_bytes * lines;
+    const uint8_t* data = raw.data();
+    auto data_size = size;
+
+    if (zip) {
+      auto* t1 = split.data();
+      auto* t2 = split.data() + (size + 1) / 2;
+      for (size_t i = 0; i < size; i += 2) {
+        *t1++ = raw[i];
+        if (i + 1 < size) *t2++ = raw[i + 1];
+      }
+
+      auto previous = split[0];
+      for (size_t i = 1; i < size; ++i) {
+        auto value = split[i];
+        split[i] = (uint8_t)(value - previous + 128);
+        previous = value;
+      }
+
+      packed.clear();
+      file_sink_deflate(split.data(), size, compression, packed);
+      if (packed.size() < size) {
+        data = packed.data();
+        data_size = packed.size();
+      }
+    }
+
+    put_u64_le(out.data() + offsets + (size_t)block * 8, out.size());
+    put_u32_le(out, (uint32_t)y0);
+    put_u32_le(out, (uint32_t)data_size);
+    out.insert(out.end(), data, data + data_size);
+  }
+}
+
+void file_sink_encode_raw(const char* src, size_t pitch, int width, int height, std::vector<uint8_t>& out) {
+  auto row_bytes = (size_t)width * 4 * sizeof(float);
+  out.resize(row_bytes * height);
+  for (int y = 0; y < height; ++y) {
+    memcpy(out.data() + row_bytes * y, src + (size_t)(height - 1 - y) * pitch, row_bytes);
+  }
+}
+
+//
+// Sink
+//
+
+struct File_Sink::Pending_Write {
+  std::vector<uint8_t> data;
+  std::string path;
+  bool active = false;
+#ifdef _WIN32
+  HANDLE file = INVALID_HANDLE_VALUE;
+  HANDLE event = NULL;
+  OVERLAPPED overlapped = {};
+#else
+  int file = -1;
+  struct aiocb request = {};
+#endif
+};
+
+File_Sink::File_Sink() {
+  budget_bytes = (size_t)512 * 1024 * 1024;
+  if (auto* env = getenv("SPOUT_FILE_SINK_QUEUE_MB")) {
+    auto mb = strtoull(env, nullptr, 10);
+    if (mb > 0) {
+      budget_bytes = (size_t)mb * 1024 * 1024;
+    }
+  }
+
+  auto cores = (int)std::thread::hardware_concurrency();
+  thread_count = cores > 1 ? cores / 2 : 1;
+  if (thread_count > 8) thread_count = 8;
+  if (auto* env = getenv("SPOUT_FILE_SINK_THREADS")) {
+    auto threads = atoi(env);
+    if (threads > 0) {
+      thread_count = threads;
+    }
+  }
+
+  written = 0;
+  dropped = 0;
+  failed = 0;
+  bytes_written = 0;
+  queued = 0;
+  pool_bytes = 0;
+  frames_per_second_milli = 0;
+  bytes_per_second = 0;
+}
+
+File_Sink::~File_Sink() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  queue_cv.notify_all();
+  for (auto& thread : workers) {
+    thread.join();
+  }
+}
+
+void File_Sink::start_workers() {
+  for (int i = 0; i < thread_count; ++i) {
+    workers.emplace_back(&File_Sink::worker, this);
+  }
+  SpoutLogNotice("File_Sink : %d encoder threads, %zu MB of frames", thread_count, budget_bytes / (1024 * 1024));
+}
+
+File_Sink_Frame* File_Sink::Acquire(int width, int height, int policy) {
+  std::unique_lock<std::mutex> lock(mutex);
+  if (workers.empty()) {
+    start_workers();
+  }
+  trimming = false;
+
+  auto frame_bytes = (size_t)width * height * 4 * sizeof(float);
+  auto limit = frame_bytes > 0 ? budget_bytes / frame_bytes : FILE_SINK_MAX_FRAMES;
+  if (limit < FILE_SINK_MIN_FRAMES) limit = FILE_SINK_MIN_FRAMES;
+  if (limit > FILE_SINK_MAX_FRAMES) limit = FILE_SINK_MAX_FRAMES;
+
+  for (;;) {
+    if (!free_frames.empty()) {
+      auto* frame = free_frames.back();
+      free_frames.pop_back();
+      lock.unlock();
+
+      // Only grows, so after the first frames of a size there is nothing to allocate
+      auto capacity = frame->pixels.capacity();
+      frame->pixels.resize((size_t)width * height * 4);
+      pool_bytes.fetch_add((frame->pixels.capacity() - capacity) * sizeof(float), std::memory_order_relaxed);
+      frame->width = width;
+      frame->height = height;
+      return frame;
+    }
+
+    if (frames.size() < limit) {
+      frames.emplace_back(new File_Sink_Frame);
+      free_frames.push_back(frames.back().get());
+      continue;
+    }
+
+    if (policy != FILE_SINK_WAIT) {
+      dropped.fetch_add(1, std::memory_order_relaxed);
+      return nullptr;
+    }
+    free_cv.wait(lock);
+  }
+}
+
+void File_Sink::Submit(File_Sink_Frame* frame, double time, const File_Sink_Config& config) {
+  frame->time = time;
+  frame->config.directory = config.directory;
+  frame->config.prefix = config.prefix;
+  frame->config.encoder = config.encoder;
+  frame->config.compression = config.compression;
+  frame->config.policy = config.policy;
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    queue.push_back(frame);
+    queued.store((int)(queue.size() - queue_head), std::memory_order_relaxed);
+  }
+  queue_cv.notify_one();
+}
+
+void File_Sink::Cancel(File_Sink_Frame* frame) {
+  std::lock_guard<std::mutex> lock(mutex);
+  release(frame);
+}
+
+// Called with the mutex held
+void File_Sink::release(File_Sink_Frame* frame) {
+  free_frames.push_back(frame);
+  if (trimming) {
+    free_unused();
+  }
+  free_cv.notify_one();
+}
+
+void File_Sink::Trim() {
+  std::lock_guard<std::mutex> lock(mutex);
+  trimming = true;
+  free_unused();
+}
+
+// Called with the mutex held
+void File_Sink::free_unused() {
+  for (auto* frame : free_frames) {
+    pool_bytes.fetch_sub(frame->pixels.capacity() * sizeof(float), std::memory_order_relaxed);
+    for (auto& owned : frames) {
+      if (owned.get() == frame) {
+        owned.swap(frames.back());
+        frames.pop_back();
+        break;
+      }
+    }
+  }
+  free_frames.clear();
+}
+
+void File_Sink::Flush() {
+  std::unique_lock<std::mutex> lock(mutex);
+  idle_cv.wait(lock, [this] { return queue_head == queue.size() && busy == 0 && writing == 0; });
+}
+
+void File_Sink::worker() {
+  Pending_Write writes[FILE_SINK_WRITES_PER_WORKER];
+  int next_write = 0;
+#ifdef _WIN32
+  for (auto& pending : writes) {
+    pending.event = CreateEventA(NULL, TRUE, FALSE, NULL);
+  }
+#endif
+
+  std::unique_lock<std::mutex> lock(mutex);
+  for (;;) {
+    // Writes finish while we wait for a frame, so a pause in playback doesn't leave files half written
+    if (queue_head == queue.size() && !stopping) {
+      lock.unlock();
+      for (auto& pending : writes) {
+        finish_write(pending);
+      }
+      lock.lock();
+    }
+
+    queue_cv.wait(lock, [this] { return queue_head < queue.size() || stopping; });
+    if (queue_head == queue.size()) {
+      break;
+    }
+
+    auto* frame = queue[queue_head++];
+    if (queue_head == queue.size()) {
+      queue.clear();
+      queue_head = 0;
+    }
+    queued.store((int)(queue.size() - queue_head), std::memory_order_relaxed);
+    ++busy;
+    lock.unlock();
+
+    // The oldest write of ours gets its buffer back first
+    auto& pending = writes[next_write];
+    next_write = (next_write + 1) % FILE_SINK_WRITES_PER_WORKER;
+    finish_write(pending);
+
+    static const char* extensions[] = { "exr", "png", "raw" };
+    auto encoder = frame->config.encoder >= FILE_SINK_EXR && frame->config.encoder <= FILE_SINK_RAW ? frame->config.encoder : FILE_SINK_EXR;
+
+    char name[64];
+    if (encoder == FILE_SINK_RAW) {
+      snprintf(name, sizeof(name), "_%dx%d_%06lld.%s", frame->width, frame->height, (long long)llround(frame->time), extensions[encoder]);
+    }
+    else {
+      snprintf(name, sizeof(name), "_%06lld.%s", (long long)llround(frame->time), extensions[encoder]);
+    }
+    pending.path = frame->config.directory;
+    if (!pending.path.empty() && pending.path.back() != '/' && pending.path.back() != '\\') {
+      pending.path += '/';
+    }
+    pending.path += frame->config.prefix;
+    pending.path += name;
+
+    {
+      spoutHistogramTimer encode_timer(encode_times);
+      switch (encoder) {
+        case FILE_SINK_PNG:
+          file_sink_encode_png(frame->data(), frame->pitch(), frame->width, frame->height, frame->config.compression, pending.data);
+          break;
+        case FILE_SINK_RAW:
+          file_sink_encode_raw(frame->data(), frame->pitch(), frame->width, frame->height, pending.data);
+          break;
+        default:
+          file_sink_encode_exr(frame->data(), frame->pitch(), frame->width, frame->height, frame->config.compression, pending.data);
+          break;
+      }
+    }
+
+    // The frame is free as soon as it's encoded, the write goes on from our own buffer
+    lock.lock();
+    release(frame);
+    lock.unlock();
+
+    pending.active = false;
+
+#ifdef _WIN32
+    pending.file = CreateFileA(pending.path.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS,
+                               FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (pending.file != INVALID_HANDLE_VALUE) {
+      pending.overlapped = {};
+      pending.overlapped.hEvent = pending.event;
+      ResetEvent(pending.event);
+      if (WriteFile(pending.file, pending.data.data(), (DWORD)pending.data.size(), NULL, &pending.overlapped) || GetLastError() == ERROR_IO_PENDING) {
+        pending.active = true;
+      }
+      else {
+        CloseHandle(pending.file);
+        pending.file = INVALID_HANDLE_VALUE;
+      }
+    }
+#else
+    pending.file = open(pending.path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (pending.file >= 0) {
+      pending.request = {};
+      pending.request.aio_fildes = pending.file;
+      pending.request.aio_buf = pending.data.data();
+      pending.request.aio_nbytes = pending.data.size();
+      pending.request.aio_offset = 0;
+      if (aio_write(&pending.request) == 0) {
+        pending.active = true;
+      }
+      else {
+        close(pending.file);
+        pending.file = -1;
+      }
+    }
+#endif
+
+    if (!pending.active && failed.fetch_add(1, std::memory_order_relaxed) == 0) {
+      SpoutLogWarning("File_Sink : could not write %s", pending.path.c_str());
+    }
+
+    lock.lock();
+    --busy;
+    if (pending.active) {
+      ++writing;
+    }
+    else if (queue_head == queue.size() && busy == 0 && writing == 0) {
+      idle_cv.notify_all();
+    }
+  }
+  lock.unlock();
+
+  for (auto& pending : writes) {
+    finish_write(pending);
+#ifdef _WIN32
+    CloseHandle(pending.event);
+#endif
+  }
+}
+
+// Waits for a write started by this worker and closes its file
+void File_Sink::finish_write(Pending_Write& pending) {
+  if (!pending.active) {
+    return;
+  }
+  pending.active = false;
+
+  auto wait_start = spoutHistogram::Now();
+  auto ok = false;
+#ifdef _WIN32
+  DWORD bytes = 0;
+  ok = GetOverlappedResult(pending.file, &pending.overlapped, &bytes, TRUE) && bytes == pending.data.size();
+  CloseHandle(pending.file);
+  pending.file = INVALID_HANDLE_VALUE;
+#else
+  const struct aiocb* requests[1] = { &pending.request };
+  while (aio_error(&pending.request) == EINPROGRESS) {
+    aio_suspend(requests, 1, nullptr);
+  }
+  auto bytes = aio_return(&pending.request);
+  // A short write finishes synchronously, it's rare enough not to bother with another request
+  while (bytes >= 0 && (size_t)bytes < pending.data.size()) {
+    auto more = pwrite(pending.file, pending.data.data() + bytes, pending.data.size() - bytes, bytes);
+    if (more <= 0) break;
+    bytes += more;
+  }
+  ok = bytes >= 0 && (size_t)bytes == pending.data.size();
+  close(pending.file);
+  pending.file = -1;
+#endif
+
+  auto now = spoutHistogram::Now();
+  write_wait_times.Record(now - wait_start);
+
+  if (ok) {
+    count_write(pending.data.size(), now);
+  }
+  else if (failed.fetch_add(1, std::memory_order_relaxed) == 0) {
+    SpoutLogWarning("File_Sink : could not write %s", pending.path.c_str());
+  }
+
+  std::lock_guard<std::mutex> lock(mutex);
+  if (--writing == 0 && queue_head == queue.size() && busy == 0) {
+    idle_cv.notify_all();
+  }
+}
+
+void File_Sink::count_write(size_t bytes, int64_t now) {
+  written.fetch_add(1, std::memory_order_relaxed);
+  bytes_written.fetch_add(bytes, std::memory_order_relaxed);
+
+  std::lock_guard<std::mutex> lock(mutex);
+  if (window_start_ns == 0) {
+    window_start_ns = now;
+  }
+  ++window_frames;
+  window_bytes += bytes;
+
+  auto elapsed = now - window_start_ns;
+  if (elapsed >= 1000000000LL) {
+    frames_per_second_milli.store((int64_t)(window_frames * 1e12 / elapsed), std::memory_order_relaxed);
+    bytes_per_second.store((int64_t)(window_bytes * 1e9 / elapsed), std::memory_order_relaxed);
+    window_start_ns = now;
+    window_frames = 0;
+    window_bytes = 0;
+  }
+}
+
+void File_Sink::Stats(File_Sink_Stats& stats) const {
+  stats.written = written.load(std::memory_order_relaxed);
+  stats.dropped = dropped.load(std::memory_order_relaxed);
+  stats.failed = failed.load(std::memory_order_relaxed);
+  stats.bytes = bytes_written.load(std::memory_order_relaxed);
+  stats.frames_per_second = frames_per_second_milli.load(std::memory_order_relaxed) / 1000.0;
+  stats.bytes_per_second = (double)bytes_per_second.load(std::memory_order_relaxed);
+  stats.queued = queued.load(std::memory_order_relaxed);
+}
+
+void File_Sink::Log(const char* name) const {
+  File_Sink_Stats stats;
+  Stats(stats);
+  if (stats.written == 0 && stats.dropped == 0 && stats.failed == 0) {
+    return;
+  }
+
+  SpoutLogNotice("%s : %llu frames written, %llu dropped, %llu failed, %.1f MB",
+                 name, (unsigned long long)stats.written, (unsigned long long)stats.dropped,
+                 (unsigned long long)stats.failed, stats.bytes / (1024.0 * 1024.0));
+
+  std::string label = name;
+  encode_times.Log((label + " encode").c_str());
+  write_wait_times.Log((label + " write wait").c_str());
+}
@@ -0,0 +1,170 @@
+/*
+Davinci Resolve Spout Sender
+Copyright (C) 2025 ValueFactory
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of
+the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "SpoutHistogram.h"
+
+// Writes the frames we publish to disk as an image sequence for review. render only copies the frame
+// into a pooled buffer and queues it, a pool of workers encodes the frames and writes them with overlapped I/O
+// (POSIX AIO off Windows), so the disk never holds up the render. Frames are float RGBA with the rows bottom up
+// as OFX gives them to us, the files are written top down.
+// The pool holds at most SPOUT_FILE_SINK_QUEUE_MB of frames, 512 by default, and there are
+// SPOUT_FILE_SINK_THREADS workers, half the cores by default.
+
+// Option order of the File Format param
+enum File_Sink_Encoder {
+  FILE_SINK_EXR = 0,  // Half float RGBA, zip compressed unless the level is 0
+  FILE_SINK_PNG,      // 16 bit RGBA clamped to 0-1, deflated at the level
+  FILE_SINK_RAW,      // Float RGBA rows top down, no header, the size is in the file name
+};
+
+// Option order of the File Queue param
+enum File_Sink_Policy {
+  FILE_SINK_DROP = 0,  // A frame arriving with every buffer in use is not written
+  FILE_SINK_WAIT,      // The render waits for a buffer
+};
+
+struct File_Sink_Config {
+  std::string directory;
+  std::string prefix;
+  int encoder = FILE_SINK_EXR;
+  // 0 is uncompressed, 1-9 trade time for size like zlib levels
+  int compression = 4;
+  int policy = FILE_SINK_DROP;
+};
+
+// A frame on its way to disk. Filled by the render between Acquire and Submit.
+struct File_Sink_Frame {
+  std::vector<float> pixels;
+  int width = 0;
+  int height = 0;
+  double time = 0.0;
+  File_Sink_Config config;
+
+  char* data() { return (char*)pixels.data(); }
+  size_t pitch() const { return (size_t)width * 4 * sizeof(float); }
+};
+
+struct File_Sink_Stats {
+  uint64_t written = 0;
+  uint64_t dropped = 0;
+  uint64_t failed = 0;
+  uint64_t bytes = 0;
+  // Over the last second of writes
+  double frames_per_second = 0.0;
+  double bytes_per_second = 0.0;
+  int queued = 0;
+};
+
+class File_Sink {
+public:
+  File_Sink();
+  // Writes what is queued, then stops the workers
+  ~File_Sink();
+  File_Sink(const File_Sink&) = delete;
+  File_Sink& operator=(const File_Sink&) = delete;
+
+  // Returns a buffer for a width x height frame, or null when the frame is dropped. Waits for a buffer
+  // under FILE_SINK_WAIT. Starts the workers on the first call.
+  File_Sink_Frame* Acquire(int width, int height, int policy);
+  // Queues a filled frame to be written with config
+  void Submit(File_Sink_Frame* frame, double time, const File_Sink_Config& config);
+  // Returns an unused frame to the pool
+  void Cancel(File_Sink_Frame* frame);
+  // Waits until every queued frame is on disk
+  void Flush();
+  // Frees the buffers not in use. Frames being written are freed as they come back.
+  void Trim();
+  // Bytes of the buffers in the pool
+  size_t PoolBytes() const { return pool_bytes.load(std::memory_order_relaxed); }
+
+  // Lock free, for the stats overlay
+  void Stats(File_Sink_Stats& stats) const;
+  void Log(const char* name) const;
+
+  // Time to encode a frame, and time a worker waited for its earlier write to complete before reusing
+  // the buffer, in nanoseconds. Waits mean the disk is slower than the encoders.
+  spoutHistogram encode_times;
+  spoutHistogram write_wait_times;
+
+private:
+  struct Pending_Write;
+
+  void start_workers();
+  void worker();
+  void release(File_Sink_Frame* frame);
+  void free_unused();
+  void finish_write(Pending_Write& pending);
+  void count_write(size_t bytes, int64_t now);
+
+  std::mutex mutex;
+  std::condition_variable queue_cv;
+  std::condition_variable free_cv;
+  std::condition_variable idle_cv;
+
+  std::vector<std::unique_ptr<File_Sink_Frame>> frames;
+  std::vector<File_Sink_Frame*> free_frames;
+  std::vector<File_Sink_Frame*> queue;
+  size_t queue_head = 0;
+  size_t budget_bytes;
+  // Set by Trim until the next Acquire
+  bool trimming = false;
+  // Workers encoding a frame and writes in flight
+  int busy = 0;
+  int writing = 0;
+  bool stopping = false;
+
+  std::vector<std::thread> workers;
+  int thread_count;
+
+  // Throughput window, under the mutex
+  int64_t window_start_ns = 0;
+  uint64_t window_frames = 0;
+  uint64_t window_bytes = 0;
+
+  std::atomic<uint64_t> written;
+  std::atomic<uint64_t> dropped;
+  std::atomic<uint64_t> failed;
+  std::atomic<uint64_t> bytes_written;
+  std::atomic<int> queued;
+  std::atomic<size_t> pool_bytes;
+  std::atomic<int64_t> frames_per_second_milli;
+  std::atomic<int64_t> bytes_per_second;
+};
+
+// Encoders, also used by tools/spout_file_sink_bench.cpp. Each replaces out with the file.
+// src holds float RGBA rows bottom up, pitch bytes apart.
+void file_sink_encode_exr(const char* src, size_t pitch, int width, int height, int compression, std::vector<uint8_t>& out);
+void file_sink_encode_png(const char* src, size_t pitch, int width, int height, int compression, std::vector<uint8_t>& out);
+void file_sink_encode_raw(const char* src, size_t pitch, int width, int height, std::vector<uint8_t>& out);
+
+// Appends a zlib stream of size bytes of src to out, level 0 stores it
+void file_sink_deflate(const uint8_t* src, size_t size, int level, std::vector<uint8_t>& out);
@@ -0,0 +1,547 @@
+/*
+Davinci Resolve Spout Sender
+Copyright (C) 2025 ValueFactory
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of
+the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+#include "frame_stats.h"
+
+#include <math.h>
+#include <string.h>
+
+#include <thread>
+
+#if !defined(_M_ARM64) && !defined(__aarch64__)
+#define FRAME_STATS_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(__clang__) || defined(__GNUC__)
+#define SPOUT_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define SPOUT_TARGET_AVX2
+#endif
+
+static_assert(sizeof(Frame_Stats) % sizeof(uint64_t) == 0, "Frame_Stats must be 8 byte aligned");
+
+// Rec. 709
+static const float luma_r = 0.2126f;
+static const float luma_g = 0.7152f;
+static const float luma_b = 0.0722f;
+
+//
+// Frame_Stats_Partial
+//
+
+void Frame_Stats_Partial::clear() {
+  for (int c = 0; c < 4; ++c) {
+    min[c] = INFINITY;
+    max[c] = -INFINITY;
+    sum[c] = 0.0;
+    finite_count[c] = 0;
+    nan_count[c] = 0;
+    inf_count[c] = 0;
+    under_count[c] = 0;
+    over_count[c] = 0;
+  }
+  memset(luma, 0, sizeof(luma));
+}
+
+void Frame_Stats_Partial::add(const Frame_Stats_Partial& other) {
+  for (int c = 0; c < 4; ++c) {
+    min[c] = other.min[c] < min[c] ? other.min[c] : min[c];
+    max[c] = other.max[c] > max[c] ? other.max[c] : max[c];
+    sum[c] += other.sum[c];
+    finite_count[c] += other.finite_count[c];
+    nan_count[c] += other.nan_count[c];
+    inf_count[c] += other.inf_count[c];
+    under_count[c] += other.under_count[c];
+    over_count[c] += other.over_count[c];
+  }
+  for (int i = 0; i < FRAME_STATS_LUMA_BINS; ++i) {
+    luma[i] += other.luma[i];
+  }
+}
+
+void Frame_Stats_Partial::finish(Frame_Stats& stats) const {
+  for (int c = 0; c < 4; ++c) {
+    // Nothing finite in the channel
+    if (finite_count[c] == 0) {
+      stats.min[c] = 0.0f;
+      stats.max[c] = 0.0f;
+      stats.mean[c] = 0.0f;
+    }
+    else {
+      stats.min[c] = min[c];
+      stats.max[c] = max[c];
+      stats.mean[c] = (float)(sum[c] / finite_count[c]);
+    }
+    stats.nan_count[c] = nan_count[c];
+    stats.inf_count[c] = inf_count[c];
+    stats.under_count[c] = under_count[c];
+    stats.over_count[c] = over_count[c];
+  }
+  memcpy(stats.luma, luma, sizeof(luma));
+}
+
+//
+// Kernels
+//
+
+// Histogram bin of a luma value, FRAME_STATS_LUMA_BINS for NaN and Inf. The AVX2 kernel clamps the same way.
+static inline int luma_bin(float l) {
+  if (!(fabsf(l) < INFINITY)) {
+    return FRAME_STATS_LUMA_BINS;
+  }
+  auto scaled = l * FRAME_STATS_LUMA_BINS;
+  scaled = scaled < 0.0f ? 0.0f : scaled;
+  scaled = scaled > FRAME_STATS_LUMA_BINS - 1 ? FRAME_STATS_LUMA_BINS - 1 : scaled;
+  return (int)scaled;
+}
+
+// 8 bit channels scaled to 0-1 with the same float multiply as the AVX2 kernel
+static inline float channel_value(float v) { return v; }
+static inline float channel_value(uint8_t v) { return (float)v * (1.0f / 255.0f); }
+
+template <typename T>
+static inline void stats_pixel(const T* px, Frame_Stats_Partial& partial, uint32_t* luma) {
+  float p[4] = { channel_value(px[0]), channel_value(px[1]), channel_value(px[2]), channel_value(px[3]) };
+  for (int c = 0; c < 4; ++c) {
+    auto v = p[c];
+    if (v != v) {
+      ++partial.nan_count[c];
+    }
+    else if (fabsf(v) == INFINITY) {
+      ++partial.inf_count[c];
+    }
+    else {
+      ++partial.finite_count[c];
+      partial.min[c] = v < partial.min[c] ? v : partial.min[c];
+      partial.max[c] = v > partial.max[c] ? v : partial.max[c];
+      partial.sum[c] += v;
+    }
+    partial.under_count[c] += v < 0.0f;
+    partial.over_count[c] += v > 1.0f;
+  }
+
+  // Summed in the order of the AVX2 horizontal adds so both give the same bin
+  auto l = (p[0] * luma_r + p[1] * luma_g) + p[2] * luma_b;
+  ++luma[luma_bin(l)];
+}
+
+template <typename T>
+static void stats_rows_scalar(const char* src, size_t src_pitch, char* dst, size_t dst_pitch, int width, int rows,
+  Frame_Stats_Partial& partial) {
+  uint32_t luma[FRAME_STATS_LUMA_BINS + 1] = {};
+  auto row_bytes = (size_t)width * 4 * sizeof(T);
+  for (int y = 0; y < rows; ++y) {
+    auto* p = (const T*)(src + (size_t)y * src_pitch);
+    for (int x = 0; x < width; ++x) {
+      stats_pixel(p + x * 4, partial, luma);
+    }
+    // The row is in cache from the loop above
+    if (dst) {
+      memcpy(dst + (size_t)y * dst_pitch, p, row_bytes);
+    }
+  }
+  for (int i = 0; i < FRAME_STATS_LUMA_BINS; ++i) {
+    partial.luma[i] += luma[i];
+  }
+}
+
+void frame_stats_copy_rows_scalar(const char* src, size_t src_pitch, char* dst, size_t dst_pitch, int width, int rows,
+  int depth, Frame_Stats_Partial& partial) {
+  if (depth == FRAME_STATS_BYTE) {
+    stats_rows_scalar<uint8_t>(src, src_pitch, dst, dst_pitch, width, rows, partial);
+  }
+  else {
+    stats_rows_scalar<float>(src, src_pitch, dst, dst_pitch, width, rows, partial);
+  }
+}
+
+#ifdef FRAME_STATS_X86
+
+// Accumulators of the AVX2 kernel. Each vector holds two pixels, so lane i is channel i % 4. NaN isn't counted
+// here, it is what is left of the pixels once the finite and infinite ones are taken away.
+struct Stats_Lanes {
+  __m256 min;
+  __m256 max;
+  __m256 sum;
+  __m256i finite;
+  __m256i inf;
+  __m256i under;
+  __m256i over;
+};
+
+// 8 bit values are always finite and in 0-1, so only the minimum, maximum and sum are kept for them
+template <bool Float>
+SPOUT_TARGET_AVX2 static inline void stats_lanes_add(Stats_Lanes& lanes, __m256 v) {
+  if (!Float) {
+    lanes.min = _mm256_min_ps(lanes.min, v);
+    lanes.max = _mm256_max_ps(lanes.max, v);
+    lanes.sum = _mm256_add_ps(lanes.sum, v);
+    return;
+  }
+
+  const __m256 abs_mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+  const __m256 pos_inf = _mm256_set1_ps(INFINITY);
+
+  const __m256 a = _mm256_and_ps(v, abs_mask);
+  const __m256 finite = _mm256_cmp_ps(a, pos_inf, _CMP_LT_OQ);
+  const __m256 inf = _mm256_cmp_ps(a, pos_inf, _CMP_EQ_OQ);
+
+  // v + v * 0 turns the infinities into NaN and keeps every finite value as it is, sign of zero included.
+  // min_ps and max_ps return the second operand when the first is NaN, so the NaN are left out without a blend.
+  const __m256 f = _mm256_add_ps(v, _mm256_mul_ps(v, _mm256_setzero_ps()));
+  lanes.min = _mm256_min_ps(f, lanes.min);
+  lanes.max = _mm256_max_ps(f, lanes.max);
+  lanes.sum = _mm256_add_ps(lanes.sum, _mm256_and_ps(v, finite));
+
+  // Masks are -1 where set
+  lanes.finite = _mm256_sub_epi32(lanes.finite, _mm256_castps_si256(finite));
+  lanes.inf = _mm256_sub_epi32(lanes.inf, _mm256_castps_si256(inf));
+  lanes.under = _mm256_sub_epi32(lanes.under, _mm256_castps_si256(_mm256_cmp_ps(v, _mm256_setzero_ps(), _CMP_LT_OQ)));
+  lanes.over = _mm256_sub_epi32(lanes.over, _mm256_castps_si256(_mm256_cmp_ps(v, _mm256_set1_ps(1.0f), _CMP_GT_OQ)));
+}
+
+// Four pixels as two vectors of two, stored to d on the way when copying
+template <bool Copy>
+SPOUT_TARGET_AVX2 static inline void load_pixels(const float* p, float* d, __m256& v0, __m256& v1) {
+  v0 = _mm256_loadu_ps(p);
+  v1 = _mm256_loadu_ps(p + 8);
+  if (Copy) {
+    _mm256_storeu_ps(d, v0);
+    _mm256_storeu_ps(d + 8, v1);
+  }
+}
+
+template <bool Copy>
+SPOUT_TARGET_AVX2 static inline void load_pixels(const uint8_t* p, uint8_t* d, __m256& v0, __m256& v1) {
+  const __m128i raw = _mm_loadu_si128((const __m128i*)p);
+  if (Copy) {
+    _mm_storeu_si128((__m128i*)d, raw);
+  }
+  const __m256 scale = _mm256_set1_ps(1.0f / 255.0f);
+  v0 = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(raw)), scale);
+  v1 = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_srli_si128(raw, 8))), scale);
+}
+
+template <typename T, bool Copy>
+SPOUT_TARGET_AVX2 static void stats_rows_avx2(const char* src, size_t src_pitch, char* dst, size_t dst_pitch, int width,
+  int rows, Frame_Stats_Partial& partial) {
+  const bool Float = sizeof(T) == sizeof(float);
+  const __m256 weights = _mm256_setr_ps(luma_r, luma_g, luma_b, 0.0f, luma_r, luma_g, luma_b, 0.0f);
+  // Alpha is masked out rather than weighted by zero, a NaN or Inf alpha would spoil the luma
+  const __m256 rgb_mask = _mm256_castsi256_ps(_mm256_setr_epi32(-1, -1, -1, 0, -1, -1, -1, 0));
+  const __m256 abs_mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+  const __m256 pos_inf = _mm256_set1_ps(INFINITY);
+  const __m256 bins = _mm256_set1_ps((float)FRAME_STATS_LUMA_BINS);
+  const __m256 top_bin = _mm256_set1_ps((float)(FRAME_STATS_LUMA_BINS - 1));
+  const __m256i no_bin = _mm256_set1_epi32(FRAME_STATS_LUMA_BINS);
+
+  Stats_Lanes lanes;
+  lanes.min = pos_inf;
+  lanes.max = _mm256_set1_ps(-INFINITY);
+  lanes.finite = _mm256_setzero_si256();
+  lanes.inf = _mm256_setzero_si256();
+  lanes.under = _mm256_setzero_si256();
+  lanes.over = _mm256_setzero_si256();
+
+  // One histogram per pixel of the 4, so a run of pixels in the same bin doesn't wait on its own increments
+  uint32_t luma[4][FRAME_STATS_LUMA_BINS + 1] = {};
+  alignas(32) int32_t bin[8];
+  alignas(32) float sum[8];
+
+  const int vector_width = width & ~3;
+  const size_t row_bytes = (size_t)width * 4 * sizeof(T);
+  const size_t vector_bytes = (size_t)vector_width * 4 * sizeof(T);
+
+  for (int y = 0; y < rows; ++y) {
+    auto* p = (const T*)(src + (size_t)y * src_pitch);
+    auto* d = Copy ? (T*)(dst + (size_t)y * dst_pitch) : nullptr;
+    // Summed in float along the row and in double across rows
+    lanes.sum = _mm256_setzero_ps();
+
+    for (int x = 0; x < vector_width; x += 4) {
+      __m256 v0, v1;
+      load_pixels<Copy>(p + x * 4, d + x * 4, v0, v1);
+      stats_lanes_add<Float>(lanes, v0);
+      stats_lanes_add<Float>(lanes, v1);
+
+      // Luma of the 4 pixels, in the order 0 2 0 2 1 3 1 3
+      __m256 l = _mm256_hadd_ps(_mm256_and_ps(_mm256_mul_ps(v0, weights), rgb_mask),
+        _mm256_and_ps(_mm256_mul_ps(v1, weights), rgb_mask));
+      l = _mm256_hadd_ps(l, l);
+
+      // max_ps returns zero for NaN, which the finite mask then drops
+      const __m256 finite = _mm256_cmp_ps(_mm256_and_ps(l, abs_mask), pos_inf, _CMP_LT_OQ);
+      const __m256 scaled = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(l, bins), _mm256_setzero_ps()), top_bin);
+      const __m256i b = _mm256_blendv_epi8(no_bin, _mm256_cvttps_epi32(scaled), _mm256_castps_si256(finite));
+      _mm256_store_si256((__m256i*)bin, b);
+      ++luma[0][bin[0]];
+      ++luma[1][bin[1]];
+      ++luma[2][bin[4]];
+      ++luma[3][bin[5]];
+    }
+
+    _mm256_store_ps(sum, lanes.sum);
+    for (int c = 0; c < 4; ++c) {
+      partial.sum[c] += (double)sum[c] + (double)sum[c + 4];
+    }
+
+    // Remaining pixels
+    for (int x = vector_width; x < width; ++x) {
+      stats_pixel(p + x * 4, partial, luma[0]);
+    }
+    if (Copy && row_bytes > vector_bytes) {
+      memcpy((char*)d + vector_bytes, (const char*)p + vector_bytes, row_bytes - vector_bytes);
+    }
+  }
+
+  alignas(32) float min[8];
+  alignas(32) float max[8];
+  alignas(32) uint32_t counts[4][8];
+  _mm256_store_ps(min, lanes.min);
+  _mm256_store_ps(max, lanes.max);
+  _mm256_store_si256((__m256i*)counts[0], lanes.finite);
+  _mm256_store_si256((__m256i*)counts[1], lanes.inf);
+  _mm256_store_si256((__m256i*)counts[2], lanes.under);
+  _mm256_store_si256((__m256i*)counts[3], lanes.over);
+
+  // Pixels of each channel that went through the vector loop
+  const uint32_t vector_pixels = (uint32_t)vector_width * (uint32_t)rows;
+  for (int c = 0; c < 4; ++c) {
+    uint32_t finite = 0;
+    uint32_t inf = 0;
+    for (int lane = c; lane < 8; lane += 4) {
+      partial.min[c] = min[lane] < partial.min[c] ? min[lane] : partial.min[c];
+      partial.max[c] = max[lane] > partial.max[c] ? max[lane] : partial.max[c];
+      finite += counts[0][lane];
+      inf += counts[1][lane];
+      partial.under_count[c] += counts[2][lane];
+      partial.over_count[c] += counts[3][lane];
+    }
+    finite = Float ? finite : vector_pixels;
+    partial.finite_count[c] += finite;
+    partial.inf_count[c] += inf;
+    partial.nan_count[c] += vector_pixels - finite - inf;
+  }
+  for (int i = 0; i < FRAME_STATS_LUMA_BINS; ++i) {
+    partial.luma[i] += luma[0][i] + luma[1][i] + luma[2][i] + luma[3][i];
+  }
+}
+
+void frame_stats_copy_rows_avx2(const char* src, size_t src_pitch, char* dst, size_t dst_pitch, int width, int rows,
+  int depth, Frame_Stats_Partial& partial) {
+  if (depth == FRAME_STATS_BYTE) {
+    if (dst) {
+      stats_rows_avx2<uint8_t, true>(src, src_pitch, dst, dst_pitch, width, rows, partial);
+    }
+    else {
+      stats_rows_avx2<uint8_t, false>(src, src_pitch, dst, dst_pitch, width, rows, partial);
+    }
+  }
+  else {
+    if (dst) {
+      stats_rows_avx2<float, true>(src, src_pitch, dst, dst_pitch, width, rows, partial);
+    }
+    else {
+      stats_rows_avx2<float, false>(src, src_pitch, dst, dst_pitch, width, rows, partial);
+    }
+  }
+}
+
+// Same test as spoutCopy::CheckSSE, the OS has to save the AVX registers as well.
+bool frame_stats_has_avx2() {
+#ifdef _MSC_VER
+  int info[4] = {};
+  __cpuid(info, 0);
+  if (info[0] < 7) {
+    return false;
+  }
+  __cpuid(info, 1);
+  auto osxsave = (info[2] & (1 << 27)) != 0;
+  auto avx = (info[2] & (1 << 28)) != 0;
+  if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) {
+    return false;
+  }
+  __cpuidex(info, 7, 0);
+  return (info[1] & (1 << 5)) != 0;
+#else
+  return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#else
+
+void frame_stats_copy_rows_avx2(const char* src, size_t src_pitch, char* dst, size_t dst_pitch, int width, int rows,
+  int depth, Frame_Stats_Partial& partial) {
+  frame_stats_copy_rows_scalar(src, src_pitch, dst, dst_pitch, width, rows, depth, partial);
+}
+
+bool frame_stats_has_avx2() {
+  return false;
+}
+
+#endif
+
+//
+// Frame_Stats_Accumulator
+//
+
+Frame_Stats_Accumulator::Frame_Stats_Accumulator() {
+  avx2 = frame_stats_has_avx2();
+  copy_fn = avx2 ? frame_stats_copy_rows_avx2 : frame_stats_copy_rows_scalar;
+  memset(&result, 0, sizeof(result));
+}
+
+void Frame_Stats_Accumulator::begin(int frame_width, int frame_height, int frame_depth, double time) {
+  valid = false;
+  if (frame_height > capacity) {
+    parts.reset(new Frame_Stats_Partial[frame_height]);
+    used.reset(new bool[frame_height]);
+    capacity = frame_height;
+  }
+  memset(used.get(), 0, (size_t)frame_height);
+  copy_fn = avx2 && !force_scalar ? frame_stats_copy_rows_avx2 : frame_stats_copy_rows_scalar;
+  width = frame_width;
+  height = frame_height;
+  depth = frame_depth;
+  result.time = time;
+  result.width = (uint32_t)frame_width;
+  result.height = (uint32_t)frame_height;
+}
+
+Frame_Stats_Partial& Frame_Stats_Accumulator::part(int y) {
+  // Only the thread that copies the part starting at y touches these
+  used[y] = true;
+  parts[y].clear();
+  return parts[y];
+}
+
+const Frame_Stats* Frame_Stats_Accumulator::finish() {
+  Frame_Stats_Partial total;
+  total.clear();
+  for (int y = 0; y < height; ++y) {
+    if (used[y]) {
+      total.add(parts[y]);
+    }
+  }
+
+  // A channel of every pixel is one of finite, NaN or Inf
+  auto pixels = (uint64_t)total.finite_count[0] + total.nan_count[0] + total.inf_count[0];
+  if (pixels != (uint64_t)width * height) {
+    valid = false;
+    return nullptr;
+  }
+
+  total.finish(result);
+  result.sequence = 0;
+  valid = true;
+  return &result;
+}
+
+//
+// Frame_Stats_Map
+//
+
+bool Frame_Stats_Map::map(const char* sender_name, bool create) {
+  if (!sender_name || !*sender_name) {
+    return false;
+  }
+  if (layout && name == sender_name) {
+    return true;
+  }
+
+  close();
+  auto map_name = std::string(sender_name) + "_FrameStats";
+  if (create) {
+    if (memory.Create(map_name.c_str(), (int)sizeof(Frame_Stats_Map_Layout)) == SPOUT_CREATE_FAILED) {
+      return false;
+    }
+  }
+  else if (!memory.Open(map_name.c_str())) {
+    return false;
+  }
+
+  layout = (Frame_Stats_Map_Layout*)memory.Buffer();
+  name = sender_name;
+  if (create) {
+    layout->version = FRAME_STATS_VERSION;
+    layout->size = (uint32_t)sizeof(Frame_Stats);
+  }
+  return true;
+}
+
+void Frame_Stats_Map::close() {
+  if (layout) {
+    memory.Close();
+  }
+  layout = nullptr;
+  name.clear();
+}
+
+bool Frame_Stats_Map::write(const char* sender_name, const Frame_Stats& stats) {
+  if (!map(sender_name, true)) {
+    return false;
+  }
+
+  uint64_t words[FRAME_STATS_WORDS];
+  memcpy(words, &stats, sizeof(stats));
+
+  // One writer, an odd value is left by a sender that closed while writing
+  auto lock = layout->lock.load(std::memory_order_relaxed) & ~1ULL;
+  layout->lock.store(lock + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  for (size_t i = 0; i < FRAME_STATS_WORDS; ++i) {
+    layout->words[i].store(words[i], std::memory_order_relaxed);
+  }
+  layout->lock.store(lock + 2, std::memory_order_release);
+  return true;
+}
+
+bool Frame_Stats_Map::read(const char* sender_name, Frame_Stats& stats) {
+  if (!map(sender_name, false)) {
+    return false;
+  }
+  if (layout->version != FRAME_STATS_VERSION || layout->size != sizeof(Frame_Stats)) {
+    return false;
+  }
+
+  uint64_t words[FRAME_STATS_WORDS];
+  for (int retry = 0; retry < 64; ++retry) {
+    auto lock1 = layout->lock.load(std::memory_order_acquire);
+    if (lock1 == 0) {
+      return false;
+    }
+    if (lock1 & 1) {
+      std::this_thread::yield();
+      continue;
+    }
+    for (size_t i = 0; i < FRAME_STATS_WORDS; ++i) {
+      words[i] = layout->words[i].load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (layout->lock.load(std::memory_order_relaxed) == lock1) {
+      memcpy(&stats, words, sizeof(stats));
+      return true;
+    }
+  }
+  return false;
+}
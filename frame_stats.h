@@ -0,0 +1,164 @@
+/*
+Davinci Resolve Spout Sender
+Copyright (C) 2025 ValueFactory
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of
+the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+
+#include "SpoutSharedMemory.h"
+
+// Scopes for receivers. The stats are worked out inside the copy that already reads every row of the frame we
+// send, the same loads feed the copy's stores and the accumulators, so they cost the copy no extra read or write of
+// the frame. Which copy that is depends on the path: the shared texture sink's, the LUT's, the YUV conversion's or
+// the reduction's. Every part of the frame a copy thread takes gets its own partial result, Frame_Stats_Accumulator
+// adds them up after the copy and the plugin writes the total to "<sender>_FrameStats" with the sequence of the
+// frame it belongs to. Float and 8 bit RGBA, 8 bit values are scaled to 0-1 first.
+
+#define FRAME_STATS_VERSION 1
+#define FRAME_STATS_LUMA_BINS 64
+
+// Channel type of the RGBA pixels
+enum Frame_Stats_Depth {
+  FRAME_STATS_FLOAT = 0,
+  FRAME_STATS_BYTE,
+};
+
+// Fixed layout, 8 byte aligned. NaN and Inf values are counted and left out of everything else.
+struct Frame_Stats {
+  uint64_t sequence;    // SpoutFrameMetadata sequence of the frame
+  double time;          // Host timeline time
+  uint32_t width;
+  uint32_t height;
+  // Per channel, RGBA
+  float min[4];
+  float max[4];
+  float mean[4];
+  uint32_t nan_count[4];
+  uint32_t inf_count[4];
+  // Below 0 and above 1, infinities included
+  uint32_t under_count[4];
+  uint32_t over_count[4];
+  // Rec. 709 luma where it is finite, 0-1 in even bins. Below 0 goes in the first, 1 and above in the last.
+  uint32_t luma[FRAME_STATS_LUMA_BINS];
+};
+
+// Stats of part of a frame, summed in double so adding bands up doesn't lose the small ones
+struct Frame_Stats_Partial {
+  float min[4];
+  float max[4];
+  double sum[4];
+  uint32_t finite_count[4];
+  uint32_t nan_count[4];
+  uint32_t inf_count[4];
+  uint32_t under_count[4];
+  uint32_t over_count[4];
+  uint32_t luma[FRAME_STATS_LUMA_BINS];
+
+  void clear();
+  void add(const Frame_Stats_Partial& other);
+  // Fills everything in stats but sequence, time and the size
+  void finish(Frame_Stats& stats) const;
+};
+
+// Copies rows of RGBA pixels of a Frame_Stats_Depth from src to dst and adds them to partial in the same pass.
+// With a null dst the rows are only read, for a copy that writes something else from them right after. The AVX2
+// kernel gives the same counts, minimum, maximum and histogram as the scalar one, the sums differ in rounding.
+void frame_stats_copy_rows_scalar(const char* src, size_t src_pitch, char* dst, size_t dst_pitch, int width, int rows,
+  int depth, Frame_Stats_Partial& partial);
+void frame_stats_copy_rows_avx2(const char* src, size_t src_pitch, char* dst, size_t dst_pitch, int width, int rows,
+  int depth, Frame_Stats_Partial& partial);
+// True when the CPU and the OS run AVX2
+bool frame_stats_has_avx2();
+
+// The stats of one frame, for the copy that reads it. Each copy thread takes the part starting at the first row of
+// its band or window and copies its rows through it, parts never overlap so no two threads share one.
+class Frame_Stats_Accumulator {
+public:
+  Frame_Stats_Accumulator();
+
+  // Uses the scalar kernel, for tools/spout_frame_stats_bench.cpp
+  bool force_scalar = false;
+
+  // Starts a frame of RGBA pixels of a Frame_Stats_Depth. Keeps the parts of earlier frames so the render doesn't
+  // allocate once it has seen the largest frame.
+  void begin(int width, int height, int depth, double time);
+  // The part starting at row y, cleared
+  Frame_Stats_Partial& part(int y);
+  // frame_stats_copy_rows with the kernel the CPU runs and the depth of the frame
+  void copy_rows(const char* src, size_t src_pitch, char* dst, size_t dst_pitch, int width, int rows, Frame_Stats_Partial& part) const {
+    copy_fn(src, src_pitch, dst, dst_pitch, width, rows, depth, part);
+  }
+  // Adds the parts up once the copy is done. Null if they don't cover every pixel of the frame, when a copy
+  // stopped early.
+  const Frame_Stats* finish();
+
+  // The stats of the last frame finished, null from begin until finish. sequence is left 0.
+  const Frame_Stats* frame_stats() const { return valid ? &result : nullptr; }
+
+private:
+  void (*copy_fn)(const char*, size_t, char*, size_t, int, int, int, Frame_Stats_Partial&);
+  bool avx2 = false;
+  // One per row, only the first row of each part is used
+  std::unique_ptr<Frame_Stats_Partial[]> parts;
+  std::unique_ptr<bool[]> used;
+  int capacity = 0;
+  int width = 0;
+  int height = 0;
+  int depth = FRAME_STATS_FLOAT;
+  Frame_Stats result;
+  bool valid = false;
+};
+
+//
+// Frame stats shared memory "<sendername>_FrameStats"
+//
+// The same sequence lock as the frame metadata: odd while the sender writes, twice the number of writes when done.
+// The record carries the sequence of its frame, a receiver compares it with the frame metadata it read to know
+// whether the stats are for the frame it has.
+//
+#define FRAME_STATS_WORDS (sizeof(Frame_Stats)/sizeof(uint64_t))
+
+struct Frame_Stats_Map_Layout {
+  std::atomic<uint64_t> lock;
+  uint32_t version;
+  uint32_t size;
+  std::atomic<uint64_t> words[FRAME_STATS_WORDS];
+};
+
+class Frame_Stats_Map {
+public:
+  // Sender. Creates the map for sender_name the first time and again when the name changes.
+  bool write(const char* sender_name, const Frame_Stats& stats);
+  // Receiver. Opens the map of sender_name, or retries opening it, and reads the latest record without blocking.
+  // False if there is none yet or no consistent copy could be read within a few retries.
+  bool read(const char* sender_name, Frame_Stats& stats);
+  void close();
+
+private:
+  bool map(const char* sender_name, bool create);
+
+  SpoutSharedMemory memory;
+  Frame_Stats_Map_Layout* layout = nullptr;
+  std::string name;
+};
@@ -0,0 +1,338 @@
+/*
+Davinci Resolve Spout Sender
+Copyright (C) 2025 ValueFactory
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of
+the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+#include "genlock.h"
+
+#include <string.h>
+
+#include <chrono>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t), "Shared memory atomics must be lock free");
+
+static uint64_t time_bits(double time) {
+  uint64_t bits;
+  memcpy(&bits, &time, sizeof(bits));
+  return bits;
+}
+
+// Tells the instances of every process apart
+static uint64_t next_member_id() {
+  static std::atomic<uint32_t> instances{ 0 };
+#ifdef _WIN32
+  uint64_t pid = GetCurrentProcessId();
+#else
+  uint64_t pid = (uint64_t)getpid();
+#endif
+  return pid << 32 | (instances.fetch_add(1, std::memory_order_relaxed) + 1);
+}
+
+Genlock_Group::Genlock_Group() {
+  id = next_member_id();
+}
+
+Genlock_Group::~Genlock_Group() {
+  leave();
+}
+
+bool Genlock_Group::map(const std::string& group, bool create) {
+  auto map_name = group + "_Genlock";
+  auto result = SPOUT_CREATE_FAILED;
+  if (create) {
+    result = memory.Create(map_name.c_str(), (int)sizeof(Genlock_Layout));
+    if (result == SPOUT_CREATE_FAILED) {
+      return false;
+    }
+  }
+  else if (!memory.Open(map_name.c_str())) {
+    return false;
+  }
+
+  auto* mapped = (Genlock_Layout*)memory.Buffer();
+  // The creator sets the version under the map mutex, a member that opens the map first sets it for it
+  if (create && memory.Lock()) {
+    if (mapped->version == 0) {
+      mapped->version = GENLOCK_VERSION;
+      mapped->count = GENLOCK_MAX_MEMBERS;
+    }
+    memory.Unlock();
+  }
+  if (mapped->version != GENLOCK_VERSION || mapped->count != GENLOCK_MAX_MEMBERS) {
+    memory.Close();
+    return false;
+  }
+
+  layout = mapped;
+  name = group;
+  return true;
+}
+
+bool Genlock_Group::join(const std::string& group) {
+  if (group.empty()) {
+    leave();
+    failed.clear();
+    return false;
+  }
+  if (layout && member && group == name) {
+    return true;
+  }
+  // The plugin joins every frame, a group we couldn't join isn't tried again until the name changes
+  if (group == failed) {
+    return false;
+  }
+
+  leave();
+  // Fails while another member is creating the map, which only takes a moment
+  auto mapped = false;
+  for (int attempt = 0; attempt < 16 && !mapped; ++attempt) {
+    mapped = map(group, true);
+    if (!mapped) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+  if (!mapped) {
+    SpoutLogError("Genlock_Group : could not join %s", group.c_str());
+    failed = group;
+    return false;
+  }
+  failed.clear();
+  member = true;
+  // Take a slot now, so the others wait for our first frame
+  slot = claim(spoutHistogram::Now());
+  return true;
+}
+
+void Genlock_Group::leave() {
+  if (layout && member && slot >= 0) {
+    auto& own = layout->slots[slot];
+    auto expected = id;
+    own.waiting.store(0, std::memory_order_relaxed);
+    own.owner.compare_exchange_strong(expected, 0);
+  }
+  if (layout) {
+    memory.Close();
+  }
+  layout = nullptr;
+  name.clear();
+  member = false;
+  slot = -1;
+}
+
+bool Genlock_Group::open(const std::string& group) {
+  if (layout && group == name) {
+    return true;
+  }
+  leave();
+  name = group;
+  return map(group, false);
+}
+
+// Our slot, or a free one, or one left by an instance that went away. Returns -1 if the group is full.
+int Genlock_Group::claim(int64_t now) {
+  if (!memory.Lock()) {
+    return -1;
+  }
+
+  auto found = -1;
+  for (int i = 0; i < GENLOCK_MAX_MEMBERS && found < 0; ++i) {
+    auto owner = layout->slots[i].owner.load(std::memory_order_relaxed);
+    if (owner == id) {
+      found = i;
+    }
+  }
+  for (int i = 0; i < GENLOCK_MAX_MEMBERS && found < 0; ++i) {
+    auto& s = layout->slots[i];
+    auto owner = s.owner.load(std::memory_order_relaxed);
+    if (owner == 0 || now - s.staged_ns.load(std::memory_order_relaxed) > GENLOCK_SLOT_TIMEOUT_NS) {
+      s.waiting.store(0, std::memory_order_relaxed);
+      s.staged_ns.store(now, std::memory_order_relaxed);
+      s.owner.store(id, std::memory_order_relaxed);
+      found = i;
+    }
+  }
+
+  memory.Unlock();
+  if (found < 0) {
+    SpoutLogWarning("Genlock_Group : %s has %d members, publishing on our own", name.c_str(), GENLOCK_MAX_MEMBERS);
+  }
+  return found;
+}
+
+// Every member that is rendering is waiting on time
+bool Genlock_Group::complete(uint64_t bits, int64_t now) const {
+  for (int i = 0; i < GENLOCK_MAX_MEMBERS; ++i) {
+    auto& s = layout->slots[i];
+    if (s.owner.load(std::memory_order_relaxed) == 0 || now - s.staged_ns.load(std::memory_order_relaxed) >= GENLOCK_ACTIVE_NS) {
+      continue;
+    }
+    if (!s.waiting.load(std::memory_order_acquire) || s.time.load(std::memory_order_relaxed) != bits) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Starts the next generation for time, unless another member already did since we staged
+uint64_t Genlock_Group::release(uint64_t base, uint64_t bits, int64_t now, bool timed_out) {
+  if (!memory.Lock()) {
+    return 0;
+  }
+
+  auto generation = layout->generation.load(std::memory_order_relaxed);
+  if (generation == base || layout->time.load(std::memory_order_relaxed) != bits) {
+    layout->time.store(bits, std::memory_order_relaxed);
+    layout->released_ns.store(now, std::memory_order_relaxed);
+    if (timed_out) {
+      layout->timeouts.fetch_add(1, std::memory_order_relaxed);
+    }
+    ++generation;
+    auto& recent = layout->recent[generation % GENLOCK_HISTORY];
+    recent.time = bits;
+    recent.generation = generation;
+    layout->generation.store(generation, std::memory_order_release);
+  }
+
+  memory.Unlock();
+  return generation;
+}
+
+// The latest generation the group published time with, 0 if it isn't a recent one
+uint64_t Genlock_Group::published(uint64_t bits) {
+  if (!memory.Lock()) {
+    return 0;
+  }
+
+  uint64_t found = 0;
+  for (int i = 0; i < GENLOCK_HISTORY; ++i) {
+    auto& recent = layout->recent[i];
+    if (recent.generation != 0 && recent.time == bits && recent.generation > found) {
+      found = recent.generation;
+    }
+  }
+
+  memory.Unlock();
+  return found;
+}
+
+uint64_t Genlock_Group::stage(double time) {
+  if (!joined()) {
+    return 0;
+  }
+
+  auto start = spoutHistogram::Now();
+  if (slot < 0 || layout->slots[slot].owner.load(std::memory_order_relaxed) != id) {
+    slot = claim(start);
+    if (slot < 0) {
+      return 0;
+    }
+  }
+
+  auto bits = time_bits(time);
+  auto& own = layout->slots[slot];
+  auto base = layout->generation.load(std::memory_order_acquire);
+  // We're late, the group already published this time. Go out at once with its generation.
+  auto late = published(bits);
+  if (late != 0) {
+    own.staged_ns.store(start, std::memory_order_relaxed);
+    wait_times.RecordSince(start);
+    return late;
+  }
+  own.time.store(bits, std::memory_order_relaxed);
+  own.staged_ns.store(start, std::memory_order_relaxed);
+  own.waiting.store(1, std::memory_order_release);
+
+  uint64_t generation = 0;
+  auto deadline = start + timeout_ns;
+  for (int spin = 0;; ++spin) {
+    // Released by the member that saw the group complete
+    auto current = layout->generation.load(std::memory_order_acquire);
+    if (current != base && layout->time.load(std::memory_order_relaxed) == bits) {
+      generation = current;
+      break;
+    }
+
+    auto now = spoutHistogram::Now();
+    // The map mutex can time out, then we keep waiting and try again
+    if (complete(bits, now)) {
+      generation = release(base, bits, now, false);
+      if (generation != 0) {
+        break;
+      }
+    }
+    // What has been staged goes out, members still rendering this time publish late on their own
+    if (now >= deadline) {
+      generation = release(base, bits, now, true);
+      break;
+    }
+
+    // Members render on other threads, so give them the core before we start sleeping
+    if (spin < 64) {
+      std::this_thread::yield();
+    }
+    else {
+      std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+  }
+
+  own.waiting.store(0, std::memory_order_release);
+  wait_times.RecordSince(start);
+  return generation;
+}
+
+bool Genlock_Group::read(Genlock_State& state) {
+  if (!layout) {
+    // Try again for a group that has no members yet
+    if (name.empty() || !map(name, false)) {
+      return false;
+    }
+  }
+
+  // The generation is stored after its time, so a generation that didn't change means the time is its own
+  for (int retry = 0; retry < 64; ++retry) {
+    auto generation = layout->generation.load(std::memory_order_acquire);
+    auto bits = layout->time.load(std::memory_order_relaxed);
+    auto released_ns = layout->released_ns.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (layout->generation.load(std::memory_order_relaxed) != generation) {
+      continue;
+    }
+
+    state.generation = generation;
+    memcpy(&state.time, &bits, sizeof(state.time));
+    state.released_ns = released_ns;
+    state.timeouts = layout->timeouts.load(std::memory_order_relaxed);
+
+    auto now = spoutHistogram::Now();
+    state.members = 0;
+    for (int i = 0; i < GENLOCK_MAX_MEMBERS; ++i) {
+      auto& s = layout->slots[i];
+      if (s.owner.load(std::memory_order_relaxed) != 0 && now - s.staged_ns.load(std::memory_order_relaxed) < GENLOCK_ACTIVE_NS) {
+        ++state.members;
+      }
+    }
+    return true;
+  }
+  return false;
+}
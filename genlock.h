@@ -0,0 +1,124 @@
+/*
+Davinci Resolve Spout Sender
+Copyright (C) 2025 ValueFactory
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of
+the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#include <atomic>
+#include <string>
+
+#include "SpoutHistogram.h"
+#include "SpoutSharedMemory.h"
+
+// Instances with the same Genlock Group publish together. Each one stages its frame, then waits until
+// every member that is rendering has staged a frame of the same timeline time, or for the timeout. The first to see
+// the group complete bumps the group generation and every member waiting on that time publishes with it, so a
+// receiver that flips its outputs when the generation changes shows the screens on the same frame.
+// The group is shared memory "<group>_Genlock", so members can be in different processes. It doesn't need D3D11 or
+// OFX, tools/spout_genlock_test.cpp runs it on Linux.
+
+#define GENLOCK_VERSION 1
+#define GENLOCK_MAX_MEMBERS 16
+// Generations remembered, so a member that fell behind catches up without waiting
+#define GENLOCK_HISTORY 16
+// Members that haven't staged a frame for this long aren't waited for
+#define GENLOCK_ACTIVE_NS 1000000000LL
+// A slot not staged for this long was left by an instance that went away without leaving, it can be taken
+#define GENLOCK_SLOT_TIMEOUT_NS 10000000000LL
+
+struct Genlock_Slot {
+  std::atomic<uint64_t> owner;      // Process id in the high word and instance number in the low, 0 if free
+  std::atomic<uint64_t> time;       // Bits of the timeline time staged
+  std::atomic<int64_t> staged_ns;   // Steady clock nanoseconds of the last stage
+  std::atomic<uint32_t> waiting;    // 1 from staging until the member is released
+  uint32_t reserved;
+};
+
+// Written under the map mutex
+struct Genlock_Release {
+  uint64_t time;
+  uint64_t generation;
+};
+
+struct Genlock_Layout {
+  uint32_t version;
+  uint32_t count;
+  std::atomic<uint64_t> generation;   // Bumped each time the group publishes, 0 before the first
+  std::atomic<uint64_t> time;         // Bits of the timeline time of the generation, written before it
+  std::atomic<int64_t> released_ns;   // Steady clock nanoseconds the generation was released
+  std::atomic<uint64_t> timeouts;     // Generations released by a timeout rather than the whole group
+  Genlock_Slot slots[GENLOCK_MAX_MEMBERS];
+  Genlock_Release recent[GENLOCK_HISTORY];   // Generation g at g % GENLOCK_HISTORY
+};
+
+// What a receiver or the stats overlay sees
+struct Genlock_State {
+  uint64_t generation = 0;
+  double time = 0.0;
+  int64_t released_ns = 0;
+  uint64_t timeouts = 0;
+  // Members that staged a frame within GENLOCK_ACTIVE_NS
+  int members = 0;
+};
+
+class Genlock_Group {
+public:
+  Genlock_Group();
+  ~Genlock_Group();
+  Genlock_Group(const Genlock_Group&) = delete;
+  Genlock_Group& operator=(const Genlock_Group&) = delete;
+
+  // Set before each frame
+  int64_t timeout_ns = 100000000;
+
+  // Sender. Joins the group, or moves to another one. An empty name leaves. Returns true if we are in a group.
+  bool join(const std::string& group);
+  void leave();
+  bool joined() const { return layout != nullptr && member; }
+  const std::string& group() const { return name; }
+
+  // Sender. Stages a frame of time and waits until every active member has staged the same time or timeout_ns
+  // passed, then returns the generation to publish with. A time among the last GENLOCK_HISTORY the group published
+  // goes out at once with its generation, as for a member that fell behind or a render of a paused frame. Returns 0 if we're not in a group or
+  // it is full.
+  uint64_t stage(double time);
+
+  // Receiver. Opens the group without joining it. Reading retries the open for a group that doesn't exist yet.
+  bool open(const std::string& group);
+  bool read(Genlock_State& state);
+
+  // Time stage waited, in nanoseconds
+  spoutHistogram wait_times;
+
+private:
+  bool map(const std::string& group, bool create);
+  int claim(int64_t now);
+  uint64_t published(uint64_t time_bits);
+  bool complete(uint64_t time_bits, int64_t now) const;
+  uint64_t release(uint64_t base, uint64_t time_bits, int64_t now, bool timed_out);
+
+  SpoutSharedMemory memory;
+  Genlock_Layout* layout = nullptr;
+  std::string name;
+  std::string failed;
+  bool member = false;
+  uint64_t id;
+  int slot = -1;
+};
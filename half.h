@@ -0,0 +1,57 @@
+/*
+Davinci Resolve Spout Sender
+Copyright (C) 2025 ValueFactory
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of
+the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+// Round to nearest even, overflow goes to infinity and NaN stays NaN.
+inline uint16_t float_to_half(float value) {
+  const uint32_t infinity = 255u << 23;
+  const uint32_t half_max = (127u + 16u) << 23;
+  const uint32_t denorm_magic = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+
+  uint32_t f;
+  memcpy(&f, &value, 4);
+  uint32_t sign = f & 0x80000000u;
+  f ^= sign;
+
+  uint16_t out;
+  if (f >= half_max) {
+    out = f > infinity ? 0x7e00 : 0x7c00;
+  }
+  else if (f < (113u << 23)) {
+    // Denormal half, let the float adder do the rounding
+    float v, magic;
+    memcpy(&v, &f, 4);
+    memcpy(&magic, &denorm_magic, 4);
+    v += magic;
+    memcpy(&f, &v, 4);
+    out = (uint16_t)(f - denorm_magic);
+  }
+  else {
+    uint32_t mantissa_odd = (f >> 13) & 1;
+    f += ((uint32_t)(15 - 127) << 23) + 0xfff;
+    f += mantissa_odd;
+    out = (uint16_t)(f >> 13);
+  }
+
+  return out | (uint16_t)(sign >> 16);
+}
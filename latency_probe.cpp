@@ -0,0 +1,311 @@
+/*
+Davinci Resolve Spout Sender
+Copyright (C) 2025 ValueFactory
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of
+the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+#include "latency_probe.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <thread>
+
+static_assert(sizeof(SpoutFrameMetadata) % sizeof(uint64_t) == 0, "SpoutFrameMetadata must be 8 byte aligned");
+
+//
+// Frame_Metadata_Map
+//
+
+bool Frame_Metadata_Map::map(const char* sender_name, bool create) {
+  if (!sender_name || !*sender_name) {
+    return false;
+  }
+  if (layout && name == sender_name) {
+    return true;
+  }
+
+  close();
+  auto map_name = std::string(sender_name) + "_FrameMetadata";
+  if (create) {
+    if (memory.Create(map_name.c_str(), (int)sizeof(SpoutFrameMetadataMap)) == SPOUT_CREATE_FAILED) {
+      return false;
+    }
+  }
+  else if (!memory.Open(map_name.c_str())) {
+    return false;
+  }
+
+  layout = (SpoutFrameMetadataMap*)memory.Buffer();
+  name = sender_name;
+  if (create) {
+    layout->version = SPOUT_FRAME_METADATA_VERSION;
+    layout->size = (uint32_t)sizeof(SpoutFrameMetadata);
+  }
+  return true;
+}
+
+void Frame_Metadata_Map::close() {
+  if (layout) {
+    memory.Close();
+  }
+  layout = nullptr;
+  name.clear();
+}
+
+bool Frame_Metadata_Map::write(const char* sender_name, SpoutFrameMetadata& metadata) {
+  if (!map(sender_name, true)) {
+    return false;
+  }
+
+  // One writer, an odd value is left by a sender that closed while writing
+  auto lock = layout->lock.load(std::memory_order_relaxed) & ~1ULL;
+  metadata.sequence = lock / 2 + 1;
+  metadata.timestamp = spoutHistogram::Now();
+
+  uint64_t words[SPOUT_FRAME_METADATA_WORDS];
+  memcpy(words, &metadata, sizeof(metadata));
+
+  layout->lock.store(lock + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  for (size_t i = 0; i < SPOUT_FRAME_METADATA_WORDS; ++i) {
+    layout->words[i].store(words[i], std::memory_order_relaxed);
+  }
+  layout->lock.store(lock + 2, std::memory_order_release);
+  return true;
+}
+
+bool Frame_Metadata_Map::read(const char* sender_name, SpoutFrameMetadata& metadata) {
+  if (!map(sender_name, false)) {
+    return false;
+  }
+  if (layout->version != SPOUT_FRAME_METADATA_VERSION || layout->size != sizeof(SpoutFrameMetadata)) {
+    return false;
+  }
+
+  uint64_t words[SPOUT_FRAME_METADATA_WORDS];
+  for (int retry = 0; retry < 64; ++retry) {
+    auto lock1 = layout->lock.load(std::memory_order_acquire);
+    if (lock1 == 0) {
+      return false;
+    }
+    if (lock1 & 1) {
+      std::this_thread::yield();
+      continue;
+    }
+    for (size_t i = 0; i < SPOUT_FRAME_METADATA_WORDS; ++i) {
+      words[i] = layout->words[i].load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (layout->lock.load(std::memory_order_relaxed) == lock1) {
+      memcpy(&metadata, words, sizeof(metadata));
+      return true;
+    }
+  }
+  return false;
+}
+
+//
+// Latency_Probe
+//
+
+Latency_Probe_Sender* Latency_Probe::find(const char* sender_name) {
+  for (auto& sender : list) {
+    if (sender->name == sender_name) {
+      return sender.get();
+    }
+  }
+  return nullptr;
+}
+
+Latency_Probe_Sender* Latency_Probe::add(const char* sender_name) {
+  auto* sender = find(sender_name);
+  if (!sender) {
+    list.emplace_back(new Latency_Probe_Sender);
+    sender = list.back().get();
+    sender->name = sender_name;
+  }
+  return sender;
+}
+
+void Latency_Probe::watch(const char* sender_name) {
+  if (sender_name && *sender_name) {
+    add(sender_name);
+  }
+}
+
+void Latency_Probe::consumed(const char* sender_name, const SpoutFrameMetadata& metadata, int64_t now_ns) {
+  if (!sender_name || !*sender_name || metadata.sequence == 0) {
+    return;
+  }
+
+  auto* sender = add(sender_name);
+  if (metadata.sequence == sender->last_sequence) {
+    return;
+  }
+
+  // A sender that started again counts from its new first frame
+  if (metadata.sequence < sender->last_sequence) {
+    ++sender->restarts;
+    sender->last_sequence = 0;
+    sender->last_consumed_ns = 0;
+  }
+
+  auto latency = now_ns - metadata.timestamp;
+  sender->latency.Record(latency > 0 ? (uint64_t)latency : 0);
+  if (sender->last_sequence != 0) {
+    auto step = metadata.sequence - sender->last_sequence;
+    sender->gaps.Record(step);
+    sender->dropped += step - 1;
+    sender->intervals.Record(now_ns > sender->last_consumed_ns ? (uint64_t)(now_ns - sender->last_consumed_ns) : 0);
+  }
+  ++sender->frames;
+  sender->last_sequence = metadata.sequence;
+  sender->last_consumed_ns = now_ns;
+}
+
+int Latency_Probe::poll() {
+  auto count = 0;
+  for (auto& sender : list) {
+    SpoutFrameMetadata metadata;
+    auto read = sender->metadata_map.read(sender->name.c_str(), metadata);
+    // Stamped after the read, so the latency includes the read as a receiver's would include its copy
+    auto now = spoutHistogram::Now();
+
+    if (read && metadata.sequence != sender->last_sequence) {
+      consumed(sender->name.c_str(), metadata, now);
+      sender->last_new_ns = now;
+      ++count;
+    }
+    else if (sender->last_new_ns == 0) {
+      sender->last_new_ns = now;
+    }
+    else if (now - sender->last_new_ns > LATENCY_PROBE_REOPEN_NS) {
+      sender->metadata_map.close();
+      sender->last_new_ns = now;
+    }
+  }
+  return count;
+}
+
+//
+// Export
+//
+
+static void write_json_string(FILE* file, const std::string& value) {
+  fputc('"', file);
+  for (auto c : value) {
+    if (c == '"' || c == '\\') {
+      fprintf(file, "\\%c", c);
+    }
+    else if ((unsigned char)c < 0x20) {
+      fprintf(file, "\\u%04x", (unsigned)c);
+    }
+    else {
+      fputc(c, file);
+    }
+  }
+  fputc('"', file);
+}
+
+static void write_json_histogram(FILE* file, const char* key, const spoutHistogram& histogram, bool last) {
+  spoutHistogramSnapshot snapshot;
+  histogram.Snapshot(snapshot);
+
+  fprintf(file, "      \"%s\": {\"count\": %llu, \"min\": %llu, \"mean\": %.1f, \"p50\": %llu, \"p90\": %llu, "
+                "\"p99\": %llu, \"p999\": %llu, \"max\": %llu, \"buckets\": [",
+          key, (unsigned long long)snapshot.count, (unsigned long long)(snapshot.count ? snapshot.min : 0),
+          snapshot.Mean(), (unsigned long long)snapshot.Percentile(50.0), (unsigned long long)snapshot.Percentile(90.0),
+          (unsigned long long)snapshot.Percentile(99.0), (unsigned long long)snapshot.Percentile(99.9),
+          (unsigned long long)snapshot.max);
+
+  // [value, count] for the buckets holding anything
+  auto first = true;
+  for (int i = 0; i < SPOUT_HISTOGRAM_BUCKETS; ++i) {
+    if (snapshot.buckets[i]) {
+      fprintf(file, "%s[%llu, %llu]", first ? "" : ", ", (unsigned long long)spoutHistogram::BucketValue(i),
+              (unsigned long long)snapshot.buckets[i]);
+      first = false;
+    }
+  }
+  fprintf(file, "]}%s\n", last ? "" : ",");
+}
+
+bool Latency_Probe::write_json(const char* path) const {
+  auto* file = fopen(path, "w");
+  if (!file) {
+    return false;
+  }
+
+  fprintf(file, "{\n  \"version\": %d,\n  \"duration_ns\": %lld,\n  \"senders\": [\n", LATENCY_PROBE_VERSION,
+          (long long)(spoutHistogram::Now() - started_ns));
+  for (size_t i = 0; i < list.size(); ++i) {
+    auto& sender = *list[i];
+    fprintf(file, "    {\n      \"name\": ");
+    write_json_string(file, sender.name);
+    fprintf(file, ",\n      \"frames\": %llu,\n      \"dropped\": %llu,\n      \"restarts\": %llu,\n",
+            (unsigned long long)sender.frames, (unsigned long long)sender.dropped,
+            (unsigned long long)sender.restarts);
+    write_json_histogram(file, "latency_ns", sender.latency, false);
+    write_json_histogram(file, "gap_frames", sender.gaps, false);
+    write_json_histogram(file, "interval_ns", sender.intervals, true);
+    fprintf(file, "    }%s\n", i + 1 < list.size() ? "," : "");
+  }
+  fprintf(file, "  ]\n}\n");
+
+  auto ok = !ferror(file);
+  return fclose(file) == 0 && ok;
+}
+
+static void write_csv_histogram(FILE* file, const std::string& sender, const char* key, const spoutHistogram& histogram) {
+  spoutHistogramSnapshot snapshot;
+  histogram.Snapshot(snapshot);
+  for (int i = 0; i < SPOUT_HISTOGRAM_BUCKETS; ++i) {
+    if (snapshot.buckets[i]) {
+      fprintf(file, "%s,%s,%llu,%llu\n", sender.c_str(), key, (unsigned long long)spoutHistogram::BucketValue(i),
+              (unsigned long long)snapshot.buckets[i]);
+    }
+  }
+}
+
+bool Latency_Probe::write_csv(const char* path) const {
+  auto* file = fopen(path, "w");
+  if (!file) {
+    return false;
+  }
+
+  fprintf(file, "sender,histogram,value,count\n");
+  for (auto& sender : list) {
+    // Quoted when the name holds a separator, with quotes doubled
+    std::string name = sender->name;
+    if (name.find_first_of(",\"\n") != std::string::npos) {
+      std::string quoted = "\"";
+      for (auto c : name) {
+        quoted += c;
+        if (c == '"') {
+          quoted += c;
+        }
+      }
+      name = quoted + "\"";
+    }
+    write_csv_histogram(file, name, "latency_ns", sender->latency);
+    write_csv_histogram(file, name, "gap_frames", sender->gaps);
+    write_csv_histogram(file, name, "interval_ns", sender->intervals);
+  }
+
+  auto ok = !ferror(file);
+  return fclose(file) == 0 && ok;
+}
@@ -0,0 +1,112 @@
+/*
+Davinci Resolve Spout Sender
+Copyright (C) 2025 ValueFactory
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of
+the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "SpoutFrameMetadata.h"
+#include "SpoutHistogram.h"
+#include "SpoutSharedMemory.h"
+
+// How long a frame takes from publish to a receiver. WriteFrameMetadata stamps every frame the plugin
+// publishes with its sequence and the steady clock time, the same clock on every process. A receiver hands the
+// metadata it read with a frame to Latency_Probe when it has the frame, and the probe keeps, per sender, the time
+// from publish to then, how many frames were skipped between the ones it got and the time between them.
+// Without a receiver, poll reads "<sender>_FrameMetadata" itself and takes each new frame as consumed when it
+// sees it. tools/spout_latency_probe.cpp runs it and writes JSON or CSV.
+
+#define LATENCY_PROBE_VERSION 1
+// A sender with no new frame for this long is opened again, on POSIX a sender that restarted has a new map
+#define LATENCY_PROBE_REOPEN_NS 1000000000LL
+
+//
+// Frame metadata shared memory "<sendername>_FrameMetadata" without spoutFrameCount, which needs D3D11.
+// The same sequence lock as WriteFrameMetadata and ReadFrameMetadata.
+//
+class Frame_Metadata_Map {
+public:
+  // Sender. Creates the map for sender_name the first time and again when the name changes. Sets the sequence and
+  // timestamp of metadata as WriteFrameMetadata does. For senders on Linux, the plugin uses spoutFrameCount.
+  bool write(const char* sender_name, SpoutFrameMetadata& metadata);
+  // Receiver. Opens the map of sender_name, or retries opening it, and reads the latest frame without blocking.
+  // False if there is none yet or no consistent copy could be read within a few retries.
+  bool read(const char* sender_name, SpoutFrameMetadata& metadata);
+  void close();
+
+private:
+  bool map(const char* sender_name, bool create);
+
+  SpoutSharedMemory memory;
+  SpoutFrameMetadataMap* layout = nullptr;
+  std::string name;
+};
+
+struct Latency_Probe_Sender {
+  std::string name;
+
+  // Nanoseconds from the publish timestamp to consumed
+  spoutHistogram latency;
+  // Sequence step between consecutive frames consumed, 1 when none was skipped
+  spoutHistogram gaps;
+  // Nanoseconds between consecutive frames consumed
+  spoutHistogram intervals;
+
+  uint64_t frames = 0;
+  // Frames published between the ones consumed
+  uint64_t dropped = 0;
+  // Times the sequence went back, a sender that started again
+  uint64_t restarts = 0;
+  uint64_t last_sequence = 0;
+  int64_t last_consumed_ns = 0;
+
+  // For poll
+  Frame_Metadata_Map metadata_map;
+  int64_t last_new_ns = 0;
+};
+
+class Latency_Probe {
+public:
+  // Adds a sender for poll. Receivers that call consumed don't need to.
+  void watch(const char* sender_name);
+
+  // Receiver. Records a frame of sender_name with the metadata read with it, consumed at now_ns.
+  // The same frame again is ignored.
+  void consumed(const char* sender_name, const SpoutFrameMetadata& metadata, int64_t now_ns);
+  // Reads the metadata of every watched sender and records the frames that are new. Returns how many there were.
+  int poll();
+
+  const std::vector<std::unique_ptr<Latency_Probe_Sender>>& senders() const { return list; }
+  Latency_Probe_Sender* find(const char* sender_name);
+
+  // Summaries and the buckets of every histogram, nanoseconds for the times. False if the file can't be written.
+  bool write_json(const char* path) const;
+  // One row a bucket: sender,histogram,value,count
+  bool write_csv(const char* path) const;
+
+private:
+  Latency_Probe_Sender* add(const char* sender_name);
+
+  std::vector<std::unique_ptr<Latency_Probe_Sender>> list;
+  int64_t started_ns = spoutHistogram::Now();
+};
@@ -0,0 +1,283 @@
+/*
+Davinci Resolve Spout Sender
+Copyright (C) 2025 ValueFactory
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of
+the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+#include "lut.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <fstream>
+#include <mutex>
+#include <unordered_map>
+
+#include <emmintrin.h>
+
+std::shared_ptr<const Lut_3d> lut_parse_cube(const std::string& path, std::string& error) {
+  std::ifstream file(path);
+  if (!file) {
+    error = "Can't open LUT file " + path;
+    return nullptr;
+  }
+
+  auto lut = std::make_shared<Lut_3d>();
+  lut->size = 0;
+  for (int i = 0; i < 3; ++i) {
+    lut->domain_min[i] = 0.0f;
+    lut->domain_max[i] = 1.0f;
+  }
+
+  size_t entries = 0;
+  size_t expected = 0;
+  int line_number = 0;
+
+  std::string line;
+  while (std::getline(file, line)) {
+    ++line_number;
+
+    auto* p = line.c_str();
+    while (*p == ' ' || *p == '\t') ++p;
+    if (*p == 0 || *p == '#' || *p == '\r') continue;
+
+    // Data lines start with a number, everything else is a keyword.
+    if ((*p >= '0' && *p <= '9') || *p == '-' || *p == '+' || *p == '.') {
+      if (lut->size == 0) {
+        error = "LUT data before LUT_3D_SIZE on line " + std::to_string(line_number);
+        return nullptr;
+      }
+      if (entries >= expected) {
+        error = "Too many LUT entries on line " + std::to_string(line_number);
+        return nullptr;
+      }
+
+      float rgb[3];
+      char* end = (char*)p;
+      for (int i = 0; i < 3; ++i) {
+        auto* start = end;
+        rgb[i] = strtof(start, &end);
+        if (end == start) {
+          error = "Bad LUT entry on line " + std::to_string(line_number);
+          return nullptr;
+        }
+      }
+
+      auto* entry = &lut->table[entries * 4];
+      entry[0] = rgb[0];
+      entry[1] = rgb[1];
+      entry[2] = rgb[2];
+      entry[3] = 1.0f;
+      ++entries;
+      continue;
+    }
+
+    if (strncmp(p, "TITLE", 5) == 0) {
+      continue;
+    }
+    else if (strncmp(p, "LUT_3D_SIZE", 11) == 0) {
+      auto size = atoi(p + 11);
+      if (size < 2 || size > 256) {
+        error = "Unsupported LUT_3D_SIZE on line " + std::to_string(line_number);
+        return nullptr;
+      }
+      lut->size = size;
+      expected = (size_t)size * size * size;
+      lut->table.assign(expected * 4, 0.0f);
+    }
+    else if (strncmp(p, "LUT_1D_SIZE", 11) == 0) {
+      error = "1D LUTs are not supported, use a 3D .cube LUT";
+      return nullptr;
+    }
+    else if (strncmp(p, "DOMAIN_MIN", 10) == 0 || strncmp(p, "DOMAIN_MAX", 10) == 0) {
+      auto* dst = p[8] == 'I' ? lut->domain_min : lut->domain_max;
+      char* end = (char*)p + 10;
+      for (int i = 0; i < 3; ++i) {
+        dst[i] = strtof(end, &end);
+      }
+    }
+    else if (strncmp(p, "LUT_3D_INPUT_RANGE", 18) == 0) {
+      // Resolve writes this instead of DOMAIN_MIN/MAX
+      char* end = (char*)p + 18;
+      auto lo = strtof(end, &end);
+      auto hi = strtof(end, &end);
+      for (int i = 0; i < 3; ++i) {
+        lut->domain_min[i] = lo;
+        lut->domain_max[i] = hi;
+      }
+    }
+    // Unknown keywords are skipped like other .cube readers do
+  }
+
+  if (lut->size == 0 || entries != expected) {
+    error = "LUT file " + path + " has " + std::to_string(entries) + " entries, expected " + std::to_string(expected);
+    return nullptr;
+  }
+
+  for (int i = 0; i < 3; ++i) {
+    if (!(lut->domain_max[i] > lut->domain_min[i])) {
+      error = "LUT file " + path + " has an empty domain";
+      return nullptr;
+    }
+  }
+
+  error.clear();
+  return lut;
+}
+
+struct Lut_Cache_Entry {
+  long long mtime;
+  long long size;
+  std::shared_ptr<const Lut_3d> lut;
+  std::string error;
+};
+
+static std::mutex lut_cache_mutex;
+static std::unordered_map<std::string, Lut_Cache_Entry> lut_cache;
+
+static bool lut_file_stat(const std::string& path, long long& mtime, long long& size) {
+#if defined(_WIN32)
+  struct _stat64 st;
+  if (_stat64(path.c_str(), &st) != 0) return false;
+#else
+  struct stat st;
+  if (stat(path.c_str(), &st) != 0) return false;
+#endif
+  mtime = (long long)st.st_mtime;
+  size = (long long)st.st_size;
+  return true;
+}
+
+std::shared_ptr<const Lut_3d> lut_cache_get(const std::string& path, std::string& error) {
+  long long mtime = 0;
+  long long size = 0;
+  if (!lut_file_stat(path, mtime, size)) {
+    error = "Can't find LUT file " + path;
+    return nullptr;
+  }
+
+  std::lock_guard<std::mutex> lock(lut_cache_mutex);
+
+  auto it = lut_cache.find(path);
+  if (it != lut_cache.end() && it->second.mtime == mtime && it->second.size == size) {
+    error = it->second.error;
+    return it->second.lut;
+  }
+
+  Lut_Cache_Entry entry;
+  entry.mtime = mtime;
+  entry.size = size;
+  entry.lut = lut_parse_cube(path, entry.error);
+  error = entry.error;
+
+  auto lut = entry.lut;
+  lut_cache[path] = std::move(entry);
+  return lut;
+}
+
+// Tetrahedral interpolation with the 4 channels of a LUT entry in one SSE register.
+// The cube cell is split into 6 tetrahedra by ordering the fractional parts, and we walk from
+// c000 to c111 along the edges of the one the sample falls into.
+void lut_apply_rgba(const Lut_3d& lut, const float* src, float* dst, int count) {
+  const int n = lut.size;
+  const float* table = lut.table.data();
+
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 top = _mm_set1_ps((float)(n - 1));
+  const __m128 domain_min = _mm_setr_ps(lut.domain_min[0], lut.domain_min[1], lut.domain_min[2], 0.0f);
+  const __m128 scale = _mm_setr_ps(
+    (float)(n - 1) / (lut.domain_max[0] - lut.domain_min[0]),
+    (float)(n - 1) / (lut.domain_max[1] - lut.domain_min[1]),
+    (float)(n - 1) / (lut.domain_max[2] - lut.domain_min[2]),
+    0.0f);
+  const __m128i cell_max = _mm_set1_epi32(n - 2);
+  const __m128 alpha_mask = _mm_castsi128_ps(_mm_setr_epi32(0, 0, 0, -1));
+
+  const int dr = 4;
+  const int dg = 4 * n;
+  const int db = 4 * n * n;
+
+  for (int i = 0; i < count; ++i) {
+    __m128 px = _mm_loadu_ps(src + i * 4);
+
+    // Position in the table, NaN goes to 0
+    __m128 v = _mm_mul_ps(_mm_sub_ps(px, domain_min), scale);
+    v = _mm_min_ps(_mm_max_ps(v, zero), top);
+
+    // v >= 0 so truncation is floor. Keep the cell inside the table so c111 is valid.
+    __m128i cell = _mm_cvttps_epi32(v);
+    __m128i over = _mm_cmpgt_epi32(cell, cell_max);
+    cell = _mm_or_si128(_mm_and_si128(over, cell_max), _mm_andnot_si128(over, cell));
+    __m128 f = _mm_sub_ps(v, _mm_cvtepi32_ps(cell));
+
+    alignas(16) int c[4];
+    alignas(16) float w[4];
+    _mm_store_si128((__m128i*)c, cell);
+    _mm_store_ps(w, f);
+
+    const float* base = table + c[0] * dr + c[1] * dg + c[2] * db;
+    __m128 c000 = _mm_load_ps(base);
+    __m128 c111 = _mm_load_ps(base + dr + dg + db);
+
+    const float fr = w[0];
+    const float fg = w[1];
+    const float fb = w[2];
+
+    // Corners between c000 and c111 and the weights along each edge
+    __m128 ca, cb;
+    float w0, w1, w2;
+    if (fr > fg) {
+      if (fg > fb) {
+        ca = _mm_load_ps(base + dr); cb = _mm_load_ps(base + dr + dg);
+        w0 = fr; w1 = fg; w2 = fb;
+      }
+      else if (fr > fb) {
+        ca = _mm_load_ps(base + dr); cb = _mm_load_ps(base + dr + db);
+        w0 = fr; w1 = fb; w2 = fg;
+      }
+      else {
+        ca = _mm_load_ps(base + db); cb = _mm_load_ps(base + dr + db);
+        w0 = fb; w1 = fr; w2 = fg;
+      }
+    }
+    else {
+      if (fb > fg) {
+        ca = _mm_load_ps(base + db); cb = _mm_load_ps(base + dg + db);
+        w0 = fb; w1 = fg; w2 = fr;
+      }
+      else if (fb > fr) {
+        ca = _mm_load_ps(base + dg); cb = _mm_load_ps(base + dg + db);
+        w0 = fg; w1 = fb; w2 = fr;
+      }
+      else {
+        ca = _mm_load_ps(base + dg); cb = _mm_load_ps(base + dr + dg);
+        w0 = fg; w1 = fr; w2 = fb;
+      }
+    }
+
+    // c000 + w0 (ca - c000) + w1 (cb - ca) + w2 (c111 - cb)
+    __m128 out = c000;
+    out = _mm_add_ps(out, _mm_mul_ps(_mm_set1_ps(w0), _mm_sub_ps(ca, c000)));
+    out = _mm_add_ps(out, _mm_mul_ps(_mm_set1_ps(w1), _mm_sub_ps(cb, ca)));
+    out = _mm_add_ps(out, _mm_mul_ps(_mm_set1_ps(w2), _mm_sub_ps(c111, cb)));
+
+    // Alpha comes from the source
+    out = _mm_or_ps(_mm_andnot_ps(alpha_mask, out), _mm_and_ps(alpha_mask, px));
+    _mm_storeu_ps(dst + i * 4, out);
+  }
+}
@@ -0,0 +1,154 @@
+/*
+Davinci Resolve Spout Sender
+Copyright (C) 2025 ValueFactory
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of
+the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+#include "lut.h"
+
+struct Lut_Params {
+  int size;
+  float3 domain_min;
+  float3 scale;
+};
+
+// Same tetrahedral interpolation as lut_apply_rgba in lut.cpp.
+__device__ static float4 lut_sample(const float4* __restrict__ table, Lut_Params p, float4 px) {
+  const int n = p.size;
+  const float top = (float)(n - 1);
+
+  // fmaxf returns the other operand for NaN, so NaN goes to 0
+  float r = fminf(fmaxf((px.x - p.domain_min.x) * p.scale.x, 0.0f), top);
+  float g = fminf(fmaxf((px.y - p.domain_min.y) * p.scale.y, 0.0f), top);
+  float b = fminf(fmaxf((px.z - p.domain_min.z) * p.scale.z, 0.0f), top);
+
+  int ir = min((int)r, n - 2);
+  int ig = min((int)g, n - 2);
+  int ib = min((int)b, n - 2);
+  float fr = r - ir;
+  float fg = g - ig;
+  float fb = b - ib;
+
+  const int dr = 1;
+  const int dg = n;
+  const int db = n * n;
+  const float4* base = table + ir * dr + ig * dg + ib * db;
+
+  float4 c000 = base[0];
+  float4 c111 = base[dr + dg + db];
+  float4 ca, cb;
+  float w0, w1, w2;
+  if (fr > fg) {
+    if (fg > fb)      { ca = base[dr]; cb = base[dr + dg]; w0 = fr; w1 = fg; w2 = fb; }
+    else if (fr > fb) { ca = base[dr]; cb = base[dr + db]; w0 = fr; w1 = fb; w2 = fg; }
+    else              { ca = base[db]; cb = base[dr + db]; w0 = fb; w1 = fr; w2 = fg; }
+  }
+  else {
+    if (fb > fg)      { ca = base[db]; cb = base[dg + db]; w0 = fb; w1 = fg; w2 = fr; }
+    else if (fb > fr) { ca = base[dg]; cb = base[dg + db]; w0 = fg; w1 = fb; w2 = fr; }
+    else              { ca = base[dg]; cb = base[dr + dg]; w0 = fg; w1 = fr; w2 = fb; }
+  }
+
+  float4 out;
+  out.x = c000.x + w0 * (ca.x - c000.x) + w1 * (cb.x - ca.x) + w2 * (c111.x - cb.x);
+  out.y = c000.y + w0 * (ca.y - c000.y) + w1 * (cb.y - ca.y) + w2 * (c111.y - cb.y);
+  out.z = c000.z + w0 * (ca.z - c000.z) + w1 * (cb.z - ca.z) + w2 * (c111.z - cb.z);
+  out.w = px.w;
+  return out;
+}
+
+__global__ static void lut_kernel(const float4* __restrict__ table, Lut_Params p,
+                                  const char* src, size_t src_pitch, char* dst, size_t dst_pitch,
+                                  char* lut_dst, size_t lut_pitch, int width, int height) {
+  int x = blockIdx.x * blockDim.x + threadIdx.x;
+  int y = blockIdx.y * blockDim.y + threadIdx.y;
+  if (x >= width || y >= height) return;
+
+  float4 px = ((const float4*)(src + y * src_pitch))[x];
+  ((float4*)(dst + y * dst_pitch))[x] = px;
+  ((float4*)(lut_dst + y * lut_pitch))[x] = lut_sample(table, p, px);
+}
+
+cudaError_t lut_cuda_upload(Lut_Cuda& cuda, const std::shared_ptr<const Lut_3d>& lut) {
+  if (cuda.uploaded == lut) return cudaSuccess;
+
+  if (cuda.table) {
+    cudaFree(cuda.table);
+    cuda.table = nullptr;
+  }
+  cuda.uploaded = nullptr;
+
+  size_t bytes = lut->table.size() * sizeof(float);
+  auto err = cudaMalloc(&cuda.table, bytes);
+  if (err != cudaSuccess) return err;
+
+  err = cudaMemcpy(cuda.table, lut->table.data(), bytes, cudaMemcpyHostToDevice);
+  if (err != cudaSuccess) return err;
+
+  cuda.uploaded = lut;
+  return cudaSuccess;
+}
+
+cudaError_t lut_cuda_reserve(Lut_Cuda& cuda, int width, int height) {
+  if (cuda.scratch && cuda.scratch_width == width && cuda.scratch_height == height) return cudaSuccess;
+
+  if (cuda.scratch) {
+    cudaFree(cuda.scratch);
+    cuda.scratch = nullptr;
+  }
+  cuda.scratch_width = 0;
+  cuda.scratch_height = 0;
+
+  auto err = cudaMallocPitch(&cuda.scratch, &cuda.scratch_pitch, width * 4 * sizeof(float), height);
+  if (err != cudaSuccess) return err;
+
+  cuda.scratch_width = width;
+  cuda.scratch_height = height;
+  return cudaSuccess;
+}
+
+cudaError_t lut_cuda_apply(Lut_Cuda& cuda, const std::shared_ptr<const Lut_3d>& lut_ptr,
+                           const void* src, size_t src_pitch, void* dst, size_t dst_pitch,
+                           int width, int height, cudaStream_t stream) {
+  auto err = lut_cuda_upload(cuda, lut_ptr);
+  if (err != cudaSuccess) return err;
+
+  const Lut_3d& lut = *lut_ptr;
+
+  err = lut_cuda_reserve(cuda, width, height);
+  if (err != cudaSuccess) return err;
+
+  Lut_Params p;
+  p.size = lut.size;
+  p.domain_min = make_float3(lut.domain_min[0], lut.domain_min[1], lut.domain_min[2]);
+  p.scale = make_float3(
+    (float)(lut.size - 1) / (lut.domain_max[0] - lut.domain_min[0]),
+    (float)(lut.size - 1) / (lut.domain_max[1] - lut.domain_min[1]),
+    (float)(lut.size - 1) / (lut.domain_max[2] - lut.domain_min[2]));
+
+  dim3 block(16, 16);
+  dim3 grid((width + block.x - 1) / block.x, (height + block.y - 1) / block.y);
+  lut_kernel<<<grid, block, 0, stream>>>((const float4*)cuda.table, p,
+                                         (const char*)src, src_pitch, (char*)dst, dst_pitch,
+                                         (char*)cuda.scratch, cuda.scratch_pitch, width, height);
+  return cudaGetLastError();
+}
+
+void lut_cuda_release(Lut_Cuda& cuda) {
+  if (cuda.table) cudaFree(cuda.table);
+  if (cuda.scratch) cudaFree(cuda.scratch);
+  cuda = Lut_Cuda();
+}
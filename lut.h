@@ -0,0 +1,75 @@
+/*
+Davinci Resolve Spout Sender
+Copyright (C) 2025 ValueFactory
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of
+the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <cuda_runtime.h>
+
+// 3D LUT applied to the frame we publish, never to the timeline passthrough.
+struct Lut_3d {
+  int size;
+  float domain_min[3];
+  float domain_max[3];
+
+  // size^3 RGBA entries, red changing fastest as in the .cube file.
+  // Alpha is unused and pads each entry to 16 bytes for aligned SIMD loads.
+  std::vector<float> table;
+};
+
+// Parses a .cube file. Returns null and sets error on failure.
+std::shared_ptr<const Lut_3d> lut_parse_cube(const std::string& path, std::string& error);
+
+// Returns the parsed LUT for path, parsing only when the file's mtime or size changed
+// since the last call. Shared by all plugin instances. Failures are cached as well so a
+// bad file isn't re-parsed every frame.
+std::shared_ptr<const Lut_3d> lut_cache_get(const std::string& path, std::string& error);
+
+// Applies the LUT to count RGBA float pixels. Alpha is copied through.
+// src and dst may be the same.
+void lut_apply_rgba(const Lut_3d& lut, const float* src, float* dst, int count);
+
+// CUDA side of the LUT. Lives in lut.cu.
+struct Lut_Cuda {
+  // Held so a reloaded LUT can't reuse the address of the uploaded one
+  std::shared_ptr<const Lut_3d> uploaded;
+  float* table = nullptr;
+
+  // LUT output for the publish copy
+  void* scratch = nullptr;
+  size_t scratch_pitch = 0;
+  int scratch_width = 0;
+  int scratch_height = 0;
+};
+
+// Uploads the table if lut is not the one already on the device.
+cudaError_t lut_cuda_upload(Lut_Cuda& cuda, const std::shared_ptr<const Lut_3d>& lut);
+
+// Makes sure the scratch buffer fits a width x height RGBA float image.
+cudaError_t lut_cuda_reserve(Lut_Cuda& cuda, int width, int height);
+
+// In one pass over src: copies src to dst (passthrough) and writes the LUT result to the scratch buffer.
+cudaError_t lut_cuda_apply(Lut_Cuda& cuda, const std::shared_ptr<const Lut_3d>& lut,
+                           const void* src, size_t src_pitch, void* dst, size_t dst_pitch,
+                           int width, int height, cudaStream_t stream);
+
+void lut_cuda_release(Lut_Cuda& cuda);
@@ -18,6 +18,14 @@ DEALINGS IN THE SOFTWARE.
 */
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 #include "ofxsImageEffect.h"
 #include "ofxsInteract.h"
@@ -30,6 +38,12 @@ DEALINGS IN THE SOFTWARE.
 #include <d3d11_1.h>
 #include "SpoutDX.h"
 
+#include "frame_stats.h"
+#include "genlock.h"
+#include "lut.h"
+#include "output_sink.h"
+#include "reduce.h"
+
 #include <wrl.h>
 using namespace Microsoft::WRL;
 
@@ -48,6 +62,24 @@ using namespace Microsoft::WRL;
 using namespace OFX;
 
 #define PARAM_SPOUT_SENDER_NAME "sender_name"
+#define PARAM_COLOR_SPACE "color_space"
+#define PARAM_LUT_FILE "lut_file"
+#define PARAM_SHOW_STATS "show_stats"
+#define PARAM_LAG_FALLBACK "lag_fallback"
+#define PARAM_SKIP_PASSTHROUGH "skip_passthrough"
+#define PARAM_OUTPUT_FORMAT "output_format"
+#define PARAM_YUV_MATRIX "yuv_matrix"
+#define PARAM_YUV_RANGE "yuv_range"
+#define PARAM_ATLAS_NAME "atlas_name"
+#define PARAM_ATLAS_SLOT "atlas_slot"
+#define PARAM_STREAM_ROWS "stream_rows"
+#define PARAM_FILE_OUTPUT "file_output"
+#define PARAM_FILE_FORMAT "file_format"
+#define PARAM_FILE_COMPRESSION "file_compression"
+#define PARAM_FILE_QUEUE "file_queue"
+#define PARAM_FRAME_STATS "frame_stats"
+#define PARAM_GENLOCK_GROUP "genlock_group"
+#define PARAM_GENLOCK_TIMEOUT "genlock_timeout"
 
 #if defined(_DEBUG)
   #define PLUGIN_NAME "SpoutSender_dev"
@@ -61,27 +93,234 @@ using namespace OFX;
   #define PLUGIN_MINOR 1
 #endif
 
+// Pixels of the LUT output the copier hands to the frame stats at a time
+#define LUT_STATS_CHUNK 256
+
 class Image_Copier : public OFX::ImageProcessor
 {
 public:
   const OFX::Image* src_img;
   int pixel_stride;
 
+  // Optional LUT output, float RGBA only. Row y of the source goes to row (y - lut_y0) of lut_dst.
+  const Lut_3d* lut = nullptr;
+  char* lut_dst = nullptr;
+  size_t lut_pitch = 0;
+  int lut_x0 = 0;
+  int lut_y0 = 0;
+  // Frame stats of the LUT output, taken as it is written. Each thread's window is one part.
+  Frame_Stats_Accumulator* stats = nullptr;
+
   explicit Image_Copier(OFX::ImageEffect& p_Instance) : OFX::ImageProcessor(p_Instance) {
   }
 
   virtual void multiThreadProcessImages(OfxRectI wnd) {
+    auto* part = lut && stats ? &stats->part(wnd.y1 - lut_y0) : nullptr;
+
     for (int y = wnd.y1; y < wnd.y2; ++y) {
-      auto* dst_px = _dstImg->getPixelAddress(wnd.x1, y);
       auto* src_px = src_img->getPixelAddress(wnd.x1, y);
 
       auto width = wnd.x2 - wnd.x1;
 
-      memcpy(dst_px, src_px, width * pixel_stride);
+      // No destination when we publish from isIdentity, then only the LUT output is written
+      if (_dstImg) {
+        auto* dst_px = _dstImg->getPixelAddress(wnd.x1, y);
+        memcpy(dst_px, src_px, width * pixel_stride);
+      }
+
+      // The source row is still in cache from the memcpy so the LUT costs us no extra read of the frame.
+      if (lut && part) {
+        // Through a chunk that stays in L1, the stats copy it on to the LUT output
+        alignas(32) float chunk[LUT_STATS_CHUNK * 4];
+        auto* lut_px = (char*)((float*)(lut_dst + (y - lut_y0) * lut_pitch) + (wnd.x1 - lut_x0) * 4);
+        for (auto x = 0; x < width; x += LUT_STATS_CHUNK) {
+          auto count = width - x < LUT_STATS_CHUNK ? width - x : LUT_STATS_CHUNK;
+          lut_apply_rgba(*lut, (const float*)src_px + x * 4, chunk, count);
+          stats->copy_rows((const char*)chunk, 0, lut_px + (size_t)x * 4 * sizeof(float), 0, count, 1, *part);
+        }
+      }
+      else if (lut) {
+        auto* lut_px = (float*)(lut_dst + (y - lut_y0) * lut_pitch) + (wnd.x1 - lut_x0) * 4;
+        lut_apply_rgba(*lut, (const float*)src_px, lut_px, width);
+      }
+    }
+  }
+};
+
+class Frame_Reducer : public OFX::ImageProcessor
+{
+public:
+  const char* src;
+  size_t src_pitch;
+  int src_width;
+  int src_height;
+  char* dst;
+  size_t dst_pitch;
+  bool half;
+  // Frame stats of the source, taken a few rows ahead of the reduction so it finds them in cache
+  Frame_Stats_Accumulator* stats = nullptr;
+
+  explicit Frame_Reducer(OFX::ImageEffect& p_Instance) : OFX::ImageProcessor(p_Instance) {
+  }
+
+  // The render window is in rows of the reduced image
+  virtual void multiThreadProcessImages(OfxRectI wnd) {
+    if (!stats) {
+      reduce_rgba_rows(src, src_pitch, src_width, src_height, dst, dst_pitch, half, wnd.y1, wnd.y2);
+      return;
+    }
+
+    // Two source rows a reduced row, each step of source rows is a part
+    for (auto y = wnd.y1; y < wnd.y2; y += OUTPUT_BAND_ROWS / 2) {
+      auto end = y + OUTPUT_BAND_ROWS / 2 < wnd.y2 ? y + OUTPUT_BAND_ROWS / 2 : wnd.y2;
+      auto src_begin = y * 2;
+      auto src_end = end * 2 < src_height ? end * 2 : src_height;
+      stats->copy_rows(src + (size_t)src_begin * src_pitch, src_pitch, nullptr, 0, src_width, src_end - src_begin, stats->part(src_begin));
+      reduce_rgba_rows(src, src_pitch, src_width, src_height, dst, dst_pitch, half, y, end);
+    }
+  }
+};
+
+// YUV output for receivers that encode right away. Rows are converted right after their passthrough copy
+// so the source is read once. The render window is in steps of rows_per_step so the row pairs of 4:2:0 formats
+// stay on one thread.
+class Yuv_Converter : public OFX::ImageProcessor
+{
+public:
+  const spoutCopy* copy;
+  const char* src;
+  unsigned int src_pitch;
+  unsigned int width;
+  unsigned int height;
+  char* yuv_dst;
+  unsigned int yuv_pitch;
+  DWORD format;
+  bool bt2020;
+  bool full_range;
+  unsigned int rows_per_step;
+  // Frame stats of the source, taken in the passthrough copy or ahead of the conversion. Each step is a part.
+  Frame_Stats_Accumulator* stats = nullptr;
+
+  explicit Yuv_Converter(OFX::ImageEffect& p_Instance) : OFX::ImageProcessor(p_Instance) {
+  }
+
+  virtual void multiThreadProcessImages(OfxRectI wnd) {
+    for (auto step = (unsigned int)wnd.y1; step < (unsigned int)wnd.y2; ++step) {
+      auto begin = step * rows_per_step;
+      auto end = begin + rows_per_step < height ? begin + rows_per_step : height;
+
+      // No destination when we publish from isIdentity or the source is the LUT output
+      if (stats) {
+        auto& part = stats->part((int)begin);
+        auto bounds = _dstImg ? _dstImg->getBounds() : OfxRectI{};
+        for (auto y = begin; y < end; ++y) {
+          auto* dst_px = _dstImg ? (char*)_dstImg->getPixelAddress(bounds.x1, bounds.y1 + y) : nullptr;
+          stats->copy_rows(src + (size_t)y * src_pitch, src_pitch, dst_px, 0, (int)width, 1, part);
+        }
+      }
+      else if (_dstImg) {
+        auto bounds = _dstImg->getBounds();
+        for (auto y = begin; y < end; ++y) {
+          auto* dst_px = _dstImg->getPixelAddress(bounds.x1, bounds.y1 + y);
+          memcpy(dst_px, src + (size_t)y * src_pitch, (size_t)width * 4 * sizeof(float));
+        }
+      }
+
+      copy->rgbaf2yuv((const float*)src, yuv_dst, width, height, src_pitch, yuv_pitch, format, bt2020, full_range, begin, end);
+    }
+  }
+};
+
+// The ring holds frames as spoutDX::AcquireFrameLease reads them, SpoutFrameMetadata then the rows
+static_assert(sizeof(SpoutFrameMetadata) <= SPOUT_FRAME_HEADER_BYTES, "frame metadata must fit the frame header");
+
+// Runs the output dispatcher on the host's threads
+class Sink_Processor : public OFX::ImageProcessor
+{
+public:
+  Output_Dispatcher* dispatcher;
+
+  explicit Sink_Processor(OFX::ImageEffect& p_Instance) : OFX::ImageProcessor(p_Instance) {
+  }
+
+  // The render window only sets how many threads we get, the dispatcher hands out the bands
+  virtual void multiThreadProcessImages(OfxRectI) {
+    dispatcher->run();
+  }
+};
+
+// The timeline passthrough. Row 0 of the frame is row src_bounds.y1 of the image, only the render window is written.
+class Passthrough_Sink : public Output_Sink
+{
+public:
+  OFX::Image* dst = nullptr;
+  OfxRectI src_bounds = {};
+  OfxRectI window = {};
+
+  virtual bool prepare(const Output_Frame& frame) override {
+    pixel_bytes = frame.pixel_bytes;
+    return dst != nullptr && window.x2 > window.x1;
+  }
+
+  virtual void write_band(const char* src, size_t pitch, int y_begin, int y_end) override {
+    auto width = (size_t)(window.x2 - window.x1);
+    auto x_offset = (size_t)(window.x1 - src_bounds.x1) * pixel_bytes;
+    for (auto row = y_begin; row < y_end; ++row, src += pitch) {
+      auto y = src_bounds.y1 + row;
+      if (y >= window.y1 && y < window.y2) {
+        memcpy(dst->getPixelAddress(window.x1, y), src + x_offset, width * pixel_bytes);
+      }
     }
   }
+
+  virtual bool publish() override {
+    return true;
+  }
+
+private:
+  int pixel_bytes = 0;
+};
+
+class Spout_Plugin;
+
+// The shared texture. Bands go to the mapped staging texture, publish copies it to the shared texture under the
+// sender mutex. Frames must be in the format of the texture.
+class Texture_Sink : public Output_Sink
+{
+public:
+  Spout_Plugin* plugin = nullptr;
+  ID3D11DeviceContext* context = nullptr;
+  ID3D11Texture2D* tex = nullptr;
+  // Taken in our copy and published with the frame when set
+  Frame_Stats_Accumulator* stats = nullptr;
+
+  virtual bool prepare(const Output_Frame& frame) override;
+  virtual void write_band(const char* src, size_t pitch, int y_begin, int y_end) override;
+  virtual bool publish() override;
+
+private:
+  Output_Frame frame;
+  D3D11_MAPPED_SUBRESOURCE mapped = {};
 };
 
+// Output format option order
+static const DWORD output_formats[] = { 0, SPOUT_YUV_NV12, SPOUT_YUV_P010, SPOUT_YUV_YUY2, SPOUT_YUV_UYVY, SPOUT_YUV_V210 };
+
+static int format_pixel_bytes(DXGI_FORMAT format) {
+  switch (format) {
+    case DXGI_FORMAT_R8_UNORM: return 1;
+    case DXGI_FORMAT_R16_UNORM:
+    case DXGI_FORMAT_R16_FLOAT: return 2;
+    case DXGI_FORMAT_R8G8B8A8_UNORM:
+    case DXGI_FORMAT_R10G10B10A2_UNORM:
+    case DXGI_FORMAT_R32_FLOAT: return 4;
+    case DXGI_FORMAT_R16G16B16A16_UNORM:
+    case DXGI_FORMAT_R16G16B16A16_FLOAT: return 8;
+    case DXGI_FORMAT_R32G32B32A32_FLOAT: return 16;
+    default: return 4;
+  }
+}
+
 void check_d3d11_error(HRESULT hr) {
   if (FAILED(hr)) {
     DEBUG_BREAK;
@@ -102,6 +341,359 @@ void invalid_format() {
   throwSuiteStatusException(kOfxStatErrImageFormat);
 }
 
+// Param values as render reads them. Every param read goes through the host's param suite and string
+// params allocate, so changedParam builds one of these and render picks it up with a pointer load. None of our
+// params animate, so a snapshot holds for every time.
+struct Param_Snapshot {
+  std::string sender_name;
+  std::string lut_file;
+  std::string atlas_name;
+  std::string file_output;
+  std::string genlock_group;
+  // The sender name with the characters a file name can't hold replaced
+  std::string file_prefix;
+  int color_space = 0;
+  int lag_fallback = 0;
+  int output_format = 0;
+  int yuv_matrix = 0;
+  int yuv_range = 0;
+  int atlas_slot = 1;
+  int file_format = 0;
+  int file_compression = 4;
+  int file_queue = 0;
+  int genlock_timeout = 100;
+  bool skip_passthrough = false;
+  bool stream_rows = false;
+  bool frame_stats = true;
+  bool show_stats = false;
+};
+
+// What send_frame needs from the render arguments, so isIdentity can publish as well
+struct Send_Arguments {
+  double time;
+  OfxPointD renderScale;
+  OfxRectI renderWindow;
+  cudaStream_t pCudaStream;
+  const Param_Snapshot* params;
+};
+
+// The name a sender is registered under, which has a _N suffix when another sender had the name first. Stored by
+// the render after a publish and read by the stats overlay without a lock, under a sequence lock that is odd
+// while a store is writing.
+struct Published_Name {
+  static const int capacity = 256;
+
+  Published_Name() {
+    for (auto& word : words) {
+      word.store(0, std::memory_order_relaxed);
+    }
+  }
+
+  // One writer at a time, the render holds staging_mutex
+  void store(const char* name) {
+    if (written == name) {
+      return;
+    }
+    written = name;
+
+    uint64_t next[word_count] = {};
+    memcpy(next, name, std::min(written.size(), (size_t)capacity - 1));
+
+    auto count = sequence.load(std::memory_order_relaxed);
+    sequence.store(count + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (int i = 0; i < word_count; i++) {
+      words[i].store(next[i], std::memory_order_relaxed);
+    }
+    sequence.store(count + 2, std::memory_order_release);
+  }
+
+  // Empty until the first store
+  void load(char (&name)[capacity]) const {
+    uint64_t copy[word_count];
+    for (;;) {
+      auto count = sequence.load(std::memory_order_acquire);
+      if (count & 1) {
+        std::this_thread::yield();
+        continue;
+      }
+      for (int i = 0; i < word_count; i++) {
+        copy[i] = words[i].load(std::memory_order_relaxed);
+      }
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (sequence.load(std::memory_order_relaxed) == count) {
+        break;
+      }
+    }
+    memcpy(name, copy, capacity);
+  }
+
+private:
+  static const int word_count = capacity / sizeof(uint64_t);
+  std::atomic<unsigned int> sequence{ 0 };
+  std::atomic<uint64_t> words[word_count];
+  std::string written;
+};
+
+// Hands a reused image back to the host when the render leaves, thrown or not
+struct Image_Release {
+  Image& image;
+  ~Image_Release() { image.release(); }
+};
+
+// Resolve keeps plugin instances alive long after their clip has left the playhead and each of them
+// holds on to a frame sized staging texture. Instances register here so that a rendering instance can free the
+// staging resources of the ones that have been idle the longest once the process goes over budget.
+// The budget is SPOUT_SENDER_STAGING_BUDGET_MB, 1024 by default.
+struct Instance_Registry {
+  std::mutex mutex;
+  std::vector<Spout_Plugin*> instances;
+  size_t budget_bytes;
+
+  Instance_Registry() {
+    budget_bytes = (size_t)1024 * 1024 * 1024;
+    if (auto* env = getenv("SPOUT_SENDER_STAGING_BUDGET_MB")) {
+      auto mb = strtoull(env, nullptr, 10);
+      if (mb > 0) {
+        budget_bytes = (size_t)mb * 1024 * 1024;
+      }
+    }
+  }
+};
+
+static Instance_Registry& instance_registry() {
+  static Instance_Registry registry;
+  return registry;
+}
+
+// Instances that rendered more recently than this are never reclaimed
+#define IDLE_RECLAIM_NS 2000000000LL
+
+// Steps we take, in order, while receivers fall behind. Each one keeps the ones before it.
+// The Receiver Lag Fallback option is the furthest we're allowed to go. Resolution and precision steps only
+// apply to float RGBA since that's what the reduction works on.
+enum Lag_Level {
+  LAG_LEVEL_FULL = 0,
+  LAG_LEVEL_SKIP_FRAMES,
+  LAG_LEVEL_HALF_RESOLUTION,
+  LAG_LEVEL_HALF_PRECISION,
+};
+
+static const char* lag_level_names[] = { "Full", "Skip Frames", "Half Resolution", "Half Precision" };
+
+// Options a render couldn't follow, shown on the effect together until one of the options changes
+enum Render_Warning {
+  RENDER_WARNING_YUV_GPU = 1,
+  RENDER_WARNING_STATS_GPU = 2,
+  RENDER_WARNING_STATS_ATLAS = 4,
+};
+
+static const char* render_warning_messages[] = {
+  "YUV output needs CPU rendering. GPU renders are sent as RGBA Float.",
+  "Frame Stats need CPU rendering. GPU renders are sent without them.",
+  "Frame Stats aren't sent for atlas tiles.",
+};
+
+// The slowest receiver is behind when it's more than this many published frames back
+#define LAG_BEHIND_FRAMES 2
+// Time between steps down, so a step has a chance to take effect before the next one
+#define LAG_STEP_DOWN_NS 500000000LL
+// Receivers have to keep up this long before we step back up
+#define LAG_RECOVER_NS 3000000000LL
+
+// Instances with the same Atlas Name copy their frame into one tile of a shared canvas, and the canvas
+// goes out as a single sender once every instance that is rendering has written its tile for the timeline time.
+// A multi-view receiver then opens one sender and waits on one frame instead of one per camera angle.
+// The grid is sized for the highest slot in use and the frame metadata tells receivers where the tiles are.
+#define ATLAS_MAX_SLOTS 16
+// Slots that wrote a tile more recently than this are waited for before the canvas is published
+#define ATLAS_ACTIVE_NS 1000000000LL
+
+struct Atlas_Sender {
+  std::string name;
+  std::mutex mutex;
+  std::unique_ptr<spoutDX> spout;
+
+  // Instances in each slot and when each slot last wrote its tile
+  int members[ATLAS_MAX_SLOTS] = {};
+  int64_t tile_written_ns[ATLAS_MAX_SLOTS] = {};
+
+  DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+  int pixel_bytes = 0;
+  int tile_width = 0;
+  int tile_height = 0;
+  int columns = 0;
+  int rows = 0;
+  std::vector<char> canvas;
+
+  // What has been collected for the timeline time being sent
+  double time = 0.0;
+  uint32_t written = 0;
+  OfxPointD render_scale = { 1.0, 1.0 };
+  uint32_t color_space = 0;
+
+  ~Atlas_Sender() {
+    if (spout) {
+      spout->ReleaseSender();
+      spout->CloseDirectX11();
+    }
+  }
+
+  size_t pitch() const {
+    return (size_t)tile_width * columns * pixel_bytes;
+  }
+
+  char* tile(int slot) {
+    return canvas.data() + (size_t)(slot / columns) * tile_height * pitch() + (size_t)(slot % columns) * tile_width * pixel_bytes;
+  }
+
+  // As square as we can make it for the highest slot in use
+  void grid(int& grid_columns, int& grid_rows) const {
+    int count = 1;
+    for (int i = 0; i < ATLAS_MAX_SLOTS; ++i) {
+      if (members[i] > 0) count = i + 1;
+    }
+    grid_columns = 1;
+    while (grid_columns * grid_columns < count) ++grid_columns;
+    grid_rows = (count + grid_columns - 1) / grid_columns;
+  }
+
+  // Every slot that is rendering has written its tile
+  bool complete(int64_t now) const {
+    for (int i = 0; i < ATLAS_MAX_SLOTS; ++i) {
+      if (members[i] > 0 && now - tile_written_ns[i] < ATLAS_ACTIVE_NS && !(written & (1u << i))) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Before a tile is written. A tile for another time means the slots we were waiting for won't render this one,
+  // so what we have is sent first. The canvas is reallocated when the layout changes.
+  // Returns true if a frame was published. Called with the mutex held.
+  bool begin_tile(double tile_time, DXGI_FORMAT tile_format, int tile_pixel_bytes, int width, int height) {
+    auto published = false;
+    if (written && tile_time != time) {
+      published = publish();
+    }
+    time = tile_time;
+
+    int grid_columns = 0;
+    int grid_rows = 0;
+    grid(grid_columns, grid_rows);
+
+    // Tiles fit the largest frame, unless the format changed and the old sizes mean nothing
+    auto next_width = tile_format == format && tile_width > width ? tile_width : width;
+    auto next_height = tile_format == format && tile_height > height ? tile_height : height;
+
+    if (tile_format != format || grid_columns != columns || grid_rows != rows || next_width != tile_width || next_height != tile_height) {
+      if (written) {
+        published = publish() || published;
+      }
+
+      format = tile_format;
+      pixel_bytes = tile_pixel_bytes;
+      tile_width = next_width;
+      tile_height = next_height;
+      columns = grid_columns;
+      rows = grid_rows;
+      canvas.assign(pitch() * tile_height * rows, 0);
+
+      SpoutLogNotice("Spout_Plugin : atlas %s is %dx%d tiles of %dx%d", name.c_str(), columns, rows, tile_width, tile_height);
+    }
+
+    return published;
+  }
+
+  // Sends the canvas with what has been written. Called with the mutex held.
+  bool publish() {
+    auto mask = written;
+    written = 0;
+    if (!mask || canvas.empty()) {
+      return false;
+    }
+
+    if (!spout) {
+      spout = std::unique_ptr<spoutDX>(new spoutDX);
+      spout->SetSenderName(name.c_str());
+    }
+
+    if (!spout->OpenDirectX11()) {
+      SpoutLogError("Spout_Plugin : atlas %s could not open D3D11", name.c_str());
+      return false;
+    }
+
+    auto width = tile_width * columns;
+    auto height = tile_height * rows;
+
+    spout->SetSenderFormat(format);
+    spout->SetSenderFormatCode(0);
+    if (!spout->CheckSender(width, height, format)) {
+      SpoutLogError("Spout_Plugin : atlas %s could not create its sender", name.c_str());
+      return false;
+    }
+
+    if (!spout->frame.CheckTextureAccess(spout->m_pSharedTexture)) {
+      return false;
+    }
+
+    spout->m_pImmediateContext->UpdateSubresource(spout->m_pSharedTexture, 0, NULL, canvas.data(), (UINT)pitch(), 0);
+    spout->m_pImmediateContext->Flush();
+
+    SpoutFrameMetadata metadata = {};
+    metadata.time = time;
+    metadata.renderScaleX = render_scale.x;
+    metadata.renderScaleY = render_scale.y;
+    metadata.colorspace = color_space;
+    metadata.format = format;
+    metadata.width = width;
+    metadata.height = height;
+    metadata.tileColumns = columns;
+    metadata.tileRows = rows;
+    metadata.tileWidth = tile_width;
+    metadata.tileHeight = tile_height;
+    metadata.tileMask = mask;
+    spout->frame.WriteFrameMetadata(&metadata);
+
+    spout->frame.SetNewFrame();
+    spout->frame.AllowTextureAccess(spout->m_pSharedTexture);
+    return true;
+  }
+};
+
+// Atlases by name. Instances hold on to them, so an atlas and its sender go away with the last instance using it.
+struct Atlas_Registry {
+  std::mutex mutex;
+  std::vector<std::weak_ptr<Atlas_Sender>> atlases;
+};
+
+static Atlas_Registry& atlas_registry() {
+  static Atlas_Registry registry;
+  return registry;
+}
+
+static std::shared_ptr<Atlas_Sender> atlas_acquire(const std::string& name) {
+  auto& registry = atlas_registry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+
+  for (auto it = registry.atlases.begin(); it != registry.atlases.end();) {
+    auto atlas = it->lock();
+    if (!atlas) {
+      it = registry.atlases.erase(it);
+      continue;
+    }
+    if (atlas->name == name) {
+      return atlas;
+    }
+    ++it;
+  }
+
+  auto atlas = std::make_shared<Atlas_Sender>();
+  atlas->name = name;
+  registry.atlases.push_back(atlas);
+  return atlas;
+}
+
 
 class Spout_Plugin : public ImageEffect {
 public: 
@@ -118,21 +710,134 @@ public:
   Clip* src_clip;
 
   StringParam* sender_name;
+  ChoiceParam* color_space;
+  StringParam* lut_file;
+  BooleanParam* show_stats;
+  ChoiceParam* lag_fallback;
+  BooleanParam* skip_passthrough;
+  ChoiceParam* output_format;
+  ChoiceParam* yuv_matrix;
+  ChoiceParam* yuv_range;
+  StringParam* atlas_name;
+  IntParam* atlas_slot;
+  BooleanParam* stream_rows;
+  StringParam* file_output;
+  ChoiceParam* file_format;
+  IntParam* file_compression;
+  ChoiceParam* file_queue;
+  BooleanParam* frame_stats;
+  StringParam* genlock_group;
+  IntParam* genlock_timeout;
+
+  // Image sequence written next to the sender. The workers start with the first frame it's given.
+  File_Sink file_sink;
+  bool file_format_logged = false;
+
+  // The plain CPU render reads the frame once and the dispatcher hands each band to the passthrough,
+  // the shared texture, the row stream ring and the file output. The LUT, YUV and CUDA paths have their own
+  // copies and only use it for the file output.
+  Output_Dispatcher dispatcher;
+  Passthrough_Sink passthrough_sink;
+  Texture_Sink texture_sink;
+  Ring_Sink ring_sink;
+  File_Output_Sink file_output_sink{ file_sink };
+  Frame_Stats_Accumulator stats_accumulator;
+  // Where publish_texture writes the stats, named after the sender
+  Frame_Stats_Map frame_stats_map;
+  // Instances with the same group name publish together
+  Genlock_Group genlock;
+
+  // Atlas we send through instead of our own sender, and our slot in it
+  std::shared_ptr<Atlas_Sender> atlas;
+  int atlas_slot_index = -1;
+
+  // LUT applied to the sent frame. Shared with other instances through lut_cache_get.
+  std::shared_ptr<const Lut_3d> lut;
+  std::string lut_path;
+  int64_t lut_checked = 0;
 
   // CPU
   std::unique_ptr<Image_Copier> copier;
+  std::unique_ptr<Frame_Reducer> reducer;
+  std::unique_ptr<Yuv_Converter> yuv_converter;
+  std::unique_ptr<Sink_Processor> sink_processor;
+  // LUT output when it is reduced before sending
+  std::vector<float> lut_host;
 
   // CUDA
-  cudaGraphicsResource* cuda_in_tex;
-  cudaGraphicsResource* cuda_out_tex;
+  cudaGraphicsResource* cuda_in_tex = nullptr;
+  cudaGraphicsResource* cuda_out_tex = nullptr;
+  Lut_Cuda lut_cuda;
+  Reduce_Cuda reduce_cuda;
 
   D3D11_TEXTURE2D_DESC in_tex_desc = {};
+  size_t in_tex_bytes = 0;
   ComPtr<ID3D11Texture2D> in_tex;
   ComPtr<ID3D11ShaderResourceView> in_srv;
 
-  bool was_using_cuda;
+  bool was_using_cuda = false;
+  // Set when the host gave us no source image in isIdentity, cleared when the option is toggled
+  bool identity_unsupported = false;
+  // Render_Warning bits on the effect, changedParam clears them
+  int render_warnings = 0;
+
+  // Held while rendering so the staging resources can't be reclaimed under us
+  std::mutex staging_mutex;
+
+  // render and isIdentity fetch into these under staging_mutex instead of a new Image per frame, with
+  // the param snapshot and the sinks reused as well nothing on the render path allocates once the sizes settle.
+  // tools/spout_render_alloc_test.cpp checks the support library side of that with a counting allocator.
+  Image src_image;
+  Image dst_image;
+
+  // Current Param_Snapshot. render and isIdentity hold it with a Param_Reader, replaced snapshots stay in
+  // param_snapshots until the last reader leaves.
+  std::atomic<const Param_Snapshot*> param_current;
+  std::atomic<bool> params_retired;
+  std::atomic<int> params_readers;
+  std::mutex params_mutex;
+  std::vector<std::unique_ptr<const Param_Snapshot>> param_snapshots;
+  std::atomic<int64_t> last_render_ns;
+  std::atomic<size_t> staging_bytes;
+
+  // Timing distributions in nanoseconds
+  spoutHistogram render_times;
+  spoutHistogram publish_times;
+  spoutHistogram passthrough_times;
+
+  // Counters for the stats overlay. The overlay draws on the UI thread while we render,
+  // so it only ever does relaxed loads of these and never touches the render locks.
+  spoutHistogram publish_intervals;
+  std::atomic<uint64_t> frames_published;
+  std::atomic<uint64_t> frames_skipped;
+  std::atomic<uint64_t> frames_dropped;
+  std::atomic<int64_t> last_publish_ns;
+  std::atomic<int64_t> publish_interval_avg_ns;
+  // Ours, or the atlas's when we send tiles
+  Published_Name published_name;
+
+  // Receiver lag fallback. The atomics are read by the stats overlay.
+  std::atomic<int> lag_level;
+  std::atomic<int> lag_receivers;
+  std::atomic<uint64_t> lag_frames;
+  int64_t lag_step_ns = 0;
+  int64_t lag_keeping_up_ns = 0;
+  bool lag_skip_next = false;
 
   ~Spout_Plugin() {
+    {
+      auto& registry = instance_registry();
+      std::lock_guard<std::mutex> lock(registry.mutex);
+      registry.instances.erase(std::remove(registry.instances.begin(), registry.instances.end(), this), registry.instances.end());
+    }
+
+    render_times.Log("Spout_Plugin render");
+    publish_times.Log("Spout_Plugin publish");
+    passthrough_times.Log("Spout_Plugin passthrough");
+    file_sink.Log("Spout_Plugin file output");
+    genlock.wait_times.Log("Spout_Plugin genlock wait");
+
+    leave_atlas();
     release_spout();
     cleanup_cuda();
   }
@@ -142,6 +847,46 @@ public:
     src_clip = fetchClip(kOfxImageEffectSimpleSourceClipName);
     sender_name = fetchStringParam("sender_name");
     sender_name->setEnabled(true);
+    color_space = fetchChoiceParam(PARAM_COLOR_SPACE);
+    lut_file = fetchStringParam(PARAM_LUT_FILE);
+    show_stats = fetchBooleanParam(PARAM_SHOW_STATS);
+    lag_fallback = fetchChoiceParam(PARAM_LAG_FALLBACK);
+    skip_passthrough = fetchBooleanParam(PARAM_SKIP_PASSTHROUGH);
+    output_format = fetchChoiceParam(PARAM_OUTPUT_FORMAT);
+    yuv_matrix = fetchChoiceParam(PARAM_YUV_MATRIX);
+    yuv_range = fetchChoiceParam(PARAM_YUV_RANGE);
+    atlas_name = fetchStringParam(PARAM_ATLAS_NAME);
+    atlas_slot = fetchIntParam(PARAM_ATLAS_SLOT);
+    stream_rows = fetchBooleanParam(PARAM_STREAM_ROWS);
+    file_output = fetchStringParam(PARAM_FILE_OUTPUT);
+    file_format = fetchChoiceParam(PARAM_FILE_FORMAT);
+    file_compression = fetchIntParam(PARAM_FILE_COMPRESSION);
+    file_queue = fetchChoiceParam(PARAM_FILE_QUEUE);
+    frame_stats = fetchBooleanParam(PARAM_FRAME_STATS);
+    genlock_group = fetchStringParam(PARAM_GENLOCK_GROUP);
+    genlock_timeout = fetchIntParam(PARAM_GENLOCK_TIMEOUT);
+
+    param_current = nullptr;
+    params_retired = false;
+    params_readers = 0;
+    update_params();
+
+    frames_published = 0;
+    frames_skipped = 0;
+    frames_dropped = 0;
+    last_publish_ns = 0;
+    publish_interval_avg_ns = 0;
+
+    lag_level = LAG_LEVEL_FULL;
+    lag_receivers = 0;
+    lag_frames = 0;
+
+    last_render_ns = spoutHistogram::Now();
+    staging_bytes = 0;
+
+    auto& registry = instance_registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.instances.push_back(this);
   }
 
   void release_spout() {
@@ -151,14 +896,82 @@ public:
       spout.reset();
       spout = 0;
     }
+    // The ring was closed with the sender
+    ring_sink.reset();
+    frame_stats_map.close();
+  }
+
+  // Reads every param into a new snapshot and swaps it in
+  void update_params() {
+    std::unique_ptr<Param_Snapshot> next(new Param_Snapshot);
+    sender_name->getValue(next->sender_name);
+    lut_file->getValue(next->lut_file);
+    atlas_name->getValue(next->atlas_name);
+    file_output->getValue(next->file_output);
+    genlock_group->getValue(next->genlock_group);
+    color_space->getValue(next->color_space);
+    lag_fallback->getValue(next->lag_fallback);
+    output_format->getValue(next->output_format);
+    yuv_matrix->getValue(next->yuv_matrix);
+    yuv_range->getValue(next->yuv_range);
+    atlas_slot->getValue(next->atlas_slot);
+    file_format->getValue(next->file_format);
+    file_compression->getValue(next->file_compression);
+    file_queue->getValue(next->file_queue);
+    genlock_timeout->getValue(next->genlock_timeout);
+    skip_passthrough->getValue(next->skip_passthrough);
+    stream_rows->getValue(next->stream_rows);
+    frame_stats->getValue(next->frame_stats);
+    show_stats->getValue(next->show_stats);
+
+    next->file_prefix = next->sender_name;
+    for (auto& c : next->file_prefix) {
+      if (strchr("\\/:*?\"<>|", c)) {
+        c = '_';
+      }
+    }
+
+    std::lock_guard<std::mutex> lock(params_mutex);
+    param_current.store(next.get(), std::memory_order_release);
+    param_snapshots.push_back(std::move(next));
+    params_retired.store(param_snapshots.size() > 1, std::memory_order_release);
+  }
+
+  // The params one render or isIdentity call uses, loaded once when it starts. The snapshot stays valid until the
+  // reader leaves, whatever changedParam does meanwhile.
+  struct Param_Reader {
+    Spout_Plugin& plugin;
+    const Param_Snapshot& params;
+
+    explicit Param_Reader(Spout_Plugin& plugin) : plugin(plugin), params(plugin.acquire_params()) {}
+    ~Param_Reader() { plugin.release_params(); }
+  };
+
+  const Param_Snapshot& acquire_params() {
+    // Counted before the load, so a release that sees no readers can't free what we're about to load
+    params_readers.fetch_add(1);
+    return *param_current.load();
+  }
+
+  void release_params() {
+    if (params_readers.fetch_sub(1) != 1 || !params_retired.exchange(false)) {
+      return;
+    }
+
+    // update_params stores param_current under the mutex, so a reader that comes in now loads latest
+    std::lock_guard<std::mutex> lock(params_mutex);
+    if (params_readers.load() == 0) {
+      auto* latest = param_current.load();
+      param_snapshots.erase(std::remove_if(param_snapshots.begin(), param_snapshots.end(), [&](const std::unique_ptr<const Param_Snapshot>& snapshot) {
+        return snapshot.get() != latest;
+      }), param_snapshots.end());
+    }
+    params_retired.store(param_snapshots.size() > 1);
   }
 
-  void init_spout() {
+  void init_spout(const std::string& name) {
     if (!spout) {
       spout = std::unique_ptr<spoutDX>(new spoutDX);
-
-      std::string name;
-      sender_name->getValue(name);
       spout->SetSenderName(name.c_str());
     }
   }
@@ -172,73 +985,307 @@ public:
       cudaGraphicsUnregisterResource(cuda_out_tex);
       cuda_out_tex = 0;
     }
+    lut_cuda_release(lut_cuda);
+    reduce_cuda_release(reduce_cuda);
   }
 
-  virtual void render(const RenderArguments& args) {
-    if (!src_clip || !dst_clip) {
-      DEBUG_BREAK;
-      throwSuiteStatusException(kOfxStatErrBadHandle);
+  // Frees what is only needed while rendering. The sender stays registered so receivers keep it
+  // and the next render only has to recreate in_tex. Called with staging_mutex held.
+  void release_staging() {
+    if (cuda_in_tex) {
+      cudaGraphicsUnregisterResource(cuda_in_tex);
+      cuda_in_tex = 0;
     }
+    lut_cuda_release(lut_cuda);
+    release_reduce();
+
+    in_srv.Reset();
+    in_tex.Reset();
+    in_tex_desc = {};
+    in_tex_bytes = 0;
+
+    copier.reset();
+    yuv_converter.reset();
+    sink_processor.reset();
+    // Frames still being written are freed as they come back
+    file_sink.Trim();
+    staging_bytes = 0;
+  }
 
-    std::unique_ptr<Image> src(src_clip->fetchImage(args.time));
-    std::unique_ptr<Image> dst(dst_clip->fetchImage(args.time));
+  void release_reduce() {
+    reduce_cuda_release(reduce_cuda);
+    reducer.reset();
+    std::vector<float>().swap(lut_host);
+  }
 
-    auto depth = src->getPixelDepth();
-    auto components = src->getPixelComponents();
+  // Joins the atlas the options name, or leaves it when the name is cleared. Returns true if we send through one.
+  // Called with staging_mutex held.
+  bool update_atlas(const Param_Snapshot& params) {
+    auto& name = params.atlas_name;
+    auto slot = params.atlas_slot;
+    auto index = slot < 1 ? 0 : slot > ATLAS_MAX_SLOTS ? ATLAS_MAX_SLOTS - 1 : slot - 1;
 
-    if (depth != dst->getPixelDepth() || components != dst->getPixelComponents()) {
-      invalid_format();
+    if (atlas && (atlas->name != name || atlas_slot_index != index)) {
+      leave_atlas();
+    }
+    if (name.empty()) {
+      return false;
     }
 
-    auto src_bounds = src->getBounds();
-    auto dst_bounds = dst->getBounds();
-
-    auto src_width = src_bounds.x2 - src_bounds.x1;
-    auto src_height = src_bounds.y2 - src_bounds.y1;
+    if (!atlas) {
+      // Our own sender would show up next to the atlas
+      release_staging();
+      release_spout();
 
-    auto dst_width = dst_bounds.x2 - dst_bounds.x1;
-    auto dst_height = dst_bounds.y2 - dst_bounds.y1;
+      atlas = atlas_acquire(name);
+      atlas_slot_index = index;
+      std::lock_guard<std::mutex> lock(atlas->mutex);
+      ++atlas->members[index];
+    }
+    return true;
+  }
 
-    if (src_width != dst_width || src_height != dst_height) {
-      invalid_format();
+  void leave_atlas() {
+    if (atlas) {
+      std::lock_guard<std::mutex> lock(atlas->mutex);
+      --atlas->members[atlas_slot_index];
     }
+    atlas.reset();
+    atlas_slot_index = -1;
+  }
 
-    auto* src_px = src->getPixelData();
-    auto* dst_px = dst->getPixelData();
+  static void reclaim_idle_instances(Spout_Plugin* current) {
+    auto& registry = instance_registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
 
-    auto pixel_size_bytes = 0;
-    auto dx_format = DXGI_FORMAT_R8G8B8A8_UNORM;
-    if (depth == eBitDepthUByte) {
-      if (components == ePixelComponentRGBA) {
-        pixel_size_bytes = 4;
-        dx_format = DXGI_FORMAT_R8G8B8A8_UNORM;
-      }
-      else if (components == ePixelComponentRGB) {
-        invalid_format();
+    size_t total = 0;
+    for (auto* instance : registry.instances) {
+      total += instance->staging_bytes;
+    }
+    if (total <= registry.budget_bytes) {
+      return;
+    }
+
+    auto now = spoutHistogram::Now();
+    // Render times are copied out since other instances keep updating them while we sort
+    std::vector<std::pair<int64_t, Spout_Plugin*>> idle;
+    for (auto* instance : registry.instances) {
+      int64_t last_render = instance->last_render_ns;
+      if (instance != current && instance->staging_bytes > 0 && now - last_render > IDLE_RECLAIM_NS) {
+        idle.push_back(std::make_pair(last_render, instance));
       }
-      else if (components == ePixelComponentAlpha) {
-        pixel_size_bytes = 1;
-        dx_format = DXGI_FORMAT_R8_UNORM;
+    }
+    std::sort(idle.begin(), idle.end());
+
+    for (auto& entry : idle) {
+      auto* instance = entry.second;
+      if (total <= registry.budget_bytes) {
+        break;
       }
-      else {
-        invalid_format();
+
+      // Never wait on an instance here. If it's rendering it isn't idle anymore.
+      std::unique_lock<std::mutex> instance_lock(instance->staging_mutex, std::try_to_lock);
+      if (!instance_lock.owns_lock()) {
+        continue;
       }
+
+      size_t bytes = instance->staging_bytes;
+      instance->release_staging();
+      total -= bytes;
+
+      SpoutLogNotice("Spout_Plugin : reclaimed %zu KB of staging memory from an idle instance", bytes / 1024);
     }
-    else if (depth == eBitDepthUShort) {
-      if (components == ePixelComponentRGBA) {
-        pixel_size_bytes = 4 * 2;
-        dx_format = DXGI_FORMAT_R16G16B16A16_UNORM;
+  }
+
+  // Stat'ing the LUT file every frame is wasted work during playback, so we only look
+  // for edits every half second. A failed reload keeps the last good LUT so a file that's half way
+  // through being saved doesn't flash the wall.
+  bool update_lut(const Param_Snapshot& params) {
+    auto& path = params.lut_file;
+
+    if (path.empty()) {
+      lut.reset();
+      lut_path.clear();
+      return false;
+    }
+
+    auto now = spoutHistogram::Now();
+    if (path != lut_path || now - lut_checked > 500000000) {
+      std::string error;
+      auto next = lut_cache_get(path, error);
+      if (next || path != lut_path) {
+        lut = next;
       }
-      else if (components == ePixelComponentRGB) {
-        invalid_format();
+      if (!next) {
+        SpoutLogWarning("Spout_Plugin LUT : %s", error.c_str());
       }
-      else if (components == ePixelComponentAlpha) {
-        pixel_size_bytes = 2;
-        dx_format = DXGI_FORMAT_R16_UNORM;
+      lut_path = path;
+      lut_checked = now;
+    }
+
+    return lut != nullptr;
+  }
+
+  // Logs the warning the first time and shows it on the effect with the others still standing. Called with
+  // staging_mutex held.
+  void warn_render(int warning) {
+    if (render_warnings & warning) {
+      return;
+    }
+    render_warnings |= warning;
+
+    std::string message;
+    for (int i = 0; i < (int)(sizeof(render_warning_messages) / sizeof(render_warning_messages[0])); ++i) {
+      if (render_warnings & (1 << i)) {
+        message += message.empty() ? "" : " ";
+        message += render_warning_messages[i];
       }
     }
-    else if (depth == eBitDepthHalf) {
-      if (components == ePixelComponentRGBA) {
+    SpoutLogWarning("Spout_Plugin : %s", message.c_str());
+    setPersistentMessage(Message::eMessageWarning, "", message);
+  }
+
+  void clear_render_warnings() {
+    if (render_warnings) {
+      render_warnings = 0;
+      clearPersistentMessage();
+    }
+  }
+
+  // Receivers record the frame they last copied and we compare it to the one we last published.
+  // When the slowest one is behind we step down the ladder, at most one step per LAG_STEP_DOWN_NS, and step back
+  // up once they've kept up for LAG_RECOVER_NS. With no receivers the lag is 0 so we recover on our own.
+  int update_lag_level(const Param_Snapshot& params) {
+    auto max_level = params.lag_fallback;
+
+    uint64_t lag = 0;
+    int receivers = 0;
+    spout->frame.GetReceiverLag(&lag, &receivers);
+    lag_frames.store(lag, std::memory_order_relaxed);
+    lag_receivers.store(receivers, std::memory_order_relaxed);
+
+    auto level = lag_level.load(std::memory_order_relaxed);
+    auto next = level;
+    auto now = spoutHistogram::Now();
+
+    if (lag > LAG_BEHIND_FRAMES) {
+      lag_keeping_up_ns = 0;
+      if (next < max_level && now - lag_step_ns > LAG_STEP_DOWN_NS) {
+        ++next;
+      }
+    }
+    else {
+      if (lag_keeping_up_ns == 0) {
+        lag_keeping_up_ns = now;
+      }
+      if (next > LAG_LEVEL_FULL && now - lag_keeping_up_ns > LAG_RECOVER_NS && now - lag_step_ns > LAG_RECOVER_NS) {
+        --next;
+      }
+    }
+
+    // The option may have been lowered since we stepped down
+    if (next > max_level) {
+      next = max_level;
+    }
+
+    if (next != level) {
+      SpoutLogNotice("Spout_Plugin : receiver lag %llu frames, fallback %s", (unsigned long long)lag, lag_level_names[next]);
+
+      lag_step_ns = now;
+      lag_keeping_up_ns = 0;
+      lag_level.store(next, std::memory_order_relaxed);
+
+      if (next < LAG_LEVEL_HALF_RESOLUTION) {
+        release_reduce();
+      }
+    }
+
+    return next;
+  }
+
+  virtual void render(const RenderArguments& args) {
+    spoutHistogramTimer render_timer(render_times);
+    std::lock_guard<std::mutex> staging_lock(staging_mutex);
+
+    if (!src_clip || !dst_clip) {
+      DEBUG_BREAK;
+      throwSuiteStatusException(kOfxStatErrBadHandle);
+    }
+
+    Image_Release src_release{ src_image };
+    Image_Release dst_release{ dst_image };
+    if (!src_clip->fetchImage(args.time, src_image) || !dst_clip->fetchImage(args.time, dst_image)) {
+      throwSuiteStatusException(kOfxStatFailed);
+    }
+    auto* src = &src_image;
+    auto* dst = &dst_image;
+
+    if (src->getPixelDepth() != dst->getPixelDepth() || src->getPixelComponents() != dst->getPixelComponents()) {
+      invalid_format();
+    }
+
+    auto src_bounds = src->getBounds();
+    auto dst_bounds = dst->getBounds();
+
+    if (src_bounds.x2 - src_bounds.x1 != dst_bounds.x2 - dst_bounds.x1 || src_bounds.y2 - src_bounds.y1 != dst_bounds.y2 - dst_bounds.y1) {
+      invalid_format();
+    }
+
+    Send_Arguments send_args;
+    send_args.time = args.time;
+    send_args.renderScale = args.renderScale;
+    send_args.renderWindow = args.renderWindow;
+    send_args.pCudaStream = (cudaStream_t)args.pCudaStream;
+    Param_Reader params_reader(*this);
+    send_args.params = &params_reader.params;
+    send_frame(src, dst, send_args);
+  }
+
+  // Publishes src and copies it to dst for the timeline. dst is null when we publish from isIdentity,
+  // the host reuses src for the output then. Called with staging_mutex held.
+  void send_frame(Image* src, Image* dst, const Send_Arguments& args) {
+    auto depth = src->getPixelDepth();
+    auto components = src->getPixelComponents();
+
+    auto src_bounds = src->getBounds();
+    auto src_width = src_bounds.x2 - src_bounds.x1;
+    auto src_height = src_bounds.y2 - src_bounds.y1;
+
+    auto* src_px = src->getPixelData();
+
+    auto pixel_size_bytes = 0;
+    auto dx_format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    if (depth == eBitDepthUByte) {
+      if (components == ePixelComponentRGBA) {
+        pixel_size_bytes = 4;
+        dx_format = DXGI_FORMAT_R8G8B8A8_UNORM;
+      }
+      else if (components == ePixelComponentRGB) {
+        invalid_format();
+      }
+      else if (components == ePixelComponentAlpha) {
+        pixel_size_bytes = 1;
+        dx_format = DXGI_FORMAT_R8_UNORM;
+      }
+      else {
+        invalid_format();
+      }
+    }
+    else if (depth == eBitDepthUShort) {
+      if (components == ePixelComponentRGBA) {
+        pixel_size_bytes = 4 * 2;
+        dx_format = DXGI_FORMAT_R16G16B16A16_UNORM;
+      }
+      else if (components == ePixelComponentRGB) {
+        invalid_format();
+      }
+      else if (components == ePixelComponentAlpha) {
+        pixel_size_bytes = 2;
+        dx_format = DXGI_FORMAT_R16_UNORM;
+      }
+    }
+    else if (depth == eBitDepthHalf) {
+      if (components == ePixelComponentRGBA) {
         pixel_size_bytes = 4 * 2;
         dx_format = DXGI_FORMAT_R16G16B16A16_FLOAT;
       }
@@ -273,11 +1320,28 @@ public:
       invalid_format();
     }
 
-    auto stream = (cudaStream_t)args.pCudaStream;
+    auto& params = *args.params;
+
+    if (update_atlas(params)) {
+      // Tiles go out with the atlas, the genlock group shouldn't wait for us
+      genlock.leave();
+      // The atlas is one sender for every tile, there is no frame of ours to take stats of
+      if (params.frame_stats) {
+        warn_render(RENDER_WARNING_STATS_ATLAS);
+      }
+      send_atlas_frame(src, dst, args, pixel_size_bytes, dx_format);
+      return;
+    }
+
+    // Staged in publish_texture. Leaving with an empty name is a no-op when we aren't in a group.
+    genlock.timeout_ns = (int64_t)params.genlock_timeout * 1000000;
+    genlock.join(params.genlock_group);
+
+    auto stream = args.pCudaStream;
     auto use_cuda = stream != nullptr;
     auto started_using_cuda = use_cuda && !was_using_cuda;
 
-    init_spout();
+    init_spout(params.sender_name);
 
     if (!use_cuda && !copier) {
       copier = std::unique_ptr<Image_Copier>(new Image_Copier(*this));
@@ -289,15 +1353,61 @@ public:
       return;
     }
     
-    if(started_using_cuda || in_tex_desc.Format != dx_format || in_tex_desc.Width != src_width || in_tex_desc.Height != src_height) {
+    auto level = update_lag_level(params);
+
+    auto publish = true;
+    if (level >= LAG_LEVEL_SKIP_FRAMES) {
+      publish = !lag_skip_next;
+      lag_skip_next = !lag_skip_next;
+    }
+    else {
+      lag_skip_next = false;
+    }
+
+    auto float_rgba = depth == eBitDepthFloat && components == ePixelComponentRGBA;
+
+    // The YUV conversion is CPU only. GPU renders keep sending float RGBA so we don't pull the frame
+    // off the GPU just to convert it.
+    DWORD yuv_format = output_formats[params.output_format];
+    if (yuv_format && use_cuda) {
+      // On the effect too, receivers waiting for YUV would otherwise just see RGBA arrive
+      warn_render(RENDER_WARNING_YUV_GPU);
+      yuv_format = 0;
+    }
+    auto yuv = publish && yuv_format != 0 && float_rgba;
+
+    // What we send when receivers are behind, the timeline always gets the full frame.
+    // YUV is already smaller than float RGBA so only frame skipping applies to it.
+    auto reduce = publish && !yuv && level >= LAG_LEVEL_HALF_RESOLUTION && float_rgba;
+    auto reduce_half = reduce && level >= LAG_LEVEL_HALF_PRECISION;
+    auto send_width = reduce ? reduce_size(src_width) : src_width;
+    auto send_height = reduce ? reduce_size(src_height) : src_height;
+    auto send_format = reduce_half ? DXGI_FORMAT_R16G16B16A16_FLOAT : dx_format;
+    auto send_pixel_size_bytes = reduce ? reduce_pixel_bytes(reduce_half) : pixel_size_bytes;
+
+    if (yuv) {
+      unsigned int tex_width = 0;
+      unsigned int tex_height = 0;
+      spoutCopy::GetYUVTexture(yuv_format, src_width, src_height, send_format, tex_width, tex_height);
+      send_width = tex_width;
+      send_height = tex_height;
+      send_pixel_size_bytes = format_pixel_bytes(send_format);
+    }
+
+    if (publish && (started_using_cuda || in_tex_desc.Format != send_format || in_tex_desc.Width != send_width || in_tex_desc.Height != send_height)) {
 
       HRESULT hr = S_OK;
       {
-        in_tex_desc.Width = src_width;
-        in_tex_desc.Height = src_height;
+        if (cuda_in_tex) {
+          cudaGraphicsUnregisterResource(cuda_in_tex);
+          cuda_in_tex = 0;
+        }
+
+        in_tex_desc.Width = send_width;
+        in_tex_desc.Height = send_height;
         in_tex_desc.MipLevels = 1;
         in_tex_desc.ArraySize = 1;
-        in_tex_desc.Format = dx_format;
+        in_tex_desc.Format = send_format;
         in_tex_desc.SampleDesc.Count = 1;
         in_tex_desc.Usage = D3D11_USAGE_DEFAULT;
         in_tex_desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
@@ -317,27 +1427,230 @@ public:
           auto result = cudaGraphicsD3D11RegisterResource(&cuda_in_tex, in_tex.Get(), cudaGraphicsRegisterFlagsNone);
           check_cuda_error(result);
         }
+
+        in_tex_bytes = (size_t)send_width * send_height * send_pixel_size_bytes;
+      }
+    }
+
+    // The frame stats are taken in the copy that reads what we send: the LUT's, the YUV conversion's, the
+    // reduction's or the texture sink's. GPU renders never pass through one, they warn instead.
+    auto stats = publish && params.frame_stats && !use_cuda && components == ePixelComponentRGBA
+      && (depth == eBitDepthFloat || depth == eBitDepthUByte);
+    if (stats) {
+      stats_accumulator.begin(src_width, src_height, depth == eBitDepthFloat ? FRAME_STATS_FLOAT : FRAME_STATS_BYTE, args.time);
+    }
+    if (publish && params.frame_stats && use_cuda) {
+      warn_render(RENDER_WARNING_STATS_GPU);
+    }
+
+    // With a LUT the passthrough copy also writes the LUT output to in_tex, so the source is
+    // read once and the timeline still gets the untouched frame. Done before taking the sender mutex so
+    // receivers only wait for the texture copy.
+    auto lut_active = publish && float_rgba && update_lut(params);
+    if (lut_active) {
+      spoutHistogramTimer passthrough_timer(passthrough_times);
+
+      if (use_cuda) {
+        auto pitch = src_width * pixel_size_bytes;
+        auto result = lut_cuda_apply(lut_cuda, lut, src_px, pitch, dst->getPixelData(), pitch, src_width, src_height, stream);
+        check_cuda_error(result);
+      }
+      else if (reduce || yuv) {
+        // The LUT output is reduced or converted below, so it goes to memory we can read back
+        lut_host.resize((size_t)src_width * src_height * 4);
+
+        copier->setDstImg(dst);
+        copier->src_img = src;
+        copier->pixel_stride = pixel_size_bytes;
+        copier->lut = lut.get();
+        copier->lut_dst = (char*)lut_host.data();
+        copier->lut_pitch = (size_t)src_width * pixel_size_bytes;
+        copier->lut_x0 = src_bounds.x1;
+        copier->lut_y0 = src_bounds.y1;
+        copier->stats = stats ? &stats_accumulator : nullptr;
+        copier->setRenderWindow(src_bounds);
+        copier->process();
+      }
+      else {
+        D3D11_MAPPED_SUBRESOURCE mapped = {};
+        auto hr = spout->m_pImmediateContext->Map(in_tex.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped);
+        check_d3d11_error(hr);
+
+        copier->setDstImg(dst);
+        copier->src_img = src;
+        copier->pixel_stride = pixel_size_bytes;
+        copier->lut = lut.get();
+        copier->lut_dst = (char*)mapped.pData;
+        copier->lut_pitch = mapped.RowPitch;
+        copier->lut_x0 = src_bounds.x1;
+        copier->lut_y0 = src_bounds.y1;
+        copier->stats = stats ? &stats_accumulator : nullptr;
+        copier->setRenderWindow(src_bounds);
+        copier->process();
+
+        spout->m_pImmediateContext->Unmap(in_tex.Get(), 0);
+      }
+    }
+
+    // The reduced frame is made from whatever we would have sent, so the LUT output if there is one.
+    // Like the LUT this happens before taking the sender mutex.
+    if (reduce) {
+      const void* reduce_src = src_px;
+      size_t reduce_pitch = (size_t)src_width * pixel_size_bytes;
+      if (lut_active && use_cuda) {
+        reduce_src = lut_cuda.scratch;
+        reduce_pitch = lut_cuda.scratch_pitch;
+      }
+      else if (lut_active) {
+        reduce_src = lut_host.data();
+      }
+
+      if (use_cuda) {
+        auto result = reduce_cuda_apply(reduce_cuda, reduce_src, reduce_pitch, src_width, src_height, reduce_half, stream);
+        check_cuda_error(result);
+      }
+      else {
+        if (!reducer) {
+          reducer = std::unique_ptr<Frame_Reducer>(new Frame_Reducer(*this));
+        }
+
+        D3D11_MAPPED_SUBRESOURCE mapped = {};
+        auto hr = spout->m_pImmediateContext->Map(in_tex.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped);
+        check_d3d11_error(hr);
+
+        reducer->src = (const char*)reduce_src;
+        reducer->src_pitch = reduce_pitch;
+        reducer->src_width = src_width;
+        reducer->src_height = src_height;
+        reducer->dst = (char*)mapped.pData;
+        reducer->dst_pitch = mapped.RowPitch;
+        reducer->half = reduce_half;
+        // The LUT took them already
+        reducer->stats = stats && !lut_active ? &stats_accumulator : nullptr;
+        OfxRectI window = { 0, 0, send_width, send_height };
+        reducer->setRenderWindow(window);
+        reducer->process();
+
+        spout->m_pImmediateContext->Unmap(in_tex.Get(), 0);
       }
     }
 
+    if (yuv) {
+      spoutHistogramTimer passthrough_timer(passthrough_times);
 
-    // NOTE(valuef): Modified spout.SendImage
-    // 2025-06-12
+      if (!yuv_converter) {
+        yuv_converter = std::unique_ptr<Yuv_Converter>(new Yuv_Converter(*this));
+      }
+
+      auto matrix = params.yuv_matrix;
+      auto range = params.yuv_range;
+
+      D3D11_MAPPED_SUBRESOURCE mapped = {};
+      auto hr = spout->m_pImmediateContext->Map(in_tex.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped);
+      check_d3d11_error(hr);
+
+      auto rows_per_step = (yuv_format == SPOUT_YUV_NV12 || yuv_format == SPOUT_YUV_P010) ? 2u : 1u;
+
+      // With a LUT the passthrough copy was done with the LUT, we convert its output
+      yuv_converter->setDstImg(lut_active ? nullptr : dst);
+      yuv_converter->copy = &spout->spoutcopy;
+      yuv_converter->src = lut_active ? (const char*)lut_host.data() : (const char*)src_px;
+      yuv_converter->src_pitch = src_width * pixel_size_bytes;
+      yuv_converter->width = src_width;
+      yuv_converter->height = src_height;
+      yuv_converter->yuv_dst = (char*)mapped.pData;
+      yuv_converter->yuv_pitch = mapped.RowPitch;
+      yuv_converter->format = yuv_format;
+      yuv_converter->bt2020 = matrix == 1;
+      yuv_converter->full_range = range == 1;
+      yuv_converter->rows_per_step = rows_per_step;
+      yuv_converter->stats = stats && !lut_active ? &stats_accumulator : nullptr;
+      OfxRectI window = { 0, 0, 1, (int)((src_height + rows_per_step - 1) / rows_per_step) };
+      yuv_converter->setRenderWindow(window);
+      yuv_converter->process();
+
+      spout->m_pImmediateContext->Unmap(in_tex.Get(), 0);
+    }
+
+    // The LUT, YUV and CUDA paths did their own passthrough copy, everything else goes through the dispatcher.
+    // It carries the frame as we send it, so the texture and the row stream ring only join when it isn't reduced.
+    auto dispatched = !use_cuda && !lut_active && !yuv;
+    auto texture_dispatched = dispatched && publish && !reduce;
+    auto file_output = publish && prepare_file_output(src, params);
+
+    // The frame metadata, stamped when the copy starts so receivers can see how far behind they are
+    char header[SPOUT_FRAME_HEADER_BYTES] = {};
     {
-      spout->SetSenderFormat(dx_format);
+      SpoutFrameMetadata metadata = {};
+      metadata.timestamp = spoutHistogram::Now();
+      metadata.time = args.time;
+      metadata.renderScaleX = args.renderScale.x;
+      metadata.renderScaleY = args.renderScale.y;
+      metadata.colorspace = (uint32_t)params.color_space;
+      metadata.format = yuv ? yuv_format : send_format;
+      metadata.width = yuv ? src_width : send_width;
+      metadata.height = yuv ? src_height : send_height;
+      memcpy(header, &metadata, sizeof(metadata));
+    }
 
-      if(!spout->CheckSender(src_width, src_height, dx_format)) {
-        spout->SpoutMessageBox("checksender failed");
-        throwSuiteStatusException(kOfxStatErrImageFormat);
-        return;
+    if (dispatched) {
+      dispatcher.clear();
+
+      passthrough_sink.dst = dst;
+      passthrough_sink.src_bounds = src_bounds;
+      passthrough_sink.window = args.renderWindow;
+      dispatcher.add(&passthrough_sink);
+
+      if (texture_dispatched && params.stream_rows && !spout->GetMemoryShareMode()) {
+        ring_sink.buffer = &spout->sharedbuffer;
+        ring_sink.name = params.sender_name;
+        dispatcher.add(&ring_sink);
       }
 
-      // Check the sender mutex for access the shared texture
-      if (spout->frame.CheckTextureAccess(spout->m_pSharedTexture)) {
+      if (file_output) {
+        dispatcher.add(&file_output_sink);
+      }
 
-        auto pitch = src_width * pixel_size_bytes;
+      // Last, publishing it can throw when the sender can't be created
+      if (texture_dispatched) {
+        texture_sink.plugin = this;
+        texture_sink.context = spout->m_pImmediateContext;
+        texture_sink.tex = in_tex.Get();
+        texture_sink.stats = stats ? &stats_accumulator : nullptr;
+        dispatcher.add(&texture_sink);
+      }
+
+      Output_Frame frame;
+      frame.width = src_width;
+      frame.height = src_height;
+      frame.pixel_bytes = pixel_size_bytes;
+      frame.format = dx_format;
+      frame.time = args.time;
+      frame.header = header;
+      frame.header_bytes = sizeof(header);
 
+      {
+        spoutHistogramTimer passthrough_timer(passthrough_times);
+        if (dispatcher.begin(frame, (const char*)src_px, (size_t)src_width * pixel_size_bytes) > 0) {
+          run_dispatcher(src_bounds);
+        }
+      }
+
+      // The texture sink publishes here
+      spoutHistogramTimer publish_timer(publish_times);
+      dispatcher.finish();
+    }
+
+    if (publish && !texture_dispatched) {
+      spoutHistogramTimer publish_timer(publish_times);
+
+      SpoutFrameMetadata metadata;
+      memcpy(&metadata, header, sizeof(metadata));
+
+      publish_texture(send_width, send_height, send_format, yuv ? yuv_format : 0, metadata, stats ? stats_accumulator.finish() : nullptr, [&]() {
         if (use_cuda) {
+          auto pitch = send_width * send_pixel_size_bytes;
+
           auto result = cudaGraphicsMapResources(1, &cuda_in_tex, stream);
           check_cuda_error(result);
 
@@ -345,77 +1658,610 @@ public:
           result = cudaGraphicsSubResourceGetMappedArray(&cuda_array, cuda_in_tex, 0, 0);
           check_cuda_error(result);
 
-          result = cudaMemcpy2DToArrayAsync(cuda_array, 0, 0, src_px, pitch, pitch, src_height, cudaMemcpyDeviceToDevice, stream);
+          if (reduce) {
+            result = cudaMemcpy2DToArrayAsync(cuda_array, 0, 0, reduce_cuda.scratch, reduce_cuda.scratch_pitch, pitch, send_height, cudaMemcpyDeviceToDevice, stream);
+          }
+          else if (lut_active) {
+            result = cudaMemcpy2DToArrayAsync(cuda_array, 0, 0, lut_cuda.scratch, lut_cuda.scratch_pitch, pitch, src_height, cudaMemcpyDeviceToDevice, stream);
+          }
+          else {
+            result = cudaMemcpy2DToArrayAsync(cuda_array, 0, 0, src_px, pitch, pitch, src_height, cudaMemcpyDeviceToDevice, stream);
+          }
           check_cuda_error(result);
 
           result = cudaGraphicsUnmapResources(1, &cuda_in_tex, stream);
           check_cuda_error(result);
-
-          spout->m_pImmediateContext->CopySubresourceRegion(spout->m_pSharedTexture, 0, 0, 0, 0, in_tex.Get(), 0, 0);
-        }
-        else {
-          // TODO : crashes when going from GPU -> CPU mode
-          // 
-          // Update the shared texture resource with the pixel buffer
-          spout->m_pImmediateContext->UpdateSubresource(spout->m_pSharedTexture, 0, NULL, src_px, pitch, 0);
         }
 
-        // Flush the command queue because the shared texture has been updated on this device
-        spout->m_pImmediateContext->Flush();
-        // Signal a new frame while the mutex is locked
-        spout->frame.SetNewFrame();
-        // Allow access to the shared texture
-        spout->frame.AllowTextureAccess(spout->m_pSharedTexture);
+        // The LUT, the reduction or the YUV conversion wrote in_tex
+        spout->m_pImmediateContext->CopySubresourceRegion(spout->m_pSharedTexture, 0, 0, 0, 0, in_tex.Get(), 0, 0);
+      });
+    }
+
+    if (use_cuda && dst && !lut_active) {
+      spoutHistogramTimer passthrough_timer(passthrough_times);
+
+      auto pitch = src_width * pixel_size_bytes;
+      auto result = cudaMemcpy2DAsync(dst->getPixelData(), pitch, src_px, pitch, pitch, src_height, cudaMemcpyDeviceToDevice, stream);
+      check_cuda_error(result);
+    }
+
+    if (file_output && !dispatched) {
+      send_file_frame(src, args);
+    }
+
+    // A skipped frame didn't create in_tex, so it still has to be registered with CUDA on the next one
+    if (use_cuda && publish) {
+      was_using_cuda = true;
+    }
+
+    {
+      size_t bytes = in_tex_bytes + lut_host.size() * sizeof(float);
+      if (lut_cuda.scratch) {
+        bytes += lut_cuda.scratch_pitch * lut_cuda.scratch_height;
       }
+      if (reduce_cuda.scratch) {
+        bytes += reduce_cuda.scratch_pitch * reduce_cuda.scratch_height;
+      }
+      if (ring_sink.length() > 0) {
+        bytes += (size_t)ring_sink.length() * 3;
+      }
+      bytes += file_sink.PoolBytes();
+      staging_bytes = bytes;
+      last_render_ns = spoutHistogram::Now();
     }
 
-    if (use_cuda) {
-      auto pitch = dst_width * pixel_size_bytes;
-      auto result = cudaMemcpy2DAsync(dst_px, pitch, src_px, pitch, pitch, dst_height, cudaMemcpyDeviceToDevice, stream);
+    reclaim_idle_instances(this);
+  }
+
+  // Hands the bands of the frame begun on the dispatcher to the host's threads. Called with staging_mutex held.
+  void run_dispatcher(const OfxRectI& bounds) {
+    if (!sink_processor) {
+      sink_processor = std::unique_ptr<Sink_Processor>(new Sink_Processor(*this));
+    }
+    sink_processor->dispatcher = &dispatcher;
+    sink_processor->setRenderWindow(bounds);
+    sink_processor->process();
+  }
+
+  // NOTE(valuef): Modified spout.SendImage
+  // 2025-06-12
+  template <typename Upload>
+  bool publish_texture(unsigned int width, unsigned int height, DXGI_FORMAT format, DWORD format_code, SpoutFrameMetadata metadata, const Frame_Stats* stats, Upload upload) {
+    // upload fills the shared texture while we hold the sender mutex. Returns false if a receiver held the mutex
+    // and the frame was skipped. stats, when given, go out with the frame's sequence. In a genlock group we wait
+    // for the other members before taking the mutex.
+    spout->SetSenderFormat(format);
+    spout->SetSenderFormatCode(format_code);
+
+    if (!spout->CheckSender(width, height, format)) {
+      spout->SpoutMessageBox("checksender failed");
+      throwSuiteStatusException(kOfxStatErrImageFormat);
+      return false;
+    }
+
+    if (genlock.joined()) {
+      metadata.genlockGeneration = (uint32_t)genlock.stage(metadata.time);
+    }
+
+    // Check the sender mutex for access the shared texture
+    if (!spout->frame.CheckTextureAccess(spout->m_pSharedTexture)) {
+      frames_skipped.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+
+    upload();
+
+    // Flush the command queue because the shared texture has been updated on this device
+    spout->m_pImmediateContext->Flush();
+
+    // Publish the timeline position of this frame while the mutex is locked so receivers
+    // that copy under the same lock get the matching record.
+    spout->frame.WriteFrameMetadata(&metadata);
+
+    // The metadata now holds the sequence of the frame, a receiver matches the stats to the frame it copied with it
+    if (stats) {
+      auto record = *stats;
+      record.sequence = metadata.sequence;
+      frame_stats_map.write(spout->GetName(), record);
+    }
+
+    // Signal a new frame while the mutex is locked
+    spout->frame.SetNewFrame();
+    // Allow access to the shared texture
+    spout->frame.AllowTextureAccess(spout->m_pSharedTexture);
+
+    published_name.store(spout->GetName());
+    count_published_frame();
+    return true;
+  }
+
+  // Reads the file output params into the file sink. False when file output is off or the frame isn't float RGBA.
+  // Called with staging_mutex held.
+  bool prepare_file_output(Image* src, const Param_Snapshot& params) {
+    auto& config = file_output_sink.config;
+    config.directory = params.file_output;
+    if (config.directory.empty()) {
+      return false;
+    }
+
+    if (src->getPixelDepth() != eBitDepthFloat || src->getPixelComponents() != ePixelComponentRGBA) {
+      if (!file_format_logged) {
+        SpoutLogWarning("Spout_Plugin : file output needs float RGBA, not writing");
+        file_format_logged = true;
+      }
+      return false;
+    }
+
+    config.encoder = params.file_format;
+    config.compression = params.file_compression;
+    config.policy = params.file_queue;
+    config.prefix = params.file_prefix;
+    return true;
+  }
+
+  // Writes src to the file output on its own, for the paths whose copies don't go through the dispatcher with it.
+  // CUDA frames are downloaded here, everything after the copy happens on the file sink workers.
+  // Called with staging_mutex held after prepare_file_output.
+  void send_file_frame(Image* src, const Send_Arguments& args) {
+    auto bounds = src->getBounds();
+
+    Output_Frame frame;
+    frame.width = bounds.x2 - bounds.x1;
+    frame.height = bounds.y2 - bounds.y1;
+    frame.pixel_bytes = 4 * sizeof(float);
+    frame.format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+    frame.time = args.time;
+    auto pitch = (size_t)frame.width * frame.pixel_bytes;
+
+    if (args.pCudaStream) {
+      if (!file_output_sink.prepare(frame)) {
+        return;
+      }
+      auto* file_frame = file_output_sink.frame();
+      auto result = cudaMemcpy2DAsync(file_frame->data(), pitch, src->getPixelData(), pitch, pitch, frame.height, cudaMemcpyDeviceToHost, args.pCudaStream);
+      check_cuda_error(result);
+      result = cudaStreamSynchronize(args.pCudaStream);
       check_cuda_error(result);
+      file_output_sink.publish();
+      return;
     }
-    else {
-      copier->setDstImg(dst.get());
-      copier->src_img = src.get();
-      copier->pixel_stride = pixel_size_bytes;
-      copier->setRenderWindow(args.renderWindow);
-      copier->process();
+
+    dispatcher.clear();
+    dispatcher.add(&file_output_sink);
+    if (dispatcher.begin(frame, (const char*)src->getPixelData(), pitch) > 0) {
+      run_dispatcher(bounds);
+    }
+    dispatcher.finish();
+  }
+
+  // Our tile goes straight into the atlas canvas while we hold its mutex, so a tile for the next
+  // timeline time can't land on a canvas that hasn't gone out yet. The LUT still applies. Reduction, YUV and the
+  // lag fallback are per sender and don't apply to a tile.
+  void send_atlas_frame(Image* src, Image* dst, const Send_Arguments& args, int pixel_size_bytes, DXGI_FORMAT dx_format) {
+    auto src_bounds = src->getBounds();
+    auto src_width = src_bounds.x2 - src_bounds.x1;
+    auto src_height = src_bounds.y2 - src_bounds.y1;
+    auto* src_px = src->getPixelData();
+    auto row_bytes = (size_t)src_width * pixel_size_bytes;
+
+    auto stream = args.pCudaStream;
+    auto use_cuda = stream != nullptr;
+
+    if (!use_cuda && !copier) {
+      copier = std::unique_ptr<Image_Copier>(new Image_Copier(*this));
+    }
+
+    auto float_rgba = src->getPixelDepth() == eBitDepthFloat && src->getPixelComponents() == ePixelComponentRGBA;
+    auto lut_active = float_rgba && update_lut(*args.params);
+    if (lut_active && use_cuda) {
+      auto result = lut_cuda_apply(lut_cuda, lut, src_px, row_bytes, dst->getPixelData(), row_bytes, src_width, src_height, stream);
+      check_cuda_error(result);
+    }
+
+    auto color_space_index = args.params->color_space;
+
+    {
+      spoutHistogramTimer publish_timer(publish_times);
+      std::lock_guard<std::mutex> lock(atlas->mutex);
+
+      if (atlas->begin_tile(args.time, dx_format, pixel_size_bytes, src_width, src_height)) {
+        count_published_frame();
+      }
+
+      auto* tile = atlas->tile(atlas_slot_index);
+      auto pitch = atlas->pitch();
+
+      if (use_cuda) {
+        const void* tile_src = lut_active ? lut_cuda.scratch : src_px;
+        auto tile_src_pitch = lut_active ? lut_cuda.scratch_pitch : row_bytes;
+        auto result = cudaMemcpy2DAsync(tile, pitch, tile_src, tile_src_pitch, row_bytes, src_height, cudaMemcpyDeviceToHost, stream);
+        check_cuda_error(result);
+        result = cudaStreamSynchronize(stream);
+        check_cuda_error(result);
+      }
+      else if (lut_active) {
+        // The passthrough copy is done with the LUT
+        copier->setDstImg(dst);
+        copier->src_img = src;
+        copier->pixel_stride = pixel_size_bytes;
+        copier->lut = lut.get();
+        copier->lut_dst = tile;
+        copier->lut_pitch = pitch;
+        copier->lut_x0 = src_bounds.x1;
+        copier->lut_y0 = src_bounds.y1;
+        copier->stats = nullptr;
+        copier->setRenderWindow(src_bounds);
+        copier->process();
+      }
+      else {
+        for (int y = 0; y < src_height; ++y) {
+          memcpy(tile + y * pitch, (const char*)src_px + y * row_bytes, row_bytes);
+        }
+      }
+
+      auto now = spoutHistogram::Now();
+      atlas->written |= 1u << atlas_slot_index;
+      atlas->tile_written_ns[atlas_slot_index] = now;
+      atlas->render_scale = args.renderScale;
+      atlas->color_space = (uint32_t)color_space_index;
+
+      if (atlas->complete(now) && atlas->publish()) {
+        published_name.store(atlas->spout->GetName());
+        count_published_frame();
+      }
+    }
+
+    if (!lut_active && dst) {
+      spoutHistogramTimer passthrough_timer(passthrough_times);
+
+      if (use_cuda) {
+        auto result = cudaMemcpy2DAsync(dst->getPixelData(), row_bytes, src_px, row_bytes, row_bytes, src_height, cudaMemcpyDeviceToDevice, stream);
+        check_cuda_error(result);
+      }
+      else {
+        copier->setDstImg(dst);
+        copier->src_img = src;
+        copier->pixel_stride = pixel_size_bytes;
+        copier->lut = nullptr;
+        copier->stats = nullptr;
+        copier->setRenderWindow(args.renderWindow);
+        copier->process();
+      }
+    }
+
+    if (prepare_file_output(src, *args.params)) {
+      send_file_frame(src, args);
     }
 
     if (use_cuda) {
       was_using_cuda = true;
     }
+
+    // The canvas belongs to the atlas, only the LUT scratch and the file output buffers are ours
+    staging_bytes = (lut_cuda.scratch ? lut_cuda.scratch_pitch * lut_cuda.scratch_height : 0) + file_sink.PoolBytes();
+    last_render_ns = spoutHistogram::Now();
+
+    reclaim_idle_instances(this);
   }
 
+  void count_published_frame() {
+    frames_published.fetch_add(1, std::memory_order_relaxed);
 
-  virtual bool isIdentity(IsIdentityArguments& args, Clip*& clip, double& time) {
-    return false;
+    auto now = spoutHistogram::Now();
+    auto previous = last_publish_ns.exchange(now, std::memory_order_relaxed);
+    auto interval = now - previous;
+
+    // Anything over a second is a pause or a scrub, not a slow frame
+    if (previous == 0 || interval > 1000000000LL) {
+      return;
+    }
+
+    publish_intervals.Record(interval);
+
+    auto avg = publish_interval_avg_ns.load(std::memory_order_relaxed);
+    avg = avg == 0 ? interval : avg + (interval - avg) / 16;
+    publish_interval_avg_ns.store(avg, std::memory_order_relaxed);
+
+    // A frame took more than one and a half frame periods, so at least one was dropped along the way
+    auto fps = getFrameRate();
+    if (fps > 0.0 && interval > (int64_t)(1.5e9 / fps)) {
+      frames_dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  // The effect never changes the image so the passthrough copy is pure bandwidth. With Skip Passthrough Copy
+  // we publish here and tell the host to use the source as the output, so render isn't called at all.
+  // isIdentity has no CUDA stream and fetching the source here would cost a download from the GPU, so once we've seen
+  // a CUDA render we leave it to render. If the host won't give us an image here we also fall back to render.
+  virtual bool isIdentity(const IsIdentityArguments& args, Clip*& clip, double& time) override {
+    if (!src_clip) {
+      return false;
+    }
+
+    std::lock_guard<std::mutex> staging_lock(staging_mutex);
+    Param_Reader params_reader(*this);
+    auto& params = params_reader.params;
+    if (!params.skip_passthrough) {
+      return false;
+    }
+
+    spoutHistogramTimer render_timer(render_times);
+
+    if (identity_unsupported || was_using_cuda) {
+      return false;
+    }
+
+    Image_Release src_release{ src_image };
+    auto fetched = false;
+    try {
+      fetched = src_clip->fetchImage(args.time, src_image);
+    }
+    catch (...) {
+    }
+
+    auto* src = &src_image;
+    if (!fetched || !src->getPixelData()) {
+      SpoutLogWarning("Spout_Plugin : no source image in isIdentity, using the passthrough copy");
+      identity_unsupported = true;
+      return false;
+    }
+
+    Send_Arguments send_args;
+    send_args.time = args.time;
+    send_args.renderScale = args.renderScale;
+    send_args.renderWindow = args.renderWindow;
+    send_args.pCudaStream = nullptr;
+    send_args.params = &params;
+
+    // render reports the error if the frame can't be sent
+    try {
+      send_frame(src, nullptr, send_args);
+    }
+    catch (...) {
+      return false;
+    }
+
+    clip = src_clip;
+    time = args.time;
+    return true;
   }
 
   virtual void getClipPreferences(ClipPreferencesSetter& pref) override {
     pref.setClipComponents(*src_clip, ePixelComponentRGBA);
     pref.setClipComponents(*dst_clip, ePixelComponentRGBA);
-    pref.setClipBitDepth(*src_clip, eBitDepthUByte);
-    pref.setClipBitDepth(*dst_clip, eBitDepthUByte);
+    // Float is the only depth describe offers. The LUT, YUV, reduced resolution and file outputs need float RGBA
+    // and check for it per frame in case a host hands us something else anyway.
+    pref.setClipBitDepth(*src_clip, eBitDepthFloat);
+    pref.setClipBitDepth(*dst_clip, eBitDepthFloat);
   }
 
   virtual void changedParam(const InstanceChangedArgs& args, const std::string& param_name) override {
+    update_params();
+
     if (param_name == PARAM_SPOUT_SENDER_NAME) {
-      // NOTE(valuef): SetSenderName does not update the name of the sender. It's set and then it's constant.
-      // So we need to re-create the spout sender to update the name.
-      // 2025-06-12
-      release_spout();
-      init_spout();
+      // RenameSender moves the sender to the new name and keeps the device and textures, so renaming
+      // during a show doesn't stall. Re-creating the sender is the fallback.
+      std::string name;
+      sender_name->getValue(name);
+
+      std::lock_guard<std::mutex> staging_lock(staging_mutex);
+      if (!spout || !spout->RenameSender(name.c_str())) {
+        // in_tex belongs to the device we release
+        release_staging();
+        release_spout();
+        init_spout(name);
+      }
+      else {
+        // The row stream ring is named after the sender, the next streamed frame creates it under the new name
+        spout->CloseSharedBuffer();
+        ring_sink.reset();
+        frame_stats_map.close();
+      }
+    }
+    else if (param_name == PARAM_LUT_FILE) {
+      std::string path;
+      lut_file->getValue(path);
+
+      std::string error;
+      if (!path.empty() && !lut_cache_get(path, error)) {
+        setPersistentMessage(Message::eMessageError, "", error);
+      }
+      else {
+        clearPersistentMessage();
+      }
+      // update_lut picks up the new path on the next render, render owns lut_path
+    }
+    else if (param_name == PARAM_SKIP_PASSTHROUGH) {
+      std::lock_guard<std::mutex> staging_lock(staging_mutex);
+      identity_unsupported = false;
+    }
+    else if (param_name == PARAM_OUTPUT_FORMAT || param_name == PARAM_FRAME_STATS || param_name == PARAM_ATLAS_NAME) {
+      // The next render warns again about what still applies
+      std::lock_guard<std::mutex> staging_lock(staging_mutex);
+      clear_render_warnings();
+    }
+  }
+};
+
+bool Texture_Sink::prepare(const Output_Frame& frame_in) {
+  frame = frame_in;
+  // Left mapped when a render threw before publishing
+  if (mapped.pData) {
+    context->Unmap(tex, 0);
+    mapped = {};
+  }
+
+  auto hr = context->Map(tex, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped);
+  if (FAILED(hr)) {
+    mapped = {};
+    count_skipped();
+    return false;
+  }
+  return true;
+}
+
+void Texture_Sink::write_band(const char* src, size_t pitch, int y_begin, int y_end) {
+  auto row_bytes = frame.row_bytes();
+  auto* dst = (char*)mapped.pData + (size_t)y_begin * mapped.RowPitch;
+  // Each band is handed out once, so it is a part of its own
+  if (stats) {
+    stats->copy_rows(src, pitch, dst, mapped.RowPitch, frame.width, y_end - y_begin, stats->part(y_begin));
+    return;
+  }
+  for (auto y = y_begin; y < y_end; ++y) {
+    memcpy(dst, src, row_bytes);
+    src += pitch;
+    dst += mapped.RowPitch;
+  }
+}
+
+bool Texture_Sink::publish() {
+  context->Unmap(tex, 0);
+  mapped = {};
+
+  SpoutFrameMetadata metadata = {};
+  if (frame.header_bytes >= sizeof(metadata)) {
+    memcpy(&metadata, frame.header, sizeof(metadata));
+  }
+
+  auto* spout = plugin->spout.get();
+  auto sent = plugin->publish_texture(frame.width, frame.height, (DXGI_FORMAT)frame.format, 0, metadata, stats ? stats->finish() : nullptr, [&]() {
+    spout->m_pImmediateContext->CopySubresourceRegion(spout->m_pSharedTexture, 0, 0, 0, 0, tex, 0, 0);
+  });
+
+  if (sent) {
+    count_published((uint64_t)frame.row_bytes() * frame.height);
+  }
+  else {
+    count_skipped();
+  }
+  return sent;
+}
+
+class Stats_Overlay : public OverlayInteract {
+public:
+  Spout_Plugin* plugin;
+  // Stays open between draws and is opened again when the group changes. read retries a group not created yet.
+  Genlock_Group genlock_reader;
+
+  Stats_Overlay(OfxInteractHandle handle, ImageEffect* effect) : OverlayInteract(handle) {
+    plugin = (Spout_Plugin*)effect;
+    addParamToSlaveTo(plugin->show_stats);
+  }
+
+  virtual bool draw(const DrawArgs& args) override {
+    auto* draw_suite = OFX::Private::gDrawSuite;
+    if (!draw_suite || !args.context) return false;
+
+    // The same snapshot the render reads, so drawing makes no host calls
+    Spout_Plugin::Param_Reader params_reader(*plugin);
+    auto& params = params_reader.params;
+    if (!params.show_stats) return false;
+
+    // Receivers see the registered name, the param until the first frame is sent
+    char name[Published_Name::capacity];
+    plugin->published_name.load(name);
+    auto sent = name[0] != 0;
+    if (!sent) {
+      snprintf(name, sizeof(name), "%s", (params.atlas_name.empty() ? params.sender_name : params.atlas_name).c_str());
+    }
+
+    spoutHistogramSnapshot intervals;
+    plugin->publish_intervals.Snapshot(intervals);
+
+    spoutHistogramSnapshot uploads;
+    plugin->publish_times.Snapshot(uploads);
+
+    auto avg = plugin->publish_interval_avg_ns.load(std::memory_order_relaxed);
+
+    char lines[8][256];
+    auto line_count = 6;
+    if (params.atlas_name.empty()) {
+      snprintf(lines[0], sizeof(lines[0]), "Spout: %s%s", name, sent ? "" : ", not sent yet");
+    }
+    else {
+      // Tiles go out under the atlas name
+      snprintf(lines[0], sizeof(lines[0]), "Spout: %s, tile %d%s", name, params.atlas_slot, sent ? "" : ", not sent yet");
+    }
+    snprintf(lines[1], sizeof(lines[1]), "Publish: %.2f fps, %llu frames",
+             avg > 0 ? 1e9 / (double)avg : 0.0,
+             (unsigned long long)plugin->frames_published.load(std::memory_order_relaxed));
+    snprintf(lines[2], sizeof(lines[2]), "Frame interval p99: %.2f ms", (double)intervals.Percentile(99.0) / 1e6);
+    snprintf(lines[3], sizeof(lines[3]), "Dropped: %llu  Skipped: %llu",
+             (unsigned long long)plugin->frames_dropped.load(std::memory_order_relaxed),
+             (unsigned long long)plugin->frames_skipped.load(std::memory_order_relaxed));
+    snprintf(lines[4], sizeof(lines[4]), "Upload: p50 %.2f ms, p99 %.2f ms",
+             (double)uploads.Percentile(50.0) / 1e6, (double)uploads.Percentile(99.0) / 1e6);
+    snprintf(lines[5], sizeof(lines[5]), "Receivers: %d, lag %llu frames, %s",
+             plugin->lag_receivers.load(std::memory_order_relaxed),
+             (unsigned long long)plugin->lag_frames.load(std::memory_order_relaxed),
+             lag_level_names[plugin->lag_level.load(std::memory_order_relaxed)]);
+
+    if (!params.file_output.empty()) {
+      File_Sink_Stats file_stats;
+      plugin->file_sink.Stats(file_stats);
+      snprintf(lines[line_count++], sizeof(lines[0]), "File: %.2f fps, %.1f MB/s, queued %d, dropped %llu, failed %llu",
+               file_stats.frames_per_second, file_stats.bytes_per_second / (1024.0 * 1024.0), file_stats.queued,
+               (unsigned long long)file_stats.dropped, (unsigned long long)file_stats.failed);
     }
+
+    auto& genlock_group = params.genlock_group;
+    if (!genlock_group.empty()) {
+      spoutHistogramSnapshot waits;
+      plugin->genlock.wait_times.Snapshot(waits);
+      Genlock_State state;
+      if (genlock_reader.group() != genlock_group) {
+        genlock_reader.open(genlock_group);
+      }
+      if (genlock_reader.read(state)) {
+        snprintf(lines[line_count++], sizeof(lines[0]), "Genlock: %s, %d members, generation %llu, wait p99 %.2f ms, %llu timeouts",
+                 genlock_group.c_str(), state.members, (unsigned long long)state.generation,
+                 (double)waits.Percentile(99.0) / 1e6, (unsigned long long)state.timeouts);
+      }
+    }
+    else {
+      genlock_reader.leave();
+    }
+
+    OfxRGBAColourF colour = { 1.0f, 1.0f, 1.0f, 1.0f };
+    draw_suite->getColour(args.context, kOfxStandardColourOverlayText, &colour);
+    draw_suite->setColour(args.context, &colour);
+
+    // Top left of the frame, one line every 18 screen pixels
+    auto size = plugin->getProjectSize();
+    auto offset = plugin->getProjectOffset();
+    OfxPointD pos;
+    pos.x = offset.x + 10.0 * args.pixelScale.x;
+    pos.y = offset.y + size.y - 10.0 * args.pixelScale.y;
+
+    for (int i = 0; i < line_count; ++i) {
+      draw_suite->drawText(args.context, lines[i], &pos, kOfxDrawTextAlignmentLeft | kOfxDrawTextAlignmentTop);
+      pos.y -= 18.0 * args.pixelScale.y;
+    }
+
+    return true;
   }
 };
 
+class Stats_Overlay_Descriptor : public DefaultEffectOverlayDescriptor<Stats_Overlay_Descriptor, Stats_Overlay> {
+};
+
 class SpoutPluginFactory : public PluginFactoryHelper<SpoutPluginFactory> {
 public:
   SpoutPluginFactory() : PluginFactoryHelper(PLUGIN_ID, PLUGIN_MAJOR, PLUGIN_MINOR) { }
   virtual void load() {
+    // A host that unloads and loads us again gets the watch back, the first use starts it otherwise
+    if (auto* settings = spoutSettings::Existing()) {
+      settings->StartWatch();
+    }
   }
   virtual void unload() {
+    // The settings watch thread can't be joined once the loader starts unloading us.
+    // Settings nothing has used yet aren't loaded just to stop them.
+    if (auto* settings = spoutSettings::Existing()) {
+      settings->StopWatch();
+    }
   }
 
   virtual void describe(ImageEffectDescriptor& desc) {
@@ -443,6 +2289,8 @@ public:
 
     desc.setSupportsCudaRender(true);
     desc.setSupportsCudaStream(true);
+
+    desc.setOverlayInteractDescriptor(new Stats_Overlay_Descriptor);
   }
 
   virtual void describeInContext(ImageEffectDescriptor& desc, ContextEnum context) {
@@ -463,6 +2311,196 @@ public:
       param->setDefault("Davinci Spout");
       param->setAnimates(false);
     }
+
+    {
+      // The host doesn't tell us the timeline color space so the user tags it here.
+      // Option order matches SpoutColorSpace, receivers get it in the frame metadata.
+      auto* param = desc.defineChoiceParam(PARAM_COLOR_SPACE);
+      param->setLabels("Color Space", "Color Space", "Color Space");
+      param->setHint("Color space tag published with each frame");
+      param->appendOption("Unspecified");
+      param->appendOption("sRGB");
+      param->appendOption("Rec.709");
+      param->appendOption("Rec.2020");
+      param->appendOption("Linear");
+      param->appendOption("ACEScg");
+      param->setDefault(SPOUT_COLORSPACE_UNSPECIFIED);
+      param->setAnimates(false);
+    }
+
+    {
+      auto* param = desc.defineStringParam(PARAM_LUT_FILE);
+      param->setLabels("LUT File", "LUT File", "LUT File");
+      param->setHint("3D .cube LUT applied to the sent frame only, the timeline output is unchanged. Leave empty for no LUT.");
+      param->setStringType(eStringTypeFilePath);
+      param->setFilePathExists(true);
+      param->setDefault("");
+      param->setAnimates(false);
+    }
+
+    {
+      auto* param = desc.defineBooleanParam(PARAM_SHOW_STATS);
+      param->setLabels("Show Stats", "Show Stats", "Show Stats");
+      param->setHint("Draws sender stats over the viewer");
+      param->setDefault(false);
+      param->setAnimates(false);
+      param->setEvaluateOnChange(false);
+    }
+
+    {
+      // Option order matches Lag_Level.
+      auto* param = desc.defineChoiceParam(PARAM_LAG_FALLBACK);
+      param->setLabels("Receiver Lag Fallback", "Receiver Lag Fallback", "Receiver Lag Fallback");
+      param->setHint("Furthest step taken while receivers fall behind: skip every other frame, then also send at half resolution, then also at half precision. Steps back up once they keep up. The timeline output is unchanged.");
+      param->appendOption("Off");
+      param->appendOption("Skip Frames");
+      param->appendOption("Half Resolution");
+      param->appendOption("Half Precision");
+      param->setDefault(LAG_LEVEL_FULL);
+      param->setAnimates(false);
+      param->setEvaluateOnChange(false);
+    }
+
+    {
+      // Option order matches output_formats.
+      auto* param = desc.defineChoiceParam(PARAM_OUTPUT_FORMAT);
+      param->setLabels("Output Format", "Output Format", "Output Format");
+      param->setHint("Pixel format sent to receivers. YUV formats are for receivers that encode the frame and need CPU rendering, GPU renders are sent as RGBA Float with a warning on the effect. Receivers find the format code in the sender info and frame metadata.");
+      param->appendOption("RGBA Float");
+      param->appendOption("NV12");
+      param->appendOption("P010");
+      param->appendOption("YUY2");
+      param->appendOption("UYVY");
+      param->appendOption("v210");
+      param->setDefault(0);
+      param->setAnimates(false);
+    }
+
+    {
+      auto* param = desc.defineChoiceParam(PARAM_YUV_MATRIX);
+      param->setLabels("YUV Matrix", "YUV Matrix", "YUV Matrix");
+      param->setHint("Matrix used for YUV output formats");
+      param->appendOption("BT.709");
+      param->appendOption("BT.2020");
+      param->setDefault(0);
+      param->setAnimates(false);
+    }
+
+    {
+      auto* param = desc.defineChoiceParam(PARAM_YUV_RANGE);
+      param->setLabels("YUV Range", "YUV Range", "YUV Range");
+      param->setHint("Limited (video) or full range for YUV output formats");
+      param->appendOption("Limited");
+      param->appendOption("Full");
+      param->setDefault(0);
+      param->setAnimates(false);
+    }
+
+    {
+      auto* param = desc.defineStringParam(PARAM_ATLAS_NAME);
+      param->setLabels("Atlas Name", "Atlas Name", "Atlas Name");
+      param->setHint("Instances with the same atlas name send their frames as tiles of one frame under this sender name, published once per timeline frame. Leave empty to send on its own.");
+      param->setDefault("");
+      param->setAnimates(false);
+    }
+
+    {
+      auto* param = desc.defineIntParam(PARAM_ATLAS_SLOT);
+      param->setLabels("Atlas Tile", "Atlas Tile", "Atlas Tile");
+      param->setHint("Tile of the atlas this instance fills, counted row by row from the top left");
+      param->setRange(1, ATLAS_MAX_SLOTS);
+      param->setDisplayRange(1, ATLAS_MAX_SLOTS);
+      param->setDefault(1);
+      param->setAnimates(false);
+    }
+
+    {
+      auto* param = desc.defineBooleanParam(PARAM_STREAM_ROWS);
+      param->setLabels("Stream Rows", "Stream Rows", "Stream Rows");
+      param->setHint("Also sends the frame through shared memory named after the sender and publishes the rows as they are copied, so receivers can start on the top of the frame before the bottom is done. CPU rendering without a LUT, reduction or YUV output only.");
+      param->setDefault(false);
+      param->setAnimates(false);
+    }
+
+    {
+      auto* param = desc.defineBooleanParam(PARAM_FRAME_STATS);
+      param->setLabels("Frame Stats", "Frame Stats", "Frame Stats");
+      param->setHint("Publishes the minimum, maximum and mean of each channel, a luma histogram and counts of NaN, Inf and clipped values with every frame, in shared memory named after the sender, so receivers can show scopes without reading the frame again. Worked out in the copy of the frame we send, with or without a LUT, YUV output or reduction, so it adds arithmetic but no extra read or write of the frame. CPU rendering only, GPU renders and atlas tiles are sent without stats and show a warning on the effect.");
+      param->setDefault(true);
+      param->setAnimates(false);
+    }
+
+    {
+      auto* param = desc.defineStringParam(PARAM_GENLOCK_GROUP);
+      param->setLabels("Genlock Group", "Genlock Group", "Genlock Group");
+      param->setHint("Instances with the same genlock group wait for each other and publish their frames of a timeline time together, with the same generation in the frame metadata, so receivers can show several outputs on the same frame. Instances the host renders one after another rather than side by side wait for the timeout each frame. Atlas tiles and the row stream go out on their own. Leave empty to publish as soon as the frame is ready.");
+      param->setDefault("");
+      param->setAnimates(false);
+    }
+
+    {
+      auto* param = desc.defineIntParam(PARAM_GENLOCK_TIMEOUT);
+      param->setLabels("Genlock Timeout", "Genlock Timeout", "Genlock Timeout");
+      param->setHint("Milliseconds to wait for the other members of the genlock group before publishing without them");
+      param->setRange(1, 1000);
+      param->setDisplayRange(1, 500);
+      param->setDefault(100);
+      param->setAnimates(false);
+    }
+
+    {
+      auto* param = desc.defineStringParam(PARAM_FILE_OUTPUT);
+      param->setLabels("File Output", "File Output", "File Output");
+      param->setHint("Folder the published frames are also written to as an image sequence named after the sender and the frame number. The frame is written as it comes in, before the LUT. Encoding and writing happen off the render thread. Leave empty for no file output.");
+      param->setStringType(eStringTypeDirectoryPath);
+      param->setDefault("");
+      param->setAnimates(false);
+      param->setEvaluateOnChange(false);
+    }
+
+    {
+      // Option order matches File_Sink_Encoder.
+      auto* param = desc.defineChoiceParam(PARAM_FILE_FORMAT);
+      param->setLabels("File Format", "File Format", "File Format");
+      param->setHint("EXR is half float, PNG is 16 bit clamped to 0-1, Raw is the float RGBA rows with the size in the file name");
+      param->appendOption("EXR Half");
+      param->appendOption("PNG 16 bit");
+      param->appendOption("Raw Float");
+      param->setDefault(FILE_SINK_EXR);
+      param->setAnimates(false);
+      param->setEvaluateOnChange(false);
+    }
+
+    {
+      auto* param = desc.defineIntParam(PARAM_FILE_COMPRESSION);
+      param->setLabels("File Compression", "File Compression", "File Compression");
+      param->setHint("0 writes uncompressed files, 1-9 trade encoding time for smaller files. Raw files are never compressed.");
+      param->setRange(0, 9);
+      param->setDisplayRange(0, 9);
+      param->setDefault(4);
+      param->setAnimates(false);
+      param->setEvaluateOnChange(false);
+    }
+
+    {
+      // Option order matches File_Sink_Policy.
+      auto* param = desc.defineChoiceParam(PARAM_FILE_QUEUE);
+      param->setLabels("File Queue", "File Queue", "File Queue");
+      param->setHint("What happens when the disk or the encoders can't keep up. Drop Frames never holds up the render, Wait writes every frame and slows the render down instead.");
+      param->appendOption("Drop Frames");
+      param->appendOption("Wait");
+      param->setDefault(FILE_SINK_DROP);
+      param->setAnimates(false);
+      param->setEvaluateOnChange(false);
+    }
+
+    {
+      auto* param = desc.defineBooleanParam(PARAM_SKIP_PASSTHROUGH);
+      param->setLabels("Skip Passthrough Copy", "Skip Passthrough Copy", "Skip Passthrough Copy");
+      param->setHint("Sends the frame before the host renders and lets it use the source as the output, so the frame isn't copied. CPU rendering only, GPU rendering keeps the copy.");
+      param->setDefault(false);
+      param->setAnimates(false);
+    }
   }
 
   virtual ImageEffect* createInstance(OfxImageEffectHandle handle, ContextEnum context) {
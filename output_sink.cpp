@@ -0,0 +1,286 @@
+/*
+Davinci Resolve Spout Sender
+Copyright (C) 2025 ValueFactory
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of
+the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+#include "output_sink.h"
+
+#include <limits.h>
+#include <string.h>
+
+//
+// Output_Sink
+//
+
+void Output_Sink::stats(Output_Sink_Stats& stats) const {
+  stats.published = published.load(std::memory_order_relaxed);
+  stats.skipped = skipped.load(std::memory_order_relaxed);
+  stats.bytes = bytes.load(std::memory_order_relaxed);
+}
+
+void Output_Sink::count_published(uint64_t frame_bytes) {
+  published.fetch_add(1, std::memory_order_relaxed);
+  bytes.fetch_add(frame_bytes, std::memory_order_relaxed);
+}
+
+void Output_Sink::count_skipped() {
+  skipped.fetch_add(1, std::memory_order_relaxed);
+}
+
+//
+// Output_Dispatcher
+//
+
+Output_Dispatcher::Output_Dispatcher() {
+  next_band = 0;
+  frontier = 0;
+}
+
+void Output_Dispatcher::add(Output_Sink* sink) {
+  if (sink_count < OUTPUT_MAX_SINKS) {
+    sinks[sink_count++] = sink;
+  }
+}
+
+void Output_Dispatcher::clear() {
+  sink_count = 0;
+  active_count = 0;
+}
+
+int Output_Dispatcher::begin(const Output_Frame& frame, const char* frame_src, size_t frame_pitch) {
+  active_count = 0;
+  for (int i = 0; i < sink_count; ++i) {
+    if (sinks[i]->prepare(frame)) {
+      active[active_count++] = sinks[i];
+    }
+  }
+
+  src = frame_src;
+  pitch = frame_pitch;
+  height = frame.height;
+  bands = (height + OUTPUT_BAND_ROWS - 1) / OUTPUT_BAND_ROWS;
+  if (bands > done_capacity) {
+    done.reset(new std::atomic<bool>[bands]);
+    done_capacity = bands;
+  }
+  for (int i = 0; i < bands; ++i) {
+    done[i] = false;
+  }
+  next_band = 0;
+  frontier = 0;
+  return active_count;
+}
+
+// Threads take bands in order so the written rows grow from the top. A band only counts towards
+// rows_completed once every band above it is done, whichever thread finishes last moves the count on.
+void Output_Dispatcher::run() {
+  if (active_count == 0) {
+    return;
+  }
+
+  for (;;) {
+    auto band = next_band.fetch_add(1, std::memory_order_relaxed);
+    if (band >= bands) {
+      break;
+    }
+
+    auto y_begin = band * OUTPUT_BAND_ROWS;
+    auto y_end = y_begin + OUTPUT_BAND_ROWS < height ? y_begin + OUTPUT_BAND_ROWS : height;
+    auto* band_src = src + (size_t)y_begin * pitch;
+
+    // Every sink after the first reads the band from cache
+    for (int i = 0; i < active_count; ++i) {
+      active[i]->write_band(band_src, pitch, y_begin, y_end);
+    }
+
+    // Sequentially consistent so that of two threads finishing neighbouring bands, at least one sees both done
+    done[band] = true;
+    auto start = frontier.load();
+    auto top = start;
+    while (top < bands && done[top]) {
+      if (frontier.compare_exchange_weak(top, top + 1)) {
+        ++top;
+      }
+    }
+
+    if (top != start) {
+      auto rows = top * OUTPUT_BAND_ROWS < height ? top * OUTPUT_BAND_ROWS : height;
+      for (int i = 0; i < active_count; ++i) {
+        active[i]->rows_completed(rows);
+      }
+    }
+  }
+}
+
+int Output_Dispatcher::finish() {
+  int count = 0;
+  for (int i = 0; i < active_count; ++i) {
+    active[i]->rows_completed(height);
+    if (active[i]->publish()) {
+      ++count;
+    }
+  }
+  active_count = 0;
+  return count;
+}
+
+//
+// Null_Sink
+//
+
+bool Null_Sink::prepare(const Output_Frame& frame) {
+  row_bytes = frame.row_bytes();
+  frame_bytes = 0;
+  return true;
+}
+
+void Null_Sink::write_band(const char*, size_t, int y_begin, int y_end) {
+  frame_bytes.fetch_add((uint64_t)(y_end - y_begin) * row_bytes, std::memory_order_relaxed);
+}
+
+bool Null_Sink::publish() {
+  count_published(frame_bytes.load(std::memory_order_relaxed));
+  return true;
+}
+
+//
+// Ring_Sink
+//
+
+bool Ring_Sink::prepare(const Output_Frame& frame) {
+  rows = nullptr;
+  if (!buffer) {
+    return false;
+  }
+
+  row_bytes = frame.row_bytes();
+  height = frame.height;
+  auto total = frame.header_bytes + row_bytes * frame.height;
+  if (total > INT_MAX) {
+    count_skipped();
+    return false;
+  }
+  auto length = (int)total;
+
+  if (length != created_length) {
+    if (length == failed_length) {
+      count_skipped();
+      return false;
+    }
+
+    if (!buffer->Create(name.c_str(), length, 3)) {
+      failed_length = length;
+      created_length = 0;
+      count_skipped();
+      return false;
+    }
+    created_length = length;
+    failed_length = 0;
+  }
+
+  int maxlength = 0;
+  // Null when receivers lease every buffer but the latest, the frame still goes out through the other sinks
+  auto* data = buffer->BeginWrite(&maxlength);
+  if (!data || maxlength < length) {
+    count_skipped();
+    return false;
+  }
+
+  // Written before any row is published, so a receiver reads it once WaitRowsCompleted reports a row
+  if (frame.header_bytes) {
+    memcpy(data, frame.header, frame.header_bytes);
+  }
+  rows = data + frame.header_bytes;
+  return true;
+}
+
+void Ring_Sink::write_band(const char* src, size_t pitch, int y_begin, int y_end) {
+  auto* dst = rows + (size_t)y_begin * row_bytes;
+  for (auto y = y_begin; y < y_end; ++y) {
+    memcpy(dst, src, row_bytes);
+    src += pitch;
+    dst += row_bytes;
+  }
+}
+
+void Ring_Sink::rows_completed(int completed) {
+  buffer->SetRowsCompleted(completed);
+}
+
+bool Ring_Sink::publish() {
+  rows = nullptr;
+  if (!buffer->Commit(created_length)) {
+    count_skipped();
+    return false;
+  }
+  count_published((uint64_t)row_bytes * height);
+  return true;
+}
+
+void Ring_Sink::reset() {
+  created_length = 0;
+  failed_length = 0;
+  rows = nullptr;
+}
+
+//
+// File_Output_Sink
+//
+
+File_Output_Sink::~File_Output_Sink() {
+  if (pending) {
+    sink.Cancel(pending);
+  }
+}
+
+bool File_Output_Sink::prepare(const Output_Frame& frame) {
+  // A render threw after taking one
+  if (pending) {
+    sink.Cancel(pending);
+    pending = nullptr;
+  }
+
+  if (config.directory.empty() || frame.pixel_bytes != 4 * sizeof(float)) {
+    return false;
+  }
+
+  pending = sink.Acquire(frame.width, frame.height, config.policy);
+  if (!pending) {
+    count_skipped();
+    return false;
+  }
+  time = frame.time;
+  return true;
+}
+
+void File_Output_Sink::write_band(const char* src, size_t pitch, int y_begin, int y_end) {
+  auto row_bytes = pending->pitch();
+  auto* dst = pending->data() + (size_t)y_begin * row_bytes;
+  for (auto y = y_begin; y < y_end; ++y) {
+    memcpy(dst, src, row_bytes);
+    src += pitch;
+    dst += row_bytes;
+  }
+}
+
+bool File_Output_Sink::publish() {
+  auto* frame = pending;
+  pending = nullptr;
+  count_published((uint64_t)frame->pitch() * frame->height);
+  sink.Submit(frame, time, config);
+  return true;
+}
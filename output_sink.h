@@ -0,0 +1,179 @@
+/*
+Davinci Resolve Spout Sender
+Copyright (C) 2025 ValueFactory
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of
+the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+
+#include "file_sink.h"
+#include "SpoutSharedBuffer.h"
+
+// Everywhere a frame goes is a sink: the timeline passthrough, the shared texture, the shared memory
+// ring and the file output. The dispatcher reads the source a band of rows at a time and hands each band to every
+// sink while it's still in cache, so another output costs its writes but no extra read of the frame.
+// The sinks here don't need D3D11 or OFX so they build on Linux for tools/spout_sink_bench.cpp. The passthrough and
+// shared texture sinks live in main.cpp.
+
+// Rows handed out at a time, small enough that a band of a float RGBA 4K frame stays in L2
+#define OUTPUT_BAND_ROWS 16
+#define OUTPUT_MAX_SINKS 8
+
+struct Output_Frame {
+  int width = 0;
+  int height = 0;
+  int pixel_bytes = 0;
+  // DXGI_FORMAT of the rows in the plugin, passed through to receivers
+  uint32_t format = 0;
+  double time = 0.0;
+  // Record written ahead of the rows by sinks that carry one, the frame metadata in the plugin
+  const void* header = nullptr;
+  size_t header_bytes = 0;
+
+  size_t row_bytes() const { return (size_t)width * pixel_bytes; }
+};
+
+struct Output_Sink_Stats {
+  uint64_t published = 0;
+  uint64_t skipped = 0;
+  uint64_t bytes = 0;
+};
+
+class Output_Sink {
+public:
+  virtual ~Output_Sink() {}
+
+  // Called before the first band of a frame. Returns false to sit the frame out, no other call is made for it then.
+  virtual bool prepare(const Output_Frame& frame) = 0;
+  // Rows y_begin to y_end, src pointing at row y_begin. Called from the copy threads, bands of a frame can arrive
+  // in any order and at the same time.
+  virtual void write_band(const char* src, size_t pitch, int y_begin, int y_end) = 0;
+  // Every row above the one given is written. Called from the copy threads as the count grows.
+  virtual void rows_completed(int /*rows*/) {}
+  // Every band is written. Returns false if the frame didn't go out.
+  virtual bool publish() = 0;
+
+  // Lock free, for the stats overlay
+  virtual void stats(Output_Sink_Stats& stats) const;
+
+protected:
+  void count_published(uint64_t bytes);
+  void count_skipped();
+
+  std::atomic<uint64_t> published{ 0 };
+  std::atomic<uint64_t> skipped{ 0 };
+  std::atomic<uint64_t> bytes{ 0 };
+};
+
+class Output_Dispatcher {
+public:
+  Output_Dispatcher();
+
+  void add(Output_Sink* sink);
+  void clear();
+
+  // Prepares every sink for the frame, whose row 0 is at src. Returns the number of sinks that take it.
+  int begin(const Output_Frame& frame, const char* src, size_t pitch);
+  // Hands out bands until none are left. Call from any number of threads between begin and finish.
+  void run();
+  // Publishes the frame to the sinks that took it. Returns the number that published.
+  int finish();
+
+private:
+  Output_Sink* sinks[OUTPUT_MAX_SINKS];
+  int sink_count = 0;
+  Output_Sink* active[OUTPUT_MAX_SINKS];
+  int active_count = 0;
+
+  const char* src = nullptr;
+  size_t pitch = 0;
+  int height = 0;
+  int bands = 0;
+  std::unique_ptr<std::atomic<bool>[]> done;
+  int done_capacity = 0;
+  std::atomic<int> next_band;
+  std::atomic<int> frontier;
+};
+
+// Counts what it's given and writes nowhere, to measure the dispatcher
+class Null_Sink : public Output_Sink {
+public:
+  virtual bool prepare(const Output_Frame& frame) override;
+  virtual void write_band(const char* src, size_t pitch, int y_begin, int y_end) override;
+  virtual bool publish() override;
+
+private:
+  size_t row_bytes = 0;
+  std::atomic<uint64_t> frame_bytes{ 0 };
+};
+
+// The shared memory ring, a versioned spoutSharedBuffer holding the header then the rows. Rows are
+// published as they complete so receivers can start on the top of the frame while the bottom is still copied.
+// Three buffers so a receiver still streaming the last frame isn't overwritten by the next one.
+class Ring_Sink : public Output_Sink {
+public:
+  // Set before each frame. The ring is created under name, or recreated when the frame size changes.
+  spoutSharedBuffer* buffer = nullptr;
+  std::string name;
+
+  virtual bool prepare(const Output_Frame& frame) override;
+  virtual void write_band(const char* src, size_t pitch, int y_begin, int y_end) override;
+  virtual void rows_completed(int rows) override;
+  virtual bool publish() override;
+
+  // Forgets the ring so the next frame creates it, after the buffer was closed or renamed
+  void reset();
+  // Bytes of each buffer, zero until it is created
+  int length() const { return created_length; }
+
+private:
+  int created_length = 0;
+  // Set to the failed size so we don't retry every frame
+  int failed_length = 0;
+  char* rows = nullptr;
+  size_t row_bytes = 0;
+  int height = 0;
+};
+
+// Feeds File_Sink. Frames must be float RGBA.
+class File_Output_Sink : public Output_Sink {
+public:
+  explicit File_Output_Sink(File_Sink& sink) : sink(sink) {}
+  ~File_Output_Sink();
+
+  // Set before each frame
+  File_Sink_Config config;
+
+  virtual bool prepare(const Output_Frame& frame) override;
+  virtual void write_band(const char* src, size_t pitch, int y_begin, int y_end) override;
+  virtual bool publish() override;
+
+  // The frame taken by prepare, for filling it without going through bands
+  File_Sink_Frame* frame() { return pending; }
+
+private:
+  File_Sink& sink;
+  // Taken by prepare and not submitted yet. Only left over when a render threw in between.
+  File_Sink_Frame* pending = nullptr;
+  double time = 0.0;
+};
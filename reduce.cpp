@@ -0,0 +1,59 @@
+/*
+Davinci Resolve Spout Sender
+Copyright (C) 2025 ValueFactory
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of
+the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+#include "reduce.h"
+#include "half.h"
+
+#include <stdint.h>
+
+#include <emmintrin.h>
+
+void reduce_rgba_rows(const char* src, size_t src_pitch, int src_width, int src_height,
+                      char* dst, size_t dst_pitch, bool half, int y_begin, int y_end) {
+  const int width = reduce_size(src_width);
+  const __m128 quarter = _mm_set1_ps(0.25f);
+
+  for (int y = y_begin; y < y_end; ++y) {
+    auto* row0 = (const float*)(src + (size_t)(2 * y) * src_pitch);
+    auto* row1 = (const float*)(src + (size_t)(2 * y + 1 < src_height ? 2 * y + 1 : 2 * y) * src_pitch);
+    auto* out = dst + (size_t)y * dst_pitch;
+
+    for (int x = 0; x < width; ++x) {
+      int x0 = 2 * x;
+      int x1 = x0 + 1 < src_width ? x0 + 1 : x0;
+
+      __m128 sum = _mm_add_ps(_mm_loadu_ps(row0 + x0 * 4), _mm_loadu_ps(row0 + x1 * 4));
+      sum = _mm_add_ps(sum, _mm_loadu_ps(row1 + x0 * 4));
+      sum = _mm_add_ps(sum, _mm_loadu_ps(row1 + x1 * 4));
+      __m128 avg = _mm_mul_ps(sum, quarter);
+
+      if (half) {
+        alignas(16) float px[4];
+        _mm_store_ps(px, avg);
+        auto* out_px = (uint16_t*)out + x * 4;
+        for (int c = 0; c < 4; ++c) {
+          out_px[c] = float_to_half(px[c]);
+        }
+      }
+      else {
+        _mm_storeu_ps((float*)out + x * 4, avg);
+      }
+    }
+  }
+}
@@ -0,0 +1,88 @@
+/*
+Davinci Resolve Spout Sender
+Copyright (C) 2025 ValueFactory
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of
+the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+#include "reduce.h"
+
+#include <cuda_fp16.h>
+
+// Same 2x2 average as reduce_rgba_rows in reduce.cpp.
+__global__ static void reduce_kernel(const char* src, size_t src_pitch, int src_width, int src_height,
+                                     char* dst, size_t dst_pitch, int width, int height, bool half) {
+  int x = blockIdx.x * blockDim.x + threadIdx.x;
+  int y = blockIdx.y * blockDim.y + threadIdx.y;
+  if (x >= width || y >= height) return;
+
+  int x0 = 2 * x;
+  int x1 = min(x0 + 1, src_width - 1);
+  int y0 = 2 * y;
+  int y1 = min(y0 + 1, src_height - 1);
+
+  auto* row0 = (const float4*)(src + y0 * src_pitch);
+  auto* row1 = (const float4*)(src + y1 * src_pitch);
+  float4 a = row0[x0];
+  float4 b = row0[x1];
+  float4 c = row1[x0];
+  float4 d = row1[x1];
+
+  float4 avg;
+  avg.x = (a.x + b.x + c.x + d.x) * 0.25f;
+  avg.y = (a.y + b.y + c.y + d.y) * 0.25f;
+  avg.z = (a.z + b.z + c.z + d.z) * 0.25f;
+  avg.w = (a.w + b.w + c.w + d.w) * 0.25f;
+
+  if (half) {
+    ushort4 out;
+    out.x = __half_as_ushort(__float2half_rn(avg.x));
+    out.y = __half_as_ushort(__float2half_rn(avg.y));
+    out.z = __half_as_ushort(__float2half_rn(avg.z));
+    out.w = __half_as_ushort(__float2half_rn(avg.w));
+    ((ushort4*)(dst + y * dst_pitch))[x] = out;
+  }
+  else {
+    ((float4*)(dst + y * dst_pitch))[x] = avg;
+  }
+}
+
+cudaError_t reduce_cuda_apply(Reduce_Cuda& cuda, const void* src, size_t src_pitch,
+                              int src_width, int src_height, bool half, cudaStream_t stream) {
+  int width = reduce_size(src_width);
+  int height = reduce_size(src_height);
+
+  if (!cuda.scratch || cuda.scratch_width != width || cuda.scratch_height != height || cuda.scratch_half != half) {
+    reduce_cuda_release(cuda);
+
+    auto err = cudaMallocPitch(&cuda.scratch, &cuda.scratch_pitch, width * reduce_pixel_bytes(half), height);
+    if (err != cudaSuccess) return err;
+
+    cuda.scratch_width = width;
+    cuda.scratch_height = height;
+    cuda.scratch_half = half;
+  }
+
+  dim3 block(16, 16);
+  dim3 grid((width + block.x - 1) / block.x, (height + block.y - 1) / block.y);
+  reduce_kernel<<<grid, block, 0, stream>>>((const char*)src, src_pitch, src_width, src_height,
+                                            (char*)cuda.scratch, cuda.scratch_pitch, width, height, half);
+  return cudaGetLastError();
+}
+
+void reduce_cuda_release(Reduce_Cuda& cuda) {
+  if (cuda.scratch) cudaFree(cuda.scratch);
+  cuda = Reduce_Cuda();
+}
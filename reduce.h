@@ -0,0 +1,63 @@
+/*
+Davinci Resolve Spout Sender
+Copyright (C) 2025 ValueFactory
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of
+the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <stddef.h>
+
+// tools/spout_passthrough_bench.cpp builds the CPU side on Linux without CUDA
+#ifndef REDUCE_NO_CUDA
+#include <cuda_runtime.h>
+#endif
+
+// Smaller copies of the frame we publish, for when receivers can't keep up.
+// Float RGBA in, half width and height out, as float RGBA or half float RGBA.
+
+// Size of the reduced image for one side of the source. Odd sizes round up.
+inline int reduce_size(int size) {
+  return (size + 1) / 2;
+}
+
+// Bytes per pixel of the reduced image.
+inline int reduce_pixel_bytes(bool half) {
+  return half ? 4 * 2 : 4 * 4;
+}
+
+// Writes rows y_begin to y_end of the reduced image, each pixel the average of a 2x2 block
+// of the source. On odd sizes the last row and column of the source are repeated.
+void reduce_rgba_rows(const char* src, size_t src_pitch, int src_width, int src_height,
+                      char* dst, size_t dst_pitch, bool half, int y_begin, int y_end);
+
+#ifndef REDUCE_NO_CUDA
+// CUDA side of the reduction. Lives in reduce.cu.
+struct Reduce_Cuda {
+  // Reduced image for the publish copy
+  void* scratch = nullptr;
+  size_t scratch_pitch = 0;
+  int scratch_width = 0;
+  int scratch_height = 0;
+  bool scratch_half = false;
+};
+
+// Reduces src into the scratch buffer, allocating it on the first call or when the size changes.
+cudaError_t reduce_cuda_apply(Reduce_Cuda& cuda, const void* src, size_t src_pitch,
+                              int src_width, int src_height, bool half, cudaStream_t stream);
+
+void reduce_cuda_release(Reduce_Cuda& cuda);
+#endif
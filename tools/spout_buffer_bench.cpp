@@ -0,0 +1,344 @@
+//
+//		spout_buffer_bench
+//
+//		Throughput of spoutSharedBuffer against the WriteMemoryBuffer and
+//		ReadMemoryBuffer calls of spoutDX it replaces.
+//
+//		A writer thread and a reader thread share a buffer of each size for
+//		a fixed time. The writer makes a payload and publishes it, the reader
+//		takes the latest one and reads every word of it.
+//
+//			memory  WriteMemoryBuffer and ReadMemoryBuffer as spoutDX does
+//			        them. The writer fills its own buffer and copies it to
+//			        the map under the map mutex, the reader copies it out
+//			        under the same mutex and reads its copy.
+//			shared  spoutSharedBuffer. The writer fills the next buffer in
+//			        place and commits it, the reader reads the latest buffer
+//			        in place and checks the version did not change.
+//
+//		spoutDX needs Windows, so the memory mode repeats its two functions
+//		on SpoutSharedMemory, which is what they use.
+//
+//		Every payload starts and ends with its number, a read that finds two
+//		different numbers was torn.
+//
+//		Build (Linux)
+//
+//			g++ -std=c++14 -O2 -pthread -ISpout tools/spout_buffer_bench.cpp
+//				Spout/SpoutSharedMemory.cpp Spout/SpoutSharedBuffer.cpp
+//				Spout/SpoutHistogram.cpp -o spout_buffer_bench -lrt
+//
+//		Run
+//
+//			./spout_buffer_bench [-k KB] [-t msec per mode]
+//
+//		Without -k it runs 4 KB, 256 KB and 8 MB.
+//
+//		SDK notices are logged to stderr, redirect it to hide them.
+//
+//		Exits with 1 if a read was torn.
+//
+// ====================================================================================
+//		Revisions :
+//
+//		17.10.26	- project start
+//
+// ====================================================================================
+//
+/*
+	Redistribution and use in source and binary forms, with or without modification,
+	are permitted provided that the following conditions are met:
+
+		1. Redistributions of source code must retain the above copyright notice,
+		   this list of conditions and the following disclaimer.
+
+		2. Redistributions in binary form must reproduce the above copyright notice,
+		   this list of conditions and the following disclaimer in the documentation
+		   and/or other materials provided with the distribution.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"	AND ANY
+	EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+	OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE	ARE DISCLAIMED.
+	IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+	INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+	PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+	LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+	OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "SpoutSharedMemory.h"
+#include "SpoutSharedBuffer.h"
+#include "SpoutHistogram.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define BENCH_NAME "spout_buffer_bench"
+
+struct ModeResult {
+	uint64_t writes;
+	uint64_t reads;
+	uint64_t torn;
+	uint64_t checksum;
+};
+
+// A payload of words, the first and last holding its number
+static void Fill(uint64_t* words, size_t count, uint64_t number)
+{
+	words[0] = number;
+	for (size_t i = 1; i + 1 < count; i++)
+		words[i] = number*0x9e3779b97f4a7c15ULL + i;
+	words[count - 1] = number;
+}
+
+// Reads every word, as a receiver using the data would. False if the payload was torn.
+static bool Consume(const uint64_t* words, size_t count, uint64_t& checksum)
+{
+	uint64_t sum = 0;
+	for (size_t i = 0; i < count; i++)
+		sum += words[i];
+	checksum += sum;
+	return words[0] == words[count - 1];
+}
+
+static void PrintTimes(const char* name, spoutHistogram& times, uint64_t ops, double seconds, double mbytes)
+{
+	spoutHistogramSnapshot snapshot;
+	times.Snapshot(snapshot);
+	printf("  %-7s usec p50 %8.1f  p99 %8.1f  %9.0f /s  %8.1f MB/s\n",
+		name, snapshot.Percentile(50.0)/1000.0, snapshot.Percentile(99.0)/1000.0,
+		ops/seconds, ops*mbytes/seconds);
+}
+
+//
+// spoutDX::WriteMemoryBuffer and ReadMemoryBuffer
+//
+
+// The first 16 bytes hold the length in decimal digits
+static bool WriteMemoryBuffer(SpoutSharedMemory& memory, const char* data, int length)
+{
+	if (memory.Size() == 0) {
+		if (!memory.Create(BENCH_NAME "_map", length + 16))
+			return false;
+		char* buffer = memory.Lock();
+		if (!buffer)
+			return false;
+		snprintf(buffer, 16, "%d", length);
+		memory.Unlock();
+	}
+
+	char* buffer = memory.Lock();
+	if (!buffer)
+		return false;
+	memcpy(buffer + 16, data, length);
+	if (memory.Size() > 16 + length)
+		buffer[16 + length] = 0;
+	memory.Unlock();
+	return true;
+}
+
+static int ReadMemoryBuffer(SpoutSharedMemory& memory, char* data, int maxlength)
+{
+	if (!memory.Name() && !memory.Open(BENCH_NAME "_map"))
+		return 0;
+
+	char* buffer = memory.Lock();
+	if (!buffer)
+		return 0;
+	buffer[15] = 0;
+	int bytes = atoi(buffer);
+	if (maxlength < bytes)
+		bytes = maxlength;
+	if (bytes > 0)
+		memcpy(data, buffer + 16, bytes);
+	memory.Unlock();
+	return bytes;
+}
+
+static ModeResult RunMemory(int length, int msec, spoutHistogram& writes, spoutHistogram& reads)
+{
+	const size_t count = length/sizeof(uint64_t);
+	ModeResult result = {};
+	std::atomic<bool> stop(false);
+	std::atomic<bool> ready(false);
+
+	SpoutSharedMemory writer_memory;
+	std::thread writer([&] {
+		std::vector<uint64_t> payload(count);
+		uint64_t number = 1;
+		Fill(payload.data(), count, number);
+		WriteMemoryBuffer(writer_memory, reinterpret_cast<const char*>(payload.data()), length);
+		ready = true;
+		while (!stop.load()) {
+			spoutHistogramTimer timer(writes);
+			Fill(payload.data(), count, ++number);
+			if (WriteMemoryBuffer(writer_memory, reinterpret_cast<const char*>(payload.data()), length))
+				result.writes++;
+		}
+	});
+
+	while (!ready.load())
+		std::this_thread::yield();
+
+	SpoutSharedMemory reader_memory;
+	std::thread reader([&] {
+		std::vector<uint64_t> copy(count);
+		while (!stop.load()) {
+			spoutHistogramTimer timer(reads);
+			if (ReadMemoryBuffer(reader_memory, reinterpret_cast<char*>(copy.data()), length) == length) {
+				result.reads++;
+				if (!Consume(copy.data(), count, result.checksum))
+					result.torn++;
+			}
+		}
+	});
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(msec));
+	stop = true;
+	writer.join();
+	reader.join();
+	reader_memory.Close();
+	writer_memory.Close();
+	return result;
+}
+
+//
+// spoutSharedBuffer
+//
+
+static ModeResult RunShared(int length, int msec, spoutHistogram& writes, spoutHistogram& reads)
+{
+	const size_t count = length/sizeof(uint64_t);
+	ModeResult result = {};
+	std::atomic<bool> stop(false);
+	std::atomic<bool> ready(false);
+
+	spoutSharedBuffer writer_buffer;
+	std::thread writer([&] {
+		if (!writer_buffer.Create(BENCH_NAME, length, 3)) {
+			ready = true;
+			return;
+		}
+		uint64_t number = 0;
+		while (!stop.load()) {
+			spoutHistogramTimer timer(writes);
+			char* data = writer_buffer.BeginWrite();
+			if (!data)
+				continue;
+			Fill(reinterpret_cast<uint64_t*>(data), count, ++number);
+			if (writer_buffer.Commit(length))
+				result.writes++;
+			ready = true;
+		}
+		ready = true;
+	});
+
+	while (!ready.load())
+		std::this_thread::yield();
+
+	spoutSharedBuffer reader_buffer;
+	std::thread reader([&] {
+		reader_buffer.Open(BENCH_NAME);
+		while (!stop.load()) {
+			spoutHistogramTimer timer(reads);
+			int read_length = 0;
+			uint64_t version = 0;
+			const char* data = reader_buffer.BeginRead(&read_length, &version);
+			if (!data || read_length != length)
+				continue;
+			uint64_t checksum = 0;
+			const bool whole = Consume(reinterpret_cast<const uint64_t*>(data), count, checksum);
+			// A buffer overwritten while it was read is dropped, as a receiver would
+			if (!reader_buffer.EndRead(version))
+				continue;
+			result.reads++;
+			result.checksum += checksum;
+			if (!whole)
+				result.torn++;
+		}
+	});
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(msec));
+	stop = true;
+	writer.join();
+	reader.join();
+	reader_buffer.Close();
+	writer_buffer.Close();
+	return result;
+}
+
+static bool RunSize(int length, int msec)
+{
+	const double seconds = msec/1000.0;
+	const double mbytes = length/1048576.0;
+	bool ok = true;
+
+	printf("%d KB\n", length/1024);
+	for (int mode = 0; mode < 2; mode++) {
+		const char* name = mode == 0 ? "memory" : "shared";
+		spoutHistogram writes;
+		spoutHistogram reads;
+		const ModeResult result = mode == 0 ? RunMemory(length, msec, writes, reads) : RunShared(length, msec, writes, reads);
+		printf(" %s  %llu torn\n", name, static_cast<unsigned long long>(result.torn));
+		PrintTimes("write", writes, result.writes, seconds, mbytes);
+		PrintTimes("read", reads, result.reads, seconds, mbytes);
+		if (result.torn || result.writes == 0 || result.reads == 0) {
+			fprintf(stderr, "spout_buffer_bench - %s %d KB failed\n", name, length/1024);
+			ok = false;
+		}
+	}
+	return ok;
+}
+
+//
+// Main
+//
+
+int main(int argc, char* argv[])
+{
+	int kbytes = 0;
+	int msec = 1000;
+
+	int opt = 0;
+	while ((opt = getopt(argc, argv, "k:t:")) != -1) {
+		switch (opt) {
+			case 'k': kbytes = atoi(optarg); break;
+			case 't': msec = atoi(optarg); break;
+			default:
+				fprintf(stderr, "usage: %s [-k KB] [-t msec per mode]\n", argv[0]);
+				return 2;
+		}
+	}
+	if (kbytes < 0 || kbytes > 512*1024 || msec < 10) {
+		fprintf(stderr, "spout_buffer_bench - invalid arguments\n");
+		return 2;
+	}
+
+	printf("spout_buffer_bench : %d msec per mode, %u cores\n", msec, std::thread::hardware_concurrency());
+
+	std::vector<int> sizes;
+	if (kbytes > 0)
+		sizes.push_back(kbytes*1024);
+	else
+		sizes = { 4*1024, 256*1024, 8*1024*1024 };
+
+	bool failed = false;
+	for (int length : sizes)
+		failed |= !RunSize(length, msec);
+
+	if (failed) {
+		printf("FAILED\n");
+		return 1;
+	}
+
+	printf("OK\n");
+	return 0;
+}
@@ -0,0 +1,327 @@
+//
+//		spout_fd_bench
+//
+//		Latency of the memfd transport compared with the shared memory ring.
+//
+//		For each transport, the process creates a frame buffer and publishes
+//		frames at a fixed interval. A forked receiver process polls for new
+//		versions and reads each frame in place.
+//
+//			shm    spoutSharedBuffer with the POSIX SpoutSharedMemory backend
+//			memfd  spoutFdBuffer, memory passed by an spoutFdBroker run on a
+//			       thread of this process at a private address
+//
+//		Measured
+//			latency  from commit to the receiver seeing the new version
+//			read     time for the receiver to read a whole frame
+//			open     time for a receiver to open the sender, after the frames
+//
+//		Both transports map the same pages in the receiver, so latency and
+//		read time are expected to match. Open differs: shm_open of a name
+//		compared with a broker round trip.
+//
+//		Build (Linux)
+//
+//			g++ -std=c++14 -O2 -pthread -ISpout tools/spout_fd_bench.cpp
+//				Spout/SpoutFdTransport.cpp Spout/SpoutSharedMemory.cpp
+//				Spout/SpoutSharedBuffer.cpp Spout/SpoutHistogram.cpp
+//				-o spout_fd_bench -lrt
+//
+//		Run
+//
+//			./spout_fd_bench [-k frame KB] [-n frames] [-i interval usec] [-o opens]
+//
+//		SDK notices are logged to stderr, redirect it to hide them.
+//
+//		Exits with 1 if a transport failed or a frame was read torn.
+//
+// ====================================================================================
+//		Revisions :
+//
+//		17.10.26	- project start
+//
+// ====================================================================================
+//
+/*
+	Redistribution and use in source and binary forms, with or without modification,
+	are permitted provided that the following conditions are met:
+
+		1. Redistributions of source code must retain the above copyright notice,
+		   this list of conditions and the following disclaimer.
+
+		2. Redistributions in binary form must reproduce the above copyright notice,
+		   this list of conditions and the following disclaimer in the documentation
+		   and/or other materials provided with the distribution.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"	AND ANY
+	EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+	OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE	ARE DISCLAIMED.
+	IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+	INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+	PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+	LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+	OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "SpoutSharedBuffer.h"
+#include "SpoutFdTransport.h"
+#include "SpoutHistogram.h"
+
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include <atomic>
+#include <new>
+
+#define BENCH_NAME "spout_fd_bench"
+
+// Frame header, followed by the payload
+struct BenchFrame {
+	uint64_t sequence;
+	int64_t timestamp; // spoutHistogram::Now() just before commit
+};
+
+// Shared with the receiver process
+struct BenchShared {
+	std::atomic<int> ready; // receiver has opened the sender
+	std::atomic<int> done; // sender has published all frames
+	uint64_t frames; // frames read
+	uint64_t torn; // frames read with mismatched payload
+	uint64_t retries; // frames overwritten during a read
+	uint64_t misses; // opens that failed
+	spoutHistogramSnapshot latency;
+	spoutHistogramSnapshot read;
+	spoutHistogramSnapshot open;
+};
+
+//
+// Receiver process
+//
+
+template<class Buffer>
+static void RunReceiver(BenchShared& shared, int opens)
+{
+	Buffer buffer;
+	const int64_t deadline = spoutHistogram::Now() + 5000000000LL;
+	while (!buffer.Open(BENCH_NAME)) {
+		if (spoutHistogram::Now() > deadline)
+			return;
+		usleep(1000);
+	}
+	shared.ready.store(1, std::memory_order_release);
+
+	spoutHistogram latency;
+	spoutHistogram read;
+	uint64_t lastversion = 0;
+
+	while (!shared.done.load(std::memory_order_acquire)) {
+
+		// Yield so that a sender on the same core is not held up
+		if (buffer.GetVersion() == lastversion) {
+			sched_yield();
+			continue;
+		}
+
+		int length = 0;
+		uint64_t version = 0;
+		const char* data = buffer.BeginRead(&length, &version);
+		if (!data || length < static_cast<int>(sizeof(BenchFrame)))
+			continue;
+
+		BenchFrame frame;
+		memcpy(&frame, data, sizeof(BenchFrame));
+		latency.RecordSince(frame.timestamp);
+
+		// Read every cache line of the payload in place
+		const int64_t start = spoutHistogram::Now();
+		const uint8_t expected = static_cast<uint8_t>(frame.sequence);
+		bool torn = false;
+		for (int i = sizeof(BenchFrame); i < length; i += 64)
+			torn |= (static_cast<uint8_t>(data[i]) != expected);
+		read.RecordSince(start);
+
+		if (!buffer.EndRead(version)) {
+			shared.retries++;
+			continue;
+		}
+		lastversion = version;
+		shared.frames++;
+		if (torn)
+			shared.torn++;
+	}
+
+	latency.Snapshot(shared.latency);
+	read.Snapshot(shared.read);
+
+	// The sender stays registered until this process has exited
+	buffer.Close();
+	spoutHistogram open;
+	for (int i = 0; i < opens; i++) {
+		Buffer another;
+		const int64_t start = spoutHistogram::Now();
+		if (!another.Open(BENCH_NAME)) {
+			shared.misses++;
+			continue;
+		}
+		open.RecordSince(start);
+	}
+	open.Snapshot(shared.open);
+}
+
+//
+// Sender
+//
+
+template<class Buffer>
+static bool RunTransport(const char* name, int length, int frames, int interval, int opens, bool& failed)
+{
+	BenchShared* pShared = static_cast<BenchShared*>(mmap(nullptr, sizeof(BenchShared),
+		PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0));
+	if (pShared == MAP_FAILED)
+		return false;
+	new (pShared) BenchShared();
+
+	Buffer buffer;
+	if (!buffer.Create(BENCH_NAME, length, 3)) {
+		fprintf(stderr, "spout_fd_bench - %s could not create the sender\n", name);
+		munmap(pShared, sizeof(BenchShared));
+		return false;
+	}
+
+	const pid_t pid = fork();
+	if (pid == 0) {
+		// _exit so that the sender is not closed here
+		RunReceiver<Buffer>(*pShared, opens);
+		_exit(0);
+	}
+	if (pid < 0) {
+		munmap(pShared, sizeof(BenchShared));
+		return false;
+	}
+
+	const int64_t deadline = spoutHistogram::Now() + 5000000000LL;
+	while (!pShared->ready.load(std::memory_order_acquire) && spoutHistogram::Now() < deadline)
+		usleep(1000);
+
+	int64_t next = spoutHistogram::Now();
+	for (int f = 1; f <= frames && pShared->ready.load(std::memory_order_acquire); f++) {
+		int maxlength = 0;
+		char* data = buffer.BeginWrite(&maxlength);
+		if (!data)
+			break;
+
+		BenchFrame frame;
+		frame.sequence = static_cast<uint64_t>(f);
+		memset(data + sizeof(BenchFrame), static_cast<uint8_t>(frame.sequence), maxlength - sizeof(BenchFrame));
+		frame.timestamp = spoutHistogram::Now();
+		memcpy(data, &frame, sizeof(BenchFrame));
+		buffer.Commit(maxlength);
+
+		next += static_cast<int64_t>(interval)*1000;
+		const int64_t wait = next - spoutHistogram::Now();
+		if (wait > 0) {
+			timespec ts;
+			ts.tv_sec = wait/1000000000LL;
+			ts.tv_nsec = wait%1000000000LL;
+			nanosleep(&ts, nullptr);
+		}
+	}
+	pShared->done.store(1, std::memory_order_release);
+
+	int status = 0;
+	waitpid(pid, &status, 0);
+	buffer.Close();
+
+	const BenchShared& shared = *pShared;
+	if (!WIFEXITED(status) || WEXITSTATUS(status) != 0 || !shared.ready.load()) {
+		fprintf(stderr, "spout_fd_bench - %s receiver failed\n", name);
+		failed = true;
+	}
+
+	printf("%s\n", name);
+	printf("  %-10s %10llu read, %llu overwritten, %llu torn, %llu failed opens\n", "frames",
+		static_cast<unsigned long long>(shared.frames), static_cast<unsigned long long>(shared.retries),
+		static_cast<unsigned long long>(shared.torn), static_cast<unsigned long long>(shared.misses));
+
+	const char* labels[3] = { "latency", "read", "open" };
+	const spoutHistogramSnapshot* snapshots[3] = { &shared.latency, &shared.read, &shared.open };
+	for (int i = 0; i < 3; i++) {
+		const spoutHistogramSnapshot& snapshot = *snapshots[i];
+		printf("  %-10s %10llu samples, usec p50 %9.1f  p90 %9.1f  p99 %9.1f  max %9.1f\n",
+			labels[i], static_cast<unsigned long long>(snapshot.count),
+			snapshot.Percentile(50.0)/1000.0, snapshot.Percentile(90.0)/1000.0,
+			snapshot.Percentile(99.0)/1000.0, snapshot.count ? snapshot.max/1000.0 : 0.0);
+	}
+
+	if (shared.torn)
+		failed = true;
+
+	munmap(pShared, sizeof(BenchShared));
+	return true;
+}
+
+//
+// Main
+//
+
+int main(int argc, char* argv[])
+{
+	int kb = 8100; // 1920x1080 RGBA8
+	int frames = 1000;
+	int interval = 1000;
+	int opens = 200;
+
+	int opt = 0;
+	while ((opt = getopt(argc, argv, "k:n:i:o:")) != -1) {
+		switch (opt) {
+			case 'k': kb = atoi(optarg); break;
+			case 'n': frames = atoi(optarg); break;
+			case 'i': interval = atoi(optarg); break;
+			case 'o': opens = atoi(optarg); break;
+			default:
+				fprintf(stderr, "usage: %s [-k frame KB] [-n frames] [-i interval usec] [-o opens]\n", argv[0]);
+				return 2;
+		}
+	}
+	if (kb < 1 || kb > 512*1024 || frames < 1 || interval < 0 || opens < 0) {
+		fprintf(stderr, "spout_fd_bench - invalid arguments\n");
+		return 2;
+	}
+
+	// A private broker address, inherited by the receiver
+	char address[64];
+	snprintf(address, sizeof(address), "@spout_fd_bench_%d", static_cast<int>(getpid()));
+	setenv(SPOUT_FD_BROKER_ENV, address, 1);
+
+	spoutFdBroker broker;
+	if (!broker.Start()) {
+		fprintf(stderr, "spout_fd_bench - could not start the broker\n");
+		return 2;
+	}
+
+	printf("spout_fd_bench : %d KB frames, %d frames every %d usec, %d opens\n", kb, frames, interval, opens);
+
+	bool failed = false;
+	if (!RunTransport<spoutSharedBuffer>("shm", kb*1024, frames, interval, opens, failed))
+		failed = true;
+	if (!RunTransport<spoutFdBuffer>("memfd", kb*1024, frames, interval, opens, failed))
+		failed = true;
+
+	broker.Stop();
+
+	if (failed) {
+		printf("FAILED\n");
+		return 1;
+	}
+
+	printf("OK\n");
+	return 0;
+}
@@ -0,0 +1,254 @@
+//
+//		spout_file_sink_bench
+//
+//		Cost of the plugin's file output to the render thread, and the
+//		throughput of the encoder pool behind it.
+//
+//		Frames of float RGBA are handed to File_Sink at a fixed interval the
+//		way the plugin's render does: Acquire a buffer, copy the frame in and
+//		Submit it. The workers encode and write them to a directory.
+//
+//		Measured
+//			render   Acquire, copy and Submit, what the render pays
+//			encode   time for a worker to encode a frame
+//			wait     time a worker waited for its earlier write to complete
+//
+//		With the drop policy the render time stays at the copy while frames
+//		are dropped once the workers fall behind. With the wait policy no
+//		frame is dropped and the render waits for the workers instead.
+//
+//		Build (Linux)
+//
+//			g++ -std=c++14 -O2 -pthread -I. -ISpout tools/spout_file_sink_bench.cpp
+//				file_sink.cpp Spout/SpoutHistogram.cpp -o spout_file_sink_bench -lrt
+//
+//		Run
+//
+//			./spout_file_sink_bench [-w width] [-h height] [-n frames]
+//				[-i interval usec] [-e exr|png|raw] [-c compression 0-9]
+//				[-p drop|wait] [-d directory]
+//
+//		Set SPOUT_FILE_SINK_THREADS and SPOUT_FILE_SINK_QUEUE_MB to size the pool.
+//		SDK notices are logged to stderr, redirect it to hide them.
+//
+//		Exits with 1 if a file failed to write, a frame was dropped under the
+//		wait policy or a written file is missing.
+//
+// ====================================================================================
+//		Revisions :
+//
+//		17.10.26	- project start
+//
+// ====================================================================================
+//
+/*
+	Redistribution and use in source and binary forms, with or without modification,
+	are permitted provided that the following conditions are met:
+
+		1. Redistributions of source code must retain the above copyright notice,
+		   this list of conditions and the following disclaimer.
+
+		2. Redistributions in binary form must reproduce the above copyright notice,
+		   this list of conditions and the following disclaimer in the documentation
+		   and/or other materials provided with the distribution.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"	AND ANY
+	EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+	OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE	ARE DISCLAIMED.
+	IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+	INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+	PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+	LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+	OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "file_sink.h"
+#include "SpoutHistogram.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+// A gradient with some noise, so the encoders see something like an image
+static void FillFrame(std::vector<float>& frame, int width, int height, int f)
+{
+	uint32_t seed = 2463534242u + static_cast<uint32_t>(f);
+	for (int y = 0; y < height; y++) {
+		float* row = frame.data() + static_cast<size_t>(y)*width*4;
+		for (int x = 0; x < width; x++) {
+			seed ^= seed << 13;
+			seed ^= seed >> 17;
+			seed ^= seed << 5;
+			const float noise = (seed & 0xff)/255.0f*0.02f;
+			row[x*4 + 0] = static_cast<float>(x)/width + noise;
+			row[x*4 + 1] = static_cast<float>(y)/height + noise;
+			row[x*4 + 2] = 0.5f + 0.5f*sinf(static_cast<float>(f + x)*0.01f);
+			row[x*4 + 3] = 1.0f;
+		}
+	}
+}
+
+static void PrintSnapshot(const char* label, const spoutHistogramSnapshot& snapshot)
+{
+	printf("  %-10s %10llu samples, usec p50 %9.1f  p90 %9.1f  p99 %9.1f  max %9.1f\n",
+		label, static_cast<unsigned long long>(snapshot.count),
+		snapshot.Percentile(50.0)/1000.0, snapshot.Percentile(90.0)/1000.0,
+		snapshot.Percentile(99.0)/1000.0, snapshot.count ? snapshot.max/1000.0 : 0.0);
+}
+
+//
+// Main
+//
+
+int main(int argc, char* argv[])
+{
+	int width = 1920;
+	int height = 1080;
+	int frames = 120;
+	int interval = 41666;
+	int compression = 4;
+	std::string encodername = "exr";
+	std::string policyname = "drop";
+	std::string directory = "spout_file_sink_bench_out";
+
+	int opt = 0;
+	while ((opt = getopt(argc, argv, "w:h:n:i:e:c:p:d:")) != -1) {
+		switch (opt) {
+			case 'w': width = atoi(optarg); break;
+			case 'h': height = atoi(optarg); break;
+			case 'n': frames = atoi(optarg); break;
+			case 'i': interval = atoi(optarg); break;
+			case 'e': encodername = optarg; break;
+			case 'c': compression = atoi(optarg); break;
+			case 'p': policyname = optarg; break;
+			case 'd': directory = optarg; break;
+			default:
+				fprintf(stderr, "usage: %s [-w width] [-h height] [-n frames] [-i interval usec] [-e exr|png|raw] [-c compression 0-9] [-p drop|wait] [-d directory]\n", argv[0]);
+				return 2;
+		}
+	}
+
+	int encoder = -1;
+	if (encodername == "exr") encoder = FILE_SINK_EXR;
+	else if (encodername == "png") encoder = FILE_SINK_PNG;
+	else if (encodername == "raw") encoder = FILE_SINK_RAW;
+	const int policy = (policyname == "wait") ? FILE_SINK_WAIT : (policyname == "drop") ? FILE_SINK_DROP : -1;
+
+	if (width < 1 || height < 1 || static_cast<int64_t>(width)*height*16 > 512LL*1024*1024
+		|| frames < 1 || interval < 0 || encoder < 0 || policy < 0 || compression < 0 || compression > 9) {
+		fprintf(stderr, "spout_file_sink_bench - invalid arguments\n");
+		return 2;
+	}
+	mkdir(directory.c_str(), 0755);
+
+	printf("spout_file_sink_bench : %dx%d, %d frames every %d usec, %s level %d, %s policy, %u cores\n",
+		width, height, frames, interval, encodername.c_str(), compression, policyname.c_str(),
+		std::thread::hardware_concurrency());
+
+	File_Sink_Config config;
+	config.directory = directory;
+	config.prefix = "bench";
+	config.encoder = encoder;
+	config.compression = compression;
+	config.policy = policy;
+
+	// Two sources so the copy isn't served from cache every frame
+	std::vector<float> sources[2];
+	for (int i = 0; i < 2; i++) {
+		sources[i].resize(static_cast<size_t>(width)*height*4);
+		FillFrame(sources[i], width, height, i);
+	}
+
+	spoutHistogram render;
+	std::vector<int> submitted;
+	int64_t start = spoutHistogram::Now();
+	int64_t elapsed = 0;
+	File_Sink_Stats stats;
+
+	{
+		File_Sink sink;
+
+		int64_t next = start;
+		for (int f = 1; f <= frames; f++) {
+			const int64_t begin = spoutHistogram::Now();
+			File_Sink_Frame* frame = sink.Acquire(width, height, policy);
+			if (frame) {
+				memcpy(frame->data(), sources[f & 1].data(), sources[f & 1].size()*sizeof(float));
+				sink.Submit(frame, static_cast<double>(f), config);
+				submitted.push_back(f);
+			}
+			render.RecordSince(begin);
+
+			next += static_cast<int64_t>(interval)*1000;
+			const int64_t wait = next - spoutHistogram::Now();
+			if (wait > 0) {
+				timespec ts;
+				ts.tv_sec = wait/1000000000LL;
+				ts.tv_nsec = wait%1000000000LL;
+				nanosleep(&ts, nullptr);
+			}
+		}
+
+		sink.Flush();
+		elapsed = spoutHistogram::Now() - start;
+		sink.Stats(stats);
+
+		spoutHistogramSnapshot snapshots[3];
+		render.Snapshot(snapshots[0]);
+		sink.encode_times.Snapshot(snapshots[1]);
+		sink.write_wait_times.Snapshot(snapshots[2]);
+
+		printf("  %-10s %10llu written, %llu dropped, %llu failed, %.1f MB\n", "frames",
+			static_cast<unsigned long long>(stats.written), static_cast<unsigned long long>(stats.dropped),
+			static_cast<unsigned long long>(stats.failed), stats.bytes/(1024.0*1024.0));
+		PrintSnapshot("render", snapshots[0]);
+		PrintSnapshot("encode", snapshots[1]);
+		PrintSnapshot("wait", snapshots[2]);
+		printf("  %-10s %10.1f fps, %.1f MB/s over the run, ratio %.2f of float RGBA\n", "throughput",
+			stats.written*1e9/elapsed, stats.bytes*1e9/elapsed/(1024.0*1024.0),
+			stats.written ? static_cast<double>(stats.bytes)/(stats.written*static_cast<double>(width)*height*16) : 0.0);
+	}
+
+	// Every frame that was submitted is on disk
+	int missing = 0;
+	static const char* extensions[] = { "exr", "png", "raw" };
+	for (int f : submitted) {
+		char path[512];
+		if (encoder == FILE_SINK_RAW)
+			snprintf(path, sizeof(path), "%s/bench_%dx%d_%06d.%s", directory.c_str(), width, height, f, extensions[encoder]);
+		else
+			snprintf(path, sizeof(path), "%s/bench_%06d.%s", directory.c_str(), f, extensions[encoder]);
+		struct stat st;
+		if (stat(path, &st) != 0 || st.st_size == 0)
+			missing++;
+	}
+
+	bool failed = false;
+	if (stats.failed || missing || stats.written != submitted.size()) {
+		fprintf(stderr, "spout_file_sink_bench - %llu failed, %d missing\n",
+			static_cast<unsigned long long>(stats.failed), missing);
+		failed = true;
+	}
+	if (policy == FILE_SINK_WAIT && stats.dropped) {
+		fprintf(stderr, "spout_file_sink_bench - frames dropped under the wait policy\n");
+		failed = true;
+	}
+
+	if (failed) {
+		printf("FAILED\n");
+		return 1;
+	}
+
+	printf("OK\n");
+	return 0;
+}
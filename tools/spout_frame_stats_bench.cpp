@@ -0,0 +1,445 @@
+//
+//		spout_frame_stats_bench
+//
+//		Cost of the frame stats folded into the copy, and a check that they
+//		are right.
+//
+//		Frames of float RGBA with NaN, Inf and out of range values mixed in,
+//		or of 8 bit RGBA, are handed to Output_Dispatcher the way the plugin's
+//		plain CPU render does, and a sink copies the bands to a staging buffer
+//		as the shared texture sink does. The stats modes do the same copy
+//		through Frame_Stats_Accumulator, so the difference is what the stats
+//		add to a copy that reads and writes the frame once either way.
+//
+//			copy          the bands copied with memcpy
+//			copy+stats    the copy with the stats, AVX2 and scalar
+//			read+stats    the stats with no destination, as the YUV conversion
+//			              and the reduction take them before using the rows
+//			copy 8 bit    the same on 8 bit RGBA
+//
+//		Every frame's stats are compared with a plain loop over the frame,
+//		the copy with the source, and the stats are written through
+//		Frame_Stats_Map and read back as a receiver would. Parts of uneven
+//		height, like the host's render windows, are checked to add up to the
+//		same stats, and a frame with a part missing to give none.
+//
+//		Build (Linux)
+//
+//			g++ -std=c++14 -O2 -pthread -I. -ISpout tools/spout_frame_stats_bench.cpp
+//				frame_stats.cpp output_sink.cpp file_sink.cpp Spout/SpoutSharedMemory.cpp
+//				Spout/SpoutSharedBuffer.cpp Spout/SpoutHistogram.cpp
+//				-o spout_frame_stats_bench -lrt
+//
+//		Run
+//
+//			./spout_frame_stats_bench [-w width] [-h height] [-n frames] [-t threads]
+//
+//		SDK notices are logged to stderr, redirect it to hide them.
+//
+//		Exits with 1 if the stats of a frame are wrong.
+//
+// ====================================================================================
+//		Revisions :
+//
+//		17.10.26	- project start
+//
+// ====================================================================================
+//
+/*
+	Redistribution and use in source and binary forms, with or without modification,
+	are permitted provided that the following conditions are met:
+
+		1. Redistributions of source code must retain the above copyright notice,
+		   this list of conditions and the following disclaimer.
+
+		2. Redistributions in binary form must reproduce the above copyright notice,
+		   this list of conditions and the following disclaimer in the documentation
+		   and/or other materials provided with the distribution.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"	AND ANY
+	EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+	OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE	ARE DISCLAIMED.
+	IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+	INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+	PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+	LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+	OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "frame_stats.h"
+#include "output_sink.h"
+#include "SpoutHistogram.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#define BENCH_NAME "spout_frame_stats_bench"
+#define BENCH_HEADER_BYTES 128
+
+static size_t PixelBytes(int depth)
+{
+	return depth == FRAME_STATS_BYTE ? 4 : 4*sizeof(float);
+}
+
+// Float values from -0.25 to 1.25 with a few NaN and Inf, or any 8 bit value. Different for every frame.
+static void FillSource(std::vector<char>& source, int depth, int frame)
+{
+	uint32_t state = 0x9e3779b9u ^ static_cast<uint32_t>(frame)*2654435761u;
+	if (depth == FRAME_STATS_BYTE) {
+		for (size_t i = 0; i < source.size(); i++) {
+			state = state*1664525u + 1013904223u;
+			source[i] = static_cast<char>(state >> 24);
+		}
+		return;
+	}
+
+	float* values = reinterpret_cast<float*>(source.data());
+	for (size_t i = 0; i < source.size()/sizeof(float); i++) {
+		state = state*1664525u + 1013904223u;
+		const uint32_t r = state >> 8;
+		if ((r & 0x3ff) == 0)
+			values[i] = NAN;
+		else if ((r & 0x3ff) == 1)
+			values[i] = (r & 0x400) ? INFINITY : -INFINITY;
+		else
+			values[i] = static_cast<float>(r & 0xffff)/65535.0f*1.5f - 0.25f;
+	}
+}
+
+// Plain loop over the whole frame, without parts or threads
+static void Reference(const std::vector<char>& source, int width, int height, int depth, Frame_Stats& stats)
+{
+	Frame_Stats_Partial partial;
+	partial.clear();
+	frame_stats_copy_rows_scalar(source.data(), static_cast<size_t>(width)*PixelBytes(depth), nullptr, 0, width, height, depth, partial);
+	memset(&stats, 0, sizeof(stats));
+	partial.finish(stats);
+}
+
+// Counts, minimum, maximum and histogram exact, the means to float rounding of the part sums
+static bool Matches(const Frame_Stats& a, const Frame_Stats& b)
+{
+	for (int c = 0; c < 4; c++) {
+		if (a.min[c] != b.min[c] || a.max[c] != b.max[c]
+			|| a.nan_count[c] != b.nan_count[c] || a.inf_count[c] != b.inf_count[c]
+			|| a.under_count[c] != b.under_count[c] || a.over_count[c] != b.over_count[c])
+			return false;
+		if (fabs(static_cast<double>(a.mean[c]) - b.mean[c]) > 1e-5*(1.0 + fabs(static_cast<double>(b.mean[c]))))
+			return false;
+	}
+	return memcmp(a.luma, b.luma, sizeof(a.luma)) == 0;
+}
+
+// Copies the bands to a staging buffer, through the stats when they are set, as the plugin's Texture_Sink
+class Staging_Sink : public Output_Sink {
+public:
+	std::vector<char> staging;
+	Frame_Stats_Accumulator* stats = nullptr;
+	// Stats only, the rows are read and nothing is written
+	bool read_only = false;
+
+	virtual bool prepare(const Output_Frame& frame) override
+	{
+		width = frame.width;
+		row_bytes = frame.row_bytes();
+		staging.resize(row_bytes*frame.height);
+		return true;
+	}
+
+	virtual void write_band(const char* src, size_t pitch, int y_begin, int y_end) override
+	{
+		char* dst = staging.data() + static_cast<size_t>(y_begin)*row_bytes;
+		if (stats) {
+			stats->copy_rows(src, pitch, read_only ? nullptr : dst, row_bytes, width, y_end - y_begin, stats->part(y_begin));
+			return;
+		}
+		for (int y = y_begin; y < y_end; y++, src += pitch, dst += row_bytes)
+			memcpy(dst, src, row_bytes);
+	}
+
+	virtual bool publish() override
+	{
+		return !stats || stats->finish() != nullptr;
+	}
+
+private:
+	int width = 0;
+	size_t row_bytes = 0;
+};
+// Runs the dispatcher on a number of threads, as the host's render threads do
+static void Dispatch(Output_Dispatcher& dispatcher, int threads)
+{
+	std::vector<std::thread> workers;
+	for (int t = 1; t < threads; t++)
+		workers.emplace_back([&dispatcher] { dispatcher.run(); });
+	dispatcher.run();
+	for (auto& worker : workers)
+		worker.join();
+}
+
+static void PrintTimes(const char* name, spoutHistogram& times, double mbytes)
+{
+	spoutHistogramSnapshot snapshot;
+	times.Snapshot(snapshot);
+	const double p50 = snapshot.Percentile(50.0)/1000.0;
+	printf("  %-11s usec p50 %9.1f  p90 %9.1f  p99 %9.1f  max %9.1f  %8.1f MB/s at p50\n",
+		name, p50, snapshot.Percentile(90.0)/1000.0, snapshot.Percentile(99.0)/1000.0,
+		snapshot.count ? snapshot.max/1000.0 : 0.0, p50 > 0.0 ? mbytes/(p50/1000000.0) : 0.0);
+}
+
+//
+// Modes
+//
+
+struct BenchConfig {
+	int width;
+	int height;
+	int frames;
+	int threads;
+};
+
+enum Stats_Mode {
+	STATS_NONE = 0,
+	STATS_COPY,
+	STATS_READ,
+};
+
+// Returns false if the stats or the copy of a frame were wrong, or the stats didn't come back through the map
+static bool RunMode(const char* name, const BenchConfig& config, int mode, bool scalar, int depth)
+{
+	const size_t rowbytes = static_cast<size_t>(config.width)*PixelBytes(depth);
+	const size_t framebytes = rowbytes*config.height;
+
+	Frame_Stats_Accumulator stats;
+	stats.force_scalar = scalar;
+
+	Staging_Sink staging_sink;
+	staging_sink.stats = mode != STATS_NONE ? &stats : nullptr;
+	staging_sink.read_only = mode == STATS_READ;
+
+	Output_Dispatcher dispatcher;
+	dispatcher.add(&staging_sink);
+
+	Frame_Stats_Map writer;
+	Frame_Stats_Map reader;
+
+	std::vector<char> source(framebytes);
+	spoutHistogram times;
+	uint64_t wrong = 0;
+	uint64_t unread = 0;
+	uint64_t skipped = 0;
+
+	for (int f = 1; f <= config.frames; f++) {
+		FillSource(source, depth, f);
+
+		char header[BENCH_HEADER_BYTES] = {};
+		Output_Frame frame;
+		frame.width = config.width;
+		frame.height = config.height;
+		frame.pixel_bytes = static_cast<int>(PixelBytes(depth));
+		frame.time = f;
+		frame.header = header;
+		frame.header_bytes = sizeof(header);
+
+		int published = 0;
+		{
+			spoutHistogramTimer timer(times);
+			if (mode != STATS_NONE)
+				stats.begin(config.width, config.height, depth, f);
+			if (dispatcher.begin(frame, source.data(), rowbytes) == 1)
+				Dispatch(dispatcher, config.threads);
+			published = dispatcher.finish();
+		}
+		if (published != 1)
+			skipped++;
+
+		if (mode != STATS_READ && memcmp(staging_sink.staging.data(), source.data(), framebytes) != 0)
+			wrong++;
+
+		if (mode == STATS_NONE)
+			continue;
+
+		const Frame_Stats* result = stats.frame_stats();
+		if (!result) {
+			wrong++;
+			continue;
+		}
+		Frame_Stats expected;
+		Reference(source, config.width, config.height, depth, expected);
+		if (!Matches(*result, expected) || result->width != static_cast<uint32_t>(config.width)
+			|| result->height != static_cast<uint32_t>(config.height) || result->time != f)
+			wrong++;
+
+		// The plugin stamps the sequence from the frame metadata
+		Frame_Stats sent = *result;
+		sent.sequence = static_cast<uint64_t>(f);
+		Frame_Stats received = {};
+		if (!writer.write(BENCH_NAME, sent) || !reader.read(BENCH_NAME, received))
+			unread++;
+		else if (memcmp(&sent, &received, sizeof(sent)) != 0)
+			wrong++;
+	}
+
+	reader.close();
+	writer.close();
+
+	printf("%s\n", name);
+	printf("  %-11s %llu skipped, %llu wrong, %llu unread\n", "frames",
+		static_cast<unsigned long long>(skipped), static_cast<unsigned long long>(wrong),
+		static_cast<unsigned long long>(unread));
+	PrintTimes("dispatch", times, framebytes/1048576.0);
+
+	const bool ok = wrong == 0 && unread == 0 && skipped == 0;
+	if (!ok)
+		fprintf(stderr, "spout_frame_stats_bench - %s failed\n", name);
+	return ok;
+}
+
+// A small frame with a width that leaves pixels over after the vector loop, copied with both kernels
+static bool CheckTail(int depth)
+{
+	const int width = 37;
+	const int height = 19;
+	std::vector<char> source(static_cast<size_t>(width)*height*PixelBytes(depth));
+	FillSource(source, depth, 0);
+	if (depth == FRAME_STATS_FLOAT) {
+		// Values on the histogram and clipping edges
+		const float edges[] = { 0.0f, -0.0f, 1.0f, 1.0f/FRAME_STATS_LUMA_BINS, 0.5f, 63.0f/FRAME_STATS_LUMA_BINS };
+		float* values = reinterpret_cast<float*>(source.data());
+		for (size_t i = 0; i < sizeof(edges)/sizeof(edges[0]); i++)
+			for (int c = 0; c < 4; c++)
+				values[(i*5)*4 + c] = edges[i];
+	}
+
+	// Destination rows wider than the source, as a mapped texture's are
+	const size_t pitch = static_cast<size_t>(width)*PixelBytes(depth);
+	const size_t dst_pitch = pitch + 64;
+	std::vector<char> copy_scalar(dst_pitch*height, 0);
+	std::vector<char> copy_avx2(dst_pitch*height, 0);
+	Frame_Stats_Partial scalar;
+	Frame_Stats_Partial avx2;
+	scalar.clear();
+	avx2.clear();
+	frame_stats_copy_rows_scalar(source.data(), pitch, copy_scalar.data(), dst_pitch, width, height, depth, scalar);
+	frame_stats_copy_rows_avx2(source.data(), pitch, copy_avx2.data(), dst_pitch, width, height, depth, avx2);
+
+	bool copied = copy_scalar == copy_avx2;
+	for (int y = 0; y < height; y++)
+		copied &= memcmp(copy_avx2.data() + y*dst_pitch, source.data() + y*pitch, pitch) == 0;
+
+	Frame_Stats a = {};
+	Frame_Stats b = {};
+	scalar.finish(a);
+	avx2.finish(b);
+	const bool ok = Matches(b, a) && copied;
+	printf("tail %dx%d %s\n  %-11s %s, %s\n", width, height, depth == FRAME_STATS_BYTE ? "8 bit" : "float", "avx2",
+		Matches(b, a) ? "matches scalar" : "differs from scalar", copied ? "copy intact" : "copy wrong");
+	return ok;
+}
+
+// Parts of uneven height, started out of order, as render windows split by the host are
+static bool CheckParts(const BenchConfig& config)
+{
+	const int depth = FRAME_STATS_FLOAT;
+	const size_t pitch = static_cast<size_t>(config.width)*PixelBytes(depth);
+	std::vector<char> source(pitch*config.height);
+	FillSource(source, depth, 7);
+
+	Frame_Stats expected;
+	Reference(source, config.width, config.height, depth, expected);
+
+	// Part boundaries, a row of its own at the top and a part that ends at the last row
+	std::vector<int> bounds;
+	bounds.push_back(0);
+	for (int y = 1; y < config.height; y += 1 + (y*7919) % 97)
+		bounds.push_back(y);
+	bounds.push_back(config.height);
+
+	Frame_Stats_Accumulator stats;
+	bool ok = true;
+	for (int missing = -1; missing < 1; missing++) {
+		stats.begin(config.width, config.height, depth, 0.0);
+		for (size_t i = bounds.size() - 1; i-- > 0;) {
+			if (static_cast<int>(i) == missing)
+				continue;
+			const int y = bounds[i];
+			stats.copy_rows(source.data() + y*pitch, pitch, nullptr, 0, config.width, bounds[i + 1] - y, stats.part(y));
+		}
+		const Frame_Stats* result = stats.finish();
+		if (missing < 0)
+			ok &= result && Matches(*result, expected);
+		else
+			ok &= result == nullptr && stats.frame_stats() == nullptr;
+	}
+
+	printf("parts\n  %-11s %d parts %s, a part missing %s\n", "stats", static_cast<int>(bounds.size()) - 1,
+		ok ? "add up" : "wrong", ok ? "gives none" : "or gives some");
+	return ok;
+}
+
+//
+// Main
+//
+
+int main(int argc, char* argv[])
+{
+	BenchConfig config;
+	config.width = 1920;
+	config.height = 1080;
+	config.frames = 60;
+	config.threads = 2;
+
+	int opt = 0;
+	while ((opt = getopt(argc, argv, "w:h:n:t:")) != -1) {
+		switch (opt) {
+			case 'w': config.width = atoi(optarg); break;
+			case 'h': config.height = atoi(optarg); break;
+			case 'n': config.frames = atoi(optarg); break;
+			case 't': config.threads = atoi(optarg); break;
+			default:
+				fprintf(stderr, "usage: %s [-w width] [-h height] [-n frames] [-t threads]\n", argv[0]);
+				return 2;
+		}
+	}
+	if (config.width < 1 || config.height < 1
+		|| static_cast<int64_t>(config.width)*config.height*16 > 512LL*1024*1024
+		|| config.frames < 1 || config.threads < 1 || config.threads > 64) {
+		fprintf(stderr, "spout_frame_stats_bench - invalid arguments\n");
+		return 2;
+	}
+
+	const bool avx2 = frame_stats_has_avx2();
+	printf("spout_frame_stats_bench : %dx%d RGBA, %d frames, %d threads, %u cores, AVX2 %s\n",
+		config.width, config.height, config.frames, config.threads, std::thread::hardware_concurrency(),
+		avx2 ? "yes" : "no");
+
+	bool failed = false;
+	if (avx2) {
+		failed |= !CheckTail(FRAME_STATS_FLOAT);
+		failed |= !CheckTail(FRAME_STATS_BYTE);
+	}
+	failed |= !CheckParts(config);
+	failed |= !RunMode("copy", config, STATS_NONE, false, FRAME_STATS_FLOAT);
+	failed |= !RunMode("copy+stats", config, STATS_COPY, false, FRAME_STATS_FLOAT);
+	if (avx2)
+		failed |= !RunMode("copy+stats scalar", config, STATS_COPY, true, FRAME_STATS_FLOAT);
+	failed |= !RunMode("read+stats", config, STATS_READ, false, FRAME_STATS_FLOAT);
+	failed |= !RunMode("copy 8 bit", config, STATS_NONE, false, FRAME_STATS_BYTE);
+	failed |= !RunMode("copy+stats 8 bit", config, STATS_COPY, false, FRAME_STATS_BYTE);
+
+	if (failed) {
+		printf("FAILED\n");
+		return 1;
+	}
+
+	printf("OK\n");
+	return 0;
+}
@@ -0,0 +1,273 @@
+//
+//		spout_genlock_test
+//
+//		Checks that senders in a Genlock Group publish together.
+//
+//		Threads stand in for sender instances, each with its own
+//		Genlock_Group on the same group as separate processes would have.
+//		They render every frame for a random time and stage it, then
+//		every member must get the same generation for the frame and the
+//		generation must go up by one each frame.
+//
+//			sync     every member renders every frame, none may time out
+//			stall    one member stops rendering for a while, the others
+//			         must publish after the timeout and not wait for it
+//			leave    one member leaves, the others must not wait for it
+//
+//		A receiver reads the group as it goes and must never see the
+//		generation go back or the time of a generation change.
+//
+//		Build (Linux)
+//
+//			g++ -std=c++14 -O2 -pthread -I. -ISpout tools/spout_genlock_test.cpp
+//				genlock.cpp Spout/SpoutSharedMemory.cpp Spout/SpoutHistogram.cpp
+//				-o spout_genlock_test -lrt
+//
+//		Run
+//
+//			./spout_genlock_test [-m members] [-n frames] [-r render msec] [-t timeout msec]
+//
+//		SDK notices are logged to stderr, redirect it to hide them.
+//
+//		Exits with 1 if members published a frame with different generations
+//		or waited for a member that wasn't rendering.
+//
+// ====================================================================================
+//		Revisions :
+//
+//		17.10.26	- project start
+//
+// ====================================================================================
+//
+/*
+	Redistribution and use in source and binary forms, with or without modification,
+	are permitted provided that the following conditions are met:
+
+		1. Redistributions of source code must retain the above copyright notice,
+		   this list of conditions and the following disclaimer.
+
+		2. Redistributions in binary form must reproduce the above copyright notice,
+		   this list of conditions and the following disclaimer in the documentation
+		   and/or other materials provided with the distribution.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"	AND ANY
+	EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+	OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE	ARE DISCLAIMED.
+	IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+	INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+	PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+	LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+	OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "genlock.h"
+#include "SpoutHistogram.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define TEST_GROUP "spout_genlock_test"
+
+struct TestConfig {
+	int members;
+	int frames;
+	int render_ms;
+	int timeout_ms;
+};
+
+static void PrintTimes(const char* name, const spoutHistogramSnapshot& snapshot)
+{
+	printf("  %-11s usec p50 %9.1f  p90 %9.1f  p99 %9.1f  max %9.1f\n",
+		name, snapshot.Percentile(50.0)/1000.0, snapshot.Percentile(90.0)/1000.0,
+		snapshot.Percentile(99.0)/1000.0, snapshot.count ? snapshot.max/1000.0 : 0.0);
+}
+
+// Reads the group until stop, as a receiver flipping its outputs on the generation would
+static void Receive(const std::string& group, std::atomic<bool>& stop, std::atomic<int>& errors, uint64_t& last)
+{
+	Genlock_Group receiver;
+	receiver.open(group);
+	Genlock_State previous;
+	while (!stop.load()) {
+		Genlock_State state;
+		if (receiver.read(state)) {
+			if (state.generation < previous.generation
+				|| (state.generation == previous.generation && state.generation != 0 && state.time != previous.time))
+				errors++;
+			previous = state;
+		}
+		std::this_thread::sleep_for(std::chrono::microseconds(100));
+	}
+	last = previous.generation;
+}
+
+//
+// Modes
+//
+
+// stall_member stops rendering for stall_ms before stall_frame, leave_member leaves before leave_frame.
+// -1 for neither.
+static bool RunMode(const char* name, const TestConfig& config, int stall_member, int stall_frame, int stall_ms,
+	int leave_member, int leave_frame)
+{
+	const std::string group = std::string(TEST_GROUP) + "_" + name;
+	const int members = config.members;
+	const int frames = config.frames;
+
+	// generations[member*frames + frame], 0 where the member didn't publish the frame
+	std::vector<uint64_t> generations(static_cast<size_t>(members)*frames, 0);
+	std::vector<spoutHistogramSnapshot> waits(members);
+	std::vector<uint64_t> timeouts(members, 0);
+
+	std::atomic<bool> stop(false);
+	std::atomic<int> receive_errors(0);
+	uint64_t received = 0;
+	std::thread receiver(Receive, group, std::ref(stop), std::ref(receive_errors), std::ref(received));
+
+	// Everyone joins before the first frame, as instances of a running timeline have
+	std::atomic<int> ready(0);
+	std::vector<std::thread> threads;
+	for (int m = 0; m < members; m++) {
+		threads.emplace_back([&, m] {
+			Genlock_Group genlock;
+			genlock.timeout_ns = static_cast<int64_t>(config.timeout_ms)*1000000;
+			genlock.join(group);
+			ready++;
+			while (ready.load() < members)
+				std::this_thread::yield();
+
+			std::mt19937 random(static_cast<uint32_t>(m)*7919u + 1u);
+			std::uniform_int_distribution<int> render(0, config.render_ms*1000);
+			for (int f = 0; f < frames; f++) {
+				if (m == leave_member && f == leave_frame) {
+					genlock.leave();
+					break;
+				}
+				if (m == stall_member && f == stall_frame)
+					std::this_thread::sleep_for(std::chrono::milliseconds(stall_ms));
+				std::this_thread::sleep_for(std::chrono::microseconds(render(random)));
+				generations[static_cast<size_t>(m)*frames + f] = genlock.stage(static_cast<double>(f)/25.0);
+			}
+
+			Genlock_State state;
+			Genlock_Group reader;
+			if (reader.open(group) && reader.read(state))
+				timeouts[m] = state.timeouts;
+			genlock.wait_times.Snapshot(waits[m]);
+		});
+	}
+	for (auto& thread : threads)
+		thread.join();
+	stop = true;
+	receiver.join();
+
+	// A stalled member publishes the frames it's late for on its own, so only the others are compared
+	int mismatched = 0;
+	int skipped = 0;
+	uint64_t previous = 0;
+	for (int f = 0; f < frames; f++) {
+		uint64_t generation = 0;
+		for (int m = 0; m < members; m++) {
+			if (m == stall_member && f >= stall_frame)
+				continue;
+			if (m == leave_member && f >= leave_frame)
+				continue;
+			const uint64_t g = generations[static_cast<size_t>(m)*frames + f];
+			if (g == 0)
+				skipped++;
+			else if (generation == 0)
+				generation = g;
+			else if (g != generation)
+				mismatched++;
+		}
+		if (generation <= previous)
+			mismatched++;
+		previous = generation;
+	}
+
+	spoutHistogramSnapshot all;
+	uint64_t timed_out = 0;
+	for (int m = 0; m < members; m++) {
+		if (m != stall_member)
+			all.Merge(waits[m]);
+		if (timeouts[m] > timed_out)
+			timed_out = timeouts[m];
+	}
+
+	printf("%s\n", name);
+	printf("  %-11s %d mismatched, %d unpublished, %llu timeouts, receiver saw %llu with %d errors\n", "frames",
+		mismatched, skipped, static_cast<unsigned long long>(timed_out), static_cast<unsigned long long>(received),
+		receive_errors.load());
+	PrintTimes("wait", all);
+
+	bool ok = mismatched == 0 && skipped == 0 && receive_errors.load() == 0 && received != 0;
+	// Members that render every frame release it together, without waiting out the timeout
+	if (stall_member < 0 && timed_out != 0)
+		ok = false;
+	// The others publish once the timeout passes rather than waiting out the whole stall, and the stalled member
+	// catches up without holding the group back again
+	if (stall_member >= 0 && (timed_out == 0 || timed_out > static_cast<uint64_t>(stall_ms/config.timeout_ms + 2)
+		|| all.max >= static_cast<uint64_t>(stall_ms)*1000000))
+		ok = false;
+	if (!ok)
+		fprintf(stderr, "spout_genlock_test - %s failed\n", name);
+	return ok;
+}
+
+//
+// Main
+//
+
+int main(int argc, char* argv[])
+{
+	TestConfig config;
+	config.members = 4;
+	config.frames = 200;
+	config.render_ms = 4;
+	config.timeout_ms = 100;
+
+	int opt = 0;
+	while ((opt = getopt(argc, argv, "m:n:r:t:")) != -1) {
+		switch (opt) {
+			case 'm': config.members = atoi(optarg); break;
+			case 'n': config.frames = atoi(optarg); break;
+			case 'r': config.render_ms = atoi(optarg); break;
+			case 't': config.timeout_ms = atoi(optarg); break;
+			default:
+				fprintf(stderr, "usage: %s [-m members] [-n frames] [-r render msec] [-t timeout msec]\n", argv[0]);
+				return 2;
+		}
+	}
+	if (config.members < 2 || config.members > GENLOCK_MAX_MEMBERS || config.frames < 10
+		|| config.render_ms < 0 || config.timeout_ms < 10 || config.timeout_ms > 500) {
+		fprintf(stderr, "spout_genlock_test - invalid arguments\n");
+		return 2;
+	}
+
+	printf("spout_genlock_test : %d members, %d frames, %d msec render, %d msec timeout, %u cores\n",
+		config.members, config.frames, config.render_ms, config.timeout_ms, std::thread::hardware_concurrency());
+
+	// The stall is shorter than GENLOCK_ACTIVE_NS, so the stalled member is still waited for until the timeout
+	const int stall_ms = config.timeout_ms*3;
+	bool failed = false;
+	failed |= !RunMode("sync", config, -1, 0, 0, -1, 0);
+	failed |= !RunMode("stall", config, config.members - 1, config.frames/2, stall_ms, -1, 0);
+	failed |= !RunMode("leave", config, -1, 0, 0, config.members - 1, config.frames/2);
+
+	if (failed) {
+		printf("FAILED\n");
+		return 1;
+	}
+
+	printf("OK\n");
+	return 0;
+}
@@ -0,0 +1,230 @@
+//
+//		spout_latency_probe
+//
+//		Time from publish to consume of the frames of one or more senders.
+//
+//		Every frame the plugin publishes carries its sequence and the steady
+//		clock time it was published in "<sender>_FrameMetadata". The probe
+//		reads the metadata of each sender it is given, takes each new frame
+//		as consumed when it sees it and keeps, per sender, histograms of
+//		the latency, of the sequence step between the frames it got and of
+//		the time between them. Receivers can do the same with their own
+//		consume time through latency_probe.h.
+//
+//		The plugin only runs on Windows. For soak tests on Linux, -p
+//		publishes frames on every sender name at a rate from a thread the
+//		way the plugin does, through the POSIX SpoutSharedMemory backend.
+//
+//		Build (Linux)
+//
+//			g++ -std=c++14 -O2 -pthread -I. -ISpout tools/spout_latency_probe.cpp
+//				latency_probe.cpp Spout/SpoutSharedMemory.cpp Spout/SpoutHistogram.cpp
+//				-o spout_latency_probe -lrt
+//
+//		Run
+//
+//			./spout_latency_probe -s sender [-s sender ...] [-t seconds] [-i poll usec]
+//				[-p fps] [-j file.json] [-c file.csv] [-l p99 msec] [-d dropped %]
+//
+//		SDK notices are logged to stderr, redirect it to hide them.
+//
+//		Exits with 1 if a sender published nothing, or the p99 latency or
+//		the share of frames dropped of a sender is over the limit given.
+//
+// ====================================================================================
+//		Revisions :
+//
+//		17.10.26	- project start
+//
+// ====================================================================================
+//
+/*
+	Redistribution and use in source and binary forms, with or without modification,
+	are permitted provided that the following conditions are met:
+
+		1. Redistributions of source code must retain the above copyright notice,
+		   this list of conditions and the following disclaimer.
+
+		2. Redistributions in binary form must reproduce the above copyright notice,
+		   this list of conditions and the following disclaimer in the documentation
+		   and/or other materials provided with the distribution.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"	AND ANY
+	EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+	OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE	ARE DISCLAIMED.
+	IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+	INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+	PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+	LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+	OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "latency_probe.h"
+#include "SpoutHistogram.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct ProbeConfig {
+	std::vector<std::string> senders;
+	int seconds;
+	int poll_usec;
+	double publish_fps;
+	const char* json;
+	const char* csv;
+	double p99_limit_ms;
+	double dropped_limit;
+};
+
+static void PrintTimes(const char* name, const spoutHistogram& times)
+{
+	spoutHistogramSnapshot snapshot;
+	times.Snapshot(snapshot);
+	printf("  %-11s usec p50 %9.1f  p90 %9.1f  p99 %9.1f  max %9.1f\n",
+		name, snapshot.Percentile(50.0)/1000.0, snapshot.Percentile(90.0)/1000.0,
+		snapshot.Percentile(99.0)/1000.0, snapshot.count ? snapshot.max/1000.0 : 0.0);
+}
+
+// Stands in for the plugin on Linux, a frame of metadata on the sender every 1/fps seconds
+static void Publish(const std::string& sender, double fps, std::atomic<bool>& stop, uint64_t& published)
+{
+	Frame_Metadata_Map map;
+	const auto interval = std::chrono::nanoseconds(static_cast<int64_t>(1e9/fps));
+	auto next = std::chrono::steady_clock::now();
+	uint64_t frame = 0;
+	while (!stop.load()) {
+		SpoutFrameMetadata metadata = {};
+		metadata.time = static_cast<double>(frame)/fps;
+		metadata.renderScaleX = 1.0;
+		metadata.renderScaleY = 1.0;
+		metadata.width = 1920;
+		metadata.height = 1080;
+		if (map.write(sender.c_str(), metadata))
+			frame++;
+		next += interval;
+		std::this_thread::sleep_until(next);
+	}
+	published = frame;
+	map.close();
+}
+
+//
+// Main
+//
+
+int main(int argc, char* argv[])
+{
+	ProbeConfig config;
+	config.seconds = 10;
+	config.poll_usec = 100;
+	config.publish_fps = 0.0;
+	config.json = nullptr;
+	config.csv = nullptr;
+	config.p99_limit_ms = 0.0;
+	config.dropped_limit = -1.0;
+
+	int opt = 0;
+	while ((opt = getopt(argc, argv, "s:t:i:p:j:c:l:d:")) != -1) {
+		switch (opt) {
+			case 's': config.senders.push_back(optarg); break;
+			case 't': config.seconds = atoi(optarg); break;
+			case 'i': config.poll_usec = atoi(optarg); break;
+			case 'p': config.publish_fps = atof(optarg); break;
+			case 'j': config.json = optarg; break;
+			case 'c': config.csv = optarg; break;
+			case 'l': config.p99_limit_ms = atof(optarg); break;
+			case 'd': config.dropped_limit = atof(optarg); break;
+			default:
+				fprintf(stderr, "usage: %s -s sender [-s sender ...] [-t seconds] [-i poll usec] [-p fps]"
+					" [-j file.json] [-c file.csv] [-l p99 msec] [-d dropped %%]\n", argv[0]);
+				return 2;
+		}
+	}
+	if (config.senders.empty() || config.seconds < 1 || config.poll_usec < 0
+		|| config.publish_fps < 0.0 || config.publish_fps > 10000.0 || config.p99_limit_ms < 0.0) {
+		fprintf(stderr, "spout_latency_probe - invalid arguments\n");
+		return 2;
+	}
+
+	printf("spout_latency_probe : %d senders, %d seconds, poll every %d usec", static_cast<int>(config.senders.size()),
+		config.seconds, config.poll_usec);
+	if (config.publish_fps > 0.0)
+		printf(", publishing at %.2f fps", config.publish_fps);
+	printf("\n");
+
+	Latency_Probe probe;
+	for (auto& sender : config.senders)
+		probe.watch(sender.c_str());
+
+	std::atomic<bool> stop(false);
+	std::vector<uint64_t> published(config.senders.size(), 0);
+	std::vector<std::thread> publishers;
+	if (config.publish_fps > 0.0) {
+		for (size_t i = 0; i < config.senders.size(); i++)
+			publishers.emplace_back(Publish, config.senders[i], config.publish_fps, std::ref(stop), std::ref(published[i]));
+	}
+
+	const int64_t end = spoutHistogram::Now() + static_cast<int64_t>(config.seconds)*1000000000LL;
+	while (spoutHistogram::Now() < end) {
+		probe.poll();
+		if (config.poll_usec > 0)
+			std::this_thread::sleep_for(std::chrono::microseconds(config.poll_usec));
+	}
+
+	stop = true;
+	for (auto& publisher : publishers)
+		publisher.join();
+
+	bool failed = false;
+	for (size_t i = 0; i < probe.senders().size(); i++) {
+		const auto& sender = *probe.senders()[i];
+		const uint64_t total = sender.frames + sender.dropped;
+		const double dropped = total ? 100.0*sender.dropped/total : 0.0;
+		printf("%s\n", sender.name.c_str());
+		printf("  %-11s %llu consumed, %llu dropped (%.2f%%), %llu restarts", "frames",
+			static_cast<unsigned long long>(sender.frames), static_cast<unsigned long long>(sender.dropped), dropped,
+			static_cast<unsigned long long>(sender.restarts));
+		if (config.publish_fps > 0.0)
+			printf(", %llu published", static_cast<unsigned long long>(published[i]));
+		printf("\n");
+		PrintTimes("latency", sender.latency);
+		PrintTimes("interval", sender.intervals);
+
+		spoutHistogramSnapshot latency;
+		sender.latency.Snapshot(latency);
+		bool ok = sender.frames > 0;
+		if (config.p99_limit_ms > 0.0 && latency.Percentile(99.0)/1e6 > config.p99_limit_ms)
+			ok = false;
+		if (config.dropped_limit >= 0.0 && dropped > config.dropped_limit)
+			ok = false;
+		if (!ok) {
+			fprintf(stderr, "spout_latency_probe - %s failed\n", sender.name.c_str());
+			failed = true;
+		}
+	}
+
+	if (config.json && !probe.write_json(config.json)) {
+		fprintf(stderr, "spout_latency_probe - could not write %s\n", config.json);
+		failed = true;
+	}
+	if (config.csv && !probe.write_csv(config.csv)) {
+		fprintf(stderr, "spout_latency_probe - could not write %s\n", config.csv);
+		failed = true;
+	}
+
+	if (failed) {
+		printf("FAILED\n");
+		return 1;
+	}
+
+	printf("OK\n");
+	return 0;
+}
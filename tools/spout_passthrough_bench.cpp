@@ -0,0 +1,299 @@
+//
+//		spout_passthrough_bench
+//
+//		What the CPU copies of a published frame cost: the passthrough copy
+//		that Skip Passthrough Copy saves, and the copy of the frame for the
+//		publish at full size, at half resolution and at half resolution in
+//		half float, the steps of the receiver lag fallback.
+//
+//		Frames are float RGBA in memory, as the host hands them to the plugin.
+//
+//			passthrough     the copy render makes into the host's output
+//			full            the float frame copied for the publish
+//			reduce float    reduce_rgba_rows to half size, float RGBA
+//			reduce half     reduce_rgba_rows to half size, half float RGBA
+//			render ...      the publish copy and the passthrough copy, as
+//			                render does without Skip Passthrough Copy
+//
+//		With Skip Passthrough Copy, isIdentity publishes and the host reuses
+//		the source, so a frame costs the publish copy alone. Every reduced
+//		frame is checked against a plain average of the 2x2 blocks.
+//
+//		Build (Linux)
+//
+//			g++ -std=c++14 -O2 -pthread -I. -ISpout -DREDUCE_NO_CUDA tools/spout_passthrough_bench.cpp
+//				reduce.cpp Spout/SpoutHistogram.cpp -o spout_passthrough_bench
+//
+//		Run
+//
+//			./spout_passthrough_bench [-w width] [-h height] [-n frames] [-t threads]
+//
+//		Exits with 1 if a reduced frame is wrong.
+//
+// ====================================================================================
+//		Revisions :
+//
+//		17.10.26	- project start
+//
+// ====================================================================================
+//
+/*
+	Redistribution and use in source and binary forms, with or without modification,
+	are permitted provided that the following conditions are met:
+
+		1. Redistributions of source code must retain the above copyright notice,
+		   this list of conditions and the following disclaimer.
+
+		2. Redistributions in binary form must reproduce the above copyright notice,
+		   this list of conditions and the following disclaimer in the documentation
+		   and/or other materials provided with the distribution.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"	AND ANY
+	EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+	OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE	ARE DISCLAIMED.
+	IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+	INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+	PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+	LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+	OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "reduce.h"
+#include "half.h"
+#include "SpoutHistogram.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <functional>
+#include <thread>
+#include <vector>
+
+#define PIXEL_BYTES (4*sizeof(float))
+
+struct BenchConfig {
+	int width;
+	int height;
+	int frames;
+	int threads;
+};
+
+enum PublishMode {
+	PUBLISH_NONE,
+	PUBLISH_FULL,
+	PUBLISH_FLOAT,
+	PUBLISH_HALF,
+};
+
+// Values from 0 to 1, different for every frame
+static void FillSource(std::vector<char>& source, int frame)
+{
+	uint32_t state = 0x9e3779b9u ^ static_cast<uint32_t>(frame)*2654435761u;
+	float* values = reinterpret_cast<float*>(source.data());
+	for (size_t i = 0; i < source.size()/sizeof(float); i++) {
+		state = state*1664525u + 1013904223u;
+		values[i] = static_cast<float>(state >> 16)/65535.0f;
+	}
+}
+
+// Rows 0 to rows split into a band per thread, as the host's render threads split the render window
+static void RunBands(int rows, int threads, const std::function<void(int, int)>& band)
+{
+	if (threads <= 1) {
+		band(0, rows);
+		return;
+	}
+	std::vector<std::thread> workers;
+	for (int t = 0; t < threads; t++) {
+		const int y_begin = rows*t/threads;
+		const int y_end = rows*(t + 1)/threads;
+		workers.emplace_back([&band, y_begin, y_end] { band(y_begin, y_end); });
+	}
+	for (auto& worker : workers)
+		worker.join();
+}
+
+static void CopyRows(const char* src, char* dst, size_t rowbytes, int y_begin, int y_end)
+{
+	for (int y = y_begin; y < y_end; y++)
+		memcpy(dst + y*rowbytes, src + y*rowbytes, rowbytes);
+}
+
+// Average of the 2x2 block, summed in the order of reduce_rgba_rows so float results match exactly
+static bool CheckReduced(const std::vector<char>& source, const std::vector<char>& reduced, const BenchConfig& config,
+	bool half)
+{
+	const int width = reduce_size(config.width);
+	const int height = reduce_size(config.height);
+	const size_t src_pitch = static_cast<size_t>(config.width)*PIXEL_BYTES;
+	const size_t dst_pitch = static_cast<size_t>(width)*reduce_pixel_bytes(half);
+	const float* src = reinterpret_cast<const float*>(source.data());
+
+	for (int y = 0; y < height; y++) {
+		const int y0 = 2*y;
+		const int y1 = y0 + 1 < config.height ? y0 + 1 : y0;
+		for (int x = 0; x < width; x++) {
+			const int x0 = 2*x;
+			const int x1 = x0 + 1 < config.width ? x0 + 1 : x0;
+			for (int c = 0; c < 4; c++) {
+				const size_t row0 = y0*src_pitch/sizeof(float);
+				const size_t row1 = y1*src_pitch/sizeof(float);
+				const float sum = ((src[row0 + x0*4 + c] + src[row0 + x1*4 + c]) + src[row1 + x0*4 + c]) + src[row1 + x1*4 + c];
+				const float expected = sum*0.25f;
+				const char* out = reduced.data() + y*dst_pitch;
+				if (half) {
+					if (reinterpret_cast<const uint16_t*>(out)[x*4 + c] != float_to_half(expected))
+						return false;
+				}
+				else if (reinterpret_cast<const float*>(out)[x*4 + c] != expected) {
+					return false;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+static void PrintTimes(const char* name, spoutHistogram& times, double mbytes)
+{
+	spoutHistogramSnapshot snapshot;
+	times.Snapshot(snapshot);
+	const double p50 = snapshot.Percentile(50.0)/1000.0;
+	printf("  %-15s usec p50 %9.1f  p90 %9.1f  p99 %9.1f  max %9.1f  %8.1f MB/s at p50\n",
+		name, p50, snapshot.Percentile(90.0)/1000.0, snapshot.Percentile(99.0)/1000.0,
+		snapshot.count ? snapshot.max/1000.0 : 0.0, p50 > 0.0 ? mbytes/(p50/1000000.0) : 0.0);
+}
+
+//
+// Modes
+//
+
+// Returns the p50 in nanoseconds, or 0 if a reduced frame was wrong
+static uint64_t RunMode(const char* name, const BenchConfig& config, PublishMode publish, bool passthrough)
+{
+	const size_t rowbytes = static_cast<size_t>(config.width)*PIXEL_BYTES;
+	const size_t framebytes = rowbytes*config.height;
+	const bool reduce = publish == PUBLISH_FLOAT || publish == PUBLISH_HALF;
+	const bool half = publish == PUBLISH_HALF;
+	const int reduced_height = reduce_size(config.height);
+	const size_t reduced_pitch = static_cast<size_t>(reduce_size(config.width))*reduce_pixel_bytes(half);
+
+	std::vector<char> source(framebytes);
+	std::vector<char> output(passthrough ? framebytes : 0);
+	std::vector<char> staging(publish == PUBLISH_NONE ? 0 : reduce ? reduced_pitch*reduced_height : framebytes);
+
+	// Bytes read and written a frame
+	size_t moved = 0;
+	if (passthrough)
+		moved += 2*framebytes;
+	if (publish == PUBLISH_FULL)
+		moved += 2*framebytes;
+	if (reduce)
+		moved += framebytes + staging.size();
+
+	spoutHistogram times;
+	int wrong = 0;
+	for (int frame = -1; frame < config.frames; frame++) {
+		FillSource(source, frame);
+
+		const int64_t start = spoutHistogram::Now();
+		if (passthrough) {
+			RunBands(config.height, config.threads, [&](int y_begin, int y_end) {
+				CopyRows(source.data(), output.data(), rowbytes, y_begin, y_end);
+			});
+		}
+		if (publish == PUBLISH_FULL) {
+			RunBands(config.height, config.threads, [&](int y_begin, int y_end) {
+				CopyRows(source.data(), staging.data(), rowbytes, y_begin, y_end);
+			});
+		}
+		else if (reduce) {
+			RunBands(reduced_height, config.threads, [&](int y_begin, int y_end) {
+				reduce_rgba_rows(source.data(), rowbytes, config.width, config.height, staging.data(), reduced_pitch,
+					half, y_begin, y_end);
+			});
+		}
+		// The first frame faults the pages in
+		if (frame >= 0)
+			times.RecordSince(start);
+
+		if (reduce && frame < 2 && !CheckReduced(source, staging, config, half))
+			wrong++;
+	}
+
+	printf("%s\n", name);
+	printf("  %-15s %.1f MB read and written, %.1f MB published\n", "frame",
+		moved/(1024.0*1024.0), (publish == PUBLISH_FULL ? framebytes : staging.size())/(1024.0*1024.0));
+	PrintTimes("copy", times, moved/(1024.0*1024.0));
+
+	if (wrong) {
+		fprintf(stderr, "spout_passthrough_bench - %s reduced %d frames wrong\n", name, wrong);
+		return 0;
+	}
+	spoutHistogramSnapshot snapshot;
+	times.Snapshot(snapshot);
+	return snapshot.Percentile(50.0) ? snapshot.Percentile(50.0) : 1;
+}
+
+//
+// Main
+//
+
+int main(int argc, char* argv[])
+{
+	BenchConfig config;
+	config.width = 3840;
+	config.height = 2160;
+	config.frames = 60;
+	config.threads = 1;
+
+	int opt = 0;
+	while ((opt = getopt(argc, argv, "w:h:n:t:")) != -1) {
+		switch (opt) {
+			case 'w': config.width = atoi(optarg); break;
+			case 'h': config.height = atoi(optarg); break;
+			case 'n': config.frames = atoi(optarg); break;
+			case 't': config.threads = atoi(optarg); break;
+			default:
+				fprintf(stderr, "usage: %s [-w width] [-h height] [-n frames] [-t threads]\n", argv[0]);
+				return 2;
+		}
+	}
+	if (config.width < 1 || config.height < 1 || config.frames < 1 || config.threads < 1 || config.threads > 64) {
+		fprintf(stderr, "spout_passthrough_bench - invalid arguments\n");
+		return 2;
+	}
+
+	printf("spout_passthrough_bench : %dx%d float RGBA, %d frames, %d threads, %u cores\n",
+		config.width, config.height, config.frames, config.threads, std::thread::hardware_concurrency());
+
+	const uint64_t passthrough = RunMode("passthrough", config, PUBLISH_NONE, true);
+	const uint64_t full = RunMode("full", config, PUBLISH_FULL, false);
+	const uint64_t reduce_float = RunMode("reduce float", config, PUBLISH_FLOAT, false);
+	const uint64_t reduce_half = RunMode("reduce half", config, PUBLISH_HALF, false);
+	const uint64_t render_full = RunMode("render full", config, PUBLISH_FULL, true);
+	const uint64_t render_float = RunMode("render float", config, PUBLISH_FLOAT, true);
+	const uint64_t render_half = RunMode("render half", config, PUBLISH_HALF, true);
+
+	if (!passthrough || !full || !reduce_float || !reduce_half || !render_full || !render_float || !render_half) {
+		printf("FAILED\n");
+		return 1;
+	}
+
+	// What a frame costs in render against isIdentity, where the publish copy is all there is
+	printf("skip passthrough copy\n");
+	const char* names[] = { "full", "reduce float", "reduce half" };
+	const uint64_t identity[] = { full, reduce_float, reduce_half };
+	const uint64_t render[] = { render_full, render_float, render_half };
+	for (int i = 0; i < 3; i++) {
+		printf("  %-15s usec p50 %9.1f in render, %9.1f in isIdentity, %4.0f%% saved\n", names[i],
+			render[i]/1000.0, identity[i]/1000.0, 100.0*(1.0 - static_cast<double>(identity[i])/render[i]));
+	}
+
+	printf("OK\n");
+	return 0;
+}
@@ -0,0 +1,854 @@
+//
+//		spout_render_alloc_test
+//
+//		Checks that the render path of the OFX support library doesn't touch
+//		the heap once it is warmed up.
+//
+//		A mock host loads a small effect through the support library the
+//		way Resolve loads the plugin: load, describe, describe in context and
+//		create instance, then calls isIdentity and render for every frame.
+//		The effect does what the plugin does around its outputs, it fetches
+//		the source and output into reused OFX::Image objects and runs an
+//		OFX::ImageProcessor copy between them. operator new is replaced with
+//		one that counts, so every allocation made on a frame is seen,
+//		whether by the library, the effect or the host.
+//
+//			in place     Clip::fetchImage(time, image), must not allocate
+//			new image    Clip::fetchImage(time), one Image per fetch, for
+//			             reference and to show the counter works
+//
+//		The mock host runs the copy threads one after another on the
+//		calling thread, so the count isn't muddied by thread start up.
+//		The D3D11 and CUDA parts of the plugin don't build here and aren't
+//		covered.
+//
+//		Build (Linux)
+//
+//			g++ -std=gnu++14 -O2 -I. -IOpenFX/include -IOpenFXSupport/include
+//				-D"__declspec(x)=" tools/spout_render_alloc_test.cpp
+//				OpenFXSupport/Library/ofxsCore.cpp OpenFXSupport/Library/ofxsImageEffect.cpp
+//				OpenFXSupport/Library/ofxsInteract.cpp OpenFXSupport/Library/ofxsLog.cpp
+//				OpenFXSupport/Library/ofxsMultiThread.cpp OpenFXSupport/Library/ofxsParams.cpp
+//				OpenFXSupport/Library/ofxsProperty.cpp OpenFXSupport/Library/ofxsPropertyValidation.cpp
+//				-o spout_render_alloc_test
+//
+//		gnu++14 rather than c++14 as the support library checks for the
+//		'linux' macro. __declspec is emptied for its exported entry points.
+//
+//		Run
+//
+//			./spout_render_alloc_test [-w width] [-h height] [-n frames] [-u warm up frames]
+//
+//		Exits with 1 if an in place frame allocated after the warm up, or
+//		a frame didn't reach the output intact.
+//
+// ====================================================================================
+//		Revisions :
+//
+//		17.10.26	- project start
+//
+// ====================================================================================
+//
+/*
+	Redistribution and use in source and binary forms, with or without modification,
+	are permitted provided that the following conditions are met:
+
+		1. Redistributions of source code must retain the above copyright notice,
+		   this list of conditions and the following disclaimer.
+
+		2. Redistributions in binary form must reproduce the above copyright notice,
+		   this list of conditions and the following disclaimer in the documentation
+		   and/or other materials provided with the distribution.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"	AND ANY
+	EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+	OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE	ARE DISCLAIMED.
+	IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+	INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+	PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+	LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+	OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "ofxsImageEffect.h"
+#include "ofxsProcessing.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+#define TEST_NAME "spout_render_alloc_test"
+#define TEST_PLUGIN_ID "com.valuefactory.SpoutRenderAllocTest"
+
+//
+// Counting allocator
+//
+
+static std::atomic<uint64_t> gAllocations(0);
+
+void* operator new(size_t size)
+{
+	gAllocations.fetch_add(1, std::memory_order_relaxed);
+	void* p = malloc(size ? size : 1);
+	if (!p)
+		throw std::bad_alloc();
+	return p;
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+	gAllocations.fetch_add(1, std::memory_order_relaxed);
+	return malloc(size ? size : 1);
+}
+
+void* operator new[](size_t size, const std::nothrow_t& tag) noexcept
+{
+	return operator new(size, tag);
+}
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete[](void* p, size_t) noexcept { free(p); }
+
+//
+// Mock host
+//
+
+// Every property holds its values as all four types, the suite reads the one asked for
+struct MockValue {
+	std::string s;
+	int i = 0;
+	double d = 0.0;
+	void* p = nullptr;
+};
+
+struct MockProperty {
+	std::string name;
+	std::vector<MockValue> values;
+};
+
+// Looked up by strcmp, so reading a property never builds a std::string
+struct MockPropertySet {
+	std::vector<MockProperty> properties;
+
+	MockProperty* Find(const char* name)
+	{
+		for (auto& property : properties) {
+			if (strcmp(property.name.c_str(), name) == 0)
+				return &property;
+		}
+		return nullptr;
+	}
+
+	MockValue* Get(const char* name, int index)
+	{
+		auto* property = Find(name);
+		if (!property || index < 0 || index >= static_cast<int>(property->values.size()))
+			return nullptr;
+		return &property->values[index];
+	}
+
+	MockValue& Set(const char* name, int index)
+	{
+		auto* property = Find(name);
+		if (!property) {
+			properties.emplace_back();
+			property = &properties.back();
+			property->name = name;
+		}
+		if (index >= static_cast<int>(property->values.size()))
+			property->values.resize(index + 1);
+		return property->values[index];
+	}
+
+	void SetString(const char* name, const char* value, int index = 0) { Set(name, index).s = value; }
+	void SetInt(const char* name, int value, int index = 0) { Set(name, index).i = value; }
+	void SetDouble(const char* name, double value, int index = 0) { Set(name, index).d = value; }
+	void SetPointer(const char* name, void* value, int index = 0) { Set(name, index).p = value; }
+};
+
+struct MockClip {
+	std::string name;
+	MockPropertySet props;
+	// The image the host hands out for this clip, refilled before each frame
+	MockPropertySet image;
+	std::vector<float> pixels;
+	int fetched = 0;
+};
+
+// A descriptor or an instance, the suites treat them alike
+struct MockEffect {
+	MockPropertySet props;
+	MockPropertySet param_props;
+	std::vector<std::unique_ptr<MockClip>> clips;
+
+	MockClip* FindClip(const char* name)
+	{
+		for (auto& clip : clips) {
+			if (clip->name == name)
+				return clip.get();
+		}
+		return nullptr;
+	}
+};
+
+static MockPropertySet* Props(OfxPropertySetHandle handle) { return reinterpret_cast<MockPropertySet*>(handle); }
+static OfxPropertySetHandle Handle(MockPropertySet* props) { return reinterpret_cast<OfxPropertySetHandle>(props); }
+static MockEffect* Effect(OfxImageEffectHandle handle) { return reinterpret_cast<MockEffect*>(handle); }
+static MockClip* Clip(OfxImageClipHandle handle) { return reinterpret_cast<MockClip*>(handle); }
+
+static OfxStatus PropSetPointer(OfxPropertySetHandle h, const char* property, int index, void* value) { Props(h)->SetPointer(property, value, index); return kOfxStatOK; }
+static OfxStatus PropSetString(OfxPropertySetHandle h, const char* property, int index, const char* value) { Props(h)->SetString(property, value, index); return kOfxStatOK; }
+static OfxStatus PropSetDouble(OfxPropertySetHandle h, const char* property, int index, double value) { Props(h)->SetDouble(property, value, index); return kOfxStatOK; }
+static OfxStatus PropSetInt(OfxPropertySetHandle h, const char* property, int index, int value) { Props(h)->SetInt(property, value, index); return kOfxStatOK; }
+
+static OfxStatus PropSetPointerN(OfxPropertySetHandle h, const char* property, int count, void* const* value)
+{
+	for (int i = 0; i < count; i++)
+		Props(h)->SetPointer(property, value[i], i);
+	return kOfxStatOK;
+}
+
+static OfxStatus PropSetStringN(OfxPropertySetHandle h, const char* property, int count, const char* const* value)
+{
+	for (int i = 0; i < count; i++)
+		Props(h)->SetString(property, value[i], i);
+	return kOfxStatOK;
+}
+
+static OfxStatus PropSetDoubleN(OfxPropertySetHandle h, const char* property, int count, const double* value)
+{
+	for (int i = 0; i < count; i++)
+		Props(h)->SetDouble(property, value[i], i);
+	return kOfxStatOK;
+}
+
+static OfxStatus PropSetIntN(OfxPropertySetHandle h, const char* property, int count, const int* value)
+{
+	for (int i = 0; i < count; i++)
+		Props(h)->SetInt(property, value[i], i);
+	return kOfxStatOK;
+}
+
+static OfxStatus PropGetPointer(OfxPropertySetHandle h, const char* property, int index, void** value)
+{
+	auto* v = Props(h)->Get(property, index);
+	if (!v)
+		return kOfxStatErrUnknown;
+	*value = v->p;
+	return kOfxStatOK;
+}
+
+static OfxStatus PropGetString(OfxPropertySetHandle h, const char* property, int index, char** value)
+{
+	auto* v = Props(h)->Get(property, index);
+	if (!v)
+		return kOfxStatErrUnknown;
+	*value = const_cast<char*>(v->s.c_str());
+	return kOfxStatOK;
+}
+
+static OfxStatus PropGetDouble(OfxPropertySetHandle h, const char* property, int index, double* value)
+{
+	auto* v = Props(h)->Get(property, index);
+	if (!v)
+		return kOfxStatErrUnknown;
+	*value = v->d;
+	return kOfxStatOK;
+}
+
+static OfxStatus PropGetInt(OfxPropertySetHandle h, const char* property, int index, int* value)
+{
+	auto* v = Props(h)->Get(property, index);
+	if (!v)
+		return kOfxStatErrUnknown;
+	*value = v->i;
+	return kOfxStatOK;
+}
+
+static OfxStatus PropGetPointerN(OfxPropertySetHandle h, const char* property, int count, void** value)
+{
+	for (int i = 0; i < count; i++) {
+		if (PropGetPointer(h, property, i, &value[i]) != kOfxStatOK)
+			return kOfxStatErrUnknown;
+	}
+	return kOfxStatOK;
+}
+
+static OfxStatus PropGetStringN(OfxPropertySetHandle h, const char* property, int count, char** value)
+{
+	for (int i = 0; i < count; i++) {
+		if (PropGetString(h, property, i, &value[i]) != kOfxStatOK)
+			return kOfxStatErrUnknown;
+	}
+	return kOfxStatOK;
+}
+
+static OfxStatus PropGetDoubleN(OfxPropertySetHandle h, const char* property, int count, double* value)
+{
+	for (int i = 0; i < count; i++) {
+		if (PropGetDouble(h, property, i, &value[i]) != kOfxStatOK)
+			return kOfxStatErrUnknown;
+	}
+	return kOfxStatOK;
+}
+
+static OfxStatus PropGetIntN(OfxPropertySetHandle h, const char* property, int count, int* value)
+{
+	for (int i = 0; i < count; i++) {
+		if (PropGetInt(h, property, i, &value[i]) != kOfxStatOK)
+			return kOfxStatErrUnknown;
+	}
+	return kOfxStatOK;
+}
+
+static OfxStatus PropReset(OfxPropertySetHandle, const char*) { return kOfxStatOK; }
+
+// A real host knows every property, one that was never set is empty
+static OfxStatus PropGetDimension(OfxPropertySetHandle h, const char* property, int* count)
+{
+	auto* p = Props(h)->Find(property);
+	*count = p ? static_cast<int>(p->values.size()) : 0;
+	return kOfxStatOK;
+}
+
+static OfxPropertySuiteV1 gPropertySuite = {
+	PropSetPointer, PropSetString, PropSetDouble, PropSetInt,
+	PropSetPointerN, PropSetStringN, PropSetDoubleN, PropSetIntN,
+	PropGetPointer, PropGetString, PropGetDouble, PropGetInt,
+	PropGetPointerN, PropGetStringN, PropGetDoubleN, PropGetIntN,
+	PropReset, PropGetDimension,
+};
+
+static OfxStatus EffectGetPropertySet(OfxImageEffectHandle effect, OfxPropertySetHandle* props)
+{
+	*props = Handle(&Effect(effect)->props);
+	return kOfxStatOK;
+}
+
+static OfxStatus EffectGetParamSet(OfxImageEffectHandle effect, OfxParamSetHandle* params)
+{
+	*params = reinterpret_cast<OfxParamSetHandle>(Effect(effect));
+	return kOfxStatOK;
+}
+
+static OfxStatus ClipDefine(OfxImageEffectHandle effect, const char* name, OfxPropertySetHandle* props)
+{
+	auto* mock = Effect(effect);
+	auto* clip = mock->FindClip(name);
+	if (!clip) {
+		mock->clips.emplace_back(new MockClip);
+		clip = mock->clips.back().get();
+		clip->name = name;
+	}
+	*props = Handle(&clip->props);
+	return kOfxStatOK;
+}
+
+static OfxStatus ClipGetHandle(OfxImageEffectHandle effect, const char* name, OfxImageClipHandle* handle, OfxPropertySetHandle* props)
+{
+	auto* clip = Effect(effect)->FindClip(name);
+	if (!clip)
+		return kOfxStatErrUnknown;
+	*handle = reinterpret_cast<OfxImageClipHandle>(clip);
+	if (props)
+		*props = Handle(&clip->props);
+	return kOfxStatOK;
+}
+
+static OfxStatus ClipGetPropertySet(OfxImageClipHandle clip, OfxPropertySetHandle* props)
+{
+	*props = Handle(&Clip(clip)->props);
+	return kOfxStatOK;
+}
+
+static OfxStatus ClipGetImage(OfxImageClipHandle clip, OfxTime, const OfxRectD*, OfxPropertySetHandle* image)
+{
+	auto* mock = Clip(clip);
+	if (mock->pixels.empty())
+		return kOfxStatFailed;
+	mock->fetched++;
+	*image = Handle(&mock->image);
+	return kOfxStatOK;
+}
+
+static OfxStatus ClipReleaseImage(OfxPropertySetHandle image)
+{
+	(void)image;
+	return kOfxStatOK;
+}
+
+static OfxStatus ClipGetRegionOfDefinition(OfxImageClipHandle clip, OfxTime, OfxRectD* bounds)
+{
+	auto* image = &Clip(clip)->image;
+	auto* rod = image->Find(kOfxImagePropRegionOfDefinition);
+	if (!rod || rod->values.size() != 4)
+		return kOfxStatFailed;
+	bounds->x1 = rod->values[0].i;
+	bounds->y1 = rod->values[1].i;
+	bounds->x2 = rod->values[2].i;
+	bounds->y2 = rod->values[3].i;
+	return kOfxStatOK;
+}
+
+static int EffectAbort(OfxImageEffectHandle) { return 0; }
+static OfxStatus ImageMemoryAlloc(OfxImageEffectHandle, size_t, OfxImageMemoryHandle*) { return kOfxStatErrUnsupported; }
+static OfxStatus ImageMemoryFree(OfxImageMemoryHandle) { return kOfxStatErrUnsupported; }
+static OfxStatus ImageMemoryLock(OfxImageMemoryHandle, void**) { return kOfxStatErrUnsupported; }
+static OfxStatus ImageMemoryUnlock(OfxImageMemoryHandle) { return kOfxStatErrUnsupported; }
+
+static OfxImageEffectSuiteV1 gEffectSuite = {
+	EffectGetPropertySet, EffectGetParamSet, ClipDefine, ClipGetHandle, ClipGetPropertySet,
+	ClipGetImage, ClipReleaseImage, ClipGetRegionOfDefinition, EffectAbort,
+	ImageMemoryAlloc, ImageMemoryFree, ImageMemoryLock, ImageMemoryUnlock,
+};
+
+// The test effect has no params, only the param set's own properties are asked for
+static OfxStatus ParamDefine(OfxParamSetHandle, const char*, const char*, OfxPropertySetHandle*) { return kOfxStatErrUnsupported; }
+static OfxStatus ParamGetHandle(OfxParamSetHandle, const char*, OfxParamHandle*, OfxPropertySetHandle*) { return kOfxStatErrUnknown; }
+
+static OfxStatus ParamSetGetPropertySet(OfxParamSetHandle params, OfxPropertySetHandle* props)
+{
+	*props = Handle(&reinterpret_cast<MockEffect*>(params)->param_props);
+	return kOfxStatOK;
+}
+
+static OfxStatus ParamGetPropertySet(OfxParamHandle, OfxPropertySetHandle*) { return kOfxStatErrUnknown; }
+static OfxStatus ParamGetValue(OfxParamHandle, ...) { return kOfxStatErrUnsupported; }
+static OfxStatus ParamGetValueAtTime(OfxParamHandle, OfxTime, ...) { return kOfxStatErrUnsupported; }
+static OfxStatus ParamGetDerivative(OfxParamHandle, OfxTime, ...) { return kOfxStatErrUnsupported; }
+static OfxStatus ParamGetIntegral(OfxParamHandle, OfxTime, OfxTime, ...) { return kOfxStatErrUnsupported; }
+static OfxStatus ParamSetValue(OfxParamHandle, ...) { return kOfxStatErrUnsupported; }
+static OfxStatus ParamSetValueAtTime(OfxParamHandle, OfxTime, ...) { return kOfxStatErrUnsupported; }
+static OfxStatus ParamGetNumKeys(OfxParamHandle, unsigned int*) { return kOfxStatErrUnsupported; }
+static OfxStatus ParamGetKeyTime(OfxParamHandle, unsigned int, OfxTime*) { return kOfxStatErrUnsupported; }
+static OfxStatus ParamGetKeyIndex(OfxParamHandle, OfxTime, int, int*) { return kOfxStatErrUnsupported; }
+static OfxStatus ParamDeleteKey(OfxParamHandle, OfxTime) { return kOfxStatErrUnsupported; }
+static OfxStatus ParamDeleteAllKeys(OfxParamHandle) { return kOfxStatErrUnsupported; }
+static OfxStatus ParamCopy(OfxParamHandle, OfxParamHandle, OfxTime, const OfxRangeD*) { return kOfxStatErrUnsupported; }
+static OfxStatus ParamEditBegin(OfxParamSetHandle, const char*) { return kOfxStatOK; }
+static OfxStatus ParamEditEnd(OfxParamSetHandle) { return kOfxStatOK; }
+
+static OfxParameterSuiteV1 gParameterSuite = {
+	ParamDefine, ParamGetHandle, ParamSetGetPropertySet, ParamGetPropertySet,
+	ParamGetValue, ParamGetValueAtTime, ParamGetDerivative, ParamGetIntegral,
+	ParamSetValue, ParamSetValueAtTime, ParamGetNumKeys, ParamGetKeyTime, ParamGetKeyIndex,
+	ParamDeleteKey, ParamDeleteAllKeys, ParamCopy, ParamEditBegin, ParamEditEnd,
+};
+
+static OfxStatus MemoryAlloc(void*, size_t bytes, void** data)
+{
+	*data = malloc(bytes);
+	return *data ? kOfxStatOK : kOfxStatErrMemory;
+}
+
+static OfxStatus MemoryFree(void* data)
+{
+	free(data);
+	return kOfxStatOK;
+}
+
+static OfxMemorySuiteV1 gMemorySuite = { MemoryAlloc, MemoryFree };
+
+#define TEST_THREADS 2
+
+static OfxStatus MultiThread(OfxThreadFunctionV1 func, unsigned int threads, void* arg)
+{
+	for (unsigned int i = 0; i < threads; i++)
+		func(i, threads, arg);
+	return kOfxStatOK;
+}
+
+static OfxStatus MultiThreadNumCPUs(unsigned int* cpus) { *cpus = TEST_THREADS; return kOfxStatOK; }
+static OfxStatus MultiThreadIndex(unsigned int* index) { *index = 0; return kOfxStatOK; }
+static int MultiThreadIsSpawnedThread(void) { return 0; }
+static OfxStatus MutexCreate(OfxMutexHandle* mutex, int) { *mutex = nullptr; return kOfxStatOK; }
+static OfxStatus MutexDestroy(const OfxMutexHandle) { return kOfxStatOK; }
+static OfxStatus MutexLock(const OfxMutexHandle) { return kOfxStatOK; }
+static OfxStatus MutexUnLock(const OfxMutexHandle) { return kOfxStatOK; }
+static OfxStatus MutexTryLock(const OfxMutexHandle) { return kOfxStatOK; }
+
+static OfxMultiThreadSuiteV1 gMultiThreadSuite = {
+	MultiThread, MultiThreadNumCPUs, MultiThreadIndex, MultiThreadIsSpawnedThread,
+	MutexCreate, MutexDestroy, MutexLock, MutexUnLock, MutexTryLock,
+};
+
+static OfxStatus Message(void*, const char*, const char*, const char* format, ...)
+{
+	fprintf(stderr, "%s - plugin message : %s\n", TEST_NAME, format);
+	return kOfxStatOK;
+}
+
+static OfxMessageSuiteV1 gMessageSuite = { Message };
+
+static const void* FetchSuite(OfxPropertySetHandle, const char* name, int version)
+{
+	if (version != 1)
+		return nullptr;
+	if (strcmp(name, kOfxPropertySuite) == 0) return &gPropertySuite;
+	if (strcmp(name, kOfxImageEffectSuite) == 0) return &gEffectSuite;
+	if (strcmp(name, kOfxParameterSuite) == 0) return &gParameterSuite;
+	if (strcmp(name, kOfxMemorySuite) == 0) return &gMemorySuite;
+	if (strcmp(name, kOfxMultiThreadSuite) == 0) return &gMultiThreadSuite;
+	if (strcmp(name, kOfxMessageSuite) == 0) return &gMessageSuite;
+	return nullptr;
+}
+
+static void FillHostProperties(MockPropertySet& host)
+{
+	host.SetString(kOfxPropName, "com.valuefactory.MockHost");
+	host.SetString(kOfxPropLabel, "Mock Host");
+	host.SetInt(kOfxImageEffectHostPropIsBackground, 0);
+	host.SetInt(kOfxImageEffectPropSupportsOverlays, 0);
+	host.SetInt(kOfxImageEffectPropSupportsMultiResolution, 0);
+	host.SetInt(kOfxImageEffectPropSupportsTiles, 0);
+	host.SetInt(kOfxImageEffectPropTemporalClipAccess, 0);
+	host.SetInt(kOfxImageEffectPropSupportsMultipleClipDepths, 0);
+	host.SetInt(kOfxImageEffectPropSupportsMultipleClipPARs, 0);
+	host.SetInt(kOfxImageEffectPropSetableFrameRate, 0);
+	host.SetInt(kOfxImageEffectPropSetableFielding, 0);
+	host.SetInt(kOfxParamHostPropSupportsStringAnimation, 0);
+	host.SetInt(kOfxParamHostPropSupportsCustomInteract, 0);
+	host.SetInt(kOfxParamHostPropSupportsChoiceAnimation, 0);
+	host.SetInt(kOfxParamHostPropSupportsBooleanAnimation, 0);
+	host.SetInt(kOfxParamHostPropSupportsCustomAnimation, 0);
+	host.SetInt(kOfxParamHostPropMaxParameters, -1);
+	host.SetInt(kOfxParamHostPropMaxPages, 0);
+	host.SetInt(kOfxParamHostPropPageRowColumnCount, 0, 0);
+	host.SetInt(kOfxParamHostPropPageRowColumnCount, 0, 1);
+	host.SetString(kOfxImageEffectPropSupportedComponents, kOfxImageComponentRGBA);
+	host.SetString(kOfxImageEffectPropSupportedContexts, kOfxImageEffectContextFilter);
+	host.SetString(kOfxImageEffectPropSupportedPixelDepths, kOfxBitDepthFloat);
+}
+
+// Float RGBA image over the whole frame, as Resolve gives them with tiles and multi resolution off
+static void FillImage(MockClip& clip, int width, int height)
+{
+	clip.pixels.assign(static_cast<size_t>(width)*height*4, 0.0f);
+	auto& image = clip.image;
+	image.SetInt(kOfxImagePropRowBytes, width*4*static_cast<int>(sizeof(float)));
+	image.SetDouble(kOfxImagePropPixelAspectRatio, 1.0);
+	image.SetString(kOfxImageEffectPropComponents, kOfxImageComponentRGBA);
+	image.SetString(kOfxImageEffectPropPixelDepth, kOfxBitDepthFloat);
+	image.SetString(kOfxImageEffectPropPreMultiplication, kOfxImagePreMultiplied);
+	image.SetString(kOfxImagePropField, kOfxImageFieldNone);
+	// Longer than any std::string keeps inline
+	image.SetString(kOfxImagePropUniqueIdentifier, "mock-host-image-identifier-0000");
+	const int rect[4] = { 0, 0, width, height };
+	for (int i = 0; i < 4; i++) {
+		image.SetInt(kOfxImagePropRegionOfDefinition, rect[i], i);
+		image.SetInt(kOfxImagePropBounds, rect[i], i);
+	}
+	image.SetDouble(kOfxImageEffectPropRenderScale, 1.0, 0);
+	image.SetDouble(kOfxImageEffectPropRenderScale, 1.0, 1);
+	image.SetPointer(kOfxImagePropData, clip.pixels.data());
+}
+
+//
+// Test effect
+//
+
+// Which fetch the effect uses, set by the host between runs
+static bool gInPlace = true;
+
+class Row_Copier : public OFX::ImageProcessor {
+public:
+	explicit Row_Copier(OFX::ImageEffect& effect) : OFX::ImageProcessor(effect) {}
+
+	OFX::Image* src = nullptr;
+
+	virtual void multiThreadProcessImages(OfxRectI window) override
+	{
+		const size_t rowbytes = static_cast<size_t>(window.x2 - window.x1)*_dstImg->getPixelComponentCount()*sizeof(float);
+		for (int y = window.y1; y < window.y2; y++)
+			memcpy(_dstImg->getPixelAddress(window.x1, y), src->getPixelAddress(window.x1, y), rowbytes);
+	}
+};
+
+struct Test_Image_Release {
+	OFX::Image& image;
+	~Test_Image_Release() { image.release(); }
+};
+
+class Alloc_Test_Effect : public OFX::ImageEffect {
+public:
+	explicit Alloc_Test_Effect(OfxImageEffectHandle handle)
+		: OFX::ImageEffect(handle), copier(*this)
+	{
+		src_clip = fetchClip(kOfxImageEffectSimpleSourceClipName);
+		dst_clip = fetchClip(kOfxImageEffectOutputClipName);
+	}
+
+	virtual void render(const OFX::RenderArguments& args) override
+	{
+		if (!gInPlace) {
+			std::unique_ptr<OFX::Image> src(src_clip->fetchImage(args.time));
+			std::unique_ptr<OFX::Image> dst(dst_clip->fetchImage(args.time));
+			copy(src.get(), dst.get(), args.renderWindow);
+			return;
+		}
+
+		Test_Image_Release src_release{ src_image };
+		Test_Image_Release dst_release{ dst_image };
+		if (!src_clip->fetchImage(args.time, src_image) || !dst_clip->fetchImage(args.time, dst_image))
+			OFX::throwSuiteStatusException(kOfxStatFailed);
+		copy(&src_image, &dst_image, args.renderWindow);
+	}
+
+	// Fetches the source the way the plugin's Skip Passthrough Copy does, then lets render run
+	virtual bool isIdentity(const OFX::IsIdentityArguments& args, OFX::Clip*& clip, double& time) override
+	{
+		if (gInPlace) {
+			Test_Image_Release src_release{ src_image };
+			if (!src_clip->fetchImage(args.time, src_image) || !src_image.getPixelData())
+				return false;
+		}
+		else {
+			std::unique_ptr<OFX::Image> src(src_clip->fetchImage(args.time));
+			if (!src || !src->getPixelData())
+				return false;
+		}
+		(void)clip;
+		(void)time;
+		return false;
+	}
+
+private:
+	void copy(OFX::Image* src, OFX::Image* dst, const OfxRectI& window)
+	{
+		copier.src = src;
+		copier.setDstImg(dst);
+		copier.setRenderWindow(window);
+		copier.process();
+	}
+
+	OFX::Clip* src_clip = nullptr;
+	OFX::Clip* dst_clip = nullptr;
+	OFX::Image src_image;
+	OFX::Image dst_image;
+	Row_Copier copier;
+};
+
+class Alloc_Test_Factory : public OFX::PluginFactoryHelper<Alloc_Test_Factory> {
+public:
+	Alloc_Test_Factory() : OFX::PluginFactoryHelper<Alloc_Test_Factory>(TEST_PLUGIN_ID, 1, 0) {}
+
+	virtual void load() override {}
+	virtual void unload() override {}
+
+	virtual void describe(OFX::ImageEffectDescriptor& desc) override
+	{
+		desc.setLabels(TEST_NAME, TEST_NAME, TEST_NAME);
+		desc.addSupportedContext(OFX::eContextFilter);
+		desc.addSupportedBitDepth(OFX::eBitDepthFloat);
+		desc.setSupportsTiles(false);
+		desc.setSupportsMultiResolution(false);
+	}
+
+	virtual void describeInContext(OFX::ImageEffectDescriptor& desc, OFX::ContextEnum) override
+	{
+		auto* src = desc.defineClip(kOfxImageEffectSimpleSourceClipName);
+		src->addSupportedComponent(OFX::ePixelComponentRGBA);
+		auto* dst = desc.defineClip(kOfxImageEffectOutputClipName);
+		dst->addSupportedComponent(OFX::ePixelComponentRGBA);
+	}
+
+	virtual OFX::ImageEffect* createInstance(OfxImageEffectHandle handle, OFX::ContextEnum) override
+	{
+		return new Alloc_Test_Effect(handle);
+	}
+};
+
+void OFX::Plugin::getPluginIDs(PluginFactoryArray& factory_array)
+{
+	static Alloc_Test_Factory factory;
+	factory_array.push_back(&factory);
+}
+
+//
+// Main
+//
+
+struct TestConfig {
+	int width;
+	int height;
+	int frames;
+	int warmup;
+};
+
+static bool Call(OfxPlugin* plugin, const char* action, void* handle, MockPropertySet* in, MockPropertySet* out, OfxStatus expected)
+{
+	const OfxStatus stat = plugin->mainEntry(action, handle, in ? Handle(in) : nullptr, out ? Handle(out) : nullptr);
+	if (stat != expected) {
+		fprintf(stderr, "%s - %s returned %d\n", TEST_NAME, action, stat);
+		return false;
+	}
+	return true;
+}
+
+// Returns false if a frame after the warm up allocated when it shouldn't have, or the copy went wrong
+static bool RunMode(const char* name, OfxPlugin* plugin, MockEffect& instance, const TestConfig& config, bool inplace)
+{
+	gInPlace = inplace;
+
+	auto* src = instance.FindClip(kOfxImageEffectSimpleSourceClipName);
+	auto* dst = instance.FindClip(kOfxImageEffectOutputClipName);
+	src->fetched = 0;
+	dst->fetched = 0;
+
+	// Filled once like a host reusing its argument sets, only the time changes
+	MockPropertySet render_args;
+	render_args.SetDouble(kOfxPropTime, 0.0);
+	render_args.SetDouble(kOfxImageEffectPropRenderScale, 1.0, 0);
+	render_args.SetDouble(kOfxImageEffectPropRenderScale, 1.0, 1);
+	const int window[4] = { 0, 0, config.width, config.height };
+	for (int i = 0; i < 4; i++)
+		render_args.SetInt(kOfxImageEffectPropRenderWindow, window[i], i);
+	render_args.SetString(kOfxImageEffectPropFieldToRender, kOfxImageFieldNone);
+	render_args.SetInt(kOfxImageEffectPropSequentialRenderStatus, 1);
+	render_args.SetInt(kOfxImageEffectPropInteractiveRenderStatus, 0);
+	render_args.SetInt(kOfxImageEffectPropRenderQualityDraft, 0);
+	MockPropertySet identity_out;
+
+	const size_t values = static_cast<size_t>(config.width)*config.height*4;
+	uint64_t allocated = 0;
+	uint64_t max_frame = 0;
+	int allocating_frames = 0;
+	int mismatched = 0;
+	int failed = 0;
+
+	for (int f = 1; f <= config.warmup + config.frames; f++) {
+		// Stamp the source so a stale output is caught
+		src->pixels[0] = static_cast<float>(f);
+		src->pixels[values - 1] = static_cast<float>(-f);
+		render_args.Set(kOfxPropTime, 0).d = f;
+
+		const uint64_t before = gAllocations.load(std::memory_order_relaxed);
+		bool ok = Call(plugin, kOfxImageEffectActionIsIdentity, &instance, &render_args, &identity_out, kOfxStatReplyDefault);
+		ok = Call(plugin, kOfxImageEffectActionRender, &instance, &render_args, nullptr, kOfxStatOK) && ok;
+		const uint64_t count = gAllocations.load(std::memory_order_relaxed) - before;
+
+		if (!ok)
+			failed++;
+		if (dst->pixels[0] != static_cast<float>(f) || dst->pixels[values - 1] != static_cast<float>(-f))
+			mismatched++;
+
+		if (f <= config.warmup)
+			continue;
+		allocated += count;
+		if (count)
+			allocating_frames++;
+		if (count > max_frame)
+			max_frame = count;
+	}
+
+	const bool fetches = src->fetched == 2*(config.warmup + config.frames) && dst->fetched == config.warmup + config.frames;
+	printf("%s\n  %-11s %.2f per frame, %d of %d frames allocated, at most %llu\n", name, "allocations",
+		static_cast<double>(allocated)/config.frames, allocating_frames, config.frames, static_cast<unsigned long long>(max_frame));
+	printf("  %-11s %d failed, %d mismatched\n", "frames", failed, mismatched);
+
+	bool pass = failed == 0 && mismatched == 0 && fetches;
+	if (inplace && allocated != 0)
+		pass = false;
+	// The counter has to see the per frame Image or it isn't counting anything
+	if (!inplace && allocated == 0)
+		pass = false;
+	if (!pass)
+		fprintf(stderr, "%s - %s failed\n", TEST_NAME, name);
+	return pass;
+}
+
+int main(int argc, char* argv[])
+{
+	TestConfig config;
+	config.width = 256;
+	config.height = 144;
+	config.frames = 240;
+	config.warmup = 4;
+
+	int opt = 0;
+	while ((opt = getopt(argc, argv, "w:h:n:u:")) != -1) {
+		switch (opt) {
+			case 'w': config.width = atoi(optarg); break;
+			case 'h': config.height = atoi(optarg); break;
+			case 'n': config.frames = atoi(optarg); break;
+			case 'u': config.warmup = atoi(optarg); break;
+			default:
+				fprintf(stderr, "usage: %s [-w width] [-h height] [-n frames] [-u warm up frames]\n", argv[0]);
+				return 2;
+		}
+	}
+	if (config.width < 1 || config.height < 1 || static_cast<int64_t>(config.width)*config.height > 64LL*1024*1024
+		|| config.frames < 1 || config.warmup < 1) {
+		fprintf(stderr, "%s - invalid arguments\n", TEST_NAME);
+		return 2;
+	}
+
+	printf("%s : %dx%d float RGBA, %d frames after %d warm up frames\n", TEST_NAME,
+		config.width, config.height, config.frames, config.warmup);
+
+	MockPropertySet host_props;
+	FillHostProperties(host_props);
+	OfxHost host = { Handle(&host_props), FetchSuite };
+
+	if (OfxGetNumberOfPlugins() != 1) {
+		fprintf(stderr, "%s - expected one plugin\n", TEST_NAME);
+		return 1;
+	}
+	OfxPlugin* plugin = OfxGetPlugin(0);
+	plugin->setHost(&host);
+
+	MockEffect descriptor;
+	MockPropertySet context_args;
+	context_args.SetString(kOfxImageEffectPropContext, kOfxImageEffectContextFilter);
+
+	MockEffect instance;
+	instance.props.SetString(kOfxImageEffectPropContext, kOfxImageEffectContextFilter);
+
+	bool ok = Call(plugin, kOfxActionLoad, nullptr, nullptr, nullptr, kOfxStatOK)
+		&& Call(plugin, kOfxActionDescribe, &descriptor, nullptr, nullptr, kOfxStatOK)
+		&& Call(plugin, kOfxImageEffectActionDescribeInContext, &descriptor, &context_args, nullptr, kOfxStatOK);
+	if (ok) {
+		// The host makes the instance's clips from the descriptor's
+		for (auto& clip : descriptor.clips) {
+			instance.clips.emplace_back(new MockClip);
+			instance.clips.back()->name = clip->name;
+			FillImage(*instance.clips.back(), config.width, config.height);
+		}
+		ok = Call(plugin, kOfxActionCreateInstance, &instance, nullptr, nullptr, kOfxStatOK);
+	}
+	if (!ok || !instance.FindClip(kOfxImageEffectSimpleSourceClipName) || !instance.FindClip(kOfxImageEffectOutputClipName)) {
+		fprintf(stderr, "%s - the plugin didn't load\n", TEST_NAME);
+		printf("FAILED\n");
+		return 1;
+	}
+
+	bool failed = false;
+	failed |= !RunMode("in place", plugin, instance, config, true);
+	failed |= !RunMode("new image", plugin, instance, config, false);
+
+	Call(plugin, kOfxActionDestroyInstance, &instance, nullptr, nullptr, kOfxStatOK);
+	Call(plugin, kOfxActionUnload, nullptr, nullptr, nullptr, kOfxStatOK);
+
+	if (failed) {
+		printf("FAILED\n");
+		return 1;
+	}
+
+	printf("OK\n");
+	return 0;
+}
@@ -0,0 +1,286 @@
+//
+//		spout_settings_test
+//
+//		Checks the settings file backend of spoutSettings (Spout/SpoutSettings.cpp).
+//
+//			parse    the file named by SPOUT_SETTINGS_FILE is read on first use,
+//			         with comments, spaces and any case in the names
+//			reload   a reload that finds the same values publishes nothing,
+//			         each change publishes them with the next generation while
+//			         a reader thread checks every copy it gets is whole
+//			missing  a file that can't be read gives the defaults
+//			watch    the background check picks up an edit, stops picking them
+//			         up after StopWatch and picks them up again after StartWatch,
+//			         as the plugin does on unload and load
+//
+//		Build (Linux)
+//
+//			g++ -std=c++14 -O2 -pthread -I. -ISpout tools/spout_settings_test.cpp
+//				Spout/SpoutSettings.cpp -o spout_settings_test
+//
+//		Run
+//
+//			./spout_settings_test [-n changes]
+//
+//		SDK notices are logged to stderr, redirect it to hide them.
+//
+//		Exits with 1 if a value, a generation or the watch was wrong.
+//
+// ====================================================================================
+//		Revisions :
+//
+//		17.10.26	- project start
+//
+// ====================================================================================
+//
+/*
+	Redistribution and use in source and binary forms, with or without modification,
+	are permitted provided that the following conditions are met:
+
+		1. Redistributions of source code must retain the above copyright notice,
+		   this list of conditions and the following disclaimer.
+
+		2. Redistributions in binary form must reproduce the above copyright notice,
+		   this list of conditions and the following disclaimer in the documentation
+		   and/or other materials provided with the distribution.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"	AND ANY
+	EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+	OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE	ARE DISCLAIMED.
+	IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+	INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+	PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+	LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+	OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "SpoutSettings.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
+static std::string g_path;
+
+// Written to a temporary file and renamed over the settings file,
+// so the watch never reads half of it
+static bool WriteSettings(const std::string& path, const char* text)
+{
+	const std::string temp = path + ".tmp";
+	FILE* file = fopen(temp.c_str(), "w");
+	if (!file)
+		return false;
+	const bool ok = fputs(text, file) >= 0;
+	if (fclose(file) != 0 || !ok)
+		return false;
+	return rename(temp.c_str(), path.c_str()) == 0;
+}
+
+static bool WriteSettings(int maxSenders, bool bFrameCount)
+{
+	char text[128];
+	snprintf(text, sizeof(text), "MaxSenders=%d\nFramecount=%d\n", maxSenders, bFrameCount ? 1 : 0);
+	return WriteSettings(g_path, text);
+}
+
+static bool Check(bool condition, const char* mode, const char* what)
+{
+	if (!condition)
+		fprintf(stderr, "spout_settings_test - %s : %s\n", mode, what);
+	return condition;
+}
+
+// Waits up to msec for the current MaxSenders to be maxSenders
+static bool WaitFor(spoutSettings& settings, int maxSenders, int msec)
+{
+	const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(msec);
+	while (std::chrono::steady_clock::now() < deadline) {
+		if (settings.Get().maxSenders == maxSenders)
+			return true;
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	}
+	return settings.Get().maxSenders == maxSenders;
+}
+
+//
+// Modes
+//
+
+static bool RunParse()
+{
+	bool ok = true;
+	ok &= WriteSettings(g_path,
+		"# Spout settings\n"
+		"; another comment\n"
+		"\n"
+		"  maxsenders = 32\n"
+		"FRAMECOUNT=1\n"
+		"MemoryShare=0\n"
+		"DX9=1\n"
+		"Unknown=5\n"
+		"no equals sign\n");
+
+	// Nothing has used the settings yet, so the plugin's unload must not find any
+	ok &= Check(spoutSettings::Existing() == nullptr, "parse", "settings exist before first use");
+
+	setenv(SPOUT_SETTINGS_FILE_ENV, g_path.c_str(), 1);
+	spoutSettings& settings = spoutSettings::Instance();
+	const spoutSettingsValues values = settings.Get();
+
+	ok &= Check(spoutSettings::Existing() == &settings, "parse", "Existing is not the instance");
+	ok &= Check(settings.GetFilePath() == g_path, "parse", "the environment variable was not used");
+	ok &= Check(values.generation == 1, "parse", "first generation is not 1");
+	ok &= Check(values.maxSenders == 32, "parse", "MaxSenders");
+	ok &= Check(values.bFrameCount, "parse", "Framecount");
+	ok &= Check(!values.bMemoryShare, "parse", "MemoryShare");
+	ok &= Check(values.bDX9, "parse", "DX9");
+
+	printf("parse\n  %-11s MaxSenders %d, Framecount %d, MemoryShare %d, DX9 %d\n", "values",
+		values.maxSenders, values.bFrameCount, values.bMemoryShare, values.bDX9);
+	return ok;
+}
+
+static bool RunReload(int changes)
+{
+	spoutSettings& settings = spoutSettings::Instance();
+	bool ok = true;
+
+	// The same values in another order, and a value that is ignored
+	ok &= WriteSettings(g_path, "DX9=1\nFramecount=1\nMaxSenders=32\nMaxSenders=0\n");
+	const unsigned int generation = settings.Get().generation;
+	settings.Reload();
+	ok &= Check(settings.Get().generation == generation, "reload", "a reload of the same values changed the generation");
+
+	// Framecount is odd MaxSenders, so a reader can tell a whole copy
+	std::atomic<bool> stop(false);
+	std::atomic<int> torn(0);
+	std::atomic<long long> reads(0);
+	std::thread reader([&] {
+		while (!stop.load()) {
+			const spoutSettingsValues values = settings.Get();
+			if (values.maxSenders >= 100 && values.bFrameCount != (values.maxSenders % 2 == 1))
+				torn++;
+			reads++;
+		}
+	});
+
+	int wrong = 0;
+	for (int i = 0; i < changes; i++) {
+		const int maxSenders = 100 + i;
+		if (!WriteSettings(maxSenders, maxSenders % 2 == 1)) {
+			ok = false;
+			break;
+		}
+		settings.Reload();
+		const spoutSettingsValues values = settings.Get();
+		if (values.maxSenders != maxSenders || values.generation != generation + 1 + static_cast<unsigned int>(i))
+			wrong++;
+		// Again with nothing changed
+		settings.Reload();
+		if (settings.Get().generation != values.generation)
+			wrong++;
+	}
+	stop = true;
+	reader.join();
+
+	printf("reload\n  %-11s %d changes, %d wrong, %lld reads, %d torn\n", "values",
+		changes, wrong, reads.load(), torn.load());
+	ok &= Check(wrong == 0, "reload", "wrong values or generation after a change");
+	ok &= Check(torn.load() == 0, "reload", "the reader got a torn copy");
+	return ok;
+}
+
+static bool RunMissing()
+{
+	spoutSettings& settings = spoutSettings::Instance();
+	const std::string missing = g_path + ".missing";
+	settings.SetFilePath(missing.c_str());
+	const spoutSettingsValues values = settings.Get();
+
+	bool ok = true;
+	ok &= Check(values.maxSenders == 64, "missing", "MaxSenders is not the default");
+	ok &= Check(!values.bFrameCount && !values.bMemoryShare && !values.bDX9, "missing", "a flag is not the default");
+	printf("missing\n  %-11s MaxSenders %d\n", "values", values.maxSenders);
+
+	settings.SetFilePath(g_path.c_str());
+	return ok;
+}
+
+static bool RunWatch()
+{
+	spoutSettings& settings = spoutSettings::Instance();
+	const int wait = SPOUT_SETTINGS_WATCH_MSEC*3;
+	bool ok = true;
+
+	ok &= WriteSettings(7, false);
+	ok &= Check(WaitFor(settings, 7, wait), "watch", "an edit was not picked up");
+
+	// Unload
+	spoutSettings::Existing()->StopWatch();
+	ok &= WriteSettings(4096, false);
+	ok &= Check(!WaitFor(settings, 4096, SPOUT_SETTINGS_WATCH_MSEC*2), "watch", "an edit was picked up after StopWatch");
+
+	// Load again
+	spoutSettings::Existing()->StartWatch();
+	ok &= Check(WaitFor(settings, 4096, wait), "watch", "an edit was not picked up after StartWatch");
+
+	printf("watch\n  %-11s MaxSenders %d, generation %u\n", "values", settings.Get().maxSenders, settings.Get().generation);
+	return ok;
+}
+
+//
+// Main
+//
+
+int main(int argc, char* argv[])
+{
+	int changes = 1000;
+
+	int opt = 0;
+	while ((opt = getopt(argc, argv, "n:")) != -1) {
+		switch (opt) {
+			case 'n': changes = atoi(optarg); break;
+			default:
+				fprintf(stderr, "usage: %s [-n changes]\n", argv[0]);
+				return 2;
+		}
+	}
+	if (changes < 1) {
+		fprintf(stderr, "spout_settings_test - invalid arguments\n");
+		return 2;
+	}
+
+	char path[] = "/tmp/spout_settings_test_XXXXXX";
+	const int fd = mkstemp(path);
+	if (fd < 0) {
+		fprintf(stderr, "spout_settings_test - could not create a settings file\n");
+		return 1;
+	}
+	close(fd);
+	g_path = path;
+
+	printf("spout_settings_test : %s, %d changes\n", g_path.c_str(), changes);
+
+	bool failed = false;
+	failed |= !RunParse();
+	failed |= !RunReload(changes);
+	failed |= !RunMissing();
+	failed |= !RunWatch();
+
+	spoutSettings::Instance().StopWatch();
+	unlink(g_path.c_str());
+
+	if (failed) {
+		printf("FAILED\n");
+		return 1;
+	}
+
+	printf("OK\n");
+	return 0;
+}
@@ -0,0 +1,324 @@
+//
+//		spout_sink_bench
+//
+//		Cost of each output the plugin's dispatcher feeds, and a check that
+//		every sink gets the frame intact.
+//
+//		A source frame is handed to Output_Dispatcher the way the plugin's
+//		plain CPU render does: the dispatcher reads it a band of rows at a
+//		time with a number of threads and writes each band to every sink.
+//		Each mode adds sinks, so the difference between modes is what a sink
+//		costs on top of the one read of the source.
+//
+//			memcpy       one plain copy of the frame, for reference
+//			null         the dispatcher alone
+//			ring         the shared memory ring, as the Stream Rows option
+//			ring+null3   the ring and three null sinks, the cost of fan out
+//			ring+file    the ring and the file output, with -d
+//
+//		After every frame the ring is read back through its own
+//		spoutSharedBuffer and compared with the source, and the null sinks
+//		must have counted every byte.
+//
+//		Build (Linux)
+//
+//			g++ -std=c++14 -O2 -pthread -I. -ISpout tools/spout_sink_bench.cpp
+//				output_sink.cpp file_sink.cpp Spout/SpoutSharedMemory.cpp
+//				Spout/SpoutSharedBuffer.cpp Spout/SpoutHistogram.cpp
+//				-o spout_sink_bench -lrt
+//
+//		Run
+//
+//			./spout_sink_bench [-w width] [-h height] [-b bytes per pixel]
+//				[-n frames] [-t threads] [-d directory]
+//
+//		The file output needs 16 bytes per pixel, float RGBA.
+//		SDK notices are logged to stderr, redirect it to hide them.
+//
+//		Exits with 1 if a sink skipped a frame or got it wrong.
+//
+// ====================================================================================
+//		Revisions :
+//
+//		17.10.26	- project start
+//
+// ====================================================================================
+//
+/*
+	Redistribution and use in source and binary forms, with or without modification,
+	are permitted provided that the following conditions are met:
+
+		1. Redistributions of source code must retain the above copyright notice,
+		   this list of conditions and the following disclaimer.
+
+		2. Redistributions in binary form must reproduce the above copyright notice,
+		   this list of conditions and the following disclaimer in the documentation
+		   and/or other materials provided with the distribution.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"	AND ANY
+	EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+	OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE	ARE DISCLAIMED.
+	IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+	INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+	PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+	LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+	OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "output_sink.h"
+#include "SpoutSharedBuffer.h"
+#include "SpoutHistogram.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#define BENCH_NAME "spout_sink_bench"
+
+// Frame header as the plugin writes it, followed by the rows
+#define BENCH_HEADER_BYTES 128
+
+struct BenchHeader {
+	uint64_t sequence;
+	int64_t timestamp;
+};
+
+// Source frame with every row different, so a row written to the wrong place is caught
+static void FillSource(std::vector<char>& source, size_t rowbytes, int height, int frame)
+{
+	memset(source.data(), frame & 0xff, source.size());
+	for (int y = 0; y < height; y++) {
+		const uint32_t stamp = (static_cast<uint32_t>(frame) << 16) ^ static_cast<uint32_t>(y);
+		memcpy(source.data() + static_cast<size_t>(y)*rowbytes, &stamp, rowbytes < sizeof(stamp) ? rowbytes : sizeof(stamp));
+	}
+}
+
+// Runs the dispatcher on a number of threads, as the host's render threads do
+static void Dispatch(Output_Dispatcher& dispatcher, int threads)
+{
+	std::vector<std::thread> workers;
+	for (int t = 1; t < threads; t++)
+		workers.emplace_back([&dispatcher] { dispatcher.run(); });
+	dispatcher.run();
+	for (auto& worker : workers)
+		worker.join();
+}
+
+static void PrintTimes(const char* name, spoutHistogram& times, double mbytes)
+{
+	spoutHistogramSnapshot snapshot;
+	times.Snapshot(snapshot);
+	const double p50 = snapshot.Percentile(50.0)/1000.0;
+	printf("  %-11s usec p50 %9.1f  p90 %9.1f  p99 %9.1f  max %9.1f  %8.1f MB/s at p50\n",
+		name, p50, snapshot.Percentile(90.0)/1000.0, snapshot.Percentile(99.0)/1000.0,
+		snapshot.count ? snapshot.max/1000.0 : 0.0, p50 > 0.0 ? mbytes/(p50/1000000.0) : 0.0);
+}
+
+//
+// Modes
+//
+
+struct BenchConfig {
+	int width;
+	int height;
+	int bpp;
+	int frames;
+	int threads;
+	std::string directory;
+};
+
+static void RunMemcpy(const BenchConfig& config)
+{
+	const size_t size = static_cast<size_t>(config.width)*config.bpp*config.height;
+	std::vector<char> source(size, 1);
+	std::vector<char> dst(size);
+	spoutHistogram times;
+	for (int f = 1; f <= config.frames; f++) {
+		spoutHistogramTimer timer(times);
+		memcpy(dst.data(), source.data(), size);
+	}
+	PrintTimes("memcpy", times, size/1048576.0);
+}
+
+// Returns false if a sink skipped a frame or got it wrong
+static bool RunMode(const char* name, const BenchConfig& config, bool ring, int nulls, bool file)
+{
+	const size_t rowbytes = static_cast<size_t>(config.width)*config.bpp;
+	const size_t framebytes = rowbytes*config.height;
+
+	spoutSharedBuffer buffer;
+	Ring_Sink ring_sink;
+	ring_sink.buffer = &buffer;
+	ring_sink.name = BENCH_NAME;
+
+	Null_Sink null_sinks[4];
+	File_Sink file_sink;
+	File_Output_Sink file_output(file_sink);
+	file_output.config.directory = config.directory;
+	file_output.config.prefix = BENCH_NAME;
+	file_output.config.encoder = FILE_SINK_RAW;
+	file_output.config.policy = FILE_SINK_DROP;
+
+	Output_Dispatcher dispatcher;
+	if (ring)
+		dispatcher.add(&ring_sink);
+	for (int i = 0; i < nulls; i++)
+		dispatcher.add(&null_sinks[i]);
+	if (file)
+		dispatcher.add(&file_output);
+	const int sinks = (ring ? 1 : 0) + nulls + (file ? 1 : 0);
+
+	// Opened after the first frame creates the ring
+	spoutSharedBuffer reader;
+
+	std::vector<char> source(framebytes);
+	spoutHistogram times;
+	uint64_t mismatched = 0;
+	uint64_t unread = 0;
+	uint64_t skipped = 0;
+
+	for (int f = 1; f <= config.frames; f++) {
+		FillSource(source, rowbytes, config.height, f);
+
+		char header[BENCH_HEADER_BYTES] = {};
+		BenchHeader stamp = { static_cast<uint64_t>(f), spoutHistogram::Now() };
+		memcpy(header, &stamp, sizeof(stamp));
+
+		Output_Frame frame;
+		frame.width = config.width;
+		frame.height = config.height;
+		frame.pixel_bytes = config.bpp;
+		frame.time = f;
+		frame.header = header;
+		frame.header_bytes = sizeof(header);
+
+		int published = 0;
+		{
+			spoutHistogramTimer timer(times);
+			if (dispatcher.begin(frame, source.data(), rowbytes) == sinks)
+				Dispatch(dispatcher, config.threads);
+			published = dispatcher.finish();
+		}
+		if (published != sinks)
+			skipped++;
+
+		if (!ring)
+			continue;
+
+		if (!reader.IsOpen() && !reader.Open(BENCH_NAME)) {
+			unread++;
+			continue;
+		}
+		int length = 0;
+		uint64_t version = 0;
+		const char* data = reader.BeginRead(&length, &version);
+		if (!data || length != static_cast<int>(BENCH_HEADER_BYTES + framebytes)) {
+			unread++;
+			continue;
+		}
+		BenchHeader read = {};
+		memcpy(&read, data, sizeof(read));
+		if (read.sequence != static_cast<uint64_t>(f)
+			|| memcmp(data + BENCH_HEADER_BYTES, source.data(), framebytes) != 0
+			|| reader.GetRowsCompleted(version) != config.height)
+			mismatched++;
+		if (!reader.EndRead(version))
+			mismatched++;
+	}
+
+	file_sink.Flush();
+	reader.Close();
+	buffer.Close();
+
+	bool ok = mismatched == 0 && unread == 0 && skipped == 0;
+	for (int i = 0; i < nulls; i++) {
+		Output_Sink_Stats stats;
+		null_sinks[i].stats(stats);
+		if (stats.published != static_cast<uint64_t>(config.frames)
+			|| stats.bytes != static_cast<uint64_t>(config.frames)*framebytes)
+			ok = false;
+	}
+	if (file) {
+		File_Sink_Stats stats;
+		file_sink.Stats(stats);
+		if (stats.failed)
+			ok = false;
+		printf("%s\n  %-11s %llu written, %llu dropped, %llu failed\n", name, "file",
+			static_cast<unsigned long long>(stats.written), static_cast<unsigned long long>(stats.dropped),
+			static_cast<unsigned long long>(stats.failed));
+	}
+	else {
+		printf("%s\n", name);
+	}
+
+	printf("  %-11s %llu skipped, %llu mismatched, %llu unread\n", "frames",
+		static_cast<unsigned long long>(skipped), static_cast<unsigned long long>(mismatched),
+		static_cast<unsigned long long>(unread));
+	PrintTimes("dispatch", times, framebytes/1048576.0);
+
+	if (!ok)
+		fprintf(stderr, "spout_sink_bench - %s failed\n", name);
+	return ok;
+}
+
+//
+// Main
+//
+
+int main(int argc, char* argv[])
+{
+	BenchConfig config;
+	config.width = 1920;
+	config.height = 1080;
+	config.bpp = 16;
+	config.frames = 120;
+	config.threads = 2;
+
+	int opt = 0;
+	while ((opt = getopt(argc, argv, "w:h:b:n:t:d:")) != -1) {
+		switch (opt) {
+			case 'w': config.width = atoi(optarg); break;
+			case 'h': config.height = atoi(optarg); break;
+			case 'b': config.bpp = atoi(optarg); break;
+			case 'n': config.frames = atoi(optarg); break;
+			case 't': config.threads = atoi(optarg); break;
+			case 'd': config.directory = optarg; break;
+			default:
+				fprintf(stderr, "usage: %s [-w width] [-h height] [-b bytes per pixel] [-n frames] [-t threads] [-d directory]\n", argv[0]);
+				return 2;
+		}
+	}
+	if (config.width < 1 || config.height < 1 || config.bpp < 1 || config.bpp > 16
+		|| static_cast<int64_t>(config.width)*config.height*config.bpp > 512LL*1024*1024
+		|| config.frames < 1 || config.threads < 1 || config.threads > 64
+		|| (!config.directory.empty() && config.bpp != 16)) {
+		fprintf(stderr, "spout_sink_bench - invalid arguments\n");
+		return 2;
+	}
+
+	printf("spout_sink_bench : %dx%d at %d bytes per pixel, %d frames, %d threads, %u cores\n",
+		config.width, config.height, config.bpp, config.frames, config.threads, std::thread::hardware_concurrency());
+
+	RunMemcpy(config);
+
+	bool failed = false;
+	failed |= !RunMode("null", config, false, 1, false);
+	failed |= !RunMode("ring", config, true, 0, false);
+	failed |= !RunMode("ring+null3", config, true, 3, false);
+	if (!config.directory.empty())
+		failed |= !RunMode("ring+file", config, true, 0, true);
+
+	if (failed) {
+		printf("FAILED\n");
+		return 1;
+	}
+
+	printf("OK\n");
+	return 0;
+}
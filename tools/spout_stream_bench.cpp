@@ -0,0 +1,416 @@
+//
+//		spout_stream_bench
+//
+//		End to end latency of whole frame and row streamed reads of the
+//		shared memory ring.
+//
+//		The process creates a frame buffer and copies a source frame into it
+//		at a fixed interval with a number of threads. The threads take chunks
+//		of rows in order and publish the rows completed from the top, as the
+//		plugin's Stream Rows option does. A forked receiver process handles
+//		every row of each frame, a read and a small sum per pixel.
+//
+//			whole   the receiver waits for the commit, then handles all rows
+//			stream  the receiver starts on the frame being written and handles
+//			        each chunk as soon as WaitRowsCompleted reports it
+//
+//		Measured
+//			e2e      from the start of the sender copy to the receiver having
+//			         handled the last row
+//			copy     time for the sender to copy a frame
+//
+//		With the receiver on its own core, streaming overlaps the receiver
+//		work with the sender copy so e2e approaches the larger of the two
+//		instead of their sum. On a single core there is nothing to overlap.
+//
+//		Build (Linux)
+//
+//			g++ -std=c++14 -O2 -pthread -ISpout tools/spout_stream_bench.cpp
+//				Spout/SpoutSharedMemory.cpp Spout/SpoutSharedBuffer.cpp
+//				Spout/SpoutHistogram.cpp -o spout_stream_bench -lrt
+//
+//		Run
+//
+//			./spout_stream_bench [-w width] [-h height] [-b bytes per pixel]
+//				[-n frames] [-i interval usec] [-t threads]
+//
+//		SDK notices are logged to stderr, redirect it to hide them.
+//
+//		Exits with 1 if a mode failed or a row was read before it was complete.
+//
+// ====================================================================================
+//		Revisions :
+//
+//		17.10.26	- project start
+//
+// ====================================================================================
+//
+/*
+	Redistribution and use in source and binary forms, with or without modification,
+	are permitted provided that the following conditions are met:
+
+		1. Redistributions of source code must retain the above copyright notice,
+		   this list of conditions and the following disclaimer.
+
+		2. Redistributions in binary form must reproduce the above copyright notice,
+		   this list of conditions and the following disclaimer in the documentation
+		   and/or other materials provided with the distribution.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"	AND ANY
+	EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+	OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE	ARE DISCLAIMED.
+	IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+	INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+	PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+	LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+	OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "SpoutSharedBuffer.h"
+#include "SpoutHistogram.h"
+
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include <atomic>
+#include <memory>
+#include <new>
+#include <thread>
+#include <vector>
+
+#define BENCH_NAME "spout_stream_bench"
+
+// Rows published together, as ROW_STREAM_CHUNK_ROWS in the plugin
+#define BENCH_CHUNK_ROWS 16
+
+// Frame header, followed by the rows
+struct BenchFrame {
+	uint64_t sequence;
+	int64_t timestamp; // spoutHistogram::Now() when the copy started
+	char reserved[48]; // rows start on a cache line
+};
+
+// Shared with the receiver process
+struct BenchShared {
+	std::atomic<int> ready; // receiver has opened the sender
+	std::atomic<int> done; // sender has published all frames
+	uint64_t frames; // frames handled
+	uint64_t torn; // rows handled with mismatched content
+	uint64_t retries; // frames overwritten while they were handled
+	uint64_t checksum; // keeps the receiver work from being optimized away
+	spoutHistogramSnapshot e2e;
+};
+
+// Receiver work on one row, each pixel read and summed
+static uint64_t HandleRow(const uint8_t* row, size_t bytes, uint8_t expected, bool& torn)
+{
+	uint64_t sum = 0;
+	for (size_t i = 0; i < bytes; i++)
+		sum += row[i];
+	torn |= (row[0] != expected) || (row[bytes - 1] != expected);
+	return sum;
+}
+
+//
+// Receiver process
+//
+
+static void RunReceiver(BenchShared& shared, bool stream, int height, size_t rowbytes)
+{
+	spoutSharedBuffer buffer;
+	const int64_t deadline = spoutHistogram::Now() + 5000000000LL;
+	while (!buffer.Open(BENCH_NAME)) {
+		if (spoutHistogram::Now() > deadline)
+			return;
+		usleep(1000);
+	}
+	shared.ready.store(1, std::memory_order_release);
+
+	spoutHistogram e2e;
+	uint64_t lastversion = 0;
+
+	while (!shared.done.load(std::memory_order_acquire)) {
+
+		uint64_t version = 0;
+		const char* data = nullptr;
+		if (stream) {
+			data = buffer.BeginStreamRead(lastversion, &version);
+		}
+		else if (buffer.GetVersion() != lastversion) {
+			int length = 0;
+			data = buffer.BeginRead(&length, &version);
+		}
+		// Yield so that a sender on the same core is not held up
+		if (!data || version <= lastversion) {
+			sched_yield();
+			continue;
+		}
+
+		// The header is written before the first rows are published
+		if (stream && buffer.WaitRowsCompleted(version, 1, 1000) < 1) {
+			shared.retries++;
+			lastversion = version;
+			continue;
+		}
+		BenchFrame frame;
+		memcpy(&frame, data, sizeof(BenchFrame));
+		const uint8_t expected = static_cast<uint8_t>(frame.sequence);
+		const uint8_t* rows = reinterpret_cast<const uint8_t*>(data + sizeof(BenchFrame));
+
+		bool torn = false;
+		bool overwritten = false;
+		for (int row = 0; row < height; row += BENCH_CHUNK_ROWS) {
+			const int end = (row + BENCH_CHUNK_ROWS < height) ? row + BENCH_CHUNK_ROWS : height;
+			if (stream && buffer.WaitRowsCompleted(version, end, 1000) < end) {
+				overwritten = true;
+				break;
+			}
+			for (int y = row; y < end; y++)
+				shared.checksum += HandleRow(rows + static_cast<size_t>(y)*rowbytes, rowbytes, expected, torn);
+		}
+
+		const bool valid = stream ? (buffer.GetRowsCompleted(version) >= 0) : buffer.EndRead(version);
+		if (overwritten || !valid) {
+			shared.retries++;
+			lastversion = version;
+			continue;
+		}
+		e2e.RecordSince(frame.timestamp);
+		lastversion = version;
+		shared.frames++;
+		if (torn)
+			shared.torn++;
+	}
+
+	e2e.Snapshot(shared.e2e);
+	buffer.Close();
+}
+
+//
+// Sender
+//
+
+// Copies a frame with a number of threads, chunks taken in order
+// and the rows completed published from the top
+class BenchCopier {
+
+	public:
+
+	BenchCopier(spoutSharedBuffer& buffer, int height, size_t rowbytes)
+		: m_Buffer(buffer), m_Height(height), m_RowBytes(rowbytes)
+	{
+		m_Chunks = (height + BENCH_CHUNK_ROWS - 1)/BENCH_CHUNK_ROWS;
+		m_Done.reset(new std::atomic<bool>[m_Chunks]);
+	}
+
+	void Copy(char* dst, const char* src, int threads)
+	{
+		for (int i = 0; i < m_Chunks; i++)
+			m_Done[i] = false;
+		m_Next = 0;
+		m_Frontier = 0;
+
+		std::vector<std::thread> workers;
+		for (int t = 1; t < threads; t++)
+			workers.emplace_back([this, dst, src] { Work(dst, src); });
+		Work(dst, src);
+		for (auto& worker : workers)
+			worker.join();
+	}
+
+	protected:
+
+	void Work(char* dst, const char* src)
+	{
+		for (;;) {
+			const int chunk = m_Next.fetch_add(1, std::memory_order_relaxed);
+			if (chunk >= m_Chunks)
+				break;
+
+			const int row = chunk*BENCH_CHUNK_ROWS;
+			const int end = (row + BENCH_CHUNK_ROWS < m_Height) ? row + BENCH_CHUNK_ROWS : m_Height;
+			memcpy(dst + static_cast<size_t>(row)*m_RowBytes, src + static_cast<size_t>(row)*m_RowBytes,
+				static_cast<size_t>(end - row)*m_RowBytes);
+
+			m_Done[chunk] = true;
+			int top = m_Frontier.load();
+			while (top < m_Chunks && m_Done[top]) {
+				if (m_Frontier.compare_exchange_weak(top, top + 1))
+					top++;
+			}
+			const int rows = top*BENCH_CHUNK_ROWS;
+			m_Buffer.SetRowsCompleted((rows < m_Height) ? rows : m_Height);
+		}
+	}
+
+	spoutSharedBuffer& m_Buffer;
+	int m_Height;
+	size_t m_RowBytes;
+	int m_Chunks;
+	std::unique_ptr<std::atomic<bool>[]> m_Done;
+	std::atomic<int> m_Next;
+	std::atomic<int> m_Frontier;
+
+};
+
+static bool RunMode(const char* name, bool stream, int width, int height, int bpp, int frames, int interval, int threads, bool& failed)
+{
+	const size_t rowbytes = static_cast<size_t>(width)*bpp;
+	const int length = static_cast<int>(sizeof(BenchFrame) + rowbytes*height);
+
+	BenchShared* pShared = static_cast<BenchShared*>(mmap(nullptr, sizeof(BenchShared),
+		PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0));
+	if (pShared == MAP_FAILED)
+		return false;
+	new (pShared) BenchShared();
+
+	spoutSharedBuffer buffer;
+	if (!buffer.Create(BENCH_NAME, length, 3)) {
+		fprintf(stderr, "spout_stream_bench - %s could not create the sender\n", name);
+		munmap(pShared, sizeof(BenchShared));
+		return false;
+	}
+
+	const pid_t pid = fork();
+	if (pid == 0) {
+		// _exit so that the sender is not closed here
+		RunReceiver(*pShared, stream, height, rowbytes);
+		_exit(0);
+	}
+	if (pid < 0) {
+		buffer.Close();
+		munmap(pShared, sizeof(BenchShared));
+		return false;
+	}
+
+	std::vector<char> source(rowbytes*height);
+	BenchCopier copier(buffer, height, rowbytes);
+	spoutHistogram copy;
+
+	const int64_t deadline = spoutHistogram::Now() + 5000000000LL;
+	while (!pShared->ready.load(std::memory_order_acquire) && spoutHistogram::Now() < deadline)
+		usleep(1000);
+
+	int64_t next = spoutHistogram::Now();
+	for (int f = 1; f <= frames && pShared->ready.load(std::memory_order_acquire); f++) {
+		// The source is ready before the frame starts, as a rendered frame is
+		memset(source.data(), static_cast<uint8_t>(f), source.size());
+
+		int maxlength = 0;
+		char* data = buffer.BeginWrite(&maxlength);
+		if (!data)
+			break;
+
+		BenchFrame frame = {};
+		frame.sequence = static_cast<uint64_t>(f);
+		frame.timestamp = spoutHistogram::Now();
+		memcpy(data, &frame, sizeof(BenchFrame));
+
+		copier.Copy(data + sizeof(BenchFrame), source.data(), threads);
+		buffer.Commit(length);
+		copy.RecordSince(frame.timestamp);
+
+		next += static_cast<int64_t>(interval)*1000;
+		const int64_t wait = next - spoutHistogram::Now();
+		if (wait > 0) {
+			timespec ts;
+			ts.tv_sec = wait/1000000000LL;
+			ts.tv_nsec = wait%1000000000LL;
+			nanosleep(&ts, nullptr);
+		}
+	}
+	pShared->done.store(1, std::memory_order_release);
+
+	int status = 0;
+	waitpid(pid, &status, 0);
+	buffer.Close();
+
+	const BenchShared& shared = *pShared;
+	if (!WIFEXITED(status) || WEXITSTATUS(status) != 0 || !shared.ready.load()) {
+		fprintf(stderr, "spout_stream_bench - %s receiver failed\n", name);
+		failed = true;
+	}
+
+	spoutHistogramSnapshot copied;
+	copy.Snapshot(copied);
+
+	printf("%s\n", name);
+	printf("  %-10s %10llu handled, %llu overwritten, %llu torn\n", "frames",
+		static_cast<unsigned long long>(shared.frames), static_cast<unsigned long long>(shared.retries),
+		static_cast<unsigned long long>(shared.torn));
+
+	const char* labels[2] = { "e2e", "copy" };
+	const spoutHistogramSnapshot* snapshots[2] = { &shared.e2e, &copied };
+	for (int i = 0; i < 2; i++) {
+		const spoutHistogramSnapshot& snapshot = *snapshots[i];
+		printf("  %-10s %10llu samples, usec p50 %9.1f  p90 %9.1f  p99 %9.1f  max %9.1f\n",
+			labels[i], static_cast<unsigned long long>(snapshot.count),
+			snapshot.Percentile(50.0)/1000.0, snapshot.Percentile(90.0)/1000.0,
+			snapshot.Percentile(99.0)/1000.0, snapshot.count ? snapshot.max/1000.0 : 0.0);
+	}
+
+	if (shared.torn || !shared.frames)
+		failed = true;
+
+	munmap(pShared, sizeof(BenchShared));
+	return true;
+}
+
+//
+// Main
+//
+
+int main(int argc, char* argv[])
+{
+	int width = 1920;
+	int height = 1080;
+	int bpp = 4;
+	int frames = 300;
+	int interval = 16666;
+	int threads = 2;
+
+	int opt = 0;
+	while ((opt = getopt(argc, argv, "w:h:b:n:i:t:")) != -1) {
+		switch (opt) {
+			case 'w': width = atoi(optarg); break;
+			case 'h': height = atoi(optarg); break;
+			case 'b': bpp = atoi(optarg); break;
+			case 'n': frames = atoi(optarg); break;
+			case 'i': interval = atoi(optarg); break;
+			case 't': threads = atoi(optarg); break;
+			default:
+				fprintf(stderr, "usage: %s [-w width] [-h height] [-b bytes per pixel] [-n frames] [-i interval usec] [-t threads]\n", argv[0]);
+				return 2;
+		}
+	}
+	if (width < 1 || height < 1 || bpp < 1 || bpp > 16 || static_cast<int64_t>(width)*height*bpp > 512LL*1024*1024
+		|| frames < 1 || interval < 0 || threads < 1 || threads > 64) {
+		fprintf(stderr, "spout_stream_bench - invalid arguments\n");
+		return 2;
+	}
+
+	printf("spout_stream_bench : %dx%d at %d bytes per pixel, %d frames every %d usec, %d copy threads, %u cores\n",
+		width, height, bpp, frames, interval, threads, std::thread::hardware_concurrency());
+
+	bool failed = false;
+	if (!RunMode("whole", false, width, height, bpp, frames, interval, threads, failed))
+		failed = true;
+	if (!RunMode("stream", true, width, height, bpp, frames, interval, threads, failed))
+		failed = true;
+
+	if (failed) {
+		printf("FAILED\n");
+		return 1;
+	}
+
+	printf("OK\n");
+	return 0;
+}
@@ -0,0 +1,533 @@
+//
+//		spout_stress
+//
+//		Multi-process stress test of the sender registry, frame exchange and
+//		shared memory transport using the POSIX SpoutSharedMemory backend.
+//
+//		N sender processes repeatedly register a sender name, create a frame
+//		buffer of a new size, publish frames, rename the sender, publish again
+//		and release it. M receiver processes pick registered senders, open
+//		their buffers and read frames. Every other receiver reads frames in
+//		place with a lease instead of copying them out.
+//
+//		Measured
+//			operations per second for each operation
+//			registry lock wait distribution
+//			frame latency from commit to read
+//
+//		Checked
+//			a registered name is never lost or duplicated
+//			no frame is read torn (header and payload from different commits)
+//			no leased frame is overwritten while it is held
+//			the registry is empty when all senders have released
+//
+//		The registry follows the layout of the "SpoutSenderNames" map, a fixed
+//		number of 256 character name slots guarded by the map mutex. Senders
+//		and receivers of the plugin use spoutSenderNames, which needs Windows.
+//		Frames use spoutSharedBuffer unchanged.
+//
+//		Build (Linux)
+//
+//			g++ -std=c++14 -O2 -pthread -ISpout tools/spout_stress.cpp
+//				Spout/SpoutSharedMemory.cpp Spout/SpoutSharedBuffer.cpp
+//				Spout/SpoutHistogram.cpp -o spout_stress -lrt
+//
+//		Run
+//
+//			./spout_stress [-s senders] [-r receivers] [-t seconds] [-k max frame KB]
+//
+//		SDK notices are logged to stderr, redirect it to hide them.
+//
+//		Exits with 1 if an invariant failed.
+//
+// ====================================================================================
+//		Revisions :
+//
+//		17.10.26	- project start
+//		17.10.26	- Leased reads
+//
+// ====================================================================================
+//
+/*
+	Redistribution and use in source and binary forms, with or without modification,
+	are permitted provided that the following conditions are met:
+
+		1. Redistributions of source code must retain the above copyright notice,
+		   this list of conditions and the following disclaimer.
+
+		2. Redistributions in binary form must reproduce the above copyright notice,
+		   this list of conditions and the following disclaimer in the documentation
+		   and/or other materials provided with the distribution.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"	AND ANY
+	EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+	OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE	ARE DISCLAIMED.
+	IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+	INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+	PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+	LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+	OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "SpoutSharedMemory.h"
+#include "SpoutSharedBuffer.h"
+#include "SpoutHistogram.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include <string>
+#include <vector>
+#include <random>
+
+#define STRESS_REGISTRY "SpoutStress_SenderNames"
+#define STRESS_RESULTS "SpoutStress_Results"
+#define STRESS_MAX_SENDERS 64 // registry slots, as the default MaxSenders
+#define STRESS_NAME_LEN 256 // as SpoutMaxSenderNameLen
+#define STRESS_MAX_PROCESSES 256
+#define STRESS_FRAMES_PER_NAME 64
+
+enum StressOp {
+	OP_REGISTER = 0,
+	OP_RENAME,
+	OP_RESIZE,
+	OP_RELEASE,
+	OP_PUBLISH,
+	OP_READ,
+	OP_LEASE,
+	OP_COUNT
+};
+
+static const char* g_OpNames[OP_COUNT] = {
+	"register", "rename", "resize", "release", "publish", "read", "lease"
+};
+
+// Results written by each process to its own slot
+struct StressResult {
+	uint64_t ops[OP_COUNT];
+	uint64_t lost; // registered name missing or duplicated
+	uint64_t torn; // frame read with mismatched content
+	uint64_t retries; // frame overwritten during a read and discarded
+	uint64_t expired; // leased frame overwritten while it was held
+	uint64_t lockfails; // registry lock timed out
+	uint64_t full; // registry had no free slot
+	uint64_t misses; // registered sender could not be opened
+	spoutHistogramSnapshot lockwait;
+	spoutHistogramSnapshot latency;
+};
+
+struct StressResults {
+	StressResult process[STRESS_MAX_PROCESSES];
+};
+
+// Frame header, followed by the payload
+struct StressFrame {
+	uint64_t sequence;
+	int64_t timestamp; // spoutHistogram::Now() at commit
+	uint32_t sender;
+	uint32_t length; // total bytes including the header
+};
+
+static uint8_t PayloadByte(const StressFrame& frame)
+{
+	return static_cast<uint8_t>(frame.sequence*31 + frame.sender);
+}
+
+//
+// Registry
+//
+
+class StressRegistry {
+
+	public:
+
+	bool Open()
+	{
+		return m_Memory.Open(STRESS_REGISTRY);
+	}
+
+	// Lock the registry, recording the wait
+	char* Lock(spoutHistogram& lockwait, StressResult& result)
+	{
+		const int64_t start = spoutHistogram::Now();
+		char* names = m_Memory.Lock();
+		lockwait.RecordSince(start);
+		if (!names)
+			result.lockfails++;
+		return names;
+	}
+
+	void Unlock()
+	{
+		m_Memory.Unlock();
+	}
+
+	static int Find(const char* names, const char* name)
+	{
+		for (int i = 0; i < STRESS_MAX_SENDERS; i++) {
+			if (strncmp(names + i*STRESS_NAME_LEN, name, STRESS_NAME_LEN) == 0)
+				return i;
+		}
+		return -1;
+	}
+
+	static int Count(const char* names, const char* name)
+	{
+		int count = 0;
+		for (int i = 0; i < STRESS_MAX_SENDERS; i++) {
+			if (strncmp(names + i*STRESS_NAME_LEN, name, STRESS_NAME_LEN) == 0)
+				count++;
+		}
+		return count;
+	}
+
+	SpoutSharedMemory m_Memory;
+
+};
+
+//
+// Sender process
+//
+
+static void PublishFrames(spoutSharedBuffer& buffer, uint32_t sender, uint64_t& sequence, StressResult& result)
+{
+	for (int f = 0; f < STRESS_FRAMES_PER_NAME; f++) {
+		int maxlength = 0;
+		char* data = buffer.BeginWrite(&maxlength);
+		if (!data)
+			continue;
+
+		StressFrame frame;
+		frame.sequence = ++sequence;
+		frame.sender = sender;
+		frame.length = static_cast<uint32_t>(maxlength);
+		memset(data + sizeof(StressFrame), PayloadByte(frame), maxlength - sizeof(StressFrame));
+		frame.timestamp = spoutHistogram::Now();
+		memcpy(data, &frame, sizeof(StressFrame));
+
+		if (buffer.Commit(maxlength))
+			result.ops[OP_PUBLISH]++;
+	}
+}
+
+static void RunSender(uint32_t index, int64_t deadline, int maxbytes, StressResult& result)
+{
+	StressRegistry registry;
+	if (!registry.Open())
+		return;
+
+	spoutHistogram lockwait;
+	std::mt19937 random(index*7919 + 1);
+	std::uniform_int_distribution<int> sizes(static_cast<int>(sizeof(StressFrame)) + 64, maxbytes);
+
+	spoutSharedBuffer buffer;
+	uint64_t sequence = 0;
+	int generation = 0;
+	char name[STRESS_NAME_LEN];
+
+	while (spoutHistogram::Now() < deadline) {
+
+		generation++;
+		snprintf(name, STRESS_NAME_LEN, "stress_%u_%d", index, generation);
+
+		// Register
+		char* names = registry.Lock(lockwait, result);
+		if (!names)
+			continue;
+		int slot = StressRegistry::Find(names, "");
+		if (slot >= 0)
+			snprintf(names + slot*STRESS_NAME_LEN, STRESS_NAME_LEN, "%s", name);
+		registry.Unlock();
+		if (slot < 0) {
+			result.full++;
+			usleep(1000);
+			continue;
+		}
+		result.ops[OP_REGISTER]++;
+
+		// Resize
+		const int length = sizes(random);
+		if (!buffer.Create(name, length, 3))
+			break;
+		result.ops[OP_RESIZE]++;
+		PublishFrames(buffer, index, sequence, result);
+
+		// Rename in place
+		char newname[STRESS_NAME_LEN];
+		snprintf(newname, STRESS_NAME_LEN, "stress_%u_%d_renamed", index, generation);
+		names = registry.Lock(lockwait, result);
+		if (names) {
+			slot = StressRegistry::Find(names, name);
+			if (slot >= 0) {
+				memset(names + slot*STRESS_NAME_LEN, 0, STRESS_NAME_LEN);
+				snprintf(names + slot*STRESS_NAME_LEN, STRESS_NAME_LEN, "%s", newname);
+			}
+			registry.Unlock();
+			if (slot < 0) {
+				result.lost++;
+			}
+			else {
+				strcpy(name, newname);
+				result.ops[OP_RENAME]++;
+				buffer.Create(name, length, 3);
+				PublishFrames(buffer, index, sequence, result);
+			}
+		}
+
+		// Check and release
+		while (!(names = registry.Lock(lockwait, result))) {}
+		if (StressRegistry::Count(names, name) != 1)
+			result.lost++;
+		slot = StressRegistry::Find(names, name);
+		if (slot >= 0)
+			memset(names + slot*STRESS_NAME_LEN, 0, STRESS_NAME_LEN);
+		registry.Unlock();
+		buffer.Close();
+		result.ops[OP_RELEASE]++;
+	}
+
+	lockwait.Snapshot(result.lockwait);
+}
+
+//
+// Receiver process
+//
+
+static void RunReceiver(uint32_t index, int64_t deadline, StressResult& result)
+{
+	StressRegistry registry;
+	if (!registry.Open())
+		return;
+
+	spoutHistogram lockwait;
+	spoutHistogram latency;
+	std::mt19937 random(index*104729 + 3);
+	std::vector<std::string> senders;
+	std::vector<uint8_t> copy;
+	const bool lease = (index % 2) == 1;
+
+	while (spoutHistogram::Now() < deadline) {
+
+		// Copy the registered names
+		senders.clear();
+		char* names = registry.Lock(lockwait, result);
+		if (!names)
+			continue;
+		for (int i = 0; i < STRESS_MAX_SENDERS; i++) {
+			if (names[i*STRESS_NAME_LEN])
+				senders.push_back(std::string(names + i*STRESS_NAME_LEN));
+		}
+		registry.Unlock();
+
+		if (senders.empty()) {
+			usleep(100);
+			continue;
+		}
+
+		spoutSharedBuffer buffer;
+		if (!buffer.Open(senders[random() % senders.size()].c_str())) {
+			result.misses++;
+			continue;
+		}
+
+		uint64_t lastversion = 0;
+		for (int f = 0; f < STRESS_FRAMES_PER_NAME; f++) {
+			int length = 0;
+			uint64_t version = 0;
+
+			// Check the frame in place, the writer must not reuse the buffer meanwhile
+			if (lease) {
+				const char* data = buffer.AcquireLease(&length, &version);
+				if (!data)
+					continue;
+				bool torn = false;
+				if (version != lastversion && length >= static_cast<int>(sizeof(StressFrame))) {
+					StressFrame frame;
+					memcpy(&frame, data, sizeof(StressFrame));
+					const uint8_t expected = PayloadByte(frame);
+					torn = frame.length != static_cast<uint32_t>(length);
+					for (int i = sizeof(StressFrame); i < length && !torn; i++)
+						torn = static_cast<uint8_t>(data[i]) != expected;
+					if (!torn)
+						latency.RecordSince(frame.timestamp);
+				}
+				if (!buffer.ReleaseLease(version))
+					result.expired++;
+				if (version == lastversion)
+					continue;
+				lastversion = version;
+				if (torn)
+					result.torn++;
+				else
+					result.ops[OP_LEASE]++;
+				continue;
+			}
+
+			const char* data = buffer.BeginRead(&length, &version);
+			if (!data || version == lastversion || length < static_cast<int>(sizeof(StressFrame)))
+				continue;
+
+			// Copy, then check that the writer did not reuse the buffer during the copy
+			copy.resize(length);
+			memcpy(copy.data(), data, length);
+			if (!buffer.EndRead(version)) {
+				result.retries++;
+				continue;
+			}
+			lastversion = version;
+
+			StressFrame frame;
+			memcpy(&frame, copy.data(), sizeof(StressFrame));
+			const uint8_t expected = PayloadByte(frame);
+			bool torn = frame.length != static_cast<uint32_t>(length);
+			for (int i = sizeof(StressFrame); i < length && !torn; i++)
+				torn = copy[i] != expected;
+
+			if (torn) {
+				result.torn++;
+				continue;
+			}
+			latency.RecordSince(frame.timestamp);
+			result.ops[OP_READ]++;
+		}
+	}
+
+	lockwait.Snapshot(result.lockwait);
+	latency.Snapshot(result.latency);
+}
+
+//
+// Main
+//
+
+static void PrintHistogram(const char* name, const spoutHistogramSnapshot& snapshot)
+{
+	printf("%-12s %10llu samples, usec p50 %9.1f  p90 %9.1f  p99 %9.1f  max %9.1f\n",
+		name, static_cast<unsigned long long>(snapshot.count),
+		snapshot.Percentile(50.0)/1000.0, snapshot.Percentile(90.0)/1000.0,
+		snapshot.Percentile(99.0)/1000.0, snapshot.count ? snapshot.max/1000.0 : 0.0);
+}
+
+int main(int argc, char* argv[])
+{
+	int senders = 4;
+	int receivers = 4;
+	int seconds = 5;
+	int maxkb = 256;
+
+	int opt = 0;
+	while ((opt = getopt(argc, argv, "s:r:t:k:")) != -1) {
+		switch (opt) {
+			case 's': senders = atoi(optarg); break;
+			case 'r': receivers = atoi(optarg); break;
+			case 't': seconds = atoi(optarg); break;
+			case 'k': maxkb = atoi(optarg); break;
+			default:
+				fprintf(stderr, "usage: %s [-s senders] [-r receivers] [-t seconds] [-k max frame KB]\n", argv[0]);
+				return 2;
+		}
+	}
+	if (senders < 1 || receivers < 0 || senders + receivers > STRESS_MAX_PROCESSES || seconds < 1 || maxkb < 1) {
+		fprintf(stderr, "spout_stress - invalid arguments\n");
+		return 2;
+	}
+
+	// The creator removes the names on close, so these only live for the run
+	SpoutSharedMemory registry;
+	SpoutSharedMemory results;
+	if (registry.Create(STRESS_REGISTRY, STRESS_MAX_SENDERS*STRESS_NAME_LEN) != SPOUT_CREATE_SUCCESS
+		|| results.Create(STRESS_RESULTS, static_cast<int>(sizeof(StressResults))) != SPOUT_CREATE_SUCCESS) {
+		fprintf(stderr, "spout_stress - could not create shared memory, is another run active?\n");
+		return 2;
+	}
+	StressResults* pResults = reinterpret_cast<StressResults*>(results.Buffer());
+	for (int i = 0; i < STRESS_MAX_PROCESSES; i++)
+		pResults->process[i] = StressResult();
+
+	printf("spout_stress : %d senders, %d receivers, %d seconds, frames up to %d KB\n", senders, receivers, seconds, maxkb);
+
+	const int64_t start = spoutHistogram::Now();
+	const int64_t deadline = start + static_cast<int64_t>(seconds)*1000000000LL;
+
+	std::vector<pid_t> children;
+	for (int i = 0; i < senders + receivers; i++) {
+		const pid_t pid = fork();
+		if (pid == 0) {
+			// Results go to this process's slot in the shared map.
+			// _exit so that the parent's maps are not closed here.
+			StressResult result = StressResult();
+			if (i < senders)
+				RunSender(static_cast<uint32_t>(i), deadline, maxkb*1024, result);
+			else
+				RunReceiver(static_cast<uint32_t>(i), deadline, result);
+			pResults->process[i] = result;
+			_exit(0);
+		}
+		if (pid < 0) {
+			fprintf(stderr, "spout_stress - fork failed\n");
+			break;
+		}
+		children.push_back(pid);
+	}
+
+	bool failed = false;
+	for (size_t i = 0; i < children.size(); i++) {
+		int status = 0;
+		waitpid(children[i], &status, 0);
+		if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+			fprintf(stderr, "spout_stress - process %d failed\n", static_cast<int>(children[i]));
+			failed = true;
+		}
+	}
+
+	const double elapsed = static_cast<double>(spoutHistogram::Now() - start)/1e9;
+
+	StressResult total = StressResult();
+	for (size_t i = 0; i < children.size(); i++) {
+		const StressResult& result = pResults->process[i];
+		for (int op = 0; op < OP_COUNT; op++)
+			total.ops[op] += result.ops[op];
+		total.lost += result.lost;
+		total.torn += result.torn;
+		total.retries += result.retries;
+		total.expired += result.expired;
+		total.lockfails += result.lockfails;
+		total.full += result.full;
+		total.misses += result.misses;
+		total.lockwait.Merge(result.lockwait);
+		total.latency.Merge(result.latency);
+	}
+
+	for (int op = 0; op < OP_COUNT; op++)
+		printf("%-12s %10llu  %12.1f /s\n", g_OpNames[op], static_cast<unsigned long long>(total.ops[op]), total.ops[op]/elapsed);
+	PrintHistogram("lock wait", total.lockwait);
+	PrintHistogram("latency", total.latency);
+	printf("retries %llu, lock timeouts %llu, registry full %llu, open misses %llu\n",
+		static_cast<unsigned long long>(total.retries), static_cast<unsigned long long>(total.lockfails),
+		static_cast<unsigned long long>(total.full), static_cast<unsigned long long>(total.misses));
+
+	// Every sender released its names
+	int leaked = 0;
+	const char* names = registry.Buffer();
+	for (int i = 0; i < STRESS_MAX_SENDERS; i++) {
+		if (names[i*STRESS_NAME_LEN])
+			leaked++;
+	}
+
+	printf("lost names %llu, torn frames %llu, expired leases %llu, leaked names %d\n",
+		static_cast<unsigned long long>(total.lost), static_cast<unsigned long long>(total.torn),
+		static_cast<unsigned long long>(total.expired), leaked);
+
+	if (total.lost || total.torn || total.expired || leaked || failed) {
+		printf("FAILED\n");
+		return 1;
+	}
+
+	printf("OK\n");
+	return 0;
+}